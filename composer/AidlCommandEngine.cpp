@@ -0,0 +1,885 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Copyright (c) 2022-2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <inttypes.h>
+#include <sync/sync.h>
+#include <algorithm>
+#include <cmath>
+#include "AidlCommandEngine.h"
+
+namespace aidl {
+namespace vendor {
+namespace qti {
+namespace hardware {
+namespace display {
+namespace composer3 {
+
+ComposerHandleImporter mHandleImporter;
+
+BufferCacheEntry::BufferCacheEntry() : mHandle(nullptr) {}
+
+BufferCacheEntry::BufferCacheEntry(BufferCacheEntry &&other) {
+  mHandle = other.mHandle;
+  other.mHandle = nullptr;
+}
+
+BufferCacheEntry &BufferCacheEntry::operator=(buffer_handle_t handle) {
+  clear();
+  mHandle = handle;
+  return *this;
+}
+
+BufferCacheEntry::~BufferCacheEntry() {
+  clear();
+}
+
+void BufferCacheEntry::clear() {
+  if (mHandle) {
+    mHandleImporter.freeBuffer(mHandle);
+  }
+}
+
+bool CommandEngine::init() {
+  mWriter = std::make_unique<ComposerServiceWriter>();
+  return (mWriter != nullptr);
+}
+
+Error CommandEngine::execute(const std::vector<DisplayCommand> &commands,
+                                                 std::vector<CommandResultPayload> *result) {
+  // std::set<int64_t> displaysPendingBrightnessChange;
+  mCommandIndex = 0;
+  resetDisplayDataCache();
+
+  for (const auto &displayCmd : commands) {
+    ExecuteCommand(displayCmd.brightness, &CommandEngine::executeSetDisplayBrightness,
+                   displayCmd.display, *displayCmd.brightness);
+    for (const auto &layerCmd : displayCmd.layers) {
+      ExecuteCommand(layerCmd.cursorPosition, &CommandEngine::executeSetLayerCursorPosition,
+                     displayCmd.display, layerCmd.layer, *layerCmd.cursorPosition);
+      ExecuteCommand(layerCmd.buffer, &CommandEngine::executeSetLayerBuffer, displayCmd.display,
+                     layerCmd.layer, *layerCmd.buffer);
+      ExecuteCommand(layerCmd.damage, &CommandEngine::executeSetLayerSurfaceDamage,
+                     displayCmd.display, layerCmd.layer, *layerCmd.damage);
+      ExecuteCommand(layerCmd.blendMode, &CommandEngine::executeSetLayerBlendMode,
+                     displayCmd.display, layerCmd.layer, *layerCmd.blendMode);
+      ExecuteCommand(layerCmd.composition, &CommandEngine::executeSetLayerComposition,
+                     displayCmd.display, layerCmd.layer, *layerCmd.composition);
+      // AIDL definiton of LayerCommand Color which calls into executeSetLayerColor:
+      // Sets the color of the given layer. If the composition type of the layer is not
+      // Composition.SOLID_COLOR, this call must succeed and have no other effect.
+      // Since the function depends on composition type to be set, executeSetLayerColor
+      // has to be called after executeSetLayerComposition
+      ExecuteCommand(layerCmd.color, &CommandEngine::executeSetLayerColor, displayCmd.display,
+                     layerCmd.layer, *layerCmd.color);
+      ExecuteCommand(layerCmd.dataspace, &CommandEngine::executeSetLayerDataspace,
+                     displayCmd.display, layerCmd.layer, *layerCmd.dataspace);
+      ExecuteCommand(layerCmd.displayFrame, &CommandEngine::executeSetLayerDisplayFrame,
+                     displayCmd.display, layerCmd.layer, *layerCmd.displayFrame);
+      ExecuteCommand(layerCmd.planeAlpha, &CommandEngine::executeSetLayerPlaneAlpha,
+                     displayCmd.display, layerCmd.layer, *layerCmd.planeAlpha);
+      ExecuteCommand(layerCmd.sidebandStream, &CommandEngine::executeSetLayerSidebandStream,
+                     displayCmd.display, layerCmd.layer, *layerCmd.sidebandStream);
+      ExecuteCommand(layerCmd.sourceCrop, &CommandEngine::executeSetLayerSourceCrop,
+                     displayCmd.display, layerCmd.layer, *layerCmd.sourceCrop);
+      ExecuteCommand(layerCmd.visibleRegion, &CommandEngine::executeSetLayerVisibleRegion,
+                     displayCmd.display, layerCmd.layer, *layerCmd.visibleRegion);
+      ExecuteCommand(layerCmd.transform, &CommandEngine::executeSetLayerTransform,
+                     displayCmd.display, layerCmd.layer, *layerCmd.transform);
+      ExecuteCommand(layerCmd.z, &CommandEngine::executeSetLayerZOrder, displayCmd.display,
+                     layerCmd.layer, *layerCmd.z);
+      ExecuteCommand(layerCmd.brightness, &CommandEngine::executeSetLayerBrightness,
+                     displayCmd.display, layerCmd.layer, *layerCmd.brightness);
+      ExecuteCommand(layerCmd.perFrameMetadata, &CommandEngine::executeSetLayerPerFrameMetadata,
+                     displayCmd.display, layerCmd.layer, *layerCmd.perFrameMetadata);
+      ExecuteCommand(layerCmd.perFrameMetadataBlob,
+                     &CommandEngine::executeSetLayerPerFrameMetadataBlobs, displayCmd.display,
+                     layerCmd.layer, *layerCmd.perFrameMetadataBlob);
+      ExecuteCommand(layerCmd.blockingRegion, &CommandEngine::executeSetLayerBlockingRegion,
+                     displayCmd.display, layerCmd.layer, *layerCmd.blockingRegion);
+    }
+    ExecuteCommand(displayCmd.colorTransformMatrix, &CommandEngine::executeSetColorTransform,
+                   displayCmd.display, *displayCmd.colorTransformMatrix);
+    ExecuteCommand(displayCmd.clientTarget, &CommandEngine::executeSetClientTarget,
+                   displayCmd.display, *displayCmd.clientTarget);
+    ExecuteCommand(displayCmd.virtualDisplayOutputBuffer, &CommandEngine::executeSetOutputBuffer,
+                   displayCmd.display, *displayCmd.virtualDisplayOutputBuffer);
+    ExecuteCommand(displayCmd.validateDisplay, &CommandEngine::executeValidateDisplay,
+                   displayCmd.display, displayCmd.expectedPresentTime);
+    ExecuteCommand(displayCmd.acceptDisplayChanges, &CommandEngine::executeAcceptDisplayChanges,
+                   displayCmd.display);
+    ExecuteCommand(displayCmd.presentDisplay, &CommandEngine::executePresentDisplay,
+                   displayCmd.display);
+    ExecuteCommand(displayCmd.presentOrValidateDisplay,
+                   &CommandEngine::executePresentOrValidateDisplay, displayCmd.display,
+                   displayCmd.expectedPresentTime);
+
+    ++mCommandIndex;
+
+    // TODO: Process brightness change on presentDisplay if both commands come in?????
+    // if (displayCmd.validateDisplay || displayCmd.presentDisplay ||
+    //     displayCmd.presentOrValidateDisplay) {
+    //   displaysPendingBrightnessChange.erase(displayCmd.display);
+    // } else if (DisplayCmd.brightness) {
+    //   displaysPendingBrightnessChange.insert(displayCmd.display);
+    // }
+  }
+
+  if (!mCommandIndex) {
+    ALOGW("%s: No command found", __FUNCTION__);
+  }
+
+  mWriter->getPendingCommandResults(result);
+  reset();
+  resetDisplayDataCache();
+
+  return (mCommandIndex) ? Error::None : Error::BadParameter;
+}
+
+Error CommandEngine::qtiExecute(const std::vector<QtiDisplayCommand> &commands,
+                                                    std::vector<CommandResultPayload> *result) {
+  resetDisplayDataCache();
+
+  for (const auto &displayCmd : commands) {
+    for (const auto &layerCmd : displayCmd.qtiLayers) {
+      ExecuteCommand(layerCmd.qtiLayerType, &CommandEngine::executeSetLayerType, displayCmd.display,
+                     layerCmd.layer, layerCmd.qtiLayerType);
+      ExecuteCommand(layerCmd.qtiLayerFlags, &CommandEngine::executeSetLayerFlag,
+                     displayCmd.display, layerCmd.layer, layerCmd.qtiLayerFlags);
+    }
+    ExecuteCommand(displayCmd.clientTarget_3_1, &CommandEngine::executeSetClientTarget_3_1,
+                   displayCmd.display, *displayCmd.clientTarget_3_1);
+    ExecuteCommand(displayCmd.time, &CommandEngine::executeSetDisplayElapseTime, displayCmd.display,
+                   displayCmd.time);
+
+    ++mCommandIndex;
+  }
+
+  if (!mCommandIndex) {
+    ALOGW("%s: No command found", __FUNCTION__);
+  }
+
+  mWriter->getPendingCommandResults(result);
+  reset();
+  resetDisplayDataCache();
+
+  return (mCommandIndex) ? Error::None : Error::BadParameter;
+}
+
+void CommandEngine::executeSetColorTransform(int64_t display,
+                                                                 const std::vector<float> &matrix) {
+  auto err = mSession.SetColorTransform(display, matrix);
+  if (err != Error::None) {
+    writeError(__FUNCTION__, err);
+  }
+}
+
+void CommandEngine::executeSetClientTarget(int64_t display,
+                                                               const ClientTarget &command) {
+  bool useCache = !command.buffer.handle;
+  buffer_handle_t clientTarget =
+      useCache ? nullptr : ::android::makeFromAidl(*command.buffer.handle);
+  native_handle_t *clientTargetClone = const_cast<native_handle_t *>(clientTarget);
+  shared_ptr<Fence> fence = nullptr;
+  auto &sfd = const_cast<::ndk::ScopedFileDescriptor &>(command.buffer.fence);
+  auto fd = sfd.get();
+  *sfd.getR() = -1;
+
+  fence = Fence::Create(fd, "fbt");
+  if (fence == nullptr) {
+    ALOGV("%s: Failed to dup fence %d", __FUNCTION__, fd);
+    sync_wait(fd, -1);
+  }
+
+  sdm::Region region = {command.damage.size(),
+                        reinterpret_cast<Rect const *>(command.damage.data())};
+  auto err = lookupBuffer(display, -1, BufferCache::CLIENT_TARGETS, command.buffer.slot, useCache,
+                          clientTarget, &clientTarget);
+  if (err == Error::None) {
+    err = mSession.SetClientTarget(display, clientTarget, fence,
+                                                INT32(command.dataspace), region);
+    auto updateBufErr = updateBuffer(display, -1, BufferCache::CLIENT_TARGETS, command.buffer.slot,
+                                     useCache, clientTarget);
+    if (err == Error::None) {
+      err = updateBufErr;
+    }
+  }
+
+  // Cleanup orginally cloned handle from the input
+  native_handle_delete(clientTargetClone);
+
+  if (err != Error::None) {
+    writeError(__FUNCTION__, err);
+  }
+}
+
+void CommandEngine::executeSetDisplayBrightness(
+    uint64_t display, const DisplayBrightness &command) {
+  if (std::isnan(command.brightness) || command.brightness > 1.0f ||
+      (command.brightness < 0.0f && command.brightness != -1.0f)) {
+    writeError(__FUNCTION__, Error::BadParameter);
+    return;
+  }
+
+  auto err = mSession.SetDisplayBrightness(display, command.brightness);
+  if (err != Error::None) {
+    writeError(__FUNCTION__, err);
+  }
+}
+void CommandEngine::executeSetOutputBuffer(uint64_t display,
+                                                               const Buffer &buffer) {
+  bool useCache = !buffer.handle;
+  buffer_handle_t outputBuffer = useCache ? nullptr : ::android::makeFromAidl(*buffer.handle);
+  native_handle_t *outputBufferClone = const_cast<native_handle_t *>(outputBuffer);
+  shared_ptr<Fence> fence = nullptr;
+  auto &sfd = const_cast<::ndk::ScopedFileDescriptor &>(buffer.fence);
+  auto fd = sfd.get();
+  *sfd.getR() = -1;
+
+  fence = Fence::Create(fd, "outbuf");
+  if (fence == nullptr) {
+    ALOGV("%s: Failed to dup fence %d", __FUNCTION__, fd);
+    sync_wait(fd, -1);
+  }
+
+  auto err = lookupBuffer(display, -1, BufferCache::OUTPUT_BUFFERS, buffer.slot, useCache,
+                          outputBuffer, &outputBuffer);
+  if (err == Error::None) {
+    err = mSession.SetOutputBuffer(display, outputBuffer, fence);
+    auto updateBufErr =
+        updateBuffer(display, -1, BufferCache::OUTPUT_BUFFERS, buffer.slot, useCache, outputBuffer);
+    if (err == Error::None) {
+      err = updateBufErr;
+    }
+  }
+
+  // Cleanup orginally cloned handle from the input
+  native_handle_delete(outputBufferClone);
+
+  if (err != Error::None) {
+    writeError(__FUNCTION__, err);
+  }
+}
+
+void CommandEngine::executeValidateDisplay(
+    int64_t display, const std::optional<ClockMonotonicTimestamp> expectedPresentTime) {
+  executeSetExpectedPresentTimeInternal(display, expectedPresentTime);
+
+  auto err = validateDisplay(display);
+
+  if (err != Error::None) {
+    writeError(__FUNCTION__, err);
+  }
+}
+
+void CommandEngine::executePresentOrValidateDisplay(
+    int64_t display, const std::optional<ClockMonotonicTimestamp> expectedPresentTime) {
+  executeSetExpectedPresentTimeInternal(display, expectedPresentTime);
+
+  // Handle unified commit.
+  bool needsCommit = false;
+  shared_ptr<Fence> presentFence = nullptr;
+  uint32_t typesCount = 0;
+  uint32_t reqsCount = 0;
+  bool validate_only = false;
+  auto status = mSession.CommitOrPrepare(display, validate_only, &presentFence,
+                                                      &typesCount, &reqsCount, &needsCommit);
+  if (needsCommit) {
+    if (status != Error::None && status != Error::HasChanges) {
+      ALOGE("%s: CommitOrPrepare failed %d", __FUNCTION__, INT32(status));
+    }
+    // Implement post validation. Getcomptypes etc;
+    postValidateDisplay(display, typesCount, reqsCount);
+    mWriter->setPresentOrValidateResult(display, PresentOrValidate::Result::Validated);
+  } else {
+    if (status == Error::HasChanges) {
+      // Perform post validate.
+      auto error = postValidateDisplay(display, typesCount, reqsCount);
+      if (error == Error::None) {
+        mSession.AcceptDisplayChanges(display);
+      }
+      // Set result to validated, has comp changes
+      mWriter->setPresentOrValidateResult(display, static_cast<PresentOrValidate::Result>(2));
+    } else {
+      // Set result to Presented.
+      mWriter->setPresentOrValidateResult(display, PresentOrValidate::Result::Presented);
+    }
+    // perform post present display.
+    postPresentDisplay(display, &presentFence);
+  }
+}
+
+void CommandEngine::executeAcceptDisplayChanges(int64_t display) {
+  auto err = mSession.AcceptDisplayChanges(display);
+  if (err != Error::None) {
+    writeError(__FUNCTION__, err);
+  }
+}
+
+Error CommandEngine::presentDisplay(int64_t display,
+                                                        shared_ptr<Fence> *presentFence) {
+  auto err = mSession.PresentDisplay(display, presentFence);
+  if (err != Error::None) {
+    return err;
+  }
+
+  return postPresentDisplay(display, presentFence);
+}
+
+void CommandEngine::executePresentDisplay(int64_t display) {
+  shared_ptr<Fence> presentFence = nullptr;
+
+  auto err = presentDisplay(display, &presentFence);
+  if (err != Error::None) {
+    writeError(__FUNCTION__, err);
+  }
+}
+
+void CommandEngine::executeSetLayerCursorPosition(int64_t display,
+                                                                      int64_t layer,
+                                                                      const Point &cursorPosition) {
+  auto err =
+      mSession.SetCursorPosition(display, layer, cursorPosition.x, cursorPosition.y);
+  if (err != Error::None) {
+    writeError(__FUNCTION__, err);
+  }
+}
+
+void CommandEngine::executeSetLayerBuffer(int64_t display, int64_t layer,
+                                                              const Buffer &buffer) {
+  bool useCache = !buffer.handle;
+  buffer_handle_t layerBuffer = useCache ? nullptr : ::android::makeFromAidl(*buffer.handle);
+  native_handle_t *layerBufferClone = const_cast<native_handle_t *>(layerBuffer);
+  shared_ptr<Fence> fence = nullptr;
+  auto &sfd = const_cast<::ndk::ScopedFileDescriptor &>(buffer.fence);
+  auto fd = sfd.get();
+  *sfd.getR() = -1;
+
+  fence = Fence::Create(fd, "layer");
+  if (fence == nullptr) {
+    ALOGV("%s: Failed to dup fence %d", __FUNCTION__, fd);
+    sync_wait(fd, -1);
+  }
+
+  auto error = lookupBuffer(display, layer, BufferCache::LAYER_BUFFERS, buffer.slot, useCache,
+                            layerBuffer, &layerBuffer);
+  if (error == Error::None) {
+    error = mSession.SetLayerBuffer(display, layer, layerBuffer, fence);
+    auto updateBufErr = updateBuffer(display, layer, BufferCache::LAYER_BUFFERS, buffer.slot,
+                                     useCache, layerBuffer);
+    if (static_cast<Error>(error) == Error::None) {
+      error = updateBufErr;
+    }
+  }
+
+  // Cleanup orginally cloned handle from the input
+  native_handle_delete(layerBufferClone);
+
+  if (error != Error::None) {
+    writeError(__FUNCTION__, error);
+  }
+}
+
+void CommandEngine::executeSetLayerSurfaceDamage(
+    int64_t display, int64_t layer, const std::vector<std::optional<Rect>> &damage) {
+  // N rectangles
+  sdm::Region region = {damage.size(), reinterpret_cast<Rect const *>(damage.data())};
+  auto err = mSession.SetLayerSurfaceDamage(display, layer, region);
+  if (err != Error::None) {
+    writeError(__FUNCTION__, err);
+  }
+}
+
+void CommandEngine::executeSetLayerBlendMode(
+    int64_t display, int64_t layer, const ParcelableBlendMode &blendMode) {
+  auto err = mSession.SetLayerBlendMode(display, layer, INT32(blendMode.blendMode));
+  if (err != Error::None) {
+    writeError(__FUNCTION__, err);
+  }
+}
+
+void CommandEngine::executeSetLayerColor(int64_t display, int64_t layer,
+                                                             const FColor &color) {
+  const auto floatColorToUint8Clamped = [](float val) -> uint8_t {
+    const auto intVal = static_cast<uint64_t>(std::round(255.0f * val));
+    const auto minVal = static_cast<uint64_t>(0);
+    const auto maxVal = static_cast<uint64_t>(255);
+    return std::clamp(intVal, minVal, maxVal);
+  };
+
+  sdm::Color int_color{floatColorToUint8Clamped(color.r), floatColorToUint8Clamped(color.g),
+                       floatColorToUint8Clamped(color.b), floatColorToUint8Clamped(color.a)};
+  auto err = mSession.SetLayerColor(display, layer, int_color);
+  if (err != Error::None) {
+    writeError(__FUNCTION__, err);
+  }
+}
+
+void CommandEngine::executeSetLayerComposition(
+    int64_t display, int64_t layer, const ParcelableComposition &composition) {
+  auto err =
+      mSession.SetLayerCompositionType(display, layer, INT32(composition.composition));
+  if (err != Error::None) {
+    writeError(__FUNCTION__, err);
+  }
+}
+
+void CommandEngine::executeSetLayerDataspace(
+    int64_t display, int64_t layer, const ParcelableDataspace &dataspace) {
+  auto err = mSession.SetLayerDataspace(display, layer, INT32(dataspace.dataspace));
+  if (err != Error::None) {
+    writeError(__FUNCTION__, err);
+  }
+}
+
+void CommandEngine::executeSetLayerDisplayFrame(int64_t display, int64_t layer,
+                                                                    const Rect &rect) {
+  auto err = mSession.SetLayerDisplayFrame(display, layer, rect);
+  if (err != Error::None) {
+    writeError(__FUNCTION__, err);
+  }
+}
+
+void CommandEngine::executeSetLayerPlaneAlpha(int64_t display, int64_t layer,
+                                                                  const PlaneAlpha &planeAlpha) {
+  auto err = mSession.SetLayerPlaneAlpha(display, layer, planeAlpha.alpha);
+  if (err != Error::None) {
+    writeError(__FUNCTION__, err);
+  }
+}
+
+void CommandEngine::executeSetLayerSidebandStream(
+    int64_t display, int64_t layer, const NativeHandle &sidebandStream) {
+  // Sideband stream is not supported
+}
+
+void CommandEngine::executeSetLayerSourceCrop(int64_t display, int64_t layer,
+                                                                  const FRect &sourceCrop) {
+  auto err = mSession.SetLayerSourceCrop(display, layer, sourceCrop);
+  if (err != Error::None) {
+    writeError(__FUNCTION__, err);
+  }
+}
+
+void CommandEngine::executeSetLayerTransform(
+    int64_t display, int64_t layer, const ParcelableTransform &transform) {
+  // TODO: Remove this catch block for invalid rotation hint after a fix is found
+  Transform layer_transform = transform.transform;
+  if (INT32(layer_transform) == 128)
+    layer_transform = Transform::NONE;
+
+  auto err = mSession.SetLayerTransform(display, layer, layer_transform);
+  if (err != Error::None) {
+    writeError(__FUNCTION__, err);
+  }
+}
+
+void CommandEngine::executeSetLayerVisibleRegion(
+    int64_t display, int64_t layer, const std::vector<std::optional<Rect>> &visibleRegion) {
+  sdm::Region region = {visibleRegion.size(), reinterpret_cast<Rect const *>(visibleRegion.data())};
+  auto err = mSession.SetLayerVisibleRegion(display, layer, region);
+  if (err != Error::None) {
+    writeError(__FUNCTION__, err);
+  }
+}
+
+void CommandEngine::executeSetLayerZOrder(int64_t display, int64_t layer,
+                                                              const ZOrder &zOrder) {
+  auto err = mSession.SetLayerZOrder(display, layer, zOrder.z);
+  if (err != Error::None) {
+    writeError(__FUNCTION__, err);
+  }
+}
+
+void CommandEngine::executeSetLayerPerFrameMetadata(
+    int64_t display, int64_t layer,
+    const std::vector<std::optional<PerFrameMetadata>> &perFrameMetadata) {
+  mMetadataKeys.clear();
+  mMetadataValues.clear();
+
+  for (const auto &m : perFrameMetadata) {
+    mMetadataKeys.push_back(INT32(m->key));
+    mMetadataValues.push_back(static_cast<float>(m->value));
+  }
+
+  auto err = mSession.SetLayerPerFrameMetadata(
+      display, layer, perFrameMetadata.size(), mMetadataKeys.data(), mMetadataValues.data());
+  if (err != Error::None) {
+    writeError(__FUNCTION__, err);
+  }
+}
+
+void CommandEngine::executeSetLayerColorTransform(
+    int64_t display, int64_t layer, const std::vector<float> &colorTransform) {
+  auto err = mSession.SetLayerColorTransform(display, layer, colorTransform.data());
+  if (err != Error::None) {
+    writeError(__FUNCTION__, err);
+  }
+}
+
+void CommandEngine::executeSetLayerPerFrameMetadataBlobs(
+    int64_t display, int64_t layer,
+    const std::vector<std::optional<PerFrameMetadataBlob>> &perFrameMetadataBlob) {
+  mMetadataKeys.clear();
+  mMetadataBlobSizes.clear();
+  mMetadataBlobData.clear();
+
+  for (const auto &m : perFrameMetadataBlob) {
+    mMetadataKeys.push_back(INT32(m->key));
+    mMetadataBlobSizes.push_back(UINT32(m->blob.size()));
+    mMetadataBlobData.insert(mMetadataBlobData.end(), m->blob.begin(), m->blob.end());
+  }
+
+  auto err = mSession.SetLayerPerFrameMetadataBlobs(
+      display, layer, perFrameMetadataBlob.size(), mMetadataKeys.data(),
+      mMetadataBlobSizes.data(), mMetadataBlobData.data());
+  if (err != Error::None) {
+    writeError(__FUNCTION__, err);
+  }
+}
+
+void CommandEngine::executeSetLayerBrightness(
+    int64_t display, int64_t layer, const LayerBrightness &brightness) {
+  auto err = mSession.SetLayerBrightness(display, layer, brightness.brightness);
+  if (err != Error::None) {
+    writeError(__FUNCTION__, err);
+  }
+}
+
+void CommandEngine::executeSetExpectedPresentTimeInternal(
+    int64_t display, const std::optional<ClockMonotonicTimestamp> expectedPresentTime) {
+  if (!expectedPresentTime.has_value()) {
+    return;
+  }
+
+  uint64_t expectedPresentTimestamp = 0;
+  if (expectedPresentTime->timestampNanos > 0) {
+    expectedPresentTimestamp = static_cast<uint64_t>(expectedPresentTime->timestampNanos);
+  }
+
+  auto err = mSession.SetExpectedPresentTime(display, expectedPresentTimestamp);
+  if (err != Error::None) {
+    writeError(__FUNCTION__, err);
+  }
+}
+
+void CommandEngine::executeSetLayerBlockingRegion(
+    int64_t display, int64_t layer, const std::vector<std::optional<Rect>> &blockingRegion) {
+  // TODO: Add impl here and in hwc_session / hwc_display
+  //   auto err = mSession.SetLayerBlockingRegion(display, blockingRegion);
+  //   if (err != Error::None) {
+  //     writeError(__FUNCTION__, err);
+  //   }
+  // writeError(__FUNCTION__, Error::Unsupported);
+}
+
+Error CommandEngine::validateDisplay(int64_t display) {
+  bool validate_only = true;
+  bool needsCommit = false;
+  uint32_t types_count = 0;
+  uint32_t reqs_count = 0;
+  shared_ptr<Fence> presentFence = nullptr;
+
+  auto err = mSession.CommitOrPrepare(display, validate_only, &presentFence,
+                                                   &types_count, &reqs_count, &needsCommit);
+  if (err != Error::None && err != Error::HasChanges) {
+    return err;
+  }
+
+  return postValidateDisplay(display, types_count, reqs_count);
+}
+
+Error CommandEngine::postPresentDisplay(int64_t display,
+                                                            shared_ptr<Fence> *presentFence) {
+  uint32_t count = 0;
+  auto err = mSession.GetReleaseFences(display, &count, nullptr, nullptr);
+  if (err != Error::None) {
+    ALOGW("%s: Failed to get release fences", __FUNCTION__);
+    return Error::None;
+  }
+
+  mLayers.resize(count);
+  mReleaseFences.resize(count);
+  err = mSession.GetReleaseFences(display, &count, mLayers.data(), &mReleaseFences);
+  if (err != Error::None) {
+    ALOGW("%s: Failed to get release fences", __FUNCTION__);
+    mLayers.clear();
+    mReleaseFences.clear();
+    return Error::None;
+  }
+
+  // Convert from Fence to ScopedFileDescriptor
+  mAidlReleaseFences.clear();
+  for (auto const &fd : mReleaseFences) {
+    mAidlReleaseFences.emplace_back(::ndk::ScopedFileDescriptor(Fence::Dup(fd)));
+  }
+
+  mWriter->setPresentFence(display,
+                           std::move(::ndk::ScopedFileDescriptor(Fence::Dup(*presentFence))));
+  mWriter->setReleaseFences(display, mLayers, &mAidlReleaseFences);
+
+  // Drop fence references, storage is retained for the next frame.
+  mReleaseFences.clear();
+  mAidlReleaseFences.clear();
+
+  return Error::None;
+}
+
+Error CommandEngine::postValidateDisplay(int64_t display, uint32_t &types_count,
+                                                             uint32_t &reqs_count) {
+  ClientTargetProperty clientTargetProperty;
+  mChangedLayers.resize(types_count);
+  mCompositionTypes.resize(types_count);
+  auto err =
+      mSession.GetChangedCompositionTypes(display, &types_count, nullptr, nullptr);
+  if (err != Error::None) {
+    return err;
+  }
+
+  err = mSession.GetChangedCompositionTypes(
+      display, &types_count, mChangedLayers.data(),
+      reinterpret_cast<std::underlying_type<Composition>::type *>(mCompositionTypes.data()));
+
+  if (err != Error::None) {
+    mChangedLayers.clear();
+    mCompositionTypes.clear();
+    return static_cast<Error>(err);
+  }
+
+  int32_t display_reqs = 0;
+  err = mSession.GetDisplayRequests(display, &display_reqs, &reqs_count, nullptr,
+                                                 nullptr);
+  if (err != Error::None) {
+    mChangedLayers.clear();
+    mCompositionTypes.clear();
+    return err;
+  }
+
+  mRequestedLayers.resize(reqs_count);
+  mRequestMasks.resize(reqs_count);
+  err = mSession.GetDisplayRequests(display, &display_reqs, &reqs_count,
+                                                 mRequestedLayers.data(), mRequestMasks.data());
+  if (err != Error::None) {
+    mChangedLayers.clear();
+    mCompositionTypes.clear();
+
+    mRequestedLayers.clear();
+    mRequestMasks.clear();
+  }
+
+  err = mSession.GetClientTargetProperty(display, &clientTargetProperty);
+  if (err != Error::None) {
+    // todo: reset to default values
+    return err;
+  }
+
+  mWriter->setChangedCompositionTypes(display, mChangedLayers, mCompositionTypes);
+  mWriter->setDisplayRequests(display, display_reqs, mRequestedLayers, mRequestMasks);
+  static constexpr float kBrightness = 1.f;
+  DimmingStage dimmingStage = DimmingStage::NONE;
+  mWriter->setClientTargetProperty(display, clientTargetProperty, kBrightness, dimmingStage);
+
+  return err;
+}
+
+// TODO: Re-add extensions API
+void CommandEngine::executeSetClientTarget_3_1(int64_t display,
+                                                                   const ClientTarget &command) {
+  bool useCache = true;
+  buffer_handle_t clientTarget = nullptr;
+  shared_ptr<Fence> fence = nullptr;
+  auto &sfd = const_cast<::ndk::ScopedFileDescriptor &>(command.buffer.fence);
+  auto fd = sfd.get();
+  *sfd.getR() = -1;
+
+  fence = Fence::Create(fd, "fbt");
+  if (fence == nullptr) {
+    ALOGW("%s: Failed to dup fence %d", __FUNCTION__, fd);
+    sync_wait(fd, -1);
+  }
+
+  sdm::Region region = {};
+  auto err = lookupBuffer(display, -1, BufferCache::CLIENT_TARGETS, command.buffer.slot, useCache,
+                          clientTarget, &clientTarget);
+  if (err == Error::None) {
+    err = mSession.SetClientTarget_3_1(display, clientTarget, fence,
+                                                    INT32(command.dataspace), region);
+    auto updateBufErr = updateBuffer(display, -1, BufferCache::CLIENT_TARGETS, command.buffer.slot,
+                                     useCache, clientTarget);
+    if (err == Error::None) {
+      err = updateBufErr;
+    }
+  }
+  if (err != Error::None) {
+    writeError(__FUNCTION__, err);
+  }
+}
+
+void CommandEngine::executeSetDisplayElapseTime(int64_t display,
+                                                                    uint64_t time) {
+  auto err = mSession.SetDisplayElapseTime(display, time);
+  if (err != Error::None) {
+    writeError(__FUNCTION__, err);
+  }
+}
+
+void CommandEngine::executeSetLayerType(int64_t display, int64_t layer,
+                                                            sdm::LayerType type) {
+  auto err = mSession.SetLayerType(display, layer, type);
+  if (err != Error::None) {
+    writeError(__FUNCTION__, err);
+  }
+}
+
+void CommandEngine::executeSetLayerFlag(int64_t display, int64_t layer,
+                                                            sdm::LayerFlag flag) {
+  auto err = mSession.SetLayerFlag(display, layer, flag);
+  if (err != Error::None) {
+    writeError(__FUNCTION__, err);
+  }
+}
+
+DisplayData *CommandEngine::getDisplayDataLocked(
+    int64_t display) {
+  if (mCachedDisplayData && mCachedDisplay == display) {
+    return mCachedDisplayData;
+  }
+
+  auto dpy = mDisplayData.find(display);
+  if (dpy == mDisplayData.end()) {
+    return nullptr;
+  }
+
+  mCachedDisplay = display;
+  mCachedDisplayData = &dpy->second;
+
+  return mCachedDisplayData;
+}
+
+Error CommandEngine::lookupBufferCacheEntryLocked(
+    int64_t display, int64_t layer, BufferCache cache, uint32_t slot, BufferCacheEntry **outEntry) {
+  DisplayData *displayData = getDisplayDataLocked(display);
+  if (!displayData) {
+    return Error::BadDisplay;
+  }
+
+  BufferCacheEntry *entry = nullptr;
+  switch (cache) {
+    case BufferCache::CLIENT_TARGETS:
+      if (slot < displayData->ClientTargets.size()) {
+        entry = &displayData->ClientTargets[slot];
+      }
+      break;
+    case BufferCache::OUTPUT_BUFFERS:
+      if (slot < displayData->OutputBuffers.size()) {
+        entry = &displayData->OutputBuffers[slot];
+      }
+      break;
+    case BufferCache::LAYER_BUFFERS: {
+      auto ly = displayData->Layers.find(layer);
+      if (ly == displayData->Layers.end()) {
+        return Error::BadLayer;
+      }
+      if (slot < ly->second.Buffers.size()) {
+        entry = &ly->second.Buffers[slot];
+      }
+    } break;
+    case BufferCache::LAYER_SIDEBAND_STREAMS: {
+      auto ly = displayData->Layers.find(layer);
+      if (ly == displayData->Layers.end()) {
+        return Error::BadLayer;
+      }
+      if (slot == 0) {
+        entry = &ly->second.SidebandStream;
+      }
+    } break;
+    default:
+      break;
+  }
+
+  if (!entry) {
+    ALOGW("%s: Invalid buffer slot %" PRIu32, __FUNCTION__, slot);
+    return Error::BadParameter;
+  }
+
+  *outEntry = entry;
+
+  return Error::None;
+}
+
+Error CommandEngine::lookupBuffer(int64_t display, int64_t layer,
+                                                      BufferCache cache, uint32_t slot,
+                                                      bool useCache, buffer_handle_t handle,
+                                                      buffer_handle_t *outHandle) {
+  if (useCache) {
+    std::lock_guard<std::mutex> lock(mDisplayDataMutex);
+
+    BufferCacheEntry *entry;
+    Error error = lookupBufferCacheEntryLocked(display, layer, cache, slot, &entry);
+    if (error != Error::None) {
+      return error;
+    }
+
+    // input handle is ignored
+    *outHandle = entry->getHandle();
+  } else if (cache == BufferCache::LAYER_SIDEBAND_STREAMS) {
+    if (handle) {
+      *outHandle = native_handle_clone(handle);
+      if (*outHandle == nullptr) {
+        return Error::NoResources;
+      }
+    }
+  } else {
+    if (!mHandleImporter.importBuffer(handle)) {
+      return Error::NoResources;
+    }
+
+    *outHandle = handle;
+  }
+
+  return Error::None;
+}
+
+Error CommandEngine::updateBuffer(int64_t display, int64_t layer,
+                                                      BufferCache cache, uint32_t slot,
+                                                      bool useCache, buffer_handle_t handle) {
+  // handle was looked up from cache
+  if (useCache) {
+    return Error::None;
+  }
+
+  std::lock_guard<std::mutex> lock(mDisplayDataMutex);
+
+  BufferCacheEntry *entry = nullptr;
+  Error error = lookupBufferCacheEntryLocked(display, layer, cache, slot, &entry);
+  if (error != Error::None) {
+    return error;
+  }
+
+  *entry = handle;
+  return Error::None;
+}
+
+}  // namespace composer3
+}  // namespace display
+}  // namespace hardware
+}  // namespace qti
+}  // namespace vendor
+}  // namespace aidl
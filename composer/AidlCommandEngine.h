@@ -0,0 +1,263 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Copyright (c) 2022-2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#pragma once
+
+#include <log/log.h>
+#include <aidl/vendor/qti/hardware/display/composer3/BnQtiComposer3Client.h>
+#include <aidl/android/hardware/graphics/composer3/BnComposerClient.h>
+#include <aidlcommonsupport/NativeHandle.h>
+#include <utils/constants.h>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+#include "hwc_command_session.h"
+#include "AidlComposerHandleImporter.h"
+#include "AidlComposerServiceWriter.h"
+
+namespace aidl {
+namespace vendor {
+namespace qti {
+namespace hardware {
+namespace display {
+namespace composer3 {
+
+using aidl::android::hardware::common::NativeHandle;
+using aidl::android::hardware::graphics::common::FRect;
+using aidl::android::hardware::graphics::common::Point;
+using aidl::android::hardware::graphics::common::Rect;
+using aidl::android::hardware::graphics::common::Transform;
+using aidl::android::hardware::graphics::composer3::Buffer;
+using aidl::android::hardware::graphics::composer3::ClientTarget;
+using aidl::android::hardware::graphics::composer3::ClockMonotonicTimestamp;
+using FColor = aidl::android::hardware::graphics::composer3::Color;
+using aidl::android::hardware::graphics::composer3::CommandResultPayload;
+using aidl::android::hardware::graphics::composer3::DimmingStage;
+using aidl::android::hardware::graphics::composer3::DisplayBrightness;
+using aidl::android::hardware::graphics::composer3::DisplayCommand;
+using aidl::android::hardware::graphics::composer3::LayerBrightness;
+using aidl::android::hardware::graphics::composer3::ParcelableBlendMode;
+using aidl::android::hardware::graphics::composer3::ParcelableComposition;
+using aidl::android::hardware::graphics::composer3::ParcelableDataspace;
+using aidl::android::hardware::graphics::composer3::ParcelableTransform;
+using aidl::android::hardware::graphics::composer3::PerFrameMetadata;
+using aidl::android::hardware::graphics::composer3::PerFrameMetadataBlob;
+using aidl::android::hardware::graphics::composer3::PlaneAlpha;
+using aidl::android::hardware::graphics::composer3::ZOrder;
+
+using sdm::Fence;
+using sdm::HWC3::Error;
+using std::shared_ptr;
+
+class BufferCacheEntry {
+ public:
+  BufferCacheEntry();
+  BufferCacheEntry(BufferCacheEntry &&other);
+
+  BufferCacheEntry(const BufferCacheEntry &other) = delete;
+  BufferCacheEntry &operator=(const BufferCacheEntry &other) = delete;
+
+  BufferCacheEntry &operator=(buffer_handle_t handle);
+  ~BufferCacheEntry();
+
+  buffer_handle_t getHandle() const { return mHandle; }
+
+ private:
+  void clear();
+
+  buffer_handle_t mHandle;
+};
+
+// Imports and frees the buffers referenced by client commands, shared by all clients.
+extern ComposerHandleImporter mHandleImporter;
+
+struct LayerBuffers {
+  std::vector<BufferCacheEntry> Buffers;
+  // the handle is a sideband stream handle, not a buffer handle
+  BufferCacheEntry SidebandStream;
+};
+
+struct DisplayData {
+  bool IsVirtual;
+
+  std::vector<BufferCacheEntry> ClientTargets;
+  std::vector<BufferCacheEntry> OutputBuffers;
+
+  std::unordered_map<sdm::LayerId, LayerBuffers> Layers;
+
+  explicit DisplayData(bool isVirtual) : IsVirtual(isVirtual) {}
+};
+
+// Executes the command batches of a client against an HWCCommandSession. The display data map
+// and its mutex belong to the client, which creates and destroys displays and layers.
+class CommandEngine {
+ public:
+  CommandEngine(sdm::HWCCommandSession &session,
+                std::unordered_map<sdm::Display, DisplayData> &displayData,
+                std::mutex &displayDataMutex)
+      : mSession(session), mDisplayData(displayData), mDisplayDataMutex(displayDataMutex) {}
+  bool init();
+  Error execute(const std::vector<DisplayCommand> &in_commands,
+                std::vector<CommandResultPayload> *aidl_return);
+  Error qtiExecute(const std::vector<QtiDisplayCommand> &in_commands,
+                   std::vector<CommandResultPayload> *aidl_return);
+  Error validateDisplay(int64_t display);
+  Error presentDisplay(int64_t display, shared_ptr<Fence> *presentFence);
+
+  void reset() { mWriter->reset(); }
+
+ private:
+  template <typename field, typename... Args, typename... prototypeParams>
+  void ExecuteCommand(field &commandField, void (CommandEngine::*func)(prototypeParams...),
+                      Args &&...args) {
+    if ((static_cast<bool>(commandField))) {
+      (this->*func)(std::forward<Args>(args)...);
+    }
+  }
+  __attribute__((always_inline)) inline void writeError(const char *function, Error err) {
+    ALOGW("%s: error: %s", function, sdm::GetErrorName(err));
+    mWriter->setError(mCommandIndex, INT32(err));
+  }
+
+  // Commands from aidl::android::hardware::graphics::composer3::IComposerClient follow.
+  void executeSetColorTransform(int64_t display, const std::vector<float> &matrix);
+  void executeSetClientTarget(int64_t display, const ClientTarget &command);
+  void executeSetDisplayBrightness(uint64_t display, const DisplayBrightness &command);
+  void executeSetOutputBuffer(uint64_t display, const Buffer &buffer);
+  void executeValidateDisplay(int64_t display,
+                              const std::optional<ClockMonotonicTimestamp> expectedPresentTime);
+  void executePresentOrValidateDisplay(
+      int64_t display, const std::optional<ClockMonotonicTimestamp> expectedPresentTime);
+  void executeAcceptDisplayChanges(int64_t display);
+  void executePresentDisplay(int64_t display);
+
+  void executeSetLayerCursorPosition(int64_t display, int64_t layer, const Point &cursorPosition);
+  void executeSetLayerBuffer(int64_t display, int64_t layer, const Buffer &buffer);
+  void executeSetLayerSurfaceDamage(int64_t display, int64_t layer,
+                                    const std::vector<std::optional<Rect>> &damage);
+  void executeSetLayerBlendMode(int64_t display, int64_t layer,
+                                const ParcelableBlendMode &blendMode);
+  void executeSetLayerColor(int64_t display, int64_t layer, const FColor &color);
+  void executeSetLayerComposition(int64_t display, int64_t layer,
+                                  const ParcelableComposition &composition);
+  void executeSetLayerDataspace(int64_t display, int64_t layer,
+                                const ParcelableDataspace &dataspace);
+  void executeSetLayerDisplayFrame(int64_t display, int64_t layer, const Rect &rect);
+  void executeSetLayerPlaneAlpha(int64_t display, int64_t layer, const PlaneAlpha &planeAlpha);
+  void executeSetLayerSidebandStream(int64_t display, int64_t layer,
+                                     const NativeHandle &sidebandStream);
+  void executeSetLayerSourceCrop(int64_t display, int64_t layer, const FRect &sourceCrop);
+  void executeSetLayerTransform(int64_t display, int64_t layer,
+                                const ParcelableTransform &transform);
+  void executeSetLayerVisibleRegion(int64_t display, int64_t layer,
+                                    const std::vector<std::optional<Rect>> &visibleRegion);
+  void executeSetLayerZOrder(int64_t display, int64_t layer, const ZOrder &zOrder);
+  void executeSetLayerPerFrameMetadata(
+      int64_t display, int64_t layer,
+      const std::vector<std::optional<PerFrameMetadata>> &perFrameMetadata);
+  void executeSetLayerColorTransform(int64_t display, int64_t layer,
+                                     const std::vector<float> &colorTransform);
+  void executeSetLayerPerFrameMetadataBlobs(
+      int64_t display, int64_t layer,
+      const std::vector<std::optional<PerFrameMetadataBlob>> &perFrameMetadataBlob);
+  void executeSetLayerBrightness(int64_t display, int64_t layer,
+                                 const LayerBrightness &brightness);
+
+  void executeSetExpectedPresentTimeInternal(
+      int64_t display, const std::optional<ClockMonotonicTimestamp> expectedPresentTime);
+  void executeSetLayerBlockingRegion(int64_t display, int64_t layer,
+                                     const std::vector<std::optional<Rect>> &blockingRegion);
+
+  // Commands from extensions (QtiComposer3Client)
+  void executeSetClientTarget_3_1(int64_t display, const ClientTarget &command);
+  void executeSetDisplayElapseTime(int64_t display, uint64_t time);
+  void executeSetLayerType(int64_t display, int64_t layer, sdm::LayerType type);
+  void executeSetLayerFlag(int64_t display, int64_t layer, sdm::LayerFlag flag);
+
+  Rect readRect();
+  std::vector<Rect> readRegion(size_t count);
+  FRect readFRect();
+  sdm::HWCCommandSession &mSession;
+  // Owned by the client, guarded by mDisplayDataMutex.
+  std::unordered_map<sdm::Display, DisplayData> &mDisplayData;
+  std::mutex &mDisplayDataMutex;
+  std::unique_ptr<ComposerServiceWriter> mWriter;
+  int32_t mCommandIndex;
+
+  // Display data looked up during the current command batch. Entries can not be erased while
+  // a batch is executing, as erasing requires the client's m_command_mutex_, held by
+  // executeCommands.
+  DisplayData *getDisplayDataLocked(int64_t display);
+  void resetDisplayDataCache() {
+    mCachedDisplay = -1;
+    mCachedDisplayData = nullptr;
+  }
+  int64_t mCachedDisplay = -1;
+  DisplayData *mCachedDisplayData = nullptr;
+
+  // Scratch storage reused across command batches to keep steady state allocation free.
+  std::vector<sdm::LayerId> mLayers;
+  std::vector<shared_ptr<Fence>> mReleaseFences;
+  std::vector<::ndk::ScopedFileDescriptor> mAidlReleaseFences;
+  std::vector<sdm::LayerId> mChangedLayers;
+  std::vector<Composition> mCompositionTypes;
+  std::vector<sdm::LayerId> mRequestedLayers;
+  std::vector<int32_t> mRequestMasks;
+  std::vector<int32_t> mMetadataKeys;
+  std::vector<float> mMetadataValues;
+  std::vector<uint32_t> mMetadataBlobSizes;
+  std::vector<uint8_t> mMetadataBlobData;
+
+  // Buffer cache impl
+  enum class BufferCache {
+    CLIENT_TARGETS,
+    OUTPUT_BUFFERS,
+    LAYER_BUFFERS,
+    LAYER_SIDEBAND_STREAMS,
+  };
+
+  Error lookupBufferCacheEntryLocked(int64_t display, int64_t layer, BufferCache cache,
+                                     uint32_t slot, BufferCacheEntry **outEntry);
+  Error lookupBuffer(int64_t display, int64_t layer, BufferCache cache, uint32_t slot,
+                     bool useCache, buffer_handle_t handle, buffer_handle_t *outHandle);
+  Error updateBuffer(int64_t display, int64_t layer, BufferCache cache, uint32_t slot,
+                     bool useCache, buffer_handle_t handle);
+
+  Error lookupLayerSidebandStream(int64_t display, int64_t layer, buffer_handle_t handle,
+                                  buffer_handle_t *outHandle) {
+    return lookupBuffer(display, layer, BufferCache::LAYER_SIDEBAND_STREAMS, 0, false, handle,
+                        outHandle);
+  }
+  Error updateLayerSidebandStream(int64_t display, int64_t layer, buffer_handle_t handle) {
+    return updateBuffer(display, layer, BufferCache::LAYER_SIDEBAND_STREAMS, 0, false, handle);
+  }
+  Error postPresentDisplay(int64_t display, shared_ptr<Fence> *presentFence);
+  Error postValidateDisplay(int64_t display, uint32_t &types_count, uint32_t &reqs_count);
+};
+
+}  // namespace composer3
+}  // namespace display
+}  // namespace hardware
+}  // namespace qti
+}  // namespace vendor
+}  // namespace aidl
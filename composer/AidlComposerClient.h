@@ -29,8 +29,7 @@
 #include <aidl/android/hardware/graphics/composer3/BnComposerClient.h>
 #include <aidlcommonsupport/NativeHandle.h>
 #include "hwc_session.h"
-#include "AidlComposerHandleImporter.h"
-#include "AidlComposerServiceWriter.h"
+#include "AidlCommandEngine.h"
 
 namespace aidl {
 namespace vendor {
@@ -42,31 +41,18 @@ namespace composer3 {
 #define TO_BINDER_STATUS(x) \
   x == 0 ? ndk::ScopedAStatus::ok() : ndk::ScopedAStatus::fromServiceSpecificError(x)
 
-using aidl::android::hardware::common::NativeHandle;
 using aidl::android::hardware::graphics::common::AlphaInterpretation;
 using aidl::android::hardware::graphics::common::Dataspace;
 using aidl::android::hardware::graphics::common::DisplayDecorationSupport;
-using aidl::android::hardware::graphics::common::FRect;
 using aidl::android::hardware::graphics::common::Hdr;
 using aidl::android::hardware::graphics::common::HdrConversionCapability;
 using aidl::android::hardware::graphics::common::HdrConversionStrategy;
 using aidl::android::hardware::graphics::common::PixelFormat;
-using aidl::android::hardware::graphics::common::Point;
-using aidl::android::hardware::graphics::common::Rect;
-using aidl::android::hardware::graphics::common::Transform;
 using aidl::android::hardware::graphics::composer3::BnComposerClient;
-using aidl::android::hardware::graphics::composer3::Buffer;
-using aidl::android::hardware::graphics::composer3::ClientTarget;
-using aidl::android::hardware::graphics::composer3::ClockMonotonicTimestamp;
-using FColor = aidl::android::hardware::graphics::composer3::Color;
 using aidl::android::hardware::graphics::composer3::ColorMode;
-using aidl::android::hardware::graphics::composer3::CommandResultPayload;
 using aidl::android::hardware::graphics::composer3::ContentType;
-using aidl::android::hardware::graphics::composer3::DimmingStage;
 using aidl::android::hardware::graphics::composer3::DisplayAttribute;
-using aidl::android::hardware::graphics::composer3::DisplayBrightness;
 using aidl::android::hardware::graphics::composer3::DisplayCapability;
-using aidl::android::hardware::graphics::composer3::DisplayCommand;
 using aidl::android::hardware::graphics::composer3::DisplayConnectionType;
 using aidl::android::hardware::graphics::composer3::DisplayContentSample;
 using aidl::android::hardware::graphics::composer3::DisplayContentSamplingAttributes;
@@ -74,50 +60,19 @@ using aidl::android::hardware::graphics::composer3::DisplayIdentification;
 using aidl::android::hardware::graphics::composer3::FormatColorComponent;
 using aidl::android::hardware::graphics::composer3::HdrCapabilities;
 using aidl::android::hardware::graphics::composer3::IComposerCallback;
-using aidl::android::hardware::graphics::composer3::LayerBrightness;
 using aidl::android::hardware::graphics::composer3::OverlayProperties;
-using aidl::android::hardware::graphics::composer3::ParcelableBlendMode;
-using aidl::android::hardware::graphics::composer3::ParcelableComposition;
-using aidl::android::hardware::graphics::composer3::ParcelableDataspace;
-using aidl::android::hardware::graphics::composer3::ParcelableTransform;
-using aidl::android::hardware::graphics::composer3::PerFrameMetadata;
-using aidl::android::hardware::graphics::composer3::PerFrameMetadataBlob;
 using aidl::android::hardware::graphics::composer3::PerFrameMetadataKey;
-using aidl::android::hardware::graphics::composer3::PlaneAlpha;
 using aidl::android::hardware::graphics::composer3::PowerMode;
 using aidl::android::hardware::graphics::composer3::ReadbackBufferAttributes;
 using aidl::android::hardware::graphics::composer3::RenderIntent;
 using aidl::android::hardware::graphics::composer3::VirtualDisplay;
 using aidl::android::hardware::graphics::composer3::VsyncPeriodChangeConstraints;
 using aidl::android::hardware::graphics::composer3::VsyncPeriodChangeTimeline;
-using aidl::android::hardware::graphics::composer3::ZOrder;
 using ::android::hardware::hidl_handle;
 using ndk::ScopedAStatus;
 using ndk::SpAIBinder;
 
-using sdm::Fence;
 using sdm::HWCSession;
-using sdm::HWC3::Error;
-using std::shared_ptr;
-
-class BufferCacheEntry {
- public:
-  BufferCacheEntry();
-  BufferCacheEntry(BufferCacheEntry &&other);
-
-  BufferCacheEntry(const BufferCacheEntry &other) = delete;
-  BufferCacheEntry &operator=(const BufferCacheEntry &other) = delete;
-
-  BufferCacheEntry &operator=(buffer_handle_t handle);
-  ~BufferCacheEntry();
-
-  buffer_handle_t getHandle() const { return mHandle; }
-
- private:
-  void clear();
-
-  buffer_handle_t mHandle;
-};
 
 class AidlComposerClient : public BnComposerClient {
  public:
@@ -229,138 +184,6 @@ class AidlComposerClient : public BnComposerClient {
   SpAIBinder createBinder() override;
 
  private:
-  struct LayerBuffers {
-    std::vector<BufferCacheEntry> Buffers;
-    // the handle is a sideband stream handle, not a buffer handle
-    BufferCacheEntry SidebandStream;
-  };
-
-  struct DisplayData {
-    bool IsVirtual;
-
-    std::vector<BufferCacheEntry> ClientTargets;
-    std::vector<BufferCacheEntry> OutputBuffers;
-
-    std::unordered_map<sdm::LayerId, LayerBuffers> Layers;
-
-    explicit DisplayData(bool isVirtual) : IsVirtual(isVirtual) {}
-  };
-
-  class CommandEngine {
-   public:
-    CommandEngine(AidlComposerClient &client) : mClient(client){};
-    bool init();
-    Error execute(const std::vector<DisplayCommand> &in_commands,
-                  std::vector<CommandResultPayload> *aidl_return);
-    Error qtiExecute(const std::vector<QtiDisplayCommand> &in_commands,
-                     std::vector<CommandResultPayload> *aidl_return);
-    Error validateDisplay(int64_t display);
-    Error presentDisplay(int64_t display, shared_ptr<Fence> *presentFence);
-
-    void reset() { mWriter->reset(); }
-
-   private:
-    template <typename field, typename... Args, typename... prototypeParams>
-    void ExecuteCommand(field &commandField, void (CommandEngine::*func)(prototypeParams...),
-                        Args &&...args) {
-      if ((static_cast<bool>(commandField))) {
-        (this->*func)(std::forward<Args>(args)...);
-      }
-    }
-    __attribute__((always_inline)) inline void writeError(std::string function, Error err) {
-      ALOGW("%s: error: %s", function.c_str(), sdm::to_string(err).c_str());
-      mWriter->setError(mCommandIndex, INT32(err));
-    }
-
-    // Commands from aidl::android::hardware::graphics::composer3::IComposerClient follow.
-    void executeSetColorTransform(int64_t display, const std::vector<float> &matrix);
-    void executeSetClientTarget(int64_t display, const ClientTarget &command);
-    void executeSetDisplayBrightness(uint64_t display, const DisplayBrightness &command);
-    void executeSetOutputBuffer(uint64_t display, const Buffer &buffer);
-    void executeValidateDisplay(int64_t display,
-                                const std::optional<ClockMonotonicTimestamp> expectedPresentTime);
-    void executePresentOrValidateDisplay(
-        int64_t display, const std::optional<ClockMonotonicTimestamp> expectedPresentTime);
-    void executeAcceptDisplayChanges(int64_t display);
-    void executePresentDisplay(int64_t display);
-
-    void executeSetLayerCursorPosition(int64_t display, int64_t layer, const Point &cursorPosition);
-    void executeSetLayerBuffer(int64_t display, int64_t layer, const Buffer &buffer);
-    void executeSetLayerSurfaceDamage(int64_t display, int64_t layer,
-                                      const std::vector<std::optional<Rect>> &damage);
-    void executeSetLayerBlendMode(int64_t display, int64_t layer,
-                                  const ParcelableBlendMode &blendMode);
-    void executeSetLayerColor(int64_t display, int64_t layer, const FColor &color);
-    void executeSetLayerComposition(int64_t display, int64_t layer,
-                                    const ParcelableComposition &composition);
-    void executeSetLayerDataspace(int64_t display, int64_t layer,
-                                  const ParcelableDataspace &dataspace);
-    void executeSetLayerDisplayFrame(int64_t display, int64_t layer, const Rect &rect);
-    void executeSetLayerPlaneAlpha(int64_t display, int64_t layer, const PlaneAlpha &planeAlpha);
-    void executeSetLayerSidebandStream(int64_t display, int64_t layer,
-                                       const NativeHandle &sidebandStream);
-    void executeSetLayerSourceCrop(int64_t display, int64_t layer, const FRect &sourceCrop);
-    void executeSetLayerTransform(int64_t display, int64_t layer,
-                                  const ParcelableTransform &transform);
-    void executeSetLayerVisibleRegion(int64_t display, int64_t layer,
-                                      const std::vector<std::optional<Rect>> &visibleRegion);
-    void executeSetLayerZOrder(int64_t display, int64_t layer, const ZOrder &zOrder);
-    void executeSetLayerPerFrameMetadata(
-        int64_t display, int64_t layer,
-        const std::vector<std::optional<PerFrameMetadata>> &perFrameMetadata);
-    void executeSetLayerColorTransform(int64_t display, int64_t layer,
-                                       const std::vector<float> &colorTransform);
-    void executeSetLayerPerFrameMetadataBlobs(
-        int64_t display, int64_t layer,
-        const std::vector<std::optional<PerFrameMetadataBlob>> &perFrameMetadataBlob);
-    void executeSetLayerBrightness(int64_t display, int64_t layer,
-                                   const LayerBrightness &brightness);
-
-    void executeSetExpectedPresentTimeInternal(
-        int64_t display, const std::optional<ClockMonotonicTimestamp> expectedPresentTime);
-    void executeSetLayerBlockingRegion(int64_t display, int64_t layer,
-                                       const std::vector<std::optional<Rect>> &blockingRegion);
-
-    // Commands from extensions (QtiComposer3Client)
-    void executeSetClientTarget_3_1(int64_t display, const ClientTarget &command);
-    void executeSetDisplayElapseTime(int64_t display, uint64_t time);
-    void executeSetLayerType(int64_t display, int64_t layer, sdm::LayerType type);
-    void executeSetLayerFlag(int64_t display, int64_t layer, sdm::LayerFlag flag);
-
-    Rect readRect();
-    std::vector<Rect> readRegion(size_t count);
-    FRect readFRect();
-    AidlComposerClient &mClient;
-    std::unique_ptr<ComposerServiceWriter> mWriter;
-    int32_t mCommandIndex;
-
-    // Buffer cache impl
-    enum class BufferCache {
-      CLIENT_TARGETS,
-      OUTPUT_BUFFERS,
-      LAYER_BUFFERS,
-      LAYER_SIDEBAND_STREAMS,
-    };
-
-    Error lookupBufferCacheEntryLocked(int64_t display, int64_t layer, BufferCache cache,
-                                       uint32_t slot, BufferCacheEntry **outEntry);
-    Error lookupBuffer(int64_t display, int64_t layer, BufferCache cache, uint32_t slot,
-                       bool useCache, buffer_handle_t handle, buffer_handle_t *outHandle);
-    Error updateBuffer(int64_t display, int64_t layer, BufferCache cache, uint32_t slot,
-                       bool useCache, buffer_handle_t handle);
-
-    Error lookupLayerSidebandStream(int64_t display, int64_t layer, buffer_handle_t handle,
-                                    buffer_handle_t *outHandle) {
-      return lookupBuffer(display, layer, BufferCache::LAYER_SIDEBAND_STREAMS, 0, false, handle,
-                          outHandle);
-    }
-    Error updateLayerSidebandStream(int64_t display, int64_t layer, buffer_handle_t handle) {
-      return updateBuffer(display, layer, BufferCache::LAYER_SIDEBAND_STREAMS, 0, false, handle);
-    }
-    Error postPresentDisplay(int64_t display, shared_ptr<Fence> *presentFence);
-    Error postValidateDisplay(int64_t display, uint32_t &types_count, uint32_t &reqs_count);
-  };
-
   HWCSession *hwc_session_ = nullptr;
   std::shared_ptr<IComposerCallback> callback_ = nullptr;
   std::mutex m_command_mutex_;
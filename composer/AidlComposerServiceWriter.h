@@ -29,6 +29,7 @@
 #include <string.h>
 
 #include <algorithm>
+#include <iterator>
 #include <limits>
 #include <memory>
 #include <vector>
@@ -42,6 +43,7 @@ namespace composer3 {
 
 using aidl::android::hardware::graphics::composer3::ChangedCompositionLayer;
 using aidl::android::hardware::graphics::composer3::ChangedCompositionTypes;
+using aidl::android::hardware::graphics::composer3::ClientTargetProperty;
 using aidl::android::hardware::graphics::composer3::ClientTargetPropertyWithBrightness;
 using aidl::android::hardware::graphics::composer3::CommandError;
 using aidl::android::hardware::graphics::composer3::CommandResultPayload;
@@ -112,18 +114,21 @@ class ComposerServiceWriter {
     }
   }
 
+  // Release fence descriptors are moved out, so that caller can reuse the fence vector storage.
   void setReleaseFences(int64_t display, const std::vector<int64_t> &layers,
-                        std::vector<::ndk::ScopedFileDescriptor> releaseFences) {
+                        std::vector<::ndk::ScopedFileDescriptor> *releaseFences) {
     ReleaseFences releaseFencesCommand;
     releaseFencesCommand.display = display;
+    releaseFencesCommand.layers.reserve(layers.size());
     for (int i = 0; i < layers.size(); i++) {
-      if (releaseFences[i].get() >= 0) {
+      auto &releaseFence = releaseFences->at(i);
+      if (releaseFence.get() >= 0) {
         ReleaseFences::Layer layer;
         layer.layer = layers[i];
-        layer.fence = std::move(releaseFences[i]);
+        layer.fence = std::move(releaseFence);
         releaseFencesCommand.layers.emplace_back(std::move(layer));
       } else {
-        ALOGV("%s: Invalid release fence %d", __FUNCTION__, releaseFences[i].get());
+        ALOGV("%s: Invalid release fence %d", __FUNCTION__, releaseFence.get());
       }
     }
     mCommandsResults.emplace_back(std::move(releaseFencesCommand));
@@ -139,8 +144,12 @@ class ComposerServiceWriter {
     mCommandsResults.emplace_back(std::move(clientTargetPropertyWithBrightness));
   }
 
-  std::vector<CommandResultPayload> getPendingCommandResults() {
-    return std::move(mCommandsResults);
+  // Results are moved element wise into the binder reply, so that the pending vector keeps its
+  // capacity and later batches do not regrow it for every command result.
+  void getPendingCommandResults(std::vector<CommandResultPayload> *results) {
+    results->assign(std::make_move_iterator(mCommandsResults.begin()),
+                    std::make_move_iterator(mCommandsResults.end()));
+    mCommandsResults.clear();
   }
 
  private:
@@ -0,0 +1,286 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+// Measures the AIDL command engine, i.e. command dispatch and result writing, against a session
+// which accepts every call, so nothing below the engine runs.
+
+#include <android/log.h>
+#include <gtest/gtest.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <memory>
+#include <mutex>   // NOLINT
+#include <new>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "AidlCommandEngine.h"
+
+namespace {
+
+std::atomic<uint64_t> g_allocations(0);
+
+}  // namespace
+
+void *operator new(size_t size) {
+  g_allocations.fetch_add(1, std::memory_order_relaxed);
+  void *ptr = malloc(size ? size : 1);
+  if (!ptr) {
+    abort();
+  }
+  return ptr;
+}
+
+void operator delete(void *ptr) noexcept {
+  free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept {
+  free(ptr);
+}
+
+namespace aidl {
+namespace vendor {
+namespace qti {
+namespace hardware {
+namespace display {
+namespace composer3 {
+namespace {
+
+using aidl::android::hardware::graphics::common::BlendMode;
+using aidl::android::hardware::graphics::common::Dataspace;
+using aidl::android::hardware::graphics::composer3::CommandError;
+using aidl::android::hardware::graphics::composer3::LayerCommand;
+using sdm::Display;
+using sdm::LayerId;
+
+// Accepts every call, except z order updates of bad_layer_ which fail so that the error path of
+// the engine can be measured as well.
+class BenchmarkSession : public sdm::HWCCommandSession {
+ public:
+  Error AcceptDisplayChanges(Display display) override { return Error::None; }
+  Error CommitOrPrepare(Display display, bool validate_only, shared_ptr<Fence> *out_retire_fence,
+                        uint32_t *out_num_types, uint32_t *out_num_requests,
+                        bool *needs_commit) override {
+    *out_num_types = 0;
+    *out_num_requests = 0;
+    *needs_commit = false;
+    return Error::None;
+  }
+  Error PresentDisplay(Display display, shared_ptr<Fence> *out_retire_fence) override {
+    return Error::None;
+  }
+  Error GetChangedCompositionTypes(Display display, uint32_t *out_num_elements,
+                                   LayerId *out_layers, int32_t *out_types) override {
+    *out_num_elements = 0;
+    return Error::None;
+  }
+  Error GetDisplayRequests(Display display, int32_t *out_display_requests,
+                           uint32_t *out_num_elements, LayerId *out_layers,
+                           int32_t *out_layer_requests) override {
+    *out_display_requests = 0;
+    *out_num_elements = 0;
+    return Error::None;
+  }
+  Error GetReleaseFences(Display display, uint32_t *out_num_elements, LayerId *out_layers,
+                         std::vector<shared_ptr<Fence>> *out_fences) override {
+    *out_num_elements = 0;
+    return Error::None;
+  }
+  Error GetClientTargetProperty(Display display,
+                                sdm::HwcClientTargetProperty *outClientTargetProperty) override {
+    return Error::None;
+  }
+  Error SetClientTarget(Display display, buffer_handle_t target, shared_ptr<Fence> acquire_fence,
+                        int32_t dataspace, sdm::Region damage) override {
+    return Error::None;
+  }
+  Error SetClientTarget_3_1(Display display, buffer_handle_t target,
+                            shared_ptr<Fence> acquire_fence, int32_t dataspace,
+                            sdm::Region damage) override {
+    return Error::None;
+  }
+  Error SetOutputBuffer(Display display, buffer_handle_t buffer,
+                        const shared_ptr<Fence> &release_fence) override {
+    return Error::None;
+  }
+  Error SetColorTransform(Display display, const std::vector<float> &matrix) override {
+    return Error::None;
+  }
+  Error SetCursorPosition(Display display, LayerId layer, int32_t x, int32_t y) override {
+    return Error::None;
+  }
+  Error SetDisplayBrightness(Display display, float brightness) override { return Error::None; }
+  Error SetDisplayElapseTime(Display display, uint64_t time) override { return Error::None; }
+  Error SetExpectedPresentTime(Display display, uint64_t expectedPresentTime) override {
+    return Error::None;
+  }
+  Error SetLayerBuffer(Display display, LayerId layer, buffer_handle_t buffer,
+                       const shared_ptr<Fence> &acquire_fence) override {
+    return Error::None;
+  }
+  Error SetLayerBlendMode(Display display, LayerId layer, int32_t int_mode) override {
+    return Error::None;
+  }
+  Error SetLayerDisplayFrame(Display display, LayerId layer, Rect frame) override {
+    return Error::None;
+  }
+  Error SetLayerPlaneAlpha(Display display, LayerId layer, float alpha) override {
+    return Error::None;
+  }
+  Error SetLayerSourceCrop(Display display, LayerId layer, FRect crop) override {
+    return Error::None;
+  }
+  Error SetLayerTransform(Display display, LayerId layer, Transform transform) override {
+    return Error::None;
+  }
+  Error SetLayerZOrder(Display display, LayerId layer, uint32_t z) override {
+    return (layer == bad_layer_) ? Error::BadLayer : Error::None;
+  }
+  Error SetLayerType(Display display, LayerId layer, sdm::LayerType type) override {
+    return Error::None;
+  }
+  Error SetLayerFlag(Display display, LayerId layer, sdm::LayerFlag flag) override {
+    return Error::None;
+  }
+  Error SetLayerSurfaceDamage(Display display, LayerId layer, sdm::Region damage) override {
+    return Error::None;
+  }
+  Error SetLayerVisibleRegion(Display display, LayerId layer, sdm::Region damage) override {
+    return Error::None;
+  }
+  Error SetLayerCompositionType(Display display, LayerId layer, int32_t int_type) override {
+    return Error::None;
+  }
+  Error SetLayerColor(Display display, LayerId layer, sdm::Color color) override {
+    return Error::None;
+  }
+  Error SetLayerDataspace(Display display, LayerId layer, int32_t dataspace) override {
+    return Error::None;
+  }
+  Error SetLayerPerFrameMetadata(Display display, LayerId layer, uint32_t num_elements,
+                                 const int32_t *int_keys, const float *metadata) override {
+    return Error::None;
+  }
+  Error SetLayerColorTransform(Display display, LayerId layer, const float *matrix) override {
+    return Error::None;
+  }
+  Error SetLayerPerFrameMetadataBlobs(Display display, LayerId layer, uint32_t num_elements,
+                                      const int32_t *int_keys, const uint32_t *sizes,
+                                      const uint8_t *metadata) override {
+    return Error::None;
+  }
+  Error SetLayerBrightness(Display display, LayerId layer, float brightness) override {
+    return Error::None;
+  }
+
+  LayerId bad_layer_ = -1;
+};
+
+const int64_t kDisplay = 0;
+const uint32_t kLayerCount = 16;
+const uint32_t kBatches = 20000;
+// Layer commands set in every LayerCommand by GetCommands(), plus presentOrValidateDisplay.
+const uint32_t kLayerCommandCount = 9;
+
+// One frame of a typical SurfaceFlinger update: geometry and state for every layer, then
+// present or validate.
+std::vector<DisplayCommand> GetCommands() {
+  std::vector<DisplayCommand> commands(1);
+  DisplayCommand &command = commands[0];
+  command.display = kDisplay;
+  command.presentOrValidateDisplay = true;
+  command.layers.resize(kLayerCount);
+  for (uint32_t i = 0; i < kLayerCount; i++) {
+    LayerCommand &layer = command.layers[i];
+    int32_t top = INT32(i) * 100;
+    layer.layer = i;
+    layer.displayFrame = Rect{.left = 0, .top = top, .right = 1080, .bottom = top + 100};
+    layer.sourceCrop = FRect{.left = 0.0f, .top = 0.0f, .right = 1080.0f, .bottom = 100.0f};
+    layer.z = ZOrder{.z = INT32(i)};
+    layer.planeAlpha = PlaneAlpha{.alpha = 1.0f};
+    layer.composition = ParcelableComposition{.composition = Composition::DEVICE};
+    layer.dataspace = ParcelableDataspace{.dataspace = Dataspace::SRGB};
+    layer.transform = ParcelableTransform{.transform = Transform::NONE};
+    layer.blendMode = ParcelableBlendMode{.blendMode = BlendMode::PREMULTIPLIED};
+    layer.damage = std::vector<std::optional<Rect>>{Rect{0, 0, 1080, 100}};
+  }
+  return commands;
+}
+
+class CommandEngineBenchmark : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    // The error batches would otherwise log a warning each.
+    __android_log_set_minimum_priority(ANDROID_LOG_ERROR);
+    display_data_.emplace(kDisplay, DisplayData(false));
+    engine_ = std::make_unique<CommandEngine>(session_, display_data_, display_data_mutex_);
+    ASSERT_TRUE(engine_->init());
+  }
+
+  // Runs kBatches batches and prints commands per second. Once the scratch storage has grown
+  // during warm up, a batch must not allocate.
+  void Run(const char *name, const std::vector<DisplayCommand> &commands,
+           std::vector<CommandResultPayload> *results) {
+    ASSERT_EQ(engine_->execute(commands, results), Error::None);
+
+    uint64_t allocations = g_allocations.load();
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < kBatches; i++) {
+      results->clear();
+      engine_->execute(commands, results);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    allocations = g_allocations.load() - allocations;
+
+    double command_count = double(kBatches) * (kLayerCount * kLayerCommandCount + 1);
+    printf("%s: %.0f commands/s\n", name, command_count / elapsed.count());
+    EXPECT_EQ(allocations, 0u);
+  }
+
+  BenchmarkSession session_;
+  std::unordered_map<sdm::Display, DisplayData> display_data_;
+  std::mutex display_data_mutex_;
+  std::unique_ptr<CommandEngine> engine_;
+};
+
+}  // namespace
+
+TEST_F(CommandEngineBenchmark, LayerUpdates) {
+  auto commands = GetCommands();
+  std::vector<CommandResultPayload> results;
+  Run("LayerUpdates", commands, &results);
+
+  // Presented, with the empty release fence list of the session.
+  ASSERT_EQ(results.size(), 2u);
+  ASSERT_EQ(results[0].getTag(), CommandResultPayload::presentOrValidateResult);
+  EXPECT_EQ(results[0].get<CommandResultPayload::presentOrValidateResult>().result,
+            PresentOrValidate::Result::Presented);
+  EXPECT_EQ(results[1].getTag(), CommandResultPayload::releaseFences);
+}
+
+TEST_F(CommandEngineBenchmark, LayerUpdatesWithError) {
+  auto commands = GetCommands();
+  session_.bad_layer_ = kLayerCount / 2;
+  std::vector<CommandResultPayload> results;
+  Run("LayerUpdatesWithError", commands, &results);
+
+  ASSERT_EQ(results.size(), 3u);
+  ASSERT_EQ(results[0].getTag(), CommandResultPayload::error);
+  const CommandError &error = results[0].get<CommandResultPayload::error>();
+  EXPECT_EQ(error.commandIndex, 0);
+  EXPECT_EQ(error.errorCode, INT32(Error::BadLayer));
+  EXPECT_EQ(results[1].getTag(), CommandResultPayload::presentOrValidateResult);
+}
+
+}  // namespace composer3
+}  // namespace display
+}  // namespace hardware
+}  // namespace qti
+}  // namespace vendor
+}  // namespace aidl
@@ -0,0 +1,356 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <errno.h>
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
+#include "cpu_color_convert.h"
+
+namespace sdm {
+
+namespace {
+
+// GCC and Clang vector extensions, lowered to NEON on device and SSE on hosts.
+typedef int32_t int32x8 __attribute__((vector_size(32)));
+typedef uint32_t uint32x8 __attribute__((vector_size(32)));
+typedef int32_t int32x4 __attribute__((vector_size(16)));
+typedef uint32_t uint32x4 __attribute__((vector_size(16)));
+typedef uint64_t uint64x4 __attribute__((vector_size(32)));
+typedef uint8_t uint8x8 __attribute__((vector_size(8)));
+typedef uint16_t uint16x8 __attribute__((vector_size(16)));
+typedef uint16_t uint16x4 __attribute__((vector_size(8)));
+
+typedef CpuColorConvert::Coefficients Coefficients;
+
+const int kShift = Coefficients::kShift;
+// Chroma is computed from the sum of a 2x2 block.
+const int kChromaShift = kShift + 2;
+// P010 keeps its 10 bit samples in the high bits.
+const int kP010Shift = 6;
+
+constexpr uint32_t ChannelMask(CpuColorConvert::SourceFormat format) {
+  return (format == CpuColorConvert::kSourceRGBA8888) ? 0xff : 0x3ff;
+}
+
+constexpr uint32_t ChannelBits(CpuColorConvert::SourceFormat format) {
+  return (format == CpuColorConvert::kSourceRGBA8888) ? 8 : 10;
+}
+
+inline int32x4 Clamp(int32x4 v, int32_t max) {
+  int32x4 zero = {};
+  int32x4 high = int32x4{} + max;
+  v &= (v > zero);
+  int32x4 over = (v > high);
+  return (v & ~over) | (high & over);
+}
+
+inline int32_t Clamp(int32_t v, int32_t max) {
+  return std::min(std::max(v, 0), max);
+}
+
+// Splits one pixel in its color channels.
+template <CpuColorConvert::SourceFormat kSource>
+inline void Unpack(uint32_t pixel, int32_t rgb[3]) {
+  const uint32_t mask = ChannelMask(kSource);
+  const uint32_t bits = ChannelBits(kSource);
+  rgb[0] = int32_t(pixel & mask);
+  rgb[1] = int32_t((pixel >> bits) & mask);
+  rgb[2] = int32_t((pixel >> (2 * bits)) & mask);
+}
+
+inline int32_t Dot(const int32_t coeff[3], const int32_t rgb[3]) {
+  return coeff[0] * rgb[0] + coeff[1] * rgb[1] + coeff[2] * rgb[2];
+}
+
+// Sum of the channel at bit position shift of the two pixels packed in each 64 bit lane. Relies
+// on the little endian layout of every target, the left pixel is in the low half.
+template <CpuColorConvert::SourceFormat kSource>
+inline int32x4 PairSum(const uint64x4 &pixels, uint32_t shift) {
+  const uint64_t mask = ChannelMask(kSource);
+  uint64x4 sum = ((pixels >> shift) & mask) + ((pixels >> (shift + 32)) & mask);
+  return __builtin_convertvector(sum, int32x4);
+}
+
+template <CpuColorConvert::SourceFormat kSource, CpuColorConvert::TargetFormat kTarget>
+void ConvertLumaRow(const uint32_t *src, uint8_t *dst, uint32_t width, const Coefficients &c) {
+  const uint32_t mask = ChannelMask(kSource);
+  const uint32_t bits = ChannelBits(kSource);
+  const int32x8 kr = int32x8{} + c.y[0];
+  const int32x8 kg = int32x8{} + c.y[1];
+  const int32x8 kb = int32x8{} + c.y[2];
+  const int32x8 bias = int32x8{} + ((c.y_offset << kShift) + (1 << (kShift - 1)));
+  uint32_t x = 0;
+
+  // Y coefficients are positive and sum up to the scale, no clamping needed.
+  for (; x + 8 <= width; x += 8) {
+    uint32x8 pixels;
+    memcpy(&pixels, src + x, sizeof(pixels));
+    int32x8 r = (int32x8)(pixels & mask);
+    int32x8 g = (int32x8)((pixels >> bits) & mask);
+    int32x8 b = (int32x8)((pixels >> (2 * bits)) & mask);
+    int32x8 y = (kr * r + kg * g + kb * b + bias) >> kShift;
+
+    if (kTarget == CpuColorConvert::kTargetNV12) {
+      uint8x8 out = __builtin_convertvector(y, uint8x8);
+      memcpy(dst + x, &out, sizeof(out));
+    } else {
+      uint16x8 out = __builtin_convertvector(y << kP010Shift, uint16x8);
+      memcpy(dst + x * 2, &out, sizeof(out));
+    }
+  }
+
+  for (; x < width; x++) {
+    int32_t rgb[3];
+    Unpack<kSource>(src[x], rgb);
+    int32_t y = (Dot(c.y, rgb) + (c.y_offset << kShift) + (1 << (kShift - 1))) >> kShift;
+
+    if (kTarget == CpuColorConvert::kTargetNV12) {
+      dst[x] = uint8_t(y);
+    } else {
+      uint16_t out = uint16_t(y << kP010Shift);
+      memcpy(dst + x * 2, &out, sizeof(out));
+    }
+  }
+}
+
+template <CpuColorConvert::SourceFormat kSource, CpuColorConvert::TargetFormat kTarget>
+void ConvertChromaRow(const uint32_t *src0, const uint32_t *src1, uint8_t *dst, uint32_t width,
+                      const Coefficients &c) {
+  const uint32_t bits = ChannelBits(kSource);
+  const int32x4 ur = int32x4{} + c.u[0];
+  const int32x4 ug = int32x4{} + c.u[1];
+  const int32x4 ub = int32x4{} + c.u[2];
+  const int32x4 vr = int32x4{} + c.v[0];
+  const int32x4 vg = int32x4{} + c.v[1];
+  const int32x4 vb = int32x4{} + c.v[2];
+  const int32_t bias = (c.c_offset << kChromaShift) + (1 << (kChromaShift - 1));
+  const int32x4 vbias = int32x4{} + bias;
+  uint32_t x = 0;
+
+  // Eight pixels of two rows give four chroma samples.
+  for (; x + 8 <= width; x += 8) {
+    uint64x4 pixels0, pixels1;
+    memcpy(&pixels0, src0 + x, sizeof(pixels0));
+    memcpy(&pixels1, src1 + x, sizeof(pixels1));
+    int32x4 r = PairSum<kSource>(pixels0, 0) + PairSum<kSource>(pixels1, 0);
+    int32x4 g = PairSum<kSource>(pixels0, bits) + PairSum<kSource>(pixels1, bits);
+    int32x4 b = PairSum<kSource>(pixels0, 2 * bits) + PairSum<kSource>(pixels1, 2 * bits);
+    int32x4 u = Clamp((ur * r + ug * g + ub * b + vbias) >> kChromaShift, c.max);
+    int32x4 v = Clamp((vr * r + vg * g + vb * b + vbias) >> kChromaShift, c.max);
+
+    if (kTarget == CpuColorConvert::kTargetNV12) {
+      uint16x4 out = __builtin_convertvector(u | (v << 8), uint16x4);
+      memcpy(dst + x, &out, sizeof(out));
+    } else {
+      uint32x4 out = (__builtin_convertvector(u, uint32x4) << kP010Shift) |
+                     (__builtin_convertvector(v, uint32x4) << (kP010Shift + 16));
+      memcpy(dst + x * 2, &out, sizeof(out));
+    }
+  }
+
+  for (; x < width; x += 2) {
+    uint32_t x1 = std::min(x + 1, width - 1);
+    int32_t sum[3] = {};
+    for (const uint32_t pixel : {src0[x], src0[x1], src1[x], src1[x1]}) {
+      int32_t rgb[3];
+      Unpack<kSource>(pixel, rgb);
+      sum[0] += rgb[0];
+      sum[1] += rgb[1];
+      sum[2] += rgb[2];
+    }
+    int32_t u = Clamp((Dot(c.u, sum) + bias) >> kChromaShift, c.max);
+    int32_t v = Clamp((Dot(c.v, sum) + bias) >> kChromaShift, c.max);
+
+    if (kTarget == CpuColorConvert::kTargetNV12) {
+      dst[x] = uint8_t(u);
+      dst[x + 1] = uint8_t(v);
+    } else {
+      uint16_t out[2] = {uint16_t(u << kP010Shift), uint16_t(v << kP010Shift)};
+      memcpy(dst + x * 2, out, sizeof(out));
+    }
+  }
+}
+
+// Converts rows [first_row, last_row), first_row is even.
+template <CpuColorConvert::SourceFormat kSource, CpuColorConvert::TargetFormat kTarget>
+void ConvertBand(const CpuColorConvert::Source &src, const CpuColorConvert::Target &dst,
+                 uint32_t width, uint32_t height, uint32_t first_row, uint32_t last_row,
+                 const Coefficients &c) {
+  const uint8_t *src_base = static_cast<const uint8_t *>(src.data);
+  uint8_t *y_base = static_cast<uint8_t *>(dst.y);
+  uint8_t *uv_base = static_cast<uint8_t *>(dst.uv);
+
+  for (uint32_t row = first_row; row < last_row; row += 2) {
+    const uint32_t *src0 = reinterpret_cast<const uint32_t *>(src_base + row * src.stride);
+    const uint32_t *src1 = src0;
+    ConvertLumaRow<kSource, kTarget>(src0, y_base + row * dst.y_stride, width, c);
+    if (row + 1 < height) {
+      src1 = reinterpret_cast<const uint32_t *>(src_base + (row + 1) * src.stride);
+      ConvertLumaRow<kSource, kTarget>(src1, y_base + (row + 1) * dst.y_stride, width, c);
+    }
+    ConvertChromaRow<kSource, kTarget>(src0, src1, uv_base + (row / 2) * dst.uv_stride, width, c);
+  }
+}
+
+}  // namespace
+
+CpuColorConvert::Coefficients CpuColorConvert::GetCoefficients(SourceFormat src_format,
+                                                               TargetFormat dst_format,
+                                                               Standard standard, Range range) {
+  double kr = 0.299, kb = 0.114;
+  if (standard == kBT709) {
+    kr = 0.2126;
+    kb = 0.0722;
+  } else if (standard == kBT2020) {
+    kr = 0.2627;
+    kb = 0.0593;
+  }
+
+  int out_bits = (dst_format == kTargetNV12) ? 8 : 10;
+  int unit = 1 << (out_bits - 8);
+  double in_max = double((1 << ChannelBits(src_format)) - 1);
+  double y_scale = 0, c_scale = 0;
+  Coefficients c = {};
+  c.max = (1 << out_bits) - 1;
+  if (range == kRangeLimited) {
+    y_scale = 219 * unit;
+    c_scale = 224 * unit;
+    c.y_offset = 16 * unit;
+    c.c_offset = 128 * unit;
+  } else {
+    y_scale = c.max;
+    c_scale = c.max;
+    c.c_offset = 1 << (out_bits - 1);
+  }
+
+  // Scale per source code, the middle coefficient takes the rounding so that white maps to the
+  // top of the range and greys to neutral chroma exactly.
+  double one = double(1 << kShift);
+  double ys = y_scale / in_max * one;
+  double cs = c_scale / in_max * one;
+  c.y[0] = int32_t(lround(kr * ys));
+  c.y[2] = int32_t(lround(kb * ys));
+  c.y[1] = int32_t(lround(ys)) - c.y[0] - c.y[2];
+  c.u[0] = int32_t(lround(-kr / (2 * (1 - kb)) * cs));
+  c.u[2] = int32_t(lround(0.5 * cs));
+  c.u[1] = -c.u[0] - c.u[2];
+  c.v[0] = int32_t(lround(0.5 * cs));
+  c.v[2] = int32_t(lround(-kb / (2 * (1 - kr)) * cs));
+  c.v[1] = -c.v[0] - c.v[2];
+
+  return c;
+}
+
+CpuColorConvert::CpuColorConvert(uint32_t num_threads) {
+  if (!num_threads) {
+    num_threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  // Calling thread converts bands as well.
+  for (uint32_t i = 1; i < num_threads; i++) {
+    workers_.push_back(std::thread(&CpuColorConvert::WorkerLoop, this));
+  }
+}
+
+CpuColorConvert::~CpuColorConvert() {
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    exit_workers_ = true;
+  }
+  job_cv_.notify_all();
+
+  for (auto &worker : workers_) {
+    worker.join();
+  }
+}
+
+int CpuColorConvert::Convert(const Source &src, const Target &dst, uint32_t width,
+                             uint32_t height, Standard standard, Range range) {
+  uint32_t sample_size = (dst.format == kTargetNV12) ? 1 : 2;
+  uint32_t chroma_width = (width + 1) & ~1u;
+  if (!src.data || !dst.y || !dst.uv || !width || !height || src.stride < width * 4 ||
+      dst.y_stride < width * sample_size || dst.uv_stride < chroma_width * sample_size) {
+    return -EINVAL;
+  }
+
+  std::unique_lock<std::mutex> lock(lock_);
+  src_ = src;
+  dst_ = dst;
+  width_ = width;
+  height_ = height;
+  coefficients_ = GetCoefficients(src.format, dst.format, standard, range);
+  num_bands_ = (height + kBandRows - 1) / kBandRows;
+  next_band_ = 0;
+
+  // Small images are not worth waking up the workers.
+  if (num_bands_ == 1 || workers_.empty()) {
+    lock.unlock();
+    RunBands();
+    return 0;
+  }
+
+  active_workers_ = uint32_t(workers_.size());
+  job_serial_++;
+  lock.unlock();
+  job_cv_.notify_all();
+
+  RunBands();
+
+  lock.lock();
+  done_cv_.wait(lock, [this] { return active_workers_ == 0; });
+
+  return 0;
+}
+
+void CpuColorConvert::WorkerLoop() {
+  uint64_t last_job = 0;
+  std::unique_lock<std::mutex> lock(lock_);
+  while (true) {
+    job_cv_.wait(lock, [this, last_job] { return exit_workers_ || job_serial_ != last_job; });
+    if (exit_workers_) {
+      return;
+    }
+    last_job = job_serial_;
+
+    lock.unlock();
+    RunBands();
+    lock.lock();
+
+    if (--active_workers_ == 0) {
+      done_cv_.notify_all();
+    }
+  }
+}
+
+void CpuColorConvert::RunBands() {
+  for (uint32_t band = next_band_++; band < num_bands_; band = next_band_++) {
+    uint32_t first_row = band * kBandRows;
+    ConvertRows(first_row, std::min(first_row + kBandRows, height_));
+  }
+}
+
+void CpuColorConvert::ConvertRows(uint32_t first_row, uint32_t last_row) {
+  const Coefficients &c = coefficients_;
+  if (src_.format == kSourceRGBA8888) {
+    if (dst_.format == kTargetNV12) {
+      ConvertBand<kSourceRGBA8888, kTargetNV12>(src_, dst_, width_, height_, first_row, last_row,
+                                                c);
+    } else {
+      ConvertBand<kSourceRGBA8888, kTargetP010>(src_, dst_, width_, height_, first_row, last_row,
+                                                c);
+    }
+  } else {
+    if (dst_.format == kTargetNV12) {
+      ConvertBand<kSourceRGBA1010102, kTargetNV12>(src_, dst_, width_, height_, first_row,
+                                                   last_row, c);
+    } else {
+      ConvertBand<kSourceRGBA1010102, kTargetP010>(src_, dst_, width_, height_, first_row,
+                                                   last_row, c);
+    }
+  }
+}
+
+}  // namespace sdm
@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __CPU_COLOR_CONVERT_H__
+#define __CPU_COLOR_CONVERT_H__
+
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace sdm {
+
+// Converts RGBA_8888 or RGBA_1010102 images to NV12 or P010 on the CPU, the counterpart of the
+// GLColorConvert RGB to YUV blit for outputs too small to justify a GPU context. Arithmetic is
+// 16 bit fixed point on integer vectors, so results are identical on every target and thread
+// count. Chroma is the average of each 2x2 block. Rows are split in bands which are shared by a
+// pool of worker threads and the calling thread.
+class CpuColorConvert {
+ public:
+  enum SourceFormat {
+    kSourceRGBA8888,     // R in the lowest byte
+    kSourceRGBA1010102,  // R in the lowest 10 bits, alpha in the 2 highest bits
+  };
+
+  enum TargetFormat {
+    kTargetNV12,
+    kTargetP010,  // 10 bit samples in the high bits of 16 bit words
+  };
+
+  enum Standard {
+    kBT601,
+    kBT709,
+    kBT2020,
+  };
+
+  enum Range {
+    kRangeLimited,
+    kRangeFull,
+  };
+
+  struct Source {
+    const void *data = nullptr;
+    uint32_t stride = 0;  // in bytes
+    SourceFormat format = kSourceRGBA8888;
+  };
+
+  struct Target {
+    void *y = nullptr;
+    uint32_t y_stride = 0;  // in bytes
+    void *uv = nullptr;
+    uint32_t uv_stride = 0;  // in bytes
+    TargetFormat format = kTargetNV12;
+  };
+
+  // num_threads of 0 uses all cores, the calling thread counts as one of them.
+  explicit CpuColorConvert(uint32_t num_threads = 0);
+  ~CpuColorConvert();
+
+  // Converts width x height pixels of src into dst. Odd sizes repeat the last row and column for
+  // chroma. Returns 0 or -EINVAL. Not reentrant.
+  int Convert(const Source &src, const Target &dst, uint32_t width, uint32_t height,
+              Standard standard, Range range);
+
+  // Fixed point coefficients of a conversion, in units of 2^-kShift output codes per source code.
+  struct Coefficients {
+    static const int kShift = 16;
+    int32_t y[3];  // R, G, B
+    int32_t u[3];
+    int32_t v[3];
+    int32_t y_offset;
+    int32_t c_offset;
+    int32_t max;
+  };
+
+  static Coefficients GetCoefficients(SourceFormat src_format, TargetFormat dst_format,
+                                      Standard standard, Range range);
+
+ private:
+  static const uint32_t kBandRows = 16;
+
+  CpuColorConvert(const CpuColorConvert &) = delete;
+  CpuColorConvert &operator=(const CpuColorConvert &) = delete;
+
+  void WorkerLoop();
+  void RunBands();
+  void ConvertRows(uint32_t first_row, uint32_t last_row);
+
+  std::vector<std::thread> workers_;
+  std::mutex lock_;
+  std::condition_variable job_cv_;
+  std::condition_variable done_cv_;
+  uint64_t job_serial_ = 0;
+  uint32_t active_workers_ = 0;
+  bool exit_workers_ = false;
+
+  // Current conversion, shared with the workers.
+  Source src_ = {};
+  Target dst_ = {};
+  uint32_t width_ = 0;
+  uint32_t height_ = 0;
+  Coefficients coefficients_ = {};
+  uint32_t num_bands_ = 0;
+  std::atomic<uint32_t> next_band_ {0};
+};
+
+}  // namespace sdm
+
+#endif  // __CPU_COLOR_CONVERT_H__
@@ -0,0 +1,342 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <errno.h>
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "cpu_color_convert.h"
+
+namespace sdm {
+namespace {
+
+typedef CpuColorConvert::SourceFormat SourceFormat;
+typedef CpuColorConvert::TargetFormat TargetFormat;
+typedef CpuColorConvert::Standard Standard;
+typedef CpuColorConvert::Range Range;
+
+const SourceFormat kSourceFormats[] = {CpuColorConvert::kSourceRGBA8888,
+                                       CpuColorConvert::kSourceRGBA1010102};
+const TargetFormat kTargetFormats[] = {CpuColorConvert::kTargetNV12,
+                                       CpuColorConvert::kTargetP010};
+const Standard kStandards[] = {CpuColorConvert::kBT601, CpuColorConvert::kBT709,
+                               CpuColorConvert::kBT2020};
+const Range kRanges[] = {CpuColorConvert::kRangeLimited, CpuColorConvert::kRangeFull};
+
+uint32_t SourceMax(SourceFormat format) {
+  return (format == CpuColorConvert::kSourceRGBA8888) ? 255 : 1023;
+}
+
+uint32_t Pack(SourceFormat format, uint32_t r, uint32_t g, uint32_t b) {
+  if (format == CpuColorConvert::kSourceRGBA8888) {
+    return r | (g << 8) | (b << 16) | (0xffu << 24);
+  }
+  return r | (g << 10) | (b << 20) | (0x3u << 30);
+}
+
+// RGBA image with a stride larger than its width and its NV12 or P010 output.
+struct Images {
+  Images(SourceFormat src_format, TargetFormat dst_format, uint32_t w, uint32_t h)
+      : width(w), height(h), src_pixels((w + 5) * h) {
+    uint32_t sample_size = (dst_format == CpuColorConvert::kTargetNV12) ? 1 : 2;
+    y.resize((w + 3) * sample_size * h, 0xee);
+    uv.resize(((w + 1) & ~1u) * sample_size * ((h + 1) / 2), 0xee);
+    src.data = src_pixels.data();
+    src.stride = (w + 5) * 4;
+    src.format = src_format;
+    dst.y = y.data();
+    dst.y_stride = (w + 3) * sample_size;
+    dst.uv = uv.data();
+    dst.uv_stride = ((w + 1) & ~1u) * sample_size;
+    dst.format = dst_format;
+  }
+
+  uint32_t &Pixel(uint32_t x, uint32_t row) { return src_pixels[row * (width + 5) + x]; }
+
+  void Fill(uint32_t seed) {
+    std::mt19937 rng(seed);
+    uint32_t max = SourceMax(src.format);
+    for (uint32_t row = 0; row < height; row++) {
+      for (uint32_t x = 0; x < width; x++) {
+        Pixel(x, row) = Pack(src.format, rng() % (max + 1), rng() % (max + 1), rng() % (max + 1));
+      }
+    }
+  }
+
+  uint32_t Y(uint32_t x, uint32_t row) const { return Sample(y, dst.y_stride, x, row); }
+  uint32_t U(uint32_t x, uint32_t row) const { return Sample(uv, dst.uv_stride, x * 2, row); }
+  uint32_t V(uint32_t x, uint32_t row) const { return Sample(uv, dst.uv_stride, x * 2 + 1, row); }
+
+  uint32_t Sample(const std::vector<uint8_t> &plane, uint32_t stride, uint32_t x,
+                  uint32_t row) const {
+    if (dst.format == CpuColorConvert::kTargetNV12) {
+      return plane[row * stride + x];
+    }
+    uint16_t value = 0;
+    memcpy(&value, &plane[row * stride + x * 2], sizeof(value));
+    EXPECT_EQ(value & 0x3f, 0) << "P010 low bits at " << x << "," << row;
+    return value >> 6;
+  }
+
+  uint32_t width;
+  uint32_t height;
+  std::vector<uint32_t> src_pixels;
+  std::vector<uint8_t> y;
+  std::vector<uint8_t> uv;
+  CpuColorConvert::Source src;
+  CpuColorConvert::Target dst;
+};
+
+// Double precision model of the conversion, with chroma from the average of each 2x2 block.
+struct Reference {
+  Reference(SourceFormat src_format, TargetFormat dst_format, Standard standard, Range range) {
+    kr = 0.299;
+    kb = 0.114;
+    if (standard == CpuColorConvert::kBT709) {
+      kr = 0.2126;
+      kb = 0.0722;
+    } else if (standard == CpuColorConvert::kBT2020) {
+      kr = 0.2627;
+      kb = 0.0593;
+    }
+    in_max = SourceMax(src_format);
+    double unit = (dst_format == CpuColorConvert::kTargetNV12) ? 1 : 4;
+    max = unit * 256 - 1;
+    if (range == CpuColorConvert::kRangeLimited) {
+      y_scale = 219 * unit;
+      c_scale = 224 * unit;
+      y_offset = 16 * unit;
+      c_offset = 128 * unit;
+    } else {
+      y_scale = c_scale = max;
+      y_offset = 0;
+      c_offset = 128 * unit;
+    }
+  }
+
+  double Luma(double r, double g, double b) const {
+    return y_offset + y_scale * (kr * r + (1 - kr - kb) * g + kb * b) / in_max;
+  }
+
+  void Chroma(double r, double g, double b, double *u, double *v) const {
+    double luma = kr * r + (1 - kr - kb) * g + kb * b;
+    *u = std::min(c_offset + c_scale * (b - luma) / (2 * (1 - kb)) / in_max, max);
+    *v = std::min(c_offset + c_scale * (r - luma) / (2 * (1 - kr)) / in_max, max);
+  }
+
+  double kr, kb, in_max, max, y_scale, c_scale, y_offset, c_offset;
+};
+
+void Unpack(SourceFormat format, uint32_t pixel, double rgb[3]) {
+  uint32_t bits = (format == CpuColorConvert::kSourceRGBA8888) ? 8 : 10;
+  uint32_t mask = (1u << bits) - 1;
+  for (int i = 0; i < 3; i++) {
+    rgb[i] = (pixel >> (i * bits)) & mask;
+  }
+}
+
+void ExpectMatchesReference(Images *images, Standard standard, Range range) {
+  Reference ref(images->src.format, images->dst.format, standard, range);
+  uint32_t width = images->width, height = images->height;
+  int max_error = 0;
+
+  for (uint32_t row = 0; row < height; row++) {
+    for (uint32_t x = 0; x < width; x++) {
+      double rgb[3];
+      Unpack(images->src.format, images->Pixel(x, row), rgb);
+      double expected = ref.Luma(rgb[0], rgb[1], rgb[2]);
+      max_error = std::max(max_error, int(fabs(images->Y(x, row) - expected) + 0.5));
+    }
+  }
+
+  for (uint32_t row = 0; row < height; row += 2) {
+    for (uint32_t x = 0; x < width; x += 2) {
+      double sum[3] = {};
+      for (uint32_t dy = 0; dy < 2; dy++) {
+        for (uint32_t dx = 0; dx < 2; dx++) {
+          double rgb[3];
+          Unpack(images->src.format,
+                 images->Pixel(std::min(x + dx, width - 1), std::min(row + dy, height - 1)), rgb);
+          for (int i = 0; i < 3; i++) {
+            sum[i] += rgb[i] / 4;
+          }
+        }
+      }
+      double u = 0, v = 0;
+      ref.Chroma(sum[0], sum[1], sum[2], &u, &v);
+      max_error = std::max(max_error, int(fabs(images->U(x / 2, row / 2) - u) + 0.5));
+      max_error = std::max(max_error, int(fabs(images->V(x / 2, row / 2) - v) + 0.5));
+    }
+  }
+
+  EXPECT_LE(max_error, 1) << "src " << images->src.format << " dst " << images->dst.format
+                          << " standard " << standard << " range " << range;
+}
+
+}  // namespace
+
+// Well known codes of primaries, white and black for 8 bit video.
+TEST(CpuColorConvertTest, GoldenColors) {
+  struct Golden {
+    Standard standard;
+    Range range;
+    uint32_t rgb[3];
+    uint32_t yuv[3];
+  } goldens[] = {
+    {CpuColorConvert::kBT601, CpuColorConvert::kRangeLimited, {255, 255, 255}, {235, 128, 128}},
+    {CpuColorConvert::kBT601, CpuColorConvert::kRangeLimited, {0, 0, 0}, {16, 128, 128}},
+    {CpuColorConvert::kBT601, CpuColorConvert::kRangeLimited, {255, 0, 0}, {81, 90, 240}},
+    {CpuColorConvert::kBT601, CpuColorConvert::kRangeLimited, {0, 255, 0}, {145, 54, 34}},
+    {CpuColorConvert::kBT601, CpuColorConvert::kRangeLimited, {0, 0, 255}, {41, 240, 110}},
+    {CpuColorConvert::kBT709, CpuColorConvert::kRangeLimited, {255, 0, 0}, {63, 102, 240}},
+    {CpuColorConvert::kBT709, CpuColorConvert::kRangeLimited, {0, 255, 0}, {173, 42, 26}},
+    {CpuColorConvert::kBT709, CpuColorConvert::kRangeLimited, {0, 0, 255}, {32, 240, 118}},
+    {CpuColorConvert::kBT2020, CpuColorConvert::kRangeLimited, {255, 0, 0}, {74, 97, 240}},
+    {CpuColorConvert::kBT601, CpuColorConvert::kRangeFull, {255, 255, 255}, {255, 128, 128}},
+    {CpuColorConvert::kBT601, CpuColorConvert::kRangeFull, {0, 0, 0}, {0, 128, 128}},
+    {CpuColorConvert::kBT601, CpuColorConvert::kRangeFull, {128, 128, 128}, {128, 128, 128}},
+    {CpuColorConvert::kBT601, CpuColorConvert::kRangeFull, {255, 0, 0}, {76, 85, 255}},
+  };
+
+  CpuColorConvert convert(1);
+  for (const auto &golden : goldens) {
+    // Wide enough for the vector path, with an odd tail.
+    Images images(CpuColorConvert::kSourceRGBA8888, CpuColorConvert::kTargetNV12, 11, 2);
+    for (uint32_t row = 0; row < 2; row++) {
+      for (uint32_t x = 0; x < 11; x++) {
+        images.Pixel(x, row) = Pack(CpuColorConvert::kSourceRGBA8888, golden.rgb[0],
+                                    golden.rgb[1], golden.rgb[2]);
+      }
+    }
+    ASSERT_EQ(convert.Convert(images.src, images.dst, 11, 2, golden.standard, golden.range), 0);
+
+    for (uint32_t x = 0; x < 11; x++) {
+      EXPECT_EQ(images.Y(x, 1), golden.yuv[0]) << golden.rgb[0] << "," << golden.rgb[1] << ","
+                                               << golden.rgb[2] << " x " << x;
+    }
+    for (uint32_t x = 0; x < 6; x++) {
+      EXPECT_EQ(images.U(x, 0), golden.yuv[1]) << golden.rgb[0] << "," << golden.rgb[1] << ","
+                                               << golden.rgb[2] << " x " << x;
+      EXPECT_EQ(images.V(x, 0), golden.yuv[2]) << golden.rgb[0] << "," << golden.rgb[1] << ","
+                                               << golden.rgb[2] << " x " << x;
+    }
+  }
+}
+
+TEST(CpuColorConvertTest, P010Range) {
+  CpuColorConvert convert(1);
+  Images images(CpuColorConvert::kSourceRGBA1010102, CpuColorConvert::kTargetP010, 16, 4);
+  for (uint32_t x = 0; x < 16; x++) {
+    images.Pixel(x, 0) = images.Pixel(x, 1) = Pack(images.src.format, 1023, 1023, 1023);
+    images.Pixel(x, 2) = images.Pixel(x, 3) = Pack(images.src.format, 0, 0, 0);
+  }
+
+  ASSERT_EQ(convert.Convert(images.src, images.dst, 16, 4, CpuColorConvert::kBT2020,
+                            CpuColorConvert::kRangeLimited), 0);
+  EXPECT_EQ(images.Y(3, 0), 940u);
+  EXPECT_EQ(images.Y(3, 2), 64u);
+  EXPECT_EQ(images.U(1, 0), 512u);
+  EXPECT_EQ(images.V(1, 1), 512u);
+
+  ASSERT_EQ(convert.Convert(images.src, images.dst, 16, 4, CpuColorConvert::kBT2020,
+                            CpuColorConvert::kRangeFull), 0);
+  EXPECT_EQ(images.Y(3, 0), 1023u);
+  EXPECT_EQ(images.Y(3, 2), 0u);
+}
+
+TEST(CpuColorConvertTest, MatchesReference) {
+  CpuColorConvert convert(2);
+  for (SourceFormat src_format : kSourceFormats) {
+    for (TargetFormat dst_format : kTargetFormats) {
+      for (Standard standard : kStandards) {
+        for (Range range : kRanges) {
+          // Odd sizes cover the scalar tail and the repeated last row and column.
+          Images images(src_format, dst_format, 61, 37);
+          images.Fill(src_format * 16 + dst_format * 8 + standard * 2 + range);
+          ASSERT_EQ(convert.Convert(images.src, images.dst, 61, 37, standard, range), 0);
+          ExpectMatchesReference(&images, standard, range);
+        }
+      }
+    }
+  }
+}
+
+// The vector loop and the scalar tail must produce the same codes for the same pixels.
+TEST(CpuColorConvertTest, VectorAndTailAgree) {
+  CpuColorConvert convert(1);
+  for (SourceFormat src_format : kSourceFormats) {
+    for (TargetFormat dst_format : kTargetFormats) {
+      Images full(src_format, dst_format, 32, 4);
+      full.Fill(7);
+      ASSERT_EQ(convert.Convert(full.src, full.dst, 32, 4, CpuColorConvert::kBT709,
+                                CpuColorConvert::kRangeLimited), 0);
+
+      // Same pixels starting 2 columns later, so vector lanes land on tail columns.
+      Images shifted(src_format, dst_format, 30, 4);
+      for (uint32_t row = 0; row < 4; row++) {
+        for (uint32_t x = 0; x < 30; x++) {
+          shifted.Pixel(x, row) = full.Pixel(x + 2, row);
+        }
+      }
+      ASSERT_EQ(convert.Convert(shifted.src, shifted.dst, 30, 4, CpuColorConvert::kBT709,
+                                CpuColorConvert::kRangeLimited), 0);
+
+      for (uint32_t row = 0; row < 4; row++) {
+        for (uint32_t x = 0; x < 30; x++) {
+          EXPECT_EQ(shifted.Y(x, row), full.Y(x + 2, row)) << x << "," << row;
+        }
+      }
+      for (uint32_t row = 0; row < 2; row++) {
+        for (uint32_t x = 0; x < 15; x++) {
+          EXPECT_EQ(shifted.U(x, row), full.U(x + 1, row)) << x << "," << row;
+          EXPECT_EQ(shifted.V(x, row), full.V(x + 1, row)) << x << "," << row;
+        }
+      }
+    }
+  }
+}
+
+TEST(CpuColorConvertTest, ThreadCountIndependent) {
+  CpuColorConvert single(1);
+  CpuColorConvert multi(4);
+  Images a(CpuColorConvert::kSourceRGBA8888, CpuColorConvert::kTargetNV12, 333, 251);
+  Images b(CpuColorConvert::kSourceRGBA8888, CpuColorConvert::kTargetNV12, 333, 251);
+  a.Fill(11);
+  b.src_pixels = a.src_pixels;
+
+  ASSERT_EQ(single.Convert(a.src, a.dst, 333, 251, CpuColorConvert::kBT601,
+                           CpuColorConvert::kRangeLimited), 0);
+  for (int i = 0; i < 3; i++) {
+    ASSERT_EQ(multi.Convert(b.src, b.dst, 333, 251, CpuColorConvert::kBT601,
+                            CpuColorConvert::kRangeLimited), 0);
+    EXPECT_EQ(a.y, b.y);
+    EXPECT_EQ(a.uv, b.uv);
+  }
+}
+
+TEST(CpuColorConvertTest, RejectsInvalid) {
+  CpuColorConvert convert(1);
+  Images images(CpuColorConvert::kSourceRGBA8888, CpuColorConvert::kTargetP010, 8, 8);
+  const auto kStandard = CpuColorConvert::kBT601;
+  const auto kRange = CpuColorConvert::kRangeLimited;
+
+  EXPECT_EQ(convert.Convert(images.src, images.dst, 0, 8, kStandard, kRange), -EINVAL);
+  EXPECT_EQ(convert.Convert(images.src, images.dst, 8, 0, kStandard, kRange), -EINVAL);
+  // Strides too small for the width.
+  EXPECT_EQ(convert.Convert(images.src, images.dst, 14, 8, kStandard, kRange), -EINVAL);
+
+  CpuColorConvert::Target no_uv = images.dst;
+  no_uv.uv = nullptr;
+  EXPECT_EQ(convert.Convert(images.src, no_uv, 8, 8, kStandard, kRange), -EINVAL);
+  CpuColorConvert::Source no_data = images.src;
+  no_data.data = nullptr;
+  EXPECT_EQ(convert.Convert(no_data, images.dst, 8, 8, kStandard, kRange), -EINVAL);
+}
+
+}  // namespace sdm
@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <errno.h>
+#include <utility>
+
+#include "cwb_request_queue.h"
+
+namespace sdm {
+
+CWBRequestQueue::~CWBRequestQueue() {
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    exit_ = true;
+  }
+  cv_.notify_one();
+  if (notifier_.joinable()) {
+    notifier_.join();
+  }
+}
+
+int CWBRequestQueue::Post(uint64_t handle_id, NotifyFn notify) {
+  std::lock_guard<std::mutex> lock(lock_);
+  if (queue_.size() >= kMaxPendingRequests) {
+    return -EBUSY;
+  }
+
+  for (auto &request : queue_) {
+    if (request.handle_id == handle_id) {
+      return -EEXIST;
+    }
+  }
+
+  Request request;
+  request.handle_id = handle_id;
+  request.notify = std::move(notify);
+  queue_.push_back(std::move(request));
+  if (!notifier_.joinable()) {
+    notifier_ = std::thread(&CWBRequestQueue::ProcessRequests, this);
+  }
+
+  return 0;
+}
+
+void CWBRequestQueue::Configured(uint64_t handle_id) {
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    for (auto &request : queue_) {
+      if (request.handle_id == handle_id) {
+        request.configured = true;
+        break;
+      }
+    }
+  }
+  cv_.notify_one();
+}
+
+void CWBRequestQueue::Cancel(uint64_t handle_id) {
+  std::lock_guard<std::mutex> lock(lock_);
+  for (auto it = queue_.begin(); it != queue_.end(); it++) {
+    if (it->handle_id == handle_id) {
+      queue_.erase(it);
+      break;
+    }
+  }
+}
+
+int CWBRequestQueue::OnDone(uint64_t handle_id, int32_t status) {
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    // A skipped done event must not hold back later requests, so match by buffer rather than
+    // expecting the front request.
+    auto it = queue_.begin();
+    for (; it != queue_.end(); it++) {
+      if (!it->done && it->handle_id == handle_id) {
+        break;
+      }
+    }
+    if (it == queue_.end()) {
+      return -1;
+    }
+
+    it->done = true;
+    it->status = status;
+  }
+  cv_.notify_one();
+
+  return 0;
+}
+
+void CWBRequestQueue::ProcessRequests() {
+  while (true) {
+    Request request;
+    {
+      std::unique_lock<std::mutex> lock(lock_);
+      cv_.wait(lock, [this] {
+        return exit_ || (!queue_.empty() && queue_.front().configured && queue_.front().done);
+      });
+      if (exit_) {
+        break;
+      }
+
+      request = std::move(queue_.front());
+      queue_.pop_front();
+    }
+
+    request.notify(request.status);
+  }
+}
+
+}  // namespace sdm
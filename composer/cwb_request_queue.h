@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __CWB_REQUEST_QUEUE_H__
+#define __CWB_REQUEST_QUEUE_H__
+
+#include <stdint.h>
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <functional>
+#include <mutex>  // NOLINT
+#include <thread>  // NOLINT
+
+namespace sdm {
+
+// Readback requests of one display. Done events may arrive in any order, requests are notified
+// in the order they were posted, by a notifier thread which only wakes up once the front request
+// is both configured and done. A buffer can be posted again once its request was notified.
+class CWBRequestQueue {
+ public:
+  // Gets the done status, 0 on success. Runs on the notifier thread.
+  typedef std::function<void(int status)> NotifyFn;
+
+  // Upper bound of readback requests in flight.
+  static const uint32_t kMaxPendingRequests = 8;
+
+  ~CWBRequestQueue();
+
+  // Queues a request for buffer handle_id, which is notified after Configured() and OnDone().
+  // Returns 0, -EBUSY when kMaxPendingRequests are pending or -EEXIST when the buffer is.
+  int Post(uint64_t handle_id, NotifyFn notify);
+  // Request was set up for capture, called after Post() also when the done event came first.
+  void Configured(uint64_t handle_id);
+  // Drops a request which could not be set up, it is not notified.
+  void Cancel(uint64_t handle_id);
+  // Records the done event. Returns -1 when no pending request waits for handle_id.
+  int OnDone(uint64_t handle_id, int32_t status);
+
+ private:
+  struct Request {
+    uint64_t handle_id = 0;
+    NotifyFn notify;
+    bool configured = false;
+    bool done = false;
+    int status = 0;
+  };
+
+  void ProcessRequests();
+
+  std::deque<Request> queue_;
+  std::mutex lock_;
+  std::condition_variable cv_;
+  std::thread notifier_;
+  bool exit_ = false;
+};
+
+}  // namespace sdm
+
+#endif  // __CWB_REQUEST_QUEUE_H__
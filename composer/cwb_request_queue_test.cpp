@@ -0,0 +1,208 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <errno.h>
+#include <algorithm>
+#include <chrono>    // NOLINT
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <mutex>     // NOLINT
+#include <thread>    // NOLINT
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "cwb_request_queue.h"
+
+namespace sdm {
+namespace {
+
+// Stands in for the display abstraction layer: captures configured buffers on its own thread
+// and reports the done events the way the CWB manager does, not necessarily in request order.
+class MockDAL {
+ public:
+  explicit MockDAL(CWBRequestQueue *queue) : queue_(queue), thread_([this] { Run(); }) { }
+
+  ~MockDAL() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      exit_ = true;
+    }
+    cv_.notify_one();
+    thread_.join();
+  }
+
+  // Completes captures in batches of batch_size, last one of a batch first.
+  void SetBatchSize(size_t batch_size) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    batch_size_ = batch_size;
+  }
+
+  // Captures handle_id, status is reported with its done event.
+  void Capture(uint64_t handle_id, int32_t status = 0) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    captures_.push_back({handle_id, status});
+    cv_.notify_one();
+  }
+
+ private:
+  void Run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      cv_.wait(lock, [this] { return exit_ || captures_.size() >= batch_size_; });
+      if (exit_) {
+        break;
+      }
+      std::vector<std::pair<uint64_t, int32_t>> batch(captures_.begin(),
+                                                      captures_.begin() + batch_size_);
+      captures_.erase(captures_.begin(), captures_.begin() + batch_size_);
+      std::reverse(batch.begin(), batch.end());
+      lock.unlock();
+      for (auto &[handle_id, status] : batch) {
+        EXPECT_EQ(queue_->OnDone(handle_id, status), 0);
+      }
+      lock.lock();
+    }
+  }
+
+  CWBRequestQueue *queue_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<std::pair<uint64_t, int32_t>> captures_;
+  size_t batch_size_ = 1;
+  bool exit_ = false;
+  std::thread thread_;
+};
+
+// Collects the notifications in the order the queue delivers them.
+class Client {
+ public:
+  CWBRequestQueue::NotifyFn Notify(uint64_t handle_id) {
+    return [this, handle_id](int status) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      notified_.push_back({handle_id, status});
+      cv_.notify_all();
+    };
+  }
+
+  bool WaitFor(size_t count) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return cv_.wait_for(lock, std::chrono::seconds(5),
+                        [this, count] { return notified_.size() >= count; });
+  }
+
+  std::vector<std::pair<uint64_t, int>> Notified() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return notified_;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::vector<std::pair<uint64_t, int>> notified_;
+};
+
+std::vector<std::pair<uint64_t, int>> Expected(std::vector<uint64_t> handle_ids) {
+  std::vector<std::pair<uint64_t, int>> expected;
+  for (auto handle_id : handle_ids) {
+    expected.push_back({handle_id, 0});
+  }
+  return expected;
+}
+
+}  // namespace
+
+TEST(CWBRequestQueueTest, NotifiesInPostingOrder) {
+  Client client;
+  CWBRequestQueue queue;
+  MockDAL dal(&queue);
+  dal.SetBatchSize(4);
+
+  for (uint64_t handle_id = 1; handle_id <= 4; handle_id++) {
+    ASSERT_EQ(queue.Post(handle_id, client.Notify(handle_id)), 0);
+    queue.Configured(handle_id);
+    dal.Capture(handle_id);
+  }
+
+  ASSERT_TRUE(client.WaitFor(4));
+  EXPECT_EQ(client.Notified(), Expected({1, 2, 3, 4}));
+}
+
+TEST(CWBRequestQueueTest, DoneBeforeConfiguredWaits) {
+  Client client;
+  CWBRequestQueue queue;
+  ASSERT_EQ(queue.Post(1, client.Notify(1)), 0);
+  ASSERT_EQ(queue.Post(2, client.Notify(2)), 0);
+  queue.Configured(2);
+  EXPECT_EQ(queue.OnDone(2, 0), 0);
+  EXPECT_EQ(queue.OnDone(1, -EIO), 0);
+
+  // Front request is done but still being configured, nothing may be notified.
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_TRUE(client.Notified().empty());
+
+  queue.Configured(1);
+  ASSERT_TRUE(client.WaitFor(2));
+  auto notified = client.Notified();
+  EXPECT_EQ(notified[0], std::make_pair(uint64_t(1), -EIO));
+  EXPECT_EQ(notified[1], std::make_pair(uint64_t(2), 0));
+}
+
+TEST(CWBRequestQueueTest, RejectsDuplicateAndFullQueue) {
+  Client client;
+  CWBRequestQueue queue;
+  for (uint64_t handle_id = 1; handle_id < CWBRequestQueue::kMaxPendingRequests; handle_id++) {
+    ASSERT_EQ(queue.Post(handle_id, client.Notify(handle_id)), 0);
+  }
+  EXPECT_EQ(queue.Post(1, client.Notify(1)), -EEXIST);
+  ASSERT_EQ(queue.Post(100, client.Notify(100)), 0);
+  EXPECT_EQ(queue.Post(101, client.Notify(101)), -EBUSY);
+
+  // Done event of a buffer which is not pending is not taken.
+  EXPECT_EQ(queue.OnDone(101, 0), -1);
+  EXPECT_EQ(queue.OnDone(1, 0), 0);
+  EXPECT_EQ(queue.OnDone(1, 0), -1);
+}
+
+TEST(CWBRequestQueueTest, CanceledRequestIsDropped) {
+  Client client;
+  CWBRequestQueue queue;
+  ASSERT_EQ(queue.Post(1, client.Notify(1)), 0);
+  ASSERT_EQ(queue.Post(2, client.Notify(2)), 0);
+  queue.Cancel(1);
+  queue.Configured(2);
+  queue.OnDone(2, 0);
+
+  ASSERT_TRUE(client.WaitFor(1));
+  EXPECT_EQ(client.Notified(), Expected({2}));
+  // Canceled buffer can be posted again.
+  EXPECT_EQ(queue.Post(1, client.Notify(1)), 0);
+}
+
+TEST(CWBRequestQueueTest, BufferRingIsReused) {
+  const uint64_t kRingSize = 3;
+  const uint64_t kFrames = 300;
+  Client client;
+  CWBRequestQueue queue;
+  MockDAL dal(&queue);
+
+  // A client cycling a ring of buffers at display rate, each reposted once it was notified.
+  std::vector<uint64_t> order;
+  for (uint64_t frame = 0; frame < kFrames; frame++) {
+    uint64_t handle_id = 1 + frame % kRingSize;
+    if (frame >= kRingSize) {
+      ASSERT_TRUE(client.WaitFor(frame - kRingSize + 1));
+    }
+    ASSERT_EQ(queue.Post(handle_id, client.Notify(handle_id)), 0) << frame;
+    queue.Configured(handle_id);
+    dal.Capture(handle_id);
+    order.push_back(handle_id);
+  }
+
+  ASSERT_TRUE(client.WaitFor(kFrames));
+  EXPECT_EQ(client.Notified(), Expected(order));
+}
+
+}  // namespace sdm
@@ -47,6 +47,7 @@ struct StitchParams {
   GLRect src_rect;
   GLRect dst_rect;
   GLRect scissor_rect;
+  bool clear_scissor = true;  // Clear scissor_rect to transparent before drawing.
   shared_ptr<Fence> src_acquire_fence = nullptr;
   shared_ptr<Fence> dst_acquire_fence = nullptr;
 };
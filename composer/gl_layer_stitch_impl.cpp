@@ -145,48 +145,28 @@ int GLLayerStitchImpl::Blit(const std::vector<StitchParams> &stitch_params,
                             shared_ptr<Fence> *release_fence) {
   DTRACE_SCOPED();
 
+  // All draws go into one submission: wait on every source once up front and create a single
+  // output fence for the client to wait on.
   std::vector<shared_ptr<Fence>> acquire_fences;
-  std::vector<shared_ptr<Fence>> release_fences;
-  bool can_batch = !NeedsGLScissor(stitch_params);
+  acquire_fences.reserve(stitch_params.size());
   for (auto &info : stitch_params) {
-    SetSourceBuffer(info.src_hnd);
-    SetDestinationBuffer(info.dst_hnd);
-    SetViewport(info.dst_rect);
-    ClearWithTransparency(info.scissor_rect);
-    glDrawArrays(GL_TRIANGLES, 0, 3);
-
     acquire_fences.push_back(info.src_acquire_fence);
-
-    if (!can_batch) {
-      // Trigger flush and cache release fence.
-      WaitOnInputFence(acquire_fences);
-      shared_ptr<Fence> temp_release_fence = nullptr;
-      CreateOutputFence(&temp_release_fence);
-      release_fences.push_back(temp_release_fence);
-      acquire_fences = {};
-    }
-  }
-
-  if (can_batch) {
-    // Create output fence for client to wait on.
-    WaitOnInputFence(acquire_fences);
-    CreateOutputFence(release_fence);
-  } else {
-    // Merge all fd's and return one.
-    *release_fence = Fence::Merge(release_fences, false);
   }
+  WaitOnInputFence(acquire_fences);
 
-  return 0;
-}
-
-int GLLayerStitchImpl::NeedsGLScissor(const std::vector<StitchParams> &stitch_params) {
+  const native_handle_t *dst_hnd = nullptr;
   for (auto &info : stitch_params) {
-    if (IsValid(info.scissor_rect)) {
-      return true;
+    SetSourceBuffer(info.src_hnd);
+    if (info.dst_hnd != dst_hnd) {
+      SetDestinationBuffer(info.dst_hnd);
+      dst_hnd = info.dst_hnd;
     }
+    SetViewport(info.dst_rect);
+    SetScissor(info.scissor_rect, info.clear_scissor);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
   }
 
-  return false;
+  return CreateOutputFence(release_fence);
 }
 
 int GLLayerStitchImpl::Init() {
@@ -200,20 +180,22 @@ int GLLayerStitchImpl::Deinit() {
   return 0;
 }
 
-void GLLayerStitchImpl::ClearWithTransparency(const GLRect &scissor_rect) {
+void GLLayerStitchImpl::SetScissor(const GLRect &scissor_rect, bool clear) {
   if (!IsValid(scissor_rect)) {
     // Disable scissor.
     GL(glDisable(GL_SCISSOR_TEST));
     return;
   }
 
-  DTRACE_SCOPED();
   // Enable scissor test.
   GL(glEnable(GL_SCISSOR_TEST));
   GL(glScissor(scissor_rect.left, scissor_rect.top, scissor_rect.right - scissor_rect.left,
                scissor_rect.bottom - scissor_rect.top));
-  GL(glClearColor(0, 0, 0, 0));
-  GL(glClear(GL_COLOR_BUFFER_BIT));
+  if (clear) {
+    DTRACE_SCOPED();
+    GL(glClearColor(0, 0, 0, 0));
+    GL(glClear(GL_COLOR_BUFFER_BIT));
+  }
 }
 
 void GLLayerStitchImpl::InitContext() {
@@ -61,8 +61,7 @@ class GLLayerStitchImpl : public GLLayerStitch, public GLCommon {
   GLContext ctx_;
 
   void InitContext();
-  void ClearWithTransparency(const GLRect &scissor_rect);
-  int NeedsGLScissor(const std::vector<StitchParams> &stitch_params);
+  void SetScissor(const GLRect &scissor_rect, bool clear);
 };
 
 }  // namespace sdm
@@ -65,6 +65,7 @@ namespace sdm {
 
 int HWCBufferAllocator::GetGrallocInstance() {
   // Lazy initialization of gralloc HALs
+  std::lock_guard<std::mutex> lock(gralloc_lock_);
   if (mapper_ != nullptr && allocator_ != nullptr && mapper_ext_ != nullptr) {
     return kErrorNone;
   }
@@ -763,6 +764,11 @@ int HWCBufferAllocator::GetBufferLayout(const AllocatedBufferInfo &buf_info, uin
 
 int HWCBufferAllocator::MapBuffer(const native_handle_t *handle, shared_ptr<Fence> acquire_fence,
                                   void **base_ptr) {
+  return MapBuffer(handle, acquire_fence, (uint64_t)BufferUsage::CPU_READ_OFTEN, base_ptr);
+}
+
+int HWCBufferAllocator::MapBuffer(const native_handle_t *handle, shared_ptr<Fence> acquire_fence,
+                                  uint64_t cpu_usage, void **base_ptr) {
   auto err = GetGrallocInstance();
   if (err != 0) {
     DLOGW("Could not get gralloc instance");
@@ -781,7 +787,7 @@ int HWCBufferAllocator::MapBuffer(const native_handle_t *handle, shared_ptr<Fenc
   auto hnd = const_cast<native_handle_t *>(handle);
   *base_ptr = NULL;
   const IMapper::Rect access_region = {.left = 0, .top = 0, .width = 0, .height = 0};
-  mapper_->lock(reinterpret_cast<void *>(hnd), (uint64_t)BufferUsage::CPU_READ_OFTEN, access_region,
+  mapper_->lock(reinterpret_cast<void *>(hnd), cpu_usage, access_region,
                 acquire_fence_handle, [&](const auto &_error, const auto &_buffer) {
                   if (_error == Error::NONE) {
                     *base_ptr = _buffer;
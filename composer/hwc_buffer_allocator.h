@@ -55,6 +55,7 @@
 #include <vendor/qti/hardware/display/mapper/4.0/IQtiMapper.h>
 #include <vendor/qti/hardware/display/mapperextensions/1.3/IQtiMapperExtensions.h>
 #include <QtiGrallocPriv.h>
+#include <mutex>
 
 using aidl::android::hardware::graphics::allocator::AllocationResult;
 using aidl::android::hardware::graphics::allocator::IAllocator;
@@ -86,6 +87,9 @@ class HWCBufferAllocator : public BufferAllocator {
                       uint32_t *num_planes);
   int SetBufferInfo(LayerBufferFormat format, int *target, uint64_t *flags);
   int MapBuffer(const native_handle_t *handle, shared_ptr<Fence> acquire_fence, void **base_ptr);
+  // cpu_usage is a BufferUsage mask, CPU_WRITE_* for buffers the CPU fills.
+  int MapBuffer(const native_handle_t *handle, shared_ptr<Fence> acquire_fence, uint64_t cpu_usage,
+                void **base_ptr);
   int UnmapBuffer(const native_handle_t *handle, int *release_fence);
   int GetHeight(void *buf, uint32_t &height);
   int GetWidth(void *buf, uint32_t &width);
@@ -107,6 +111,7 @@ class HWCBufferAllocator : public BufferAllocator {
   android::sp<IMapper> mapper_;
   std::shared_ptr<IAllocator> allocator_;
   android::sp<IQtiMapperExtensions_v1_3> mapper_ext_;
+  std::mutex gralloc_lock_;  // Guards the lazy init, displays can be created concurrently
 };
 
 }  // namespace sdm
@@ -83,6 +83,26 @@ static RenderIntent GetRenderIntentFromStcIntent(const snapdragoncolor::RenderIn
 HWCColorModeStc::HWCColorModeStc(DisplayInterface *display_intf) : HWCColorMode(display_intf) {}
 
 HWC3::Error HWCColorModeStc::Init() {
+  // The mode list is queried by LoadColorModes() on the first client mode request, the query
+  // loads the mode assets of the panel.
+  return HWC3::Error::None;
+}
+
+HWC3::Error HWCColorModeStc::DeInit() {
+  stc_mode_list_.list.clear();
+  color_mode_map_.clear();
+  modes_loaded_ = false;
+  return HWC3::Error::None;
+}
+
+// Not called from the frame path, ApplyCurrentColorModeWithRenderIntent() does nothing until a
+// client has asked for the modes.
+void HWCColorModeStc::LoadColorModes() {
+  if (modes_loaded_) {
+    return;
+  }
+
+  modes_loaded_ = true;
   DisplayError error = display_intf_->GetStcColorModes(&stc_mode_list_);
   if (error != kErrorNone) {
     DLOGW("Failed to get Stc color modes, error %d", error);
@@ -92,13 +112,6 @@ HWC3::Error HWCColorModeStc::Init() {
   }
 
   PopulateColorModes();
-  return HWC3::Error::None;
-}
-
-HWC3::Error HWCColorModeStc::DeInit() {
-  stc_mode_list_.list.clear();
-  color_mode_map_.clear();
-  return HWC3::Error::None;
 }
 
 void HWCColorModeStc::PopulateColorModes() {
@@ -201,6 +214,7 @@ int32_t HWCColorModeStc::GetStcColorModeFromMap(const ColorMode &mode, const Ren
 }
 
 uint32_t HWCColorModeStc::GetColorModeCount() {
+  LoadColorModes();
   uint32_t count = UINT32(color_mode_map_.size());
   DLOGI("Supported color mode count = %d", count);
   return std::max(1U, count);
@@ -211,6 +225,7 @@ HWC3::Error HWCColorModeStc::GetColorModes(uint32_t *out_num_modes, ColorMode *o
     DLOGE("Invalid parameters : out_num_modes %pK out_mode %pK", out_num_modes, out_modes);
     return HWC3::Error::BadParameter;
   }
+  LoadColorModes();
   auto it = color_mode_map_.begin();
   *out_num_modes = std::min(*out_num_modes, UINT32(color_mode_map_.size()));
   for (uint32_t i = 0; i < *out_num_modes; it++, i++) {
@@ -221,6 +236,7 @@ HWC3::Error HWCColorModeStc::GetColorModes(uint32_t *out_num_modes, ColorMode *o
 }
 
 uint32_t HWCColorModeStc::GetRenderIntentCount(ColorMode mode) {
+  LoadColorModes();
   uint32_t count = UINT32(color_mode_map_[mode].size());
   DLOGI("mode: %d supported rendering intent count = %d", mode, count);
   return std::max(1U, count);
@@ -232,6 +248,7 @@ HWC3::Error HWCColorModeStc::GetRenderIntents(ColorMode mode, uint32_t *out_num_
     DLOGE("Invalid parameters : out_num_intents %pK out_intents %pK", out_num_intents, out_intents);
     return HWC3::Error::BadParameter;
   }
+  LoadColorModes();
   if (color_mode_map_.find(mode) == color_mode_map_.end()) {
     DLOGE("Color mode = %d is not supported", mode);
     return HWC3::Error::BadParameter;
@@ -265,6 +282,7 @@ HWC3::Error HWCColorModeStc::SetColorTransform(const float *matrix,
 }
 
 HWC3::Error HWCColorModeStc::CacheColorModeWithRenderIntent(ColorMode mode, RenderIntent intent) {
+  LoadColorModes();
   if (current_color_mode_ == mode && current_render_intent_ == intent) {
     return HWC3::Error::None;
   }
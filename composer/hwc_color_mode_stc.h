@@ -68,7 +68,9 @@ class HWCColorModeStc : public HWCColorMode {
   typedef std::map<DynamicRangeType, snapdragoncolor::ColorMode> DynamicRangeMap;
   typedef std::map<RenderIntent, DynamicRangeMap> RenderIntentMap;
   std::map<ColorMode, RenderIntentMap> color_mode_map_ = {};
+  bool modes_loaded_ = false;
 
+  void LoadColorModes();
   void PopulateColorModes();
   int32_t GetStcColorModeFromMap(const ColorMode &mode, const RenderIntent &intent,
                                  const DynamicRangeType &dynamic_range,
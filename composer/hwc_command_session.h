@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __HWC_COMMAND_SESSION_H__
+#define __HWC_COMMAND_SESSION_H__
+
+#include <aidl/android/hardware/graphics/composer3/ClientTargetProperty.h>
+#include <cutils/native_handle.h>
+#include <utils/fence.h>
+#include <memory>
+#include <vector>
+
+#include "hwc_common.h"
+
+namespace sdm {
+
+using std::shared_ptr;
+using HwcClientTargetProperty = aidl::android::hardware::graphics::composer3::ClientTargetProperty;
+
+// Session calls made by the AIDL command engine while it executes a command batch. HWCSession
+// implements it; tests and benchmarks of the engine can supply their own session.
+class HWCCommandSession {
+ public:
+  virtual HWC3::Error AcceptDisplayChanges(Display display) = 0;
+  virtual HWC3::Error CommitOrPrepare(Display display, bool validate_only,
+                                      shared_ptr<Fence> *out_retire_fence,
+                                      uint32_t *out_num_types, uint32_t *out_num_requests,
+                                      bool *needs_commit) = 0;
+  virtual HWC3::Error PresentDisplay(Display display, shared_ptr<Fence> *out_retire_fence) = 0;
+  virtual HWC3::Error GetChangedCompositionTypes(Display display, uint32_t *out_num_elements,
+                                                 LayerId *out_layers, int32_t *out_types) = 0;
+  virtual HWC3::Error GetDisplayRequests(Display display, int32_t *out_display_requests,
+                                         uint32_t *out_num_elements, LayerId *out_layers,
+                                         int32_t *out_layer_requests) = 0;
+  virtual HWC3::Error GetReleaseFences(Display display, uint32_t *out_num_elements,
+                                       LayerId *out_layers,
+                                       std::vector<shared_ptr<Fence>> *out_fences) = 0;
+  virtual HWC3::Error GetClientTargetProperty(
+      Display display, HwcClientTargetProperty *outClientTargetProperty) = 0;
+  virtual HWC3::Error SetClientTarget(Display display, buffer_handle_t target,
+                                      shared_ptr<Fence> acquire_fence, int32_t dataspace,
+                                      Region damage) = 0;
+  virtual HWC3::Error SetClientTarget_3_1(Display display, buffer_handle_t target,
+                                          shared_ptr<Fence> acquire_fence, int32_t dataspace,
+                                          Region damage) = 0;
+  virtual HWC3::Error SetOutputBuffer(Display display, buffer_handle_t buffer,
+                                      const shared_ptr<Fence> &release_fence) = 0;
+  virtual HWC3::Error SetColorTransform(Display display, const std::vector<float> &matrix) = 0;
+  virtual HWC3::Error SetCursorPosition(Display display, LayerId layer, int32_t x, int32_t y) = 0;
+  virtual HWC3::Error SetDisplayBrightness(Display display, float brightness) = 0;
+  virtual HWC3::Error SetDisplayElapseTime(Display display, uint64_t time) = 0;
+  virtual HWC3::Error SetExpectedPresentTime(Display display, uint64_t expectedPresentTime) = 0;
+
+  // Layer functions
+  virtual HWC3::Error SetLayerBuffer(Display display, LayerId layer, buffer_handle_t buffer,
+                                     const shared_ptr<Fence> &acquire_fence) = 0;
+  virtual HWC3::Error SetLayerBlendMode(Display display, LayerId layer, int32_t int_mode) = 0;
+  virtual HWC3::Error SetLayerDisplayFrame(Display display, LayerId layer, Rect frame) = 0;
+  virtual HWC3::Error SetLayerPlaneAlpha(Display display, LayerId layer, float alpha) = 0;
+  virtual HWC3::Error SetLayerSourceCrop(Display display, LayerId layer, FRect crop) = 0;
+  virtual HWC3::Error SetLayerTransform(Display display, LayerId layer, Transform transform) = 0;
+  virtual HWC3::Error SetLayerZOrder(Display display, LayerId layer, uint32_t z) = 0;
+  virtual HWC3::Error SetLayerType(Display display, LayerId layer, LayerType type) = 0;
+  virtual HWC3::Error SetLayerFlag(Display display, LayerId layer, LayerFlag flag) = 0;
+  virtual HWC3::Error SetLayerSurfaceDamage(Display display, LayerId layer, Region damage) = 0;
+  virtual HWC3::Error SetLayerVisibleRegion(Display display, LayerId layer, Region damage) = 0;
+  virtual HWC3::Error SetLayerCompositionType(Display display, LayerId layer,
+                                              int32_t int_type) = 0;
+  virtual HWC3::Error SetLayerColor(Display display, LayerId layer, Color color) = 0;
+  virtual HWC3::Error SetLayerDataspace(Display display, LayerId layer, int32_t dataspace) = 0;
+  virtual HWC3::Error SetLayerPerFrameMetadata(Display display, LayerId layer,
+                                               uint32_t num_elements, const int32_t *int_keys,
+                                               const float *metadata) = 0;
+  virtual HWC3::Error SetLayerColorTransform(Display display, LayerId layer,
+                                             const float *matrix) = 0;
+  virtual HWC3::Error SetLayerPerFrameMetadataBlobs(Display display, LayerId layer,
+                                                    uint32_t num_elements,
+                                                    const int32_t *int_keys,
+                                                    const uint32_t *sizes,
+                                                    const uint8_t *metadata) = 0;
+  virtual HWC3::Error SetLayerBrightness(Display display, LayerId layer, float brightness) = 0;
+
+ protected:
+  virtual ~HWCCommandSession() {}
+};
+
+}  // namespace sdm
+
+#endif  // __HWC_COMMAND_SESSION_H__
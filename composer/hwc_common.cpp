@@ -27,7 +27,7 @@
 
 namespace sdm {
 
-std::string to_string(HWC3::Error error) {
+const char *GetErrorName(HWC3::Error error) {
   switch (error) {
     case HWC3::Error::None:
       return "None";
@@ -54,6 +54,10 @@ std::string to_string(HWC3::Error error) {
   }
 }
 
+std::string to_string(HWC3::Error error) {
+  return GetErrorName(error);
+}
+
 std::string to_string(PowerMode mode) {
   switch (mode) {
     case PowerMode::OFF:
@@ -135,6 +135,8 @@ enum {
   HWC_NUM_DISPLAY_TYPES = 9,
 };
 
+// Static string, usable on paths which must not allocate.
+const char *GetErrorName(HWC3::Error error);
 std::string to_string(HWC3::Error error);
 std::string to_string(PowerMode mode);
 std::string to_string(Composition composition);
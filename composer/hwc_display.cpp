@@ -25,6 +25,7 @@
  */
 
 #include <cutils/properties.h>
+#include <display_config_notify.h>
 #include <errno.h>
 #include <math.h>
 #include <sync/sync.h>
@@ -1027,6 +1028,9 @@ HWC3::Error HWCDisplay::SetPowerMode(PowerMode mode, bool teardown) {
   // Update release fence.
   release_fence_ = release_fence;
   current_power_mode_ = mode;
+  if (event_handler_) {
+    event_handler_->NotifyPowerModeChange(id_, mode);
+  }
 
   PostPowerMode();
 
@@ -1357,6 +1361,10 @@ HWC3::Error HWCDisplay::SetFrameDumpConfig(uint32_t count, uint32_t bit_mask_lay
   dump_frame_index_ = 0;
   dump_input_layers_ = ((bit_mask_layer_type & (1 << INPUT_LAYER_DUMP)) != 0);
 
+  int budget_mb = 0;
+  HWCDebugHandler::Get()->GetProperty(FRAME_DUMP_BUDGET_MB, &budget_mb);
+  frame_dump_writer_.SetBudget(UINT64(std::max(budget_mb, 0)) << 20);
+
   if (dump_input_layers_) {
     dump_input_frame_count_ = count;
     dump_input_frame_index_ = 0;
@@ -1988,7 +1996,6 @@ DisplayError HWCDisplay::SetMaxMixerStages(uint32_t max_mixer_stages) {
 
 void HWCDisplay::DumpInputBuffers() {
   char dir_path[PATH_MAX];
-  int status;
   int dump_metadata = 0;
 
   if (!dump_input_frame_count_ || flush_ || !dump_input_layers_) {
@@ -1999,18 +2006,10 @@ void HWCDisplay::DumpInputBuffers() {
   snprintf(dir_path, sizeof(dir_path), "%s/frame_dump_disp_id_%02u_%s", HWCDebugHandler::DumpDir(),
            UINT32(id_), GetDisplayString());
 
-  status = mkdir(dir_path, 777);
-  if ((status != 0) && errno != EEXIST) {
-    DLOGW("Failed to create %s directory errno = %d, desc = %s", dir_path, errno, strerror(errno));
-    return;
-  }
-
-  // Even if directory exists already, need to explicitly change the permission.
-  if (chmod(dir_path, 0777) != 0) {
-    DLOGW("Failed to change permissions on %s directory", dir_path);
-    return;
-  }
+  HWCDebugHandler::Get()->GetProperty(ENABLE_METADATA_DUMPING, &dump_metadata);
 
+  // Buffers are only referenced here. Fence wait, mapping and file write are deferred to
+  // frame_dump_writer_, to keep dumping from altering composition timing.
   bool dump_gpu_target = false;  // whether to dump GPU Target layer.
   for (uint32_t i = 0; i < layer_stack_.layers.size(); i++) {
     auto layer = layer_stack_.layers.at(i);
@@ -2023,11 +2022,8 @@ void HWCDisplay::DumpInputBuffers() {
       }
     }
 
-    const native_handle_t *handle =
-        reinterpret_cast<const native_handle_t *>(layer->input_buffer.buffer_id);
-    Fence::Wait(layer->input_buffer.acquire_fence);
-
-    if (!handle) {
+    const LayerBuffer &input_buffer = layer->input_buffer;
+    if (!input_buffer.buffer_id || input_buffer.planes[0].fd < 0) {
       DLOGW(
           "Buffer handle is detected as null for layer: %s(%d) out of %lu layers with layer "
           "flag value: %u",
@@ -2035,60 +2031,28 @@ void HWCDisplay::DumpInputBuffers() {
       continue;
     }
 
-    DLOGI("Dump layer[%d] of %lu handle %p", i, layer_stack_.layers.size(), handle);
-
-    void *base_ptr = NULL;
-    int error = buffer_allocator_->MapBuffer(handle, nullptr, &base_ptr);
-    if (error != kErrorNone) {
-      DLOGE("Failed to map buffer, error = %d", error);
-      continue;
-    }
+    DLOGI("Dump layer[%d] of %lu buffer_id 0x%" PRIx64, i, layer_stack_.layers.size(),
+          input_buffer.buffer_id);
 
     char dump_file_name[PATH_MAX];
-    size_t result = 0;
-
-    uint32_t width = 0, height = 0, alloc_size = 0;
-
-    buffer_allocator_->GetWidth((void *)handle, width);
-    buffer_allocator_->GetHeight((void *)handle, height);
-    buffer_allocator_->GetAllocationSize((void *)handle, alloc_size);
-
     snprintf(dump_file_name, sizeof(dump_file_name), "%s/input_layer%d_%dx%d_%s_frame%d.raw",
-             dir_path, i, width, height, GetFormatString(layer->input_buffer.format),
-             dump_input_frame_index_);
-
-    if (base_ptr != nullptr) {
-      FILE *fp = fopen(dump_file_name, "w+");
-      if (fp) {
-        result = fwrite(base_ptr, alloc_size, 1, fp);
-        fclose(fp);
-      }
-    }
+             dir_path, i, input_buffer.width, input_buffer.height,
+             GetFormatString(input_buffer.format), dump_input_frame_index_);
 
-    int release_fence = -1;
-    error = buffer_allocator_->UnmapBuffer(handle, &release_fence);
-    if (error != 0) {
-      DLOGE("Failed to unmap buffer, error = %d", error);
-      continue;
+    if (!frame_dump_writer_.QueueBuffer(dump_file_name, input_buffer.planes[0].fd,
+                                        input_buffer.size, input_buffer.acquire_fence)) {
+      DLOGW("Dropped frame dump %s", dump_file_name);
     }
 
-    DLOGI("Frame Dump %s: is %s", dump_file_name, result ? "Successful" : "Failed");
-
-    HWCDebugHandler::Get()->GetProperty(ENABLE_METADATA_DUMPING, &dump_metadata);
     if (dump_metadata) {
       // Dump only extended content metadata for now. Property named generically for future extension
-      std::shared_ptr<CustomContentMetadata> c_md = layer->input_buffer.extended_content_metadata;
+      std::shared_ptr<CustomContentMetadata> c_md = input_buffer.extended_content_metadata;
       if (c_md) {
-        result = 0;
         snprintf(dump_file_name, sizeof(dump_file_name), "%s/input_layer%d_content_md_frame%d.raw",
                  dir_path, i, dump_frame_index_);
-        FILE *fp = fopen(dump_file_name, "w+");
-        if (fp) {
-          result = fwrite(&c_md->metadataPayload, c_md->size, 1, fp);
-          fclose(fp);
+        if (!frame_dump_writer_.QueueData(dump_file_name, &c_md->metadataPayload, c_md->size)) {
+          DLOGW("Dropped frame metadata dump %s", dump_file_name);
         }
-
-        DLOGI("Frame Metadata Dump %s: is %s", dump_file_name, result ? "Successful" : "Failed");
       }
     }
 
@@ -2104,49 +2068,32 @@ void HWCDisplay::DumpInputBuffers() {
 void HWCDisplay::DumpOutputBuffer(const BufferInfo &buffer_info, void *base,
                                   shared_ptr<Fence> &retire_fence) {
   char dir_path[PATH_MAX];
-  int status;
+  char dump_file_name[PATH_MAX];
 
   snprintf(dir_path, sizeof(dir_path), "%s/frame_dump_disp_id_%02u_%s", HWCDebugHandler::DumpDir(),
            UINT32(id_), GetDisplayString());
+  snprintf(dump_file_name, sizeof(dump_file_name), "%s/output_layer_%dx%d_%s_frame%d.raw",
+           dir_path, buffer_info.alloc_buffer_info.aligned_width,
+           buffer_info.alloc_buffer_info.aligned_height,
+           GetFormatString(buffer_info.buffer_config.format), dump_frame_index_);
 
-  status = mkdir(dir_path, 777);
-  if ((status != 0) && errno != EEXIST) {
-    DLOGW("Failed to create %s directory errno = %d, desc = %s", dir_path, errno, strerror(errno));
-    return;
-  }
-
-  // Even if directory exists already, need to explicitly change the permission.
-  if (chmod(dir_path, 0777) != 0) {
-    DLOGW("Failed to change permissions on %s directory", dir_path);
+  if (type_ == kVirtual) {
+    // Client owned output buffer is written once and not recycled by us, dump it by reference.
+    if (!frame_dump_writer_.QueueBuffer(dump_file_name, buffer_info.alloc_buffer_info.fd,
+                                        buffer_info.alloc_buffer_info.size, retire_fence)) {
+      DLOGW("Dropped frame dump %s", dump_file_name);
+    }
     return;
   }
 
   if (base) {
-    char dump_file_name[PATH_MAX];
-    size_t result = 0;
-
-    if (Fence::Wait(retire_fence) != kErrorNone) {
-      DLOGW("sync_wait error errno = %d, desc = %s", errno, strerror(errno));
-      return;
-    }
-
-    snprintf(dump_file_name, sizeof(dump_file_name), "%s/output_layer_%dx%d_%s_frame%d.raw",
-             dir_path, buffer_info.alloc_buffer_info.aligned_width,
-             buffer_info.alloc_buffer_info.aligned_height,
-             GetFormatString(buffer_info.buffer_config.format), dump_frame_index_);
-
-    FILE *fp = fopen(dump_file_name, "w+");
-    if (fp) {
-      result = fwrite(base, buffer_info.alloc_buffer_info.size, 1, fp);
-      fclose(fp);
+    // CWB buffer is reused for next frame as soon as this returns. Its content is known to be
+    // complete once CWB done is notified, so snapshot it and leave the write to the worker.
+    if (!frame_dump_writer_.QueueData(dump_file_name, base, buffer_info.alloc_buffer_info.size)) {
+      DLOGW("Dropped frame dump %s", dump_file_name);
     }
     // Need to clear buffer after dumping of current frame to provide empty buffer for next frame.
-    // But avoid this in case of virtual display frame dump, else it would provide empty buffer
-    // to virtual display client, because it uses client buffer for dumping output.
-    if (type_ != kVirtual) {
-      memset(base, 0, buffer_info.alloc_buffer_info.size);
-    }
-    DLOGI("Frame Dump of %s is %s", dump_file_name, result ? "Successful" : "Failed");
+    memset(base, 0, buffer_info.alloc_buffer_info.size);
   }
 }
 
@@ -2662,6 +2609,16 @@ void HWCDisplay::Dump(std::ostringstream *os) {
     *os << display_intf_->Dump();
   }
 
+  FrameDumpWriter::Stats dump_stats = frame_dump_writer_.GetStats();
+  if (dump_stats.written || dump_stats.failed || dump_stats.dropped_queue_full ||
+      dump_stats.dropped_budget) {
+    *os << "\n----------Frame Dump-----------\n";
+    *os << "written: " << dump_stats.written << " (" << dump_stats.bytes_written << " bytes)";
+    *os << " failed: " << dump_stats.failed;
+    *os << " dropped queue full: " << dump_stats.dropped_queue_full;
+    *os << " dropped budget: " << dump_stats.dropped_budget << std::endl;
+  }
+
   *os << "\n";
 }
 
@@ -3098,8 +3055,16 @@ HWC3::Error HWCDisplay::GetCachedActiveConfig(Config *active_config) {
 }
 
 void HWCDisplay::SetActiveConfigIndex(int index) {
-  std::lock_guard<std::mutex> lock(active_config_lock_);
-  active_config_index_ = index;
+  {
+    std::lock_guard<std::mutex> lock(active_config_lock_);
+    if (active_config_index_ == index) {
+      return;
+    }
+    active_config_index_ = index;
+  }
+
+  // Mode switches do not go through DisplayConfig, whose clients cache refresh rates.
+  DisplayConfig::NotifyDisplayConfigChanged();
 }
 
 int HWCDisplay::GetActiveConfigIndex() {
@@ -3326,52 +3291,51 @@ HWC3::Error HWCDisplay::TryDrawMethod(DrawMethod client_drawMethod) {
   return status;
 }
 
-HWC3::Error HWCDisplay::SetReadbackBuffer(const native_handle_t *buffer,
-                                          shared_ptr<Fence> acquire_fence, CwbConfig cwb_config,
-                                          CWBClient client) {
-  if (current_power_mode_ == PowerMode::OFF || current_power_mode_ == PowerMode::DOZE_SUSPEND) {
-    DLOGW("CWB requested on either Powered-Off or Doze-Suspended display.");
-    return HWC3::Error::BadDisplay;
-  }
-
-  if (secure_event_ != kSecureEventMax) {
-    DLOGW("CWB is not supported as TUI transition is in progress");
-    return HWC3::Error::Unsupported;
-  }
-
+HWC3::Error HWCDisplay::GetReadbackBufferInfo(const native_handle_t *buffer,
+                                              LayerBuffer *output_buffer) {
   void *hdl = const_cast<native_handle_t *>(buffer);
 
-  if (!buffer) {
-    DLOGE("Bad parameter: handle is null");
-    return HWC3::Error::BadParameter;
-  }
-
-  int fd;
+  // fd is read once here for both the cached and uncached paths.
+  int fd = -1;
   gralloc::GetMetaDataValue(hdl, (int64_t)qtigralloc::MetadataType_FD.value, &fd);
   if (fd < 0) {
     DLOGE("Bad parameter: fd is null");
     return HWC3::Error::BadParameter;
   }
 
-  LayerBuffer output_buffer = {};
+  uint64_t handle_id = 0;
+  auto err = gralloc::GetMetaDataValue(hdl, (int64_t)StandardMetadataType::BUFFER_ID, &handle_id);
+  if (err != gralloc::Error::NONE) {
+    DLOGE("Failed to retrieve buffer id");
+  }
+
+  // fd differs per request since clients send a cloned handle, everything else is per buffer.
+  auto it = readback_buffer_cache_.find(handle_id);
+  if (handle_id && it != readback_buffer_cache_.end()) {
+    *output_buffer = it->second;
+    output_buffer->planes[0].fd = fd;
+    return HWC3::Error::None;
+  }
+
+  LayerBuffer &buf = *output_buffer;
   // Configure the output buffer as Readback buffer
-  auto err = gralloc::GetMetaDataValue(
-      hdl, (int64_t)qtigralloc::MetadataType_AlignedWidthInPixels.value, &output_buffer.width);
+  err = gralloc::GetMetaDataValue(
+      hdl, (int64_t)qtigralloc::MetadataType_AlignedWidthInPixels.value, &buf.width);
   if (err != gralloc::Error::NONE) {
     DLOGE("Failed to retrieve aligned width");
   }
   err = gralloc::GetMetaDataValue(
-      hdl, (int64_t)qtigralloc::MetadataType_AlignedHeightInPixels.value, &output_buffer.height);
+      hdl, (int64_t)qtigralloc::MetadataType_AlignedHeightInPixels.value, &buf.height);
   if (err != gralloc::Error::NONE) {
     DLOGE("Failed to retrieve aligned height");
   }
   err = gralloc::GetMetaDataValue(hdl, (int64_t)StandardMetadataType::WIDTH,
-                                  &output_buffer.unaligned_width);
+                                  &buf.unaligned_width);
   if (err != gralloc::Error::NONE) {
     DLOGE("Failed to retrieve unaligned width");
   }
   err = gralloc::GetMetaDataValue(hdl, (int64_t)StandardMetadataType::HEIGHT,
-                                  &output_buffer.unaligned_height);
+                                  &buf.unaligned_height);
   if (err != gralloc::Error::NONE) {
     DLOGE("Failed to retrieve unaligned height");
   }
@@ -3385,32 +3349,59 @@ HWC3::Error HWCDisplay::SetReadbackBuffer(const native_handle_t *buffer,
   if (err != gralloc::Error::NONE) {
     DLOGE("Failed to retrieve flag");
   }
-  output_buffer.format = HWCLayer::GetSDMFormat(format, flag);
-  err = gralloc::GetMetaDataValue(hdl, (int64_t)QTI_FD, &output_buffer.planes[0].fd);
-  if (err != gralloc::Error::NONE) {
-    DLOGE("Failed to retrieve file descriptor");
-  }
+  buf.format = HWCLayer::GetSDMFormat(format, flag);
+  buf.planes[0].fd = fd;
   err = gralloc::GetMetaDataValue(hdl, (int64_t)QTI_ALIGNED_WIDTH_IN_PIXELS,
-                                  &output_buffer.planes[0].stride);
+                                  &buf.planes[0].stride);
   if (err != gralloc::Error::NONE) {
     DLOGE("Failed to retrieve stride");
   }
-  err = gralloc::GetMetaDataValue(hdl, (int64_t)StandardMetadataType::BUFFER_ID,
-                                  &output_buffer.handle_id);
-  if (err != gralloc::Error::NONE) {
-    DLOGE("Failed to retrieve buffer id");
-  }
+  buf.handle_id = handle_id;
 
-  output_buffer.acquire_fence = acquire_fence;
-
-  if (output_buffer.format == kFormatInvalid) {
+  if (buf.format == kFormatInvalid) {
     DLOGW("Format %d is not supported by SDM", format);
     return HWC3::Error::BadParameter;
-  } else if (!display_intf_->IsWriteBackSupportedFormat(output_buffer.format)) {
-    DLOGW("WB doesn't support color format : %s .", GetFormatString(output_buffer.format));
+  } else if (!display_intf_->IsWriteBackSupportedFormat(buf.format)) {
+    DLOGW("WB doesn't support color format : %s .", GetFormatString(buf.format));
+    return HWC3::Error::BadParameter;
+  }
+
+  if (handle_id) {
+    if (readback_buffer_cache_.size() >= kMaxReadbackBufferCache) {
+      // Client moved on to a new set of buffers.
+      readback_buffer_cache_.clear();
+    }
+    readback_buffer_cache_[handle_id] = buf;
+  }
+
+  return HWC3::Error::None;
+}
+
+HWC3::Error HWCDisplay::SetReadbackBuffer(const native_handle_t *buffer,
+                                          shared_ptr<Fence> acquire_fence, CwbConfig cwb_config,
+                                          CWBClient client) {
+  if (current_power_mode_ == PowerMode::OFF || current_power_mode_ == PowerMode::DOZE_SUSPEND) {
+    DLOGW("CWB requested on either Powered-Off or Doze-Suspended display.");
+    return HWC3::Error::BadDisplay;
+  }
+
+  if (secure_event_ != kSecureEventMax) {
+    DLOGW("CWB is not supported as TUI transition is in progress");
+    return HWC3::Error::Unsupported;
+  }
+
+  if (!buffer) {
+    DLOGE("Bad parameter: handle is null");
     return HWC3::Error::BadParameter;
   }
 
+  LayerBuffer output_buffer = {};
+  HWC3::Error status = GetReadbackBufferInfo(buffer, &output_buffer);
+  if (status != HWC3::Error::None) {
+    return status;
+  }
+  output_buffer.acquire_fence = acquire_fence;
+
   CwbConfig config = cwb_config;
   LayerRect &roi = config.cwb_roi;
   LayerRect &full_rect = config.cwb_full_rect;
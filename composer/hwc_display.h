@@ -32,6 +32,7 @@
 #include <aidl/android/hardware/graphics/common/BufferUsage.h>
 #include <core/core_interface.h>
 #include <private/color_params.h>
+#include <utils/frame_dump_writer.h>
 #include <sys/stat.h>
 #include <algorithm>
 #include <bitset>
@@ -205,6 +206,7 @@ class HWCDisplay : public DisplayEventHandler {
     return kErrorNotSupported;
   }
   virtual PowerMode GetCurrentPowerMode();
+  uint32_t GetCurrentRefreshRate() { return current_refresh_rate_; }
   virtual int SetFrameBufferResolution(uint32_t x_pixels, uint32_t y_pixels);
   virtual void GetFrameBufferResolution(uint32_t *x_pixels, uint32_t *y_pixels);
   virtual int SetDisplayStatus(DisplayStatus display_status);
@@ -582,6 +584,7 @@ class HWCDisplay : public DisplayEventHandler {
   BufferInfo output_buffer_info_ = {};
   void *output_buffer_base_ = nullptr;  // points to base address of output_buffer_info_
   CwbConfig output_buffer_cwb_config_ = {};
+  FrameDumpWriter frame_dump_writer_;
 
   // Members for 1 frame capture in a client provided buffer
   bool frame_capture_buffer_queued_ = false;
@@ -597,10 +600,15 @@ class HWCDisplay : public DisplayEventHandler {
   std::condition_variable cwb_cv_;
   std::map<CWBClient, CWBCaptureResponse> cwb_capture_status_map_;
   static constexpr unsigned int kCwbWaitMs = 100;
+  // Validated readback buffer description per buffer id. Readback clients cycle through a small
+  // set of buffers, so metadata lookup and format negotiation is done once per buffer.
+  std::map<uint64_t, LayerBuffer> readback_buffer_cache_ = {};
+  static constexpr uint32_t kMaxReadbackBufferCache = 8;
   bool validate_done_ = false;
 
  private:
   bool CanSkipSdmPrepare(uint32_t *num_types, uint32_t *num_requests);
+  HWC3::Error GetReadbackBufferInfo(const native_handle_t *buffer, LayerBuffer *output_buffer);
   void WaitOnPreviousFence();
   bool NotifyIdleNow();
   qService::QService *qservice_ = NULL;
@@ -0,0 +1,45 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "hwc_display_bringup.h"
+
+namespace sdm {
+
+void DisplayBringUp::Add(PrepareFn prepare, PublishFn publish) {
+  displays_.push_back({std::move(prepare), std::move(publish)});
+}
+
+int DisplayBringUp::Run() {
+  std::vector<Display> displays;
+  displays.swap(displays_);
+  if (displays.empty()) {
+    return 0;
+  }
+
+  // The first display is prepared on this thread, a batch of one doesn't start any thread.
+  std::vector<int> status(displays.size(), 0);
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < displays.size(); i++) {
+    threads.emplace_back([&displays, &status, i]() { status[i] = displays[i].prepare(); });
+  }
+  status[0] = displays[0].prepare();
+
+  int ret = 0;
+  for (size_t i = 0; i < displays.size(); i++) {
+    if (i) {
+      threads[i - 1].join();
+    }
+    displays[i].publish(status[i]);
+    ret = ret ? ret : status[i];
+  }
+
+  return ret;
+}
+
+}  // namespace sdm
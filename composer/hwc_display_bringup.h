@@ -0,0 +1,41 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __HWC_DISPLAY_BRINGUP_H__
+#define __HWC_DISPLAY_BRINGUP_H__
+
+#include <functional>
+#include <vector>
+
+namespace sdm {
+
+// Brings up a batch of displays in two phases. Prepare creates the display and must not touch
+// session state, it runs for all displays of the batch at once, each on its own thread. Publish
+// makes a prepared display visible, it runs on the thread calling Run(), one display at a time in
+// Add() order, as soon as that display is prepared.
+class DisplayBringUp {
+ public:
+  // Returns 0 or a negative errno.
+  typedef std::function<int()> PrepareFn;
+  // Gets the status of the prepare, also on failure so that the display can be cleaned up.
+  typedef std::function<void(int status)> PublishFn;
+
+  void Add(PrepareFn prepare, PublishFn publish);
+  size_t Size() const { return displays_.size(); }
+  // Returns the first failed prepare status in Add() order or 0, and empties the batch.
+  int Run();
+
+ private:
+  struct Display {
+    PrepareFn prepare;
+    PublishFn publish;
+  };
+
+  std::vector<Display> displays_;
+};
+
+}  // namespace sdm
+
+#endif  // __HWC_DISPLAY_BRINGUP_H__
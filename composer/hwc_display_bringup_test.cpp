@@ -0,0 +1,177 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <errno.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "hwc_display_bringup.h"
+
+namespace sdm {
+namespace {
+
+const auto kTimeout = std::chrono::seconds(5);
+
+// Stands in for CoreImpl and the session: creation looks the display up under a core lock and
+// initializes it off the lock like CoreImpl::CreateDisplay() does, everything else is recorded
+// in one event log.
+class FakeCore {
+ public:
+  struct Event {
+    enum Type { kPrepareStart, kPrepareEnd, kPublish } type;
+    int display;
+    std::thread::id thread;
+  };
+
+  int CreateDisplay(int display, std::chrono::milliseconds duration, int status = 0) {
+    Record(Event::kPrepareStart, display);
+    {
+      std::lock_guard<std::mutex> lock(core_lock_);
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    std::this_thread::sleep_for(duration);
+    Record(Event::kPrepareEnd, display);
+    return status;
+  }
+
+  void Publish(int display) { Record(Event::kPublish, display); }
+
+  // Blocks until Publish(display) or the timeout.
+  bool WaitForPublish(int display) {
+    std::unique_lock<std::mutex> lock(lock_);
+    return cv_.wait_for(lock, kTimeout, [&]() { return Find(Event::kPublish, display) >= 0; });
+  }
+
+  // Position of the event in the log or -1.
+  int Find(Event::Type type, int display) const {
+    for (size_t i = 0; i < events_.size(); i++) {
+      if (events_[i].type == type && events_[i].display == display) {
+        return static_cast<int>(i);
+      }
+    }
+    return -1;
+  }
+
+  std::vector<Event> events_;
+
+ private:
+  void Record(Event::Type type, int display) {
+    std::lock_guard<std::mutex> lock(lock_);
+    events_.push_back({type, display, std::this_thread::get_id()});
+    cv_.notify_all();
+  }
+
+  std::mutex core_lock_;
+  std::mutex lock_;
+  std::condition_variable cv_;
+};
+
+}  // namespace
+
+TEST(DisplayBringUpTest, EmptyBatch) {
+  DisplayBringUp bring_up;
+  EXPECT_EQ(bring_up.Run(), 0);
+}
+
+TEST(DisplayBringUpTest, PreparesRunConcurrently) {
+  const int kDisplays = 4;
+  std::mutex lock;
+  std::condition_variable cv;
+  int started = 0;
+
+  // Every prepare waits for all of them to have started, which only works if they overlap.
+  DisplayBringUp bring_up;
+  std::vector<bool> overlapped(kDisplays, false);
+  for (int i = 0; i < kDisplays; i++) {
+    bring_up.Add([&, i]() {
+      std::unique_lock<std::mutex> guard(lock);
+      started++;
+      cv.notify_all();
+      overlapped[i] = cv.wait_for(guard, kTimeout, [&]() { return started == kDisplays; });
+      return 0;
+    }, [](int) {});
+  }
+
+  EXPECT_EQ(bring_up.Size(), size_t(kDisplays));
+  EXPECT_EQ(bring_up.Run(), 0);
+  EXPECT_EQ(bring_up.Size(), 0u);
+  for (int i = 0; i < kDisplays; i++) {
+    EXPECT_TRUE(overlapped[i]) << "display " << i;
+  }
+}
+
+TEST(DisplayBringUpTest, PublishInAddOrderOnCallingThread) {
+  const int kDisplays = 4;
+  FakeCore core;
+  DisplayBringUp bring_up;
+
+  // Later displays prepare faster, so they finish first.
+  for (int i = 0; i < kDisplays; i++) {
+    auto duration = std::chrono::milliseconds(10 * (kDisplays - i));
+    bring_up.Add([&core, i, duration]() { return core.CreateDisplay(i, duration); },
+                 [&core, i](int status) {
+                   EXPECT_EQ(status, 0);
+                   core.Publish(i);
+                 });
+  }
+  EXPECT_EQ(bring_up.Run(), 0);
+
+  std::vector<int> published;
+  for (auto &event : core.events_) {
+    if (event.type == FakeCore::Event::kPublish) {
+      published.push_back(event.display);
+      EXPECT_EQ(event.thread, std::this_thread::get_id());
+    }
+  }
+  EXPECT_EQ(published, std::vector<int>({0, 1, 2, 3}));
+
+  for (int i = 0; i < kDisplays; i++) {
+    EXPECT_LT(core.Find(FakeCore::Event::kPrepareEnd, i), core.Find(FakeCore::Event::kPublish, i));
+  }
+}
+
+TEST(DisplayBringUpTest, PublishDoesNotWaitForLaterDisplays) {
+  FakeCore core;
+  DisplayBringUp bring_up;
+  bool published_first = false;
+
+  bring_up.Add([&core]() { return core.CreateDisplay(0, std::chrono::milliseconds(0)); },
+               [&core](int) { core.Publish(0); });
+  // Only finishes once the first display is published.
+  bring_up.Add([&]() {
+    published_first = core.WaitForPublish(0);
+    return core.CreateDisplay(1, std::chrono::milliseconds(0));
+  }, [&core](int) { core.Publish(1); });
+
+  EXPECT_EQ(bring_up.Run(), 0);
+  EXPECT_TRUE(published_first);
+}
+
+TEST(DisplayBringUpTest, FailedPrepares) {
+  FakeCore core;
+  DisplayBringUp bring_up;
+  std::vector<int> status(3, 1);
+
+  const int results[] = {0, -ENODEV, -EINVAL};
+  for (int i = 0; i < 3; i++) {
+    bring_up.Add([&core, &results, i]() {
+      return core.CreateDisplay(i, std::chrono::milliseconds(1), results[i]);
+    }, [&status, i](int result) { status[i] = result; });
+  }
+
+  // Every display gets its publish, the first failure is reported.
+  EXPECT_EQ(bring_up.Run(), -ENODEV);
+  EXPECT_EQ(status, std::vector<int>({0, -ENODEV, -EINVAL}));
+
+  // The batch is gone after Run().
+  EXPECT_EQ(bring_up.Run(), 0);
+  EXPECT_EQ(status, std::vector<int>({0, -ENODEV, -EINVAL}));
+}
+
+}  // namespace sdm
@@ -327,36 +327,61 @@ HWC3::Error HWCDisplayBuiltIn::CommitStitchLayers() {
     return HWC3::Error::None;
   }
 
-  LayerStitchContext ctx = {};
   Layer *stitch_layer = stitch_target_->GetSDMLayer();
   LayerBuffer &output_buffer = stitch_layer->input_buffer;
+  stitch_layers_.clear();
+  stitch_sources_.clear();
   for (auto &layer : layer_stack_.layers) {
     LayerComposition &composition = layer->composition;
     if (composition != kCompositionStitch) {
       continue;
     }
 
+    LayerBuffer &input_buffer = layer->input_buffer;
+    LayerStitchPlanner::Source source = {};
+    source.buffer_id = input_buffer.buffer_id;
+    source.width = input_buffer.unaligned_width;
+    source.height = input_buffer.unaligned_height;
+    source.dst_rect = layer->stitch_info.dst_rect;
+    source.slice_rect = layer->stitch_info.slice_rect;
+    source.dirty_regions = &layer->dirty_regions;
+    source.single_buffer = layer->flags.single_buffer;
+    stitch_sources_.push_back(source);
+    stitch_layers_.push_back(layer);
+  }
+
+  if (!stitch_sources_.size()) {
+    // No layers marked for stitch.
+    return HWC3::Error::None;
+  }
+
+  // Stitch target keeps its content across frames, only damaged tiles are rendered again.
+  if (!stitch_planner_.Plan(output_buffer.buffer_id, stitch_sources_, &stitch_draws_)) {
+    // Nothing changed. Stitch target still carries the fence of the last blit.
+    return HWC3::Error::None;
+  }
+
+  for (auto &draw : stitch_draws_) {
+    Layer *layer = stitch_layers_.at(draw.source);
+    LayerBuffer &input_buffer = layer->input_buffer;
     StitchParams params = {};
     // Stitch target doesn't have an input fence.
-    // Render all layers at specified destination.
-    LayerBuffer &input_buffer = layer->input_buffer;
+    // Render layer at specified destination, clipped to the tile.
     params.src_hnd = reinterpret_cast<const native_handle_t *>(input_buffer.buffer_id);
     params.dst_hnd = reinterpret_cast<const native_handle_t *>(output_buffer.buffer_id);
     SetRect(layer->stitch_info.dst_rect, &params.dst_rect);
-    SetRect(layer->stitch_info.slice_rect, &params.scissor_rect);
+    SetRect(draw.scissor, &params.scissor_rect);
+    params.clear_scissor = draw.clear;
     params.src_acquire_fence = input_buffer.acquire_fence;
 
-    ctx.stitch_params.push_back(params);
+    stitch_ctx_.stitch_params.push_back(params);
   }
 
-  if (!ctx.stitch_params.size()) {
-    // No layers marked for stitch.
-    return HWC3::Error::None;
-  }
-
-  layer_stitch_task_.PerformTask(LayerStitchTaskCode::kCodeStitch, &ctx);
+  layer_stitch_task_.PerformTask(LayerStitchTaskCode::kCodeStitch, &stitch_ctx_);
   // Set release fence.
-  output_buffer.acquire_fence = ctx.release_fence;
+  output_buffer.acquire_fence = stitch_ctx_.release_fence;
+  // Drop the source fences, keep the capacity for the next frame.
+  stitch_ctx_.stitch_params.clear();
 
   return HWC3::Error::None;
 }
@@ -413,6 +438,7 @@ HWC3::Error HWCDisplayBuiltIn::Present(shared_ptr<Fence> *out_retire_fence) {
   if (display_paused_) {
     return status;
   } else {
+    status = CommitStitchLayers();
     if (status != HWC3::Error::None) {
       DLOGE("Stitch failed: %d", status);
       return status;
@@ -1143,6 +1169,7 @@ HWC3::Error HWCDisplayBuiltIn::SetClientTarget(buffer_handle_t target,
                              sdm_layer->input_buffer.unaligned_height)) {
       return HWC3::Error::BadParameter;
     }
+    UpdateStitchTarget();
   }
 
   return HWC3::Error::None;
@@ -1187,6 +1214,7 @@ int HWCDisplayBuiltIn::Deinit() {
   if (gl_layer_stitch_) {
     layer_stitch_task_.PerformTask(LayerStitchTaskCode::kCodeDestroyInstance, nullptr);
   }
+  FreeStitchBuffers();
 
   histogram.stop();
   return HWCDisplay::Deinit();
@@ -1237,7 +1265,7 @@ bool HWCDisplayBuiltIn::InitLayerStitch() {
   }
 
   if (!AllocateStitchBuffer()) {
-    return true;
+    return false;
   }
 
   stitch_target_ = new HWCLayer(id_, static_cast<HWCBufferAllocator *>(buffer_allocator_));
@@ -1260,15 +1288,30 @@ bool HWCDisplayBuiltIn::AllocateStitchBuffer() {
     return false;
   }
 
-  BufferConfig &config = buffer_info_.buffer_config;
-  config.width = fb_config_.x_pixels;
-  config.height = fb_config_.y_pixels * kBufferHeightFactor;
+  uint32_t width = fb_config_.x_pixels;
+  uint32_t height = fb_config_.y_pixels * kBufferHeightFactor;
 
   // By default UBWC is enabled and below property is global enable/disable for all
   // buffers allocated through gralloc , including framebuffer targets.
   int ubwc_disabled = 0;
   HWCDebugHandler::Get()->GetProperty(DISABLE_UBWC_PROP, &ubwc_disabled);
-  config.format = ubwc_disabled ? kFormatRGBA8888 : kFormatRGBA8888Ubwc;
+  LayerBufferFormat format = ubwc_disabled ? kFormatRGBA8888 : kFormatRGBA8888Ubwc;
+
+  // Reuse a buffer of the same format and size, e.g. when switching back to a previous
+  // frame buffer resolution.
+  for (auto &buffer_info : stitch_buffers_) {
+    BufferConfig &config = buffer_info.buffer_config;
+    if (config.width == width && config.height == height && config.format == format) {
+      buffer_info_ = buffer_info;
+      return true;
+    }
+  }
+
+  BufferInfo buffer_info = {};
+  BufferConfig &config = buffer_info.buffer_config;
+  config.width = width;
+  config.height = height;
+  config.format = format;
 
   config.gfx_client = true;
 
@@ -1277,16 +1320,56 @@ bool HWCDisplayBuiltIn::AllocateStitchBuffer() {
   config.cache = false;
   config.secure_camera = false;
 
-  int err = buffer_allocator_->AllocateBuffer(&buffer_info_);
+  int err = buffer_allocator_->AllocateBuffer(&buffer_info);
 
   if (err != 0) {
-    DLOGE("Failed to allocate buffer. Error: %d", error);
+    DLOGE("Failed to allocate buffer. Error: %d", err);
     return false;
   }
 
+  // Evict the oldest buffer which is not the one currently stitched into.
+  if (stitch_buffers_.size() >= kMaxStitchBuffers) {
+    for (auto it = stitch_buffers_.begin(); it != stitch_buffers_.end(); it++) {
+      if (it->private_data != buffer_info_.private_data) {
+        buffer_allocator_->FreeBuffer(&(*it));
+        stitch_buffers_.erase(it);
+        break;
+      }
+    }
+  }
+
+  stitch_buffers_.push_back(buffer_info);
+  buffer_info_ = buffer_info;
+
   return true;
 }
 
+void HWCDisplayBuiltIn::UpdateStitchTarget() {
+  if (disable_layer_stitch_ || !stitch_target_) {
+    return;
+  }
+
+  // Stitch target follows the frame buffer size.
+  void *private_data = buffer_info_.private_data;
+  if (!AllocateStitchBuffer()) {
+    DLOGW("Keeping %ux%u stitch buffer", buffer_info_.buffer_config.width,
+          buffer_info_.buffer_config.height);
+    return;
+  }
+
+  if (buffer_info_.private_data != private_data) {
+    InitStitchTarget();
+  }
+}
+
+void HWCDisplayBuiltIn::FreeStitchBuffers() {
+  for (auto &buffer_info : stitch_buffers_) {
+    buffer_allocator_->FreeBuffer(&buffer_info);
+  }
+  stitch_buffers_.clear();
+  buffer_info_ = {};
+}
+
 void HWCDisplayBuiltIn::InitStitchTarget() {
   LayerBuffer buffer = {};
   buffer.planes[0].fd = buffer_info_.alloc_buffer_info.fd;
@@ -49,6 +49,7 @@
 #include "hwc_layers.h"
 
 #include "gl_layer_stitch.h"
+#include "layer_stitch_planner.h"
 
 namespace sdm {
 
@@ -178,6 +179,8 @@ class HWCDisplayBuiltIn : public HWCDisplay, public SyncTask<LayerStitchTaskCode
   bool InitLayerStitch();
   void InitStitchTarget();
   bool AllocateStitchBuffer();
+  void UpdateStitchTarget();
+  void FreeStitchBuffers();
   void PostCommitStitchLayers();
   bool NeedsLargeCompPerfHint();
   void ValidateUiScaling();
@@ -195,6 +198,8 @@ class HWCDisplayBuiltIn : public HWCDisplay, public SyncTask<LayerStitchTaskCode
   const int kPerfHintDisplayOff = 0x00001040;
   const int kPerfHintDisplayOn = 0x00001041;
   const int kPerfHintDisplayDoze = 0x00001053;
+  // Stitch buffers kept for reuse across frame buffer resolution switches.
+  const size_t kMaxStitchBuffers = 2;
   HWCBufferAllocator *buffer_allocator_ = nullptr;
   CPUHint *cpu_hint_ = nullptr;
 
@@ -208,7 +213,13 @@ class HWCDisplayBuiltIn : public HWCDisplay, public SyncTask<LayerStitchTaskCode
   SyncTask<LayerStitchTaskCode> layer_stitch_task_;
   GLLayerStitch *gl_layer_stitch_ = nullptr;
   BufferInfo buffer_info_ = {};
+  std::vector<BufferInfo> stitch_buffers_;
   DisplayConfigVariableInfo fb_config_ = {};
+  LayerStitchPlanner stitch_planner_;
+  LayerStitchContext stitch_ctx_ = {};
+  std::vector<Layer *> stitch_layers_;
+  std::vector<LayerStitchPlanner::Source> stitch_sources_;
+  std::vector<LayerStitchPlanner::Draw> stitch_draws_;
 
   bool qsync_enabled_ = false;
   bool qsync_reconfigured_ = false;
@@ -47,6 +47,7 @@ class HWCDisplayEventHandler {
   virtual void VmReleaseDone(Display display) = 0;
   virtual int NotifyCwbDone(int dpy_index, int32_t status, uint64_t handle_id) = 0;
   virtual int NotifyIdleStatus(bool idle_status) = 0;
+  virtual void NotifyPowerModeChange(Display display, PowerMode mode) = 0;
 
  protected:
   virtual ~HWCDisplayEventHandler() {}
@@ -94,13 +94,6 @@ HWC3::Error HWCDisplayVirtual::DumpVDSBuffer() {
       BufferInfo buffer_info;
       const native_handle_t *output_handle =
           reinterpret_cast<const native_handle_t *>(output_buffer_->buffer_id);
-      void *base_ptr = NULL;
-      int error = buffer_allocator_->MapBuffer(output_handle, nullptr, &base_ptr);
-      if (error != 0) {
-        DLOGE("Failed to map output buffer, error = %d", error);
-        dump_frame_index_ = dump_frame_count_ = 0;
-        return HWC3::Error::BadParameter;
-      }
       uint32_t width, height, alloc_size = 0;
       int32_t format, flags = 0;
       buffer_allocator_->GetWidth((void *)output_handle, width);
@@ -112,19 +105,14 @@ HWC3::Error HWCDisplayVirtual::DumpVDSBuffer() {
       buffer_info.buffer_config.width = width;
       buffer_info.buffer_config.height = height;
       buffer_info.buffer_config.format = HWCLayer::GetSDMFormat(format, flags);
+      buffer_info.alloc_buffer_info.fd = output_buffer_->planes[0].fd;
       buffer_info.alloc_buffer_info.aligned_width = width;
       buffer_info.alloc_buffer_info.aligned_height = height;
       buffer_info.alloc_buffer_info.size = alloc_size;
-      DumpOutputBuffer(buffer_info, base_ptr, layer_stack_.retire_fence);
+      // Output buffer is dumped by reference once retire fence signals, no mapping needed here.
+      DumpOutputBuffer(buffer_info, nullptr, layer_stack_.retire_fence);
       dump_frame_count_--;
       dump_frame_index_++;
-
-      int release_fence = -1;
-      error = buffer_allocator_->UnmapBuffer(output_handle, &release_fence);
-      if (error != 0) {
-        DLOGE("Failed to unmap buffer, error = %d", error);
-        return HWC3::Error::BadParameter;
-      }
     } else {
       DLOGW(
           "Output buffer handle is detected as null."
@@ -56,6 +56,11 @@ int HWCDisplayVirtualGPU::Init() {
 
   disable_animation_ = Debug::IsExtAnimDisabled();
 
+  int value = 0;
+  if (HWCDebugHandler::Get()->GetProperty(CPU_COLOR_CONVERT_MAX_PIXELS, &value) == kErrorNone) {
+    cpu_convert_max_pixels_ = value;
+  }
+
   return HWCDisplayVirtual::Init();
 }
 
@@ -64,6 +69,7 @@ int HWCDisplayVirtualGPU::Deinit() {
   if (gl_color_convert_) {
     color_convert_task_.PerformTask(ColorConvertTaskCode::kCodeDestroyInstance, nullptr);
   }
+  cpu_color_convert_ = nullptr;
 
   DisplayError error = core_intf_->DestroyNullDisplay(display_intf_);
   if (error != kErrorNone) {
@@ -178,6 +184,13 @@ HWC3::Error HWCDisplayVirtualGPU::Present(shared_ptr<Fence> *out_retire_fence) {
 
   layer_stack_.output_buffer = output_buffer_;
 
+  // Small outputs are converted on the CPU, which also avoids creating the GL context.
+  if (ConvertOnCpu() == 0) {
+    DumpVDSBuffer();
+    *out_retire_fence = nullptr;
+    return status;
+  }
+
   // Ensure that blit is initialized.
   // GPU context gets in secure or non-secure mode depending on output buffer provided.
   if (!gl_color_convert_) {
@@ -212,6 +225,123 @@ HWC3::Error HWCDisplayVirtualGPU::Present(shared_ptr<Fence> *out_retire_fence) {
   return status;
 }
 
+bool HWCDisplayVirtualGPU::CanConvertOnCpu(CpuColorConvert::Source *src,
+                                           CpuColorConvert::Target *dst) {
+  const LayerBuffer &input_buffer = client_target_->GetSDMLayer()->input_buffer;
+  uint64_t pixels = UINT64(output_buffer_->unaligned_width) * output_buffer_->unaligned_height;
+  if (pixels > UINT64(std::max(cpu_convert_max_pixels_, 0))) {
+    return false;
+  }
+
+  // No CPU access to protected buffers, and no scaling on the CPU.
+  if (output_buffer_->flags.secure || input_buffer.flags.secure ||
+      input_buffer.unaligned_width != output_buffer_->unaligned_width ||
+      input_buffer.unaligned_height != output_buffer_->unaligned_height) {
+    return false;
+  }
+
+  switch (input_buffer.format) {
+    case kFormatRGBA8888:
+    case kFormatRGBX8888:
+      src->format = CpuColorConvert::kSourceRGBA8888;
+      break;
+    case kFormatRGBA1010102:
+    case kFormatRGBX1010102:
+      src->format = CpuColorConvert::kSourceRGBA1010102;
+      break;
+    default:
+      return false;
+  }
+
+  switch (output_buffer_->format) {
+    case kFormatYCbCr420SemiPlanar:
+    case kFormatYCbCr420SemiPlanarVenus:
+      dst->format = CpuColorConvert::kTargetNV12;
+      break;
+    case kFormatYCbCr420P010:
+    case kFormatYCbCr420P010Venus:
+      dst->format = CpuColorConvert::kTargetP010;
+      break;
+    default:
+      return false;
+  }
+
+  AllocatedBufferInfo buffer_info = {};
+  buffer_info.format = output_buffer_->format;
+  buffer_info.aligned_width = output_buffer_->width;
+  buffer_info.aligned_height = output_buffer_->height;
+  uint32_t stride[4] = {}, offset[4] = {}, num_planes = 0;
+  if (buffer_allocator_->GetBufferLayout(buffer_info, stride, offset, &num_planes) ||
+      num_planes != 2) {
+    return false;
+  }
+
+  src->stride = input_buffer.planes[0].stride * 4;
+  dst->y_stride = stride[0];
+  dst->uv_stride = stride[1];
+  // Plane offsets until mapped.
+  dst->y = reinterpret_cast<void *>(uintptr_t(offset[0]));
+  dst->uv = reinterpret_cast<void *>(uintptr_t(offset[1]));
+
+  return true;
+}
+
+int HWCDisplayVirtualGPU::ConvertOnCpu() {
+  CpuColorConvert::Source src = {};
+  CpuColorConvert::Target dst = {};
+  if (!CanConvertOnCpu(&src, &dst)) {
+    return -ENOTSUP;
+  }
+
+  DTRACE_SCOPED();
+  LayerBuffer &input_buffer = client_target_->GetSDMLayer()->input_buffer;
+  auto src_hnd = reinterpret_cast<const native_handle_t *>(input_buffer.buffer_id);
+  void *src_base = nullptr, *dst_base = nullptr;
+  int release_fd = -1;
+
+  // Mapping waits for the acquire fences.
+  if (buffer_allocator_->MapBuffer(src_hnd, input_buffer.acquire_fence, &src_base)) {
+    DLOGW("Failed to map client target, using the GPU");
+    return -EINVAL;
+  }
+
+  uint64_t usage = UINT64(BufferUsage::CPU_READ_OFTEN) | UINT64(BufferUsage::CPU_WRITE_OFTEN);
+  if (buffer_allocator_->MapBuffer(output_handle_, output_buffer_->acquire_fence, usage,
+                                   &dst_base)) {
+    DLOGW("Failed to map output buffer, using the GPU");
+    buffer_allocator_->UnmapBuffer(src_hnd, &release_fd);
+    return -EINVAL;
+  }
+
+  src.data = src_base;
+  dst.y = static_cast<uint8_t *>(dst_base) + reinterpret_cast<uintptr_t>(dst.y);
+  dst.uv = static_cast<uint8_t *>(dst_base) + reinterpret_cast<uintptr_t>(dst.uv);
+
+  const ColorMetaData &color_metadata = output_buffer_->color_metadata;
+  CpuColorConvert::Standard standard = CpuColorConvert::kBT601;
+  if (color_metadata.colorPrimaries == ColorPrimaries_BT709_5) {
+    standard = CpuColorConvert::kBT709;
+  } else if (color_metadata.colorPrimaries == ColorPrimaries_BT2020) {
+    standard = CpuColorConvert::kBT2020;
+  }
+  CpuColorConvert::Range range = (color_metadata.range == Range_Full) ?
+                                 CpuColorConvert::kRangeFull : CpuColorConvert::kRangeLimited;
+
+  if (!cpu_color_convert_) {
+    cpu_color_convert_ = std::make_unique<CpuColorConvert>(kCpuConvertThreads);
+  }
+  int status = cpu_color_convert_->Convert(src, dst, output_buffer_->unaligned_width,
+                                           output_buffer_->unaligned_height, standard, range);
+
+  buffer_allocator_->UnmapBuffer(output_handle_, &release_fd);
+  buffer_allocator_->UnmapBuffer(src_hnd, &release_fd);
+  if (status) {
+    DLOGW("CPU color convert failed %d, using the GPU", status);
+  }
+
+  return status;
+}
+
 void HWCDisplayVirtualGPU::OnTask(const ColorConvertTaskCode &task_code,
                                   SyncTask<ColorConvertTaskCode>::TaskContext *task_context) {
   switch (task_code) {
@@ -37,9 +37,12 @@
 #ifndef __HWC_DISPLAY_VIRTUAL_GPU_H__
 #define __HWC_DISPLAY_VIRTUAL_GPU_H__
 
+#include <memory>
+
 #include "utils/sync_task.h"
 #include "hwc_display_virtual.h"
 #include "gl_color_convert.h"
+#include "cpu_color_convert.h"
 
 namespace sdm {
 
@@ -84,12 +87,20 @@ class HWCDisplayVirtualGPU : public HWCDisplayVirtual,
   }
 
  private:
+  // Outputs up to this many pixels are converted on the CPU by default, 720p.
+  static const int kCpuConvertMaxPixels = 1280 * 720;
+  static const uint32_t kCpuConvertThreads = 4;
+
   // SyncTask methods.
   void OnTask(const ColorConvertTaskCode &task_code,
               SyncTask<ColorConvertTaskCode>::TaskContext *task_context);
+  bool CanConvertOnCpu(CpuColorConvert::Source *src, CpuColorConvert::Target *dst);
+  int ConvertOnCpu();
 
   SyncTask<ColorConvertTaskCode> color_convert_task_;
   GLColorConvert *gl_color_convert_ = nullptr;
+  std::unique_ptr<CpuColorConvert> cpu_color_convert_;
+  int cpu_convert_max_pixels_ = kCpuConvertMaxPixels;
 
   bool disable_animation_ = false;
   bool animation_in_progress_ = false;
@@ -28,6 +28,7 @@
 #include <binder/Parcel.h>
 #include <core/buffer_allocator.h>
 #include <cutils/properties.h>
+#include <display_config_notify.h>
 #include <hardware_legacy/uevent.h>
 #include <private/color_params.h>
 #include <sync/sync.h>
@@ -50,6 +51,7 @@
 #include "hwc_buffer_allocator.h"
 #include "hwc_session.h"
 #include "hwc_debugger.h"
+#include "hwc_display_bringup.h"
 #include "ipc_impl.h"
 
 #define __CLASS__ "HWCSession"
@@ -255,6 +257,10 @@ int HWCSession::Init() {
     return -EINVAL;
   }
 
+  if (status_page_.Init()) {
+    DLOGW("Display status page unavailable, clients fall back to binder queries");
+  }
+
   int value = 0;  // Default value when property is not present.
   HWCDebugHandler::Get()->GetProperty(ENABLE_VERBOSE_LOG, &value);
   if (value == 1) {
@@ -365,6 +371,8 @@ int HWCSession::Deinit() {
     DLOGE("Display core de-initialization failed. Error = %d", error);
   }
 
+  status_page_.Deinit();
+
   SCOPE_LOCK(primary_display_lock_);
   primary_pending_ = true;
 
@@ -786,6 +794,8 @@ HWC3::Error HWCSession::getDisplayDecorationSupport(Display display, PixelFormat
 
 void HWCSession::PerformQsyncCallback(Display display, bool qsync_enabled, uint32_t refresh_rate,
                                       uint32_t qsync_refresh_rate) {
+  status_page_.UpdateQsync(display, qsync_enabled, refresh_rate, qsync_refresh_rate);
+
   // AIDL callback
   if (!callback_clients_.empty()) {
     std::lock_guard<decltype(callbacks_lock_)> lock_guard(callbacks_lock_);
@@ -821,7 +831,7 @@ HWC3::Error HWCSession::PresentDisplay(Display display, shared_ptr<Fence> *out_r
     return HWC3::Error::BadDisplay;
   }
 
-  HandleSecureSession();
+  HandleSecureSession(display);
 
   {
     SEQUENCE_EXIT_SCOPE_LOCK(locker_[display]);
@@ -868,6 +878,13 @@ void HWCSession::PostCommitLocked(Display display, shared_ptr<Fence> &retire_fen
   }
   PerformIdleStatusCallback(display);
 
+  HWCStatusPage::FrameStatus &frame = frame_status_[display];
+  frame.power_mode = hwc_display_[display]->GetCurrentPowerMode();
+  hwc_display_[display]->GetActiveDisplayConfig(&frame.active_config);
+  frame.refresh_rate = hwc_display_[display]->GetCurrentRefreshRate();
+  frame.idle = hwc_display_[display]->IsDisplayIdle();
+  frame_status_pending_[display] = true;
+
   if (clients_waiting_for_commit_[display].any()) {
     retire_fence_[display] = retire_fence;
     commit_error_[display] = 0;
@@ -879,6 +896,10 @@ void HWCSession::PostCommitUnlocked(Display display, const shared_ptr<Fence> &re
   HandlePendingPowerMode(display, retire_fence);
   HandlePendingHotplug(display, retire_fence);
   HandlePendingRefresh();
+  if (frame_status_pending_[display]) {
+    frame_status_pending_[display] = false;
+    status_page_.UpdateFrame(display, frame_status_[display]);
+  }
   display_ready_.set(UINT32(display));
   std::unique_lock<std::mutex> caller_lock(hotplug_mutex_);
   if (!resource_ready_) {
@@ -1234,6 +1255,8 @@ HWC3::Error HWCSession::SetPowerMode(Display display, int32_t int_mode) {
     if (error != HWC3::Error::None) {
       return error;
     }
+  status_page_.UpdatePowerMode(display, mode);
+
   // Reset idle pc ref count on suspend, as we enable idle pc during suspend.
   if (mode == PowerMode::OFF) {
     idle_pc_ref_cnt_ = 0;
@@ -1866,6 +1889,24 @@ android::status_t HWCSession::notifyCallback(uint32_t command, const android::Pa
       output_parcel->writeInt32(status);
     } break;
 
+    case qService::IQService::GET_DISPLAY_STATUS_PAGE: {
+      if (!output_parcel) {
+        DLOGE("QService command = %d: output_parcel needed.", command);
+        break;
+      }
+      int fd = status_page_.GetFd();
+      status = (fd < 0) ? -ENODEV : 0;
+      output_parcel->writeInt32(status);
+      if (!status) {
+        status = output_parcel->writeDupFileDescriptor(fd);
+      }
+    } break;
+
+    case qService::IQService::RELOAD_DEBUG_PROPERTIES:
+      Debug::ReloadProperties();
+      status = 0;
+      break;
+
     case qService::IQService::GET_DISPLAY_PORT_ID: {
       if (!input_parcel || !output_parcel) {
         DLOGE("QService command = %d: input_parcel and output_parcel needed.", command);
@@ -1954,6 +1995,23 @@ android::status_t HWCSession::notifyCallback(uint32_t command, const android::Pa
       break;
   }
 
+  if (status == android::OK) {
+    // Commands which change what DisplayConfig clients cache. Active config changes notify
+    // from HWCDisplay::SetActiveConfigIndex() once applied.
+    switch (command) {
+      case qService::IQService::SET_DISPLAY_MODE:
+      case qService::IQService::SET_SECONDARY_DISPLAY_STATUS:
+      case qService::IQService::CONFIGURE_DYN_REFRESH_RATE:
+      case qService::IQService::SET_LAYER_MIXER_RESOLUTION:
+      case qService::IQService::SET_DSI_CLK:
+      case qService::IQService::SET_PANEL_LUMINANCE:
+        DisplayConfig::NotifyDisplayConfigChanged();
+        break;
+      default:
+        break;
+    }
+  }
+
   return status;
 }
 
@@ -2928,7 +2986,14 @@ int HWCSession::HandleBuiltInDisplays() {
     return -EINVAL;
   }
 
-  int status = 0;
+  // Each built-in display claims the next free slot, then all of them are created at once off
+  // the slot locks and published in slot order. Concurrent HWCDisplayBuiltIn::Create() calls
+  // only share the core, whose CreateDisplay() initializes displays off the core lock, the debug
+  // handler, which reads properties without state, and the buffer allocator, whose lazy gralloc
+  // init is locked. CPUHint and everything else they set up belongs to the display being created.
+  DisplayBringUp bring_up;
+  std::vector<HWCDisplay *> created(hw_displays_info.size(), nullptr);
+  auto slot = map_info_builtin_.begin();
   for (auto &iter : hw_displays_info) {
     auto &info = iter.second;
 
@@ -2937,50 +3002,67 @@ int HWCSession::HandleBuiltInDisplays() {
       continue;
     }
 
-    for (auto &map_info : map_info_builtin_) {
-      Display client_id = map_info.client_id;
+    slot = std::find_if(slot, map_info_builtin_.end(), [this](auto &map_info) {
+      SCOPE_LOCK(locker_[map_info.client_id]);
+      return !hwc_display_[map_info.client_id];
+    });
+    if (slot == map_info_builtin_.end()) {
+      break;
+    }
 
-      {
-        SCOPE_LOCK(locker_[client_id]);
-        // Lock confined to this scope
-        if (hwc_display_[client_id]) {
-          continue;
-        }
+    Display claimed_id = (slot++)->client_id;
+    int32_t sdm_id = info.display_id;
+    HWCDisplay **hwc_display = &created[bring_up.Size()];
+    auto create = [this, sdm_id, hwc_display](Display client_id) {
+      DLOGI("Create builtin display, sdm id = %d, client id = %d", sdm_id, UINT32(client_id));
+      return HWCDisplayBuiltIn::Create(core_intf_, &buffer_allocator_, &callbacks_, this,
+                                       qservice_, client_id, sdm_id, hwc_display);
+    };
+    bring_up.Add([create, claimed_id]() { return create(claimed_id); },
+                 [this, create, claimed_id, sdm_id, hwc_display](int status) {
+      if (status) {
+        DLOGE("Builtin display creation failed.");
+        return;
+      }
 
-        DLOGI("Create builtin display, sdm id = %d, client id = %d", info.display_id,
-              UINT32(client_id));
-        status =
-            HWCDisplayBuiltIn::Create(core_intf_, &buffer_allocator_, &callbacks_, this, qservice_,
-                                      client_id, info.display_id, &hwc_display_[client_id]);
-        if (status) {
+      // A failed creation earlier in this batch leaves its slot free, move down into it.
+      DisplayMapInfo *slot_info = GetFreeSlot(&map_info_builtin_);
+      if (!slot_info || slot_info->client_id != claimed_id) {
+        HWCDisplayBuiltIn::Destroy(*hwc_display);
+        *hwc_display = nullptr;
+        if (!slot_info || create(slot_info->client_id)) {
           DLOGE("Builtin display creation failed.");
-          break;
+          return;
         }
+      }
+      DisplayMapInfo &map_info = *slot_info;
+      Display client_id = map_info.client_id;
 
+      {
+        SCOPE_LOCK(locker_[client_id]);
+        hwc_display_[client_id] = *hwc_display;
         {
           SCOPE_LOCK(hdr_locker_[client_id]);
           is_hdr_display_[UINT32(client_id)] = HasHDRSupport(hwc_display_[client_id]);
         }
 
-        DLOGI("Builtin display created: sdm id = %d, client id = %d", info.display_id,
-              UINT32(client_id));
-        map_info.disp_type = info.display_type;
-        map_info.sdm_id = info.display_id;
+        DLOGI("Builtin display created: sdm id = %d, client id = %d", sdm_id, UINT32(client_id));
+        map_info.disp_type = kBuiltIn;
+        map_info.sdm_id = sdm_id;
 
         map_active_displays_.insert(std::make_pair(client_id, &map_info));
       }
 
-      DLOGI("Hotplugging builtin display, sdm id = %d, client id = %d", info.display_id,
+      DLOGI("Hotplugging builtin display, sdm id = %d, client id = %d", sdm_id,
             UINT32(client_id));
-      // Free lock before the callback
+      // Free lock before the callback, displays still being created don't hold it.
       primary_display_lock_.Unlock();
       callbacks_.Hotplug(client_id, true);
       primary_display_lock_.Lock();
-      break;
-    }
+    });
   }
 
-  return status;
+  return bring_up.Run();
 }
 
 bool HWCSession::IsHWDisplayConnected(Display client_id) {
@@ -3048,10 +3130,13 @@ int HWCSession::HandlePluggableDisplays(bool delay_hotplug) {
   int status = HandleDisconnectedDisplays(&hw_displays_info);
   if (status) {
     DLOGE("All displays could not be disconnected.");
+    DisplayConfig::NotifyDisplayConfigChanged();
     return status;
   }
 
   status = HandleConnectedDisplays(&hw_displays_info, delay_hotplug);
+  // Display list changed, drop what DisplayConfig clients cached about it.
+  DisplayConfig::NotifyDisplayConfigChanged();
   if (status) {
     switch (status) {
       case -EAGAIN:
@@ -3085,6 +3170,11 @@ int HWCSession::HandleConnectedDisplays(HWDisplaysInfo *hw_displays_info, bool d
   int status = 0;
   Display client_id = 0;
 
+  // Displays are created at once off the slot locks and published in slot order, see
+  // DisplayBringUp.
+  DisplayBringUp bring_up;
+  std::vector<HWCDisplay *> created(hw_displays_info->size(), nullptr);
+  auto slot = map_info_pluggable_.begin();
   for (auto &iter : *hw_displays_info) {
     auto &info = iter.second;
 
@@ -3101,8 +3191,9 @@ int HWCSession::HandleConnectedDisplays(HWDisplaysInfo *hw_displays_info, bool d
       continue;
     }
 
-    // Count active pluggable display slots and slots with no commits.
-    bool first_commit_pending = false;
+    // Count active pluggable display slots and slots with no commits, a display still being
+    // created has no commit either.
+    bool first_commit_pending = (bring_up.Size() > 0);
     std::for_each(map_info_pluggable_.begin(), map_info_pluggable_.end(), [&](auto &p) {
       SCOPE_LOCK(locker_[p.client_id]);
       if (hwc_display_[p.client_id]) {
@@ -3130,60 +3221,77 @@ int HWCSession::HandleConnectedDisplays(HWDisplaysInfo *hw_displays_info, bool d
       break;
     }
 
-    // find an empty slot to create display.
-    for (auto &map_info : map_info_pluggable_) {
-      client_id = map_info.client_id;
+    // find an empty slot to create display, slots before it are used or claimed by this batch.
+    slot = std::find_if(slot, map_info_pluggable_.end(), [this](auto &map_info) {
+      SCOPE_LOCK(locker_[map_info.client_id]);
+      return !hwc_display_[map_info.client_id];
+    });
+    if (slot == map_info_pluggable_.end()) {
+      continue;
+    }
 
-      SCOPE_LOCK(locker_[client_id]);
-      auto &hwc_display = hwc_display_[client_id];
-      if (hwc_display) {
-        // Display slot is already used.
-        continue;
+    Display claimed_id = (slot++)->client_id;
+    int32_t sdm_id = info.display_id;
+    HWCDisplay **hwc_display = &created[bring_up.Size()];
+
+    // Test pattern generation ?
+    bool test_pattern = (hpd_bpp_ > 0) && (hpd_pattern_ > 0);
+    auto create = [this, sdm_id, test_pattern, hwc_display](Display client_id) {
+      DLOGI("Create pluggable display, sdm id = %d, client id = %d", sdm_id, UINT32(client_id));
+      if (!test_pattern) {
+        return HWCDisplayPluggable::Create(core_intf_, &buffer_allocator_, &callbacks_, this,
+                                           qservice_, client_id, sdm_id, 0, 0, false,
+                                           hwc_display);
       }
-
-      DLOGI("Create pluggable display, sdm id = %d, client id = %d", info.display_id,
-            UINT32(client_id));
-
-      // Test pattern generation ?
-      map_info.test_pattern = (hpd_bpp_ > 0) && (hpd_pattern_ > 0);
-      int err = 0;
-      if (!map_info.test_pattern) {
-        err = HWCDisplayPluggable::Create(core_intf_, &buffer_allocator_, &callbacks_, this,
-                                          qservice_, client_id, info.display_id, 0, 0, false,
-                                          &hwc_display);
-      } else {
-        err = HWCDisplayPluggableTest::Create(core_intf_, &buffer_allocator_, &callbacks_, this,
-                                              qservice_, client_id, info.display_id,
-                                              UINT32(hpd_bpp_), UINT32(hpd_pattern_), &hwc_display);
+      return HWCDisplayPluggableTest::Create(core_intf_, &buffer_allocator_, &callbacks_, this,
+                                             qservice_, client_id, sdm_id, UINT32(hpd_bpp_),
+                                             UINT32(hpd_pattern_), hwc_display);
+    };
+    bring_up.Add([create, claimed_id]() { return create(claimed_id); },
+                 [this, create, claimed_id, sdm_id, test_pattern, hwc_display,
+                  &client_id](int err) {
+      // A failed creation earlier in this batch leaves its slot free, move down into it.
+      DisplayMapInfo *slot_info = err ? nullptr : GetFreeSlot(&map_info_pluggable_);
+      if (!err && (!slot_info || slot_info->client_id != claimed_id)) {
+        if (!test_pattern) {
+          HWCDisplayPluggable::Destroy(*hwc_display);
+        } else {
+          HWCDisplayPluggableTest::Destroy(*hwc_display);
+        }
+        *hwc_display = nullptr;
+        err = slot_info ? create(slot_info->client_id) : -ENODEV;
       }
-
       if (err) {
         DLOGW("Pluggable display creation failed/aborted. Error %d '%s'.", err, strerror(abs(err)));
-        status = err;
-        // Attempt creating remaining pluggable displays.
-        break;
+        return;
       }
+      DisplayMapInfo &map_info = *slot_info;
+      client_id = map_info.client_id;
 
+      SCOPE_LOCK(locker_[client_id]);
+      hwc_display_[client_id] = *hwc_display;
       {
         SCOPE_LOCK(hdr_locker_[client_id]);
-        is_hdr_display_[UINT32(client_id)] = HasHDRSupport(hwc_display);
+        is_hdr_display_[UINT32(client_id)] = HasHDRSupport(hwc_display_[client_id]);
       }
 
-      DLOGI("Created pluggable display successfully: sdm id = %d, client id = %d", info.display_id,
+      DLOGI("Created pluggable display successfully: sdm id = %d, client id = %d", sdm_id,
             UINT32(client_id));
 
-      map_info.disp_type = info.display_type;
-      map_info.sdm_id = info.display_id;
+      map_info.disp_type = kPluggable;
+      map_info.sdm_id = sdm_id;
+      map_info.test_pattern = test_pattern;
 
       map_active_displays_.insert(std::make_pair(client_id, &map_info));
 
       pending_hotplugs_.push_back((Display)client_id);
-
-      // Display is created for this sdm id, move to next connected display.
-      break;
-    }
+    });
   }
 
+  // A failure doesn't stop the other displays, a deferral above takes precedence.
+  int err = bring_up.Run();
+  status = status ? status : err;
+
   // No display was created.
   if (!pending_hotplugs_.size()) {
     return status;
@@ -3208,6 +3316,20 @@ int HWCSession::HandleConnectedDisplays(HWDisplaysInfo *hw_displays_info, bool d
   return status;
 }
 
+// Displays of one bring up batch claim slots in connection order before they are created, and
+// publish in that order. A failed creation leaves its slot free for the next display to publish,
+// so the slots end up as if the displays had been created one after another.
+HWCSession::DisplayMapInfo *HWCSession::GetFreeSlot(std::vector<DisplayMapInfo> *slots) {
+  for (auto &map_info : *slots) {
+    SCOPE_LOCK(locker_[map_info.client_id]);
+    if (!hwc_display_[map_info.client_id]) {
+      return &map_info;
+    }
+  }
+
+  return nullptr;
+}
+
 bool HWCSession::HasHDRSupport(HWCDisplay *hwc_display) {
   // query number of hdr types
   uint32_t out_num_types = 0;
@@ -3363,8 +3485,10 @@ void HWCSession::DestroyPluggableDisplayLocked(DisplayMapInfo *map_info) {
 
   map_active_displays_.erase(client_id);
   display_ready_.reset(UINT32(client_id));
+  display_power_on_mask_ &= ~(1U << UINT32(client_id));
   pending_power_mode_[client_id] = false;
   hwc_display = nullptr;
+  status_page_.RemoveDisplay(client_id);
   map_info->Reset();
 }
 
@@ -3402,6 +3526,8 @@ void HWCSession::DestroyNonPluggableDisplayLocked(DisplayMapInfo *map_info) {
   pending_power_mode_[client_id] = false;
   hwc_display = nullptr;
   display_ready_.reset(UINT32(client_id));
+  display_power_on_mask_ &= ~(1U << UINT32(client_id));
+  status_page_.RemoveDisplay(client_id);
   map_info->Reset();
 }
 
@@ -3424,9 +3550,8 @@ void HWCSession::PerformDisplayPowerReset() {
   std::lock_guard<std::mutex> lock(command_seq_mutex_);
 
   // Acquire lock on all displays.
-  for (Display display = HWC_DISPLAY_PRIMARY; display < HWCCallbacks::kNumDisplays; display++) {
-    locker_[display].Lock();
-  }
+  Locker::MultiScopeLock lock_all(locker_, HWCCallbacks::kNumDisplays,
+                                  (1ULL << HWCCallbacks::kNumDisplays) - 1);
 
   HWC3::Error status = HWC3::Error::None;
   PowerMode last_power_mode[HWCCallbacks::kNumDisplays] = {};
@@ -3468,11 +3593,6 @@ void HWCSession::PerformDisplayPowerReset() {
     }
   }
 
-  // Release lock on all displays.
-  for (Display display = HWC_DISPLAY_PRIMARY; display < HWCCallbacks::kNumDisplays; display++) {
-    locker_[display].Unlock();
-  }
-
   callbacks_.Refresh(vsync_source);
 }
 
@@ -3491,17 +3611,25 @@ void HWCSession::VmReleaseDone(Display display) {
   }
 }
 
-void HWCSession::HandleSecureSession() {
+void HWCSession::HandleSecureSession(Display display) {
   std::bitset<kSecureMax> secure_sessions = 0;
   Display client_id = HWCCallbacks::kNumDisplays;
-  {
-    // TODO(user): Revisit if supporting secure display on non-primary.
-    Display active_builtin_disp_id = GetActiveBuiltinDisplay();
-    if (active_builtin_disp_id >= HWCCallbacks::kNumDisplays) {
+  // TODO(user): Revisit if supporting secure display on non-primary.
+  Display active_builtin_disp_id = GetActiveBuiltinDisplay();
+  if (active_builtin_disp_id >= HWCCallbacks::kNumDisplays) {
+    return;
+  }
+  if (display == active_builtin_disp_id) {
+    Locker::ScopeLock lock_d(locker_[active_builtin_disp_id]);
+    if (!hwc_display_[active_builtin_disp_id]) {
       return;
     }
-    Locker::ScopeLock lock_d(locker_[active_builtin_disp_id]);
     hwc_display_[active_builtin_disp_id]->GetActiveSecureSession(&secure_sessions);
+    builtin_secure_sessions_ = UINT32(secure_sessions.to_ulong());
+  } else {
+    // Secure sessions only change with the builtin layer stack, which publishes them on its
+    // own commit. Avoid stalling other displays on the builtin locker.
+    secure_sessions = builtin_secure_sessions_.load();
   }
 
   if (secure_sessions[kSecureDisplay] || secure_sessions[kSecureCamera]) {
@@ -3511,6 +3639,22 @@ void HWCSession::HandleSecureSession() {
     return;
   }
 
+  // Displays are updated all at once only when the secure sessions change. Otherwise the state
+  // is already applied and the caller catches up under its own locker, e.g. when it was created
+  // after the transition.
+  uint32_t sessions = UINT32(secure_sessions.to_ulong());
+  if (applied_secure_sessions_.exchange(sessions) == sessions) {
+    if (display >= HWCCallbacks::kNumRealDisplays) {
+      return;
+    }
+    Locker::ScopeLock lock_d(locker_[display]);
+    if (hwc_display_[display]) {
+      hwc_display_[display]->HandleSecureSession(secure_sessions, &pending_power_mode_[display],
+                                                 display == active_builtin_disp_id);
+    }
+    return;
+  }
+
   // If there are any ongoing non-secure virtual displays, we need to destroy them.
   bool is_active_virtual_display = false;
   for (auto &map_info : map_info_virtual_) {
@@ -3525,7 +3669,6 @@ void HWCSession::HandleSecureSession() {
 
   // If it is called during primary prepare/commit, we need to pause any ongoing commit on
   // external/virtual display.
-  bool found_active_secure_display = false;
   for (Display display = HWC_DISPLAY_PRIMARY; display < HWCCallbacks::kNumRealDisplays; display++) {
     Locker::ScopeLock lock_d(locker_[display]);
     HWCDisplay *hwc_display = hwc_display_[display];
@@ -3533,15 +3676,9 @@ void HWCSession::HandleSecureSession() {
       continue;
     }
 
-    bool is_active_secure_display = false;
-    // The first On/Doze/DozeSuspend built-in display is taken as the secure display.
-    if (!found_active_secure_display && hwc_display->GetDisplayClass() == DISPLAY_CLASS_BUILTIN &&
-        hwc_display->GetCurrentPowerMode() != PowerMode::OFF) {
-      is_active_secure_display = true;
-      found_active_secure_display = true;
-    }
+    // The active builtin, the first On/Doze/DozeSuspend built-in display, is the secure display.
     hwc_display->HandleSecureSession(secure_sessions, &pending_power_mode_[display],
-                                     is_active_secure_display);
+                                     display == active_builtin_disp_id);
   }
 }
 
@@ -3556,10 +3693,19 @@ void HWCSession::HandlePendingPowerMode(Display disp_id, const shared_ptr<Fence>
     return;
   }
 
-  Locker::ScopeLock lock_d(locker_[active_builtin_disp_id]);
-  bool pending_power_mode = false;
+  // Displays are scanned one at a time. Never hold the builtin locker while taking another
+  // display's locker outside of Locker::MultiScopeLock, to keep a single lock order.
   std::bitset<kSecureMax> secure_sessions = 0;
-  hwc_display_[active_builtin_disp_id]->GetActiveSecureSession(&secure_sessions);
+  {
+    Locker::ScopeLock lock_d(locker_[active_builtin_disp_id]);
+    if (!hwc_display_[active_builtin_disp_id]) {
+      return;
+    }
+    hwc_display_[active_builtin_disp_id]->GetActiveSecureSession(&secure_sessions);
+    builtin_secure_sessions_ = UINT32(secure_sessions.to_ulong());
+  }
+
+  bool pending_power_mode = false;
   for (Display display = HWC_DISPLAY_PRIMARY + 1; display < HWCCallbacks::kNumDisplays; display++) {
     if (display != active_builtin_disp_id) {
       Locker::ScopeLock lock_d(locker_[display]);
@@ -3599,7 +3745,9 @@ void HWCSession::HandlePendingPowerMode(Display disp_id, const shared_ptr<Fence>
       continue;
     }
 
-    Locker::ScopeLock lock_d(locker_[display]);
+    // Builtin must not start a new secure commit while this display transitions out of it.
+    Locker::MultiScopeLock lock_d(locker_, HWCCallbacks::kNumDisplays,
+                                  (1ULL << active_builtin_disp_id) | (1ULL << display));
     if (!pending_power_mode_[display] || !hwc_display_[display]) {
       continue;
     }
@@ -3868,8 +4016,12 @@ HWC3::Error HWCSession::SetDisplayBrightness(Display display, float brightness)
     return HWC3::Error::BadParameter;
   }
 
-  return (INT32(hwc_display_[display]->SetPanelBrightness(brightness))) ? HWC3::Error::Unsupported
-                                                                        : HWC3::Error::None;
+  if (INT32(hwc_display_[display]->SetPanelBrightness(brightness))) {
+    return HWC3::Error::Unsupported;
+  }
+
+  status_page_.UpdateBrightness(display, brightness);
+  return HWC3::Error::None;
 }
 
 android::status_t HWCSession::SetBppMode(const android::Parcel *input_parcel) {
@@ -3936,22 +4088,34 @@ android::status_t HWCSession::SetIdlePC(const android::Parcel *input_parcel) {
 }
 
 Display HWCSession::GetActiveBuiltinDisplay() {
-  Display active_display = HWCCallbacks::kNumDisplays;
-  // Get first active display among primary and built-in displays.
-  std::vector<DisplayMapInfo> map_info = {map_info_primary_};
-  std::copy(map_info_builtin_.begin(), map_info_builtin_.end(), std::back_inserter(map_info));
-
-  for (auto &info : map_info) {
-    Display target_display = info.client_id;
-    Locker::ScopeLock lock_d(locker_[target_display]);
-    auto &hwc_display = hwc_display_[target_display];
-    if (hwc_display && hwc_display->GetCurrentPowerMode() != PowerMode::OFF) {
-      active_display = info.client_id;
-      break;
+  // Get first active display among primary and built-in displays. Power state is tracked via
+  // NotifyPowerModeChange, so that callers do not need to take builtin display lockers.
+  uint32_t power_on_mask = display_power_on_mask_.load();
+  if (map_info_primary_.client_id < HWCCallbacks::kNumDisplays &&
+      (power_on_mask & (1U << UINT32(map_info_primary_.client_id)))) {
+    return map_info_primary_.client_id;
+  }
+
+  for (auto &info : map_info_builtin_) {
+    if (info.client_id < HWCCallbacks::kNumDisplays &&
+        (power_on_mask & (1U << UINT32(info.client_id)))) {
+      return info.client_id;
     }
   }
 
-  return active_display;
+  return HWCCallbacks::kNumDisplays;
+}
+
+void HWCSession::NotifyPowerModeChange(Display display, PowerMode mode) {
+  if (display >= HWCCallbacks::kNumDisplays) {
+    return;
+  }
+
+  if (mode != PowerMode::OFF) {
+    display_power_on_mask_ |= (1U << UINT32(display));
+  } else {
+    display_power_on_mask_ &= ~(1U << UINT32(display));
+  }
 }
 
 HWC3::Error HWCSession::SetDisplayBrightnessScale(const android::Parcel *input_parcel) {
@@ -4590,7 +4754,7 @@ HWC3::Error HWCSession::CommitOrPrepare(Display display, bool validate_only,
     }
   }
 
-  HandleSecureSession();
+  HandleSecureSession(display);
   auto status = HWC3::Error::None;
   {
     SEQUENCE_ENTRY_SCOPE_LOCK(locker_[display]);
@@ -50,6 +50,8 @@
 #include <atomic>
 #include <core/display_interface.h>
 
+#include "cwb_request_queue.h"
+#include "hwc_command_session.h"
 #include "hwc_callbacks.h"
 #include "hwc_layers.h"
 #include "hwc_display.h"
@@ -62,6 +64,7 @@
 #include "hwc_display_event_handler.h"
 #include "hwc_buffer_sync_handler.h"
 #include "hwc_display_virtual_factory.h"
+#include "hwc_status_page.h"
 
 using ::android::sp;
 using android::hardware::hidl_handle;
@@ -122,8 +125,10 @@ class HWCUEvent {
 class HWCSession : public HWCUEvent,
                    public qClient::BnQClient,
                    public HWCDisplayEventHandler,
+                   public HWCCommandSession,
                    public DisplayConfig::ClientContext {
   friend class aidl::vendor::qti::hardware::display::config::DisplayConfigAIDL;
+  friend class HWCSessionLockingTest;
 
  public:
   enum HotPlugEvent {
@@ -192,21 +197,21 @@ class HWCSession : public HWCUEvent,
   void GetCapabilities(uint32_t *outCount, int32_t *outCapabilities);
   void Dump(uint32_t *out_size, char *out_buffer);
 
-  HWC3::Error AcceptDisplayChanges(Display display);
+  HWC3::Error AcceptDisplayChanges(Display display) override;
   HWC3::Error CreateLayer(Display display, LayerId *out_layer_id);
   HWC3::Error CreateVirtualDisplay(uint32_t width, uint32_t height, int32_t *format,
                                    Display *out_display_id);
   HWC3::Error DestroyLayer(Display display, LayerId layer);
   HWC3::Error DestroyVirtualDisplay(Display display);
-  HWC3::Error PresentDisplay(Display display, shared_ptr<Fence> *out_retire_fence);
+  HWC3::Error PresentDisplay(Display display, shared_ptr<Fence> *out_retire_fence) override;
   void RegisterCallback(CallbackCommand descriptor, void *callback_data, void *callback_fn);
   HWC3::Error SetOutputBuffer(Display display, buffer_handle_t buffer,
-                              const shared_ptr<Fence> &release_fence);
+                              const shared_ptr<Fence> &release_fence) override;
   HWC3::Error SetPowerMode(Display display, int32_t int_mode);
   HWC3::Error SetColorMode(Display display, int32_t /*ColorMode*/ int_mode);
   HWC3::Error SetColorModeWithRenderIntent(Display display, int32_t /*ColorMode*/ int_mode,
                                            int32_t /*RenderIntent*/ int_render_intent);
-  HWC3::Error SetColorTransform(Display display, const std::vector<float> &matrix);
+  HWC3::Error SetColorTransform(Display display, const std::vector<float> &matrix) override;
   HWC3::Error getDisplayDecorationSupport(Display display, PixelFormat_V3 *format,
                                           AlphaInterpretation *alpha);
   HWC3::Error GetReadbackBufferAttributes(Display display, int32_t *format, int32_t *dataspace);
@@ -218,7 +223,7 @@ class HWCSession : public HWCUEvent,
                                            uint8_t *outData);
   HWC3::Error GetDisplayCapabilities(Display display, hidl_vec<HwcDisplayCapability> *capabilities);
   HWC3::Error GetDisplayBrightnessSupport(Display display, bool *outSupport);
-  HWC3::Error SetDisplayBrightness(Display display, float brightness);
+  HWC3::Error SetDisplayBrightness(Display display, float brightness) override;
   HWC3::Error WaitForResources(bool wait_for_resources, Display active_builtin_id,
                                Display display_id);
 
@@ -242,51 +247,52 @@ class HWCSession : public HWCUEvent,
   HWC3::Error GetDisplayName(Display display, uint32_t *out_size, char *out_name);
   HWC3::Error SetActiveConfig(Display display, Config config);
   HWC3::Error GetChangedCompositionTypes(Display display, uint32_t *out_num_elements,
-                                         LayerId *out_layers, int32_t *out_types);
+                                         LayerId *out_layers, int32_t *out_types) override;
   HWC3::Error GetDisplayRequests(Display display, int32_t *out_display_requests,
                                  uint32_t *out_num_elements, LayerId *out_layers,
-                                 int32_t *out_layer_requests);
+                                 int32_t *out_layer_requests) override;
   HWC3::Error GetReleaseFences(Display display, uint32_t *out_num_elements, LayerId *out_layers,
-                               std::vector<shared_ptr<Fence>> *out_fences);
+                               std::vector<shared_ptr<Fence>> *out_fences) override;
   HWC3::Error SetClientTarget(Display display, buffer_handle_t target,
-                              shared_ptr<Fence> acquire_fence, int32_t dataspace, Region damage);
+                              shared_ptr<Fence> acquire_fence, int32_t dataspace,
+                              Region damage) override;
   HWC3::Error SetClientTarget_3_1(Display display, buffer_handle_t target,
                                   shared_ptr<Fence> acquire_fence, int32_t dataspace,
-                                  Region damage);
-  HWC3::Error SetCursorPosition(Display display, LayerId layer, int32_t x, int32_t y);
+                                  Region damage) override;
+  HWC3::Error SetCursorPosition(Display display, LayerId layer, int32_t x, int32_t y) override;
   HWC3::Error GetDataspaceSaturationMatrix(int32_t /*Dataspace*/ int_dataspace, float *out_matrix);
   HWC3::Error SetDisplayBrightnessScale(const android::Parcel *input_parcel);
   HWC3::Error GetDisplayConnectionType(Display display, HwcDisplayConnectionType *type);
   HWC3::Error SetDimmingEnable(Display display, int32_t int_enabled);
   HWC3::Error SetDimmingMinBl(Display display, int32_t min_bl);
   HWC3::Error GetClientTargetProperty(Display display,
-                                      HwcClientTargetProperty *outClientTargetProperty);
+                                      HwcClientTargetProperty *outClientTargetProperty) override;
   HWC3::Error SetDemuraState(Display display, int32_t state);
   HWC3::Error SetDemuraConfig(Display display, int32_t demura_idx);
 
   // Layer functions
   HWC3::Error SetLayerBuffer(Display display, LayerId layer, buffer_handle_t buffer,
-                             const shared_ptr<Fence> &acquire_fence);
-  HWC3::Error SetLayerBlendMode(Display display, LayerId layer, int32_t int_mode);
-  HWC3::Error SetLayerDisplayFrame(Display display, LayerId layer, Rect frame);
-  HWC3::Error SetLayerPlaneAlpha(Display display, LayerId layer, float alpha);
-  HWC3::Error SetLayerSourceCrop(Display display, LayerId layer, FRect crop);
-  HWC3::Error SetLayerTransform(Display display, LayerId layer, Transform transform);
-  HWC3::Error SetLayerZOrder(Display display, LayerId layer, uint32_t z);
-  HWC3::Error SetLayerType(Display display, LayerId layer, LayerType type);
-  HWC3::Error SetLayerFlag(Display display, LayerId layer, LayerFlag flag);
-  HWC3::Error SetLayerSurfaceDamage(Display display, LayerId layer, Region damage);
-  HWC3::Error SetLayerVisibleRegion(Display display, LayerId layer, Region damage);
-  HWC3::Error SetLayerCompositionType(Display display, LayerId layer, int32_t int_type);
-  HWC3::Error SetLayerColor(Display display, LayerId layer, Color color);
-  HWC3::Error SetLayerDataspace(Display display, LayerId layer, int32_t dataspace);
+                             const shared_ptr<Fence> &acquire_fence) override;
+  HWC3::Error SetLayerBlendMode(Display display, LayerId layer, int32_t int_mode) override;
+  HWC3::Error SetLayerDisplayFrame(Display display, LayerId layer, Rect frame) override;
+  HWC3::Error SetLayerPlaneAlpha(Display display, LayerId layer, float alpha) override;
+  HWC3::Error SetLayerSourceCrop(Display display, LayerId layer, FRect crop) override;
+  HWC3::Error SetLayerTransform(Display display, LayerId layer, Transform transform) override;
+  HWC3::Error SetLayerZOrder(Display display, LayerId layer, uint32_t z) override;
+  HWC3::Error SetLayerType(Display display, LayerId layer, LayerType type) override;
+  HWC3::Error SetLayerFlag(Display display, LayerId layer, LayerFlag flag) override;
+  HWC3::Error SetLayerSurfaceDamage(Display display, LayerId layer, Region damage) override;
+  HWC3::Error SetLayerVisibleRegion(Display display, LayerId layer, Region damage) override;
+  HWC3::Error SetLayerCompositionType(Display display, LayerId layer, int32_t int_type) override;
+  HWC3::Error SetLayerColor(Display display, LayerId layer, Color color) override;
+  HWC3::Error SetLayerDataspace(Display display, LayerId layer, int32_t dataspace) override;
   HWC3::Error SetLayerPerFrameMetadata(Display display, LayerId layer, uint32_t num_elements,
-                                       const int32_t *int_keys, const float *metadata);
-  HWC3::Error SetLayerColorTransform(Display display, LayerId layer, const float *matrix);
+                                       const int32_t *int_keys, const float *metadata) override;
+  HWC3::Error SetLayerColorTransform(Display display, LayerId layer, const float *matrix) override;
   HWC3::Error SetLayerPerFrameMetadataBlobs(Display display, LayerId layer, uint32_t num_elements,
                                             const int32_t *int_keys, const uint32_t *sizes,
-                                            const uint8_t *metadata);
-  HWC3::Error SetLayerBrightness(Display display, LayerId layer, float brightness);
+                                            const uint8_t *metadata) override;
+  HWC3::Error SetLayerBrightness(Display display, LayerId layer, float brightness) override;
   HWC3::Error SetDisplayedContentSamplingEnabled(Display display, bool enabled,
                                                  uint8_t component_mask, uint64_t max_frames);
   HWC3::Error GetDisplayedContentSamplingAttributes(Display display, int32_t *format,
@@ -296,7 +302,7 @@ class HWCSession : public HWCUEvent,
                                         uint64_t *numFrames,
                                         int32_t samples_size[NUM_HISTOGRAM_COLOR_COMPONENTS],
                                         uint64_t *samples[NUM_HISTOGRAM_COLOR_COMPONENTS]);
-  HWC3::Error SetDisplayElapseTime(Display display, uint64_t time);
+  HWC3::Error SetDisplayElapseTime(Display display, uint64_t time) override;
 
   int SetCameraSmoothInfo(CameraSmoothOp op, int32_t fps);
   int RegisterCallbackClient(const std::shared_ptr<IDisplayConfigCallback> &callback,
@@ -313,6 +319,7 @@ class HWCSession : public HWCUEvent,
   virtual void VmReleaseDone(Display display);
   virtual int NotifyCwbDone(int dpy_index, int32_t status, uint64_t handle_id);
   virtual int NotifyIdleStatus(bool idle_status);
+  virtual void NotifyPowerModeChange(Display display, PowerMode mode);
 
   HWC3::Error SetVsyncEnabled(Display display, bool enabled);
   HWC3::Error GetDozeSupport(Display display, int32_t *out_support);
@@ -327,9 +334,9 @@ class HWCSession : public HWCUEvent,
       VsyncPeriodChangeTimeline *out_timeline);
   HWC3::Error CommitOrPrepare(Display display, bool validate_only,
                               shared_ptr<Fence> *out_retire_fence, uint32_t *out_num_types,
-                              uint32_t *out_num_requests, bool *needs_commit);
+                              uint32_t *out_num_requests, bool *needs_commit) override;
   HWC3::Error TryDrawMethod(Display display, DrawMethod drawMethod);
-  HWC3::Error SetExpectedPresentTime(Display display, uint64_t expectedPresentTime);
+  HWC3::Error SetExpectedPresentTime(Display display, uint64_t expectedPresentTime) override;
   HWC3::Error GetOverlaySupport(OverlayProperties *supported_props);
 
   static Locker locker_[HWCCallbacks::kNumDisplays];
@@ -353,43 +360,10 @@ class HWCSession : public HWCUEvent,
     int OnCWBDone(int dpy_index, int32_t status, uint64_t handle_id);
 
    private:
-    enum CWBNotifiedStatus {
-      kCwbNotifiedFailure = -1,
-      kCwbNotifiedSuccess,
-      kCwbNotifiedNone,
-    };
-
-    struct QueueNode {
-      QueueNode(std::shared_ptr<IDisplayConfigCallback> cb, const CwbConfig &cwb_conf,
-                const hidl_handle &buf, Display disp_type, uint64_t buf_id)
-          : callback(cb),
-            cwb_config(cwb_conf),
-            buffer(buf),
-            display_type(disp_type),
-            handle_id(buf_id) {}
-
-      std::shared_ptr<IDisplayConfigCallback> callback;
-      CwbConfig cwb_config = {};
-      const native_handle_t *buffer;
-      Display display_type;
-      uint64_t handle_id;
-      CWBNotifiedStatus notified_status = kCwbNotifiedNone;
-      bool request_completed = false;
-    };
-
-    struct DisplayCWBSession {
-      std::deque<std::shared_ptr<QueueNode>> queue;
-      std::mutex lock;
-      std::condition_variable cv;
-      std::future<void> future;
-      bool async_thread_running = false;
-    };
-
-    static void AsyncTaskToProcessCWBStatus(CWB *cwb, int dpy_index);
-    void ProcessCWBStatus(int dpy_index);
-    void NotifyCWBStatus(int status, std::shared_ptr<QueueNode> cwb_node);
-
-    std::map<int, DisplayCWBSession> display_cwb_session_map_;
+    static void NotifyCWBStatus(int status, std::shared_ptr<IDisplayConfigCallback> callback,
+                                const native_handle_t *buffer);
+
+    std::map<int, CWBRequestQueue> display_cwb_queues_;
     HWCSession *hwc_session_ = nullptr;
   };
 
@@ -430,6 +404,7 @@ class HWCSession : public HWCUEvent,
   int HandlePluggableDisplays(bool delay_hotplug);
   int HandleConnectedDisplays(HWDisplaysInfo *hw_displays_info, bool delay_hotplug);
   int HandleDisconnectedDisplays(HWDisplaysInfo *hw_displays_info);
+  DisplayMapInfo *GetFreeSlot(std::vector<DisplayMapInfo> *slots);
   void DestroyDisplay(DisplayMapInfo *map_info);
   void DestroyDisplayLocked(DisplayMapInfo *map_info);
   void DestroyPluggableDisplay(DisplayMapInfo *map_info);
@@ -510,7 +485,7 @@ class HWCSession : public HWCUEvent,
   android::status_t RetrieveDemuraTnFiles(const android::Parcel *input_parcel);
 
   // Internal methods
-  void HandleSecureSession();
+  void HandleSecureSession(Display display);
   void HandlePendingPowerMode(Display display, const shared_ptr<Fence> &retire_fence);
   void HandlePendingHotplug(Display disp_id, const shared_ptr<Fence> &retire_fence);
   bool IsPluggableDisplayConnected();
@@ -596,7 +571,17 @@ class HWCSession : public HWCUEvent,
   bool async_vds_creation_ = false;
   bool tui_state_transition_[HWCCallbacks::kNumDisplays] = {};
   std::bitset<HWCCallbacks::kNumDisplays> display_ready_;
+  // Published to the status page once the display locker is released.
+  HWCStatusPage status_page_;
+  HWCStatusPage::FrameStatus frame_status_[HWCCallbacks::kNumDisplays] = {};
+  bool frame_status_pending_[HWCCallbacks::kNumDisplays] = {};
   bool secure_session_active_ = false;
+  // Lock free snapshots read on paths which must not take other displays' lockers.
+  // Lock order, whenever more than one display locker is held: command_seq_mutex_, then
+  // locker_ in ascending display index (see Locker::MultiScopeLock).
+  std::atomic<uint32_t> display_power_on_mask_ = 0;
+  std::atomic<uint32_t> builtin_secure_sessions_ = 0;
+  std::atomic<uint32_t> applied_secure_sessions_ = 0;  // last state handed to every display
   bool is_client_up_ = false;
   std::shared_ptr<IPCIntf> ipc_intf_ = nullptr;
   bool primary_pending_ = true;
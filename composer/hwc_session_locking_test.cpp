@@ -0,0 +1,424 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+// Drives the present, hotplug and secure session paths of a real HWCSession against a core which
+// hands out null displays, to check how they take the display lockers.
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/eventfd.h>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <condition_variable>  // NOLINT
+#include <functional>
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "display_null.h"
+#include "hwc_session.h"
+
+namespace sdm {
+namespace {
+
+const int32_t kBuiltinId = 0;
+const int32_t kNumPluggables = 2;
+const int kHotplugs = 200;
+const auto kTimeout = std::chrono::seconds(60);
+
+// Stands in for CoreImpl: every display is a DisplayNull, pluggables connect and disconnect
+// on request of the test.
+class FakeCore : public CoreInterface {
+ public:
+  FakeCore() {
+    HWDisplayInfo &builtin = displays_[kBuiltinId];
+    builtin.display_id = kBuiltinId;
+    builtin.display_type = kBuiltIn;
+    builtin.is_connected = true;
+    builtin.is_primary = true;
+    for (int32_t i = 1; i <= kNumPluggables; i++) {
+      HWDisplayInfo &pluggable = displays_[i];
+      pluggable.display_id = i;
+      pluggable.display_type = kPluggable;
+    }
+  }
+
+  void SetConnected(bool connected) {
+    std::lock_guard<std::mutex> lock(lock_);
+    for (auto &iter : displays_) {
+      if (iter.second.display_type == kPluggable) {
+        iter.second.is_connected = connected;
+      }
+    }
+  }
+
+  int Alive() {
+    std::lock_guard<std::mutex> lock(lock_);
+    return created_ - destroyed_;
+  }
+
+  DisplayError CreateDisplay(DisplayType type, DisplayEventHandler *event_handler,
+                             DisplayInterface **interface) override {
+    return CreateNullDisplay(interface);
+  }
+  DisplayError CreateDisplay(int32_t display_id, DisplayEventHandler *event_handler,
+                             DisplayInterface **interface) override {
+    {
+      std::lock_guard<std::mutex> lock(lock_);
+      auto iter = displays_.find(display_id);
+      if (iter == displays_.end() || !iter->second.is_connected) {
+        return kErrorDeviceRemoved;
+      }
+    }
+    return CreateNullDisplay(interface);
+  }
+  DisplayError CreateNullDisplay(DisplayInterface **interface) override {
+    DisplayNull *display = new DisplayNull();
+    display->Init();
+    *interface = display;
+    std::lock_guard<std::mutex> lock(lock_);
+    created_++;
+    return kErrorNone;
+  }
+  DisplayError DestroyDisplay(DisplayInterface *interface) override {
+    return DestroyNullDisplay(interface);
+  }
+  DisplayError DestroyNullDisplay(DisplayInterface *interface) override {
+    delete interface;
+    std::lock_guard<std::mutex> lock(lock_);
+    destroyed_++;
+    return kErrorNone;
+  }
+  DisplayError DumpCodeCoverage() override { return kErrorNone; }
+  DisplayError SetMaxBandwidthMode(HWBwModes mode) override { return kErrorNotSupported; }
+  DisplayError GetFirstDisplayInterfaceType(HWDisplayInterfaceInfo *hw_disp_info) override {
+    hw_disp_info->type = kBuiltIn;
+    hw_disp_info->is_connected = true;
+    return kErrorNone;
+  }
+  DisplayError GetDisplaysStatus(HWDisplaysInfo *hw_displays_info) override {
+    std::lock_guard<std::mutex> lock(lock_);
+    *hw_displays_info = displays_;
+    return kErrorNone;
+  }
+  DisplayError GetMaxDisplaysSupported(DisplayType type, int32_t *max_displays) override {
+    *max_displays = (type == kPluggable) ? kNumPluggables : 1;
+    return kErrorNone;
+  }
+  bool IsRotatorSupportedFormat(LayerBufferFormat format) override { return false; }
+  DisplayError ReserveDemuraResources() override { return kErrorNotSupported; }
+  DisplayError RequestVirtualDisplayId(int32_t *vdisp_id) override { return kErrorNotSupported; }
+
+ private:
+  std::mutex lock_;
+  HWDisplaysInfo displays_;
+  int created_ = 0;
+  int destroyed_ = 0;
+};
+
+// Primary builtin whose secure session is set by the test. Its commits always succeed, with a
+// retire fence which polls readable like a signaled sync fence.
+class StubBuiltin : public HWCDisplay {
+ public:
+  StubBuiltin(CoreInterface *core_intf, BufferAllocator *buffer_allocator,
+              HWCCallbacks *callbacks, HWCDisplayEventHandler *event_handler)
+      : HWCDisplay(core_intf, buffer_allocator, callbacks, event_handler, nullptr, kBuiltIn,
+                   HWC_DISPLAY_PRIMARY, kBuiltinId, DISPLAY_CLASS_BUILTIN) {}
+
+  HWC3::Error Present(shared_ptr<Fence> *out_retire_fence) override {
+    frames_++;
+    *out_retire_fence = Fence::Create(eventfd(1, EFD_CLOEXEC), "stub_retire");
+    return HWC3::Error::None;
+  }
+  int GetActiveSecureSession(std::bitset<kSecureMax> *secure_sessions) override {
+    *secure_sessions = secure_sessions_.load();
+    return 0;
+  }
+  // The secure display itself stays on, like HWCDisplayBuiltin.
+  int HandleSecureSession(const std::bitset<kSecureMax> &secure_sessions,
+                          bool *power_on_pending, bool is_active_secure_display) override {
+    active_secure_sessions_ = secure_sessions;
+    return 0;
+  }
+
+  std::atomic<uint64_t> frames_ = 0;
+  std::atomic<unsigned long> secure_sessions_ = 0;
+};
+
+// Fails the test instead of hanging it when the threads deadlock.
+class Watchdog {
+ public:
+  explicit Watchdog(int count) : pending_(count) {}
+
+  void Done() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_--;
+    cv_.notify_all();
+  }
+
+  bool Wait(std::chrono::seconds timeout) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return cv_.wait_for(lock, timeout, [this] { return pending_ == 0; });
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  int pending_ = 0;
+};
+
+bool IsLocked(Locker *locker) {
+  if (locker->TryLock() == EBUSY) {
+    return true;
+  }
+  locker->Unlock();
+  return false;
+}
+
+}  // namespace
+
+// Friend of HWCSession. Sets the session up the way Init() does, minus the real core.
+class HWCSessionLockingTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    session_ = new HWCSession();
+    session_->core_intf_ = &core_;
+    // Create every connected pluggable in one pass, like the bringup of several monitors.
+    session_->disable_hotplug_bwcheck_ = 1;
+
+    Display client_id = HWC_DISPLAY_PRIMARY;
+    session_->map_info_primary_.client_id = client_id++;
+    session_->map_info_pluggable_.resize(kNumPluggables);
+    for (auto &map_info : session_->map_info_pluggable_) {
+      map_info.client_id = client_id++;
+    }
+    session_->map_info_virtual_.resize(1);
+    session_->map_info_virtual_[0].client_id = client_id++;
+    session_->is_hdr_display_.resize(UINT32(client_id));
+    for (auto &pending : HWCSession::pending_power_mode_) {
+      pending = false;
+    }
+
+    builtin_ = new StubBuiltin(&core_, &session_->buffer_allocator_, &session_->callbacks_,
+                               session_.get());
+    ASSERT_EQ(builtin_->Init(), 0);
+    session_->map_info_primary_.sdm_id = kBuiltinId;
+    session_->map_info_primary_.disp_type = kBuiltIn;
+    session_->hwc_display_[HWC_DISPLAY_PRIMARY] = builtin_;
+    session_->NotifyPowerModeChange(HWC_DISPLAY_PRIMARY, PowerMode::ON);
+
+    // Hotplug() waits for a client otherwise.
+    session_->callbacks_.Register(CALLBACK_HOTPLUG, this, &hotplug_);
+    session_->callbacks_.Register(CALLBACK_REFRESH, this, &refresh_);
+  }
+
+  void TearDown() override {
+    core_.SetConnected(false);
+    EXPECT_EQ(HandleHotplug(), 0);
+    for (Display display = 0; display < HWCCallbacks::kNumDisplays; display++) {
+      EXPECT_FALSE(IsLocked(&HWCSession::locker_[display])) << display;
+    }
+
+    // Callbacks run in queue order, so once this refresh is seen none are left.
+    {
+      std::unique_lock<std::mutex> lock(callback_lock_);
+      draining_ = true;
+      session_->callbacks_.Refresh(HWC_DISPLAY_PRIMARY);
+      EXPECT_TRUE(callback_cv_.wait_for(lock, kTimeout, [this] { return !draining_; }));
+    }
+    session_->callbacks_.Register(CALLBACK_HOTPLUG, this, nullptr);
+    session_->callbacks_.Register(CALLBACK_REFRESH, this, nullptr);
+
+    session_->hwc_display_[HWC_DISPLAY_PRIMARY] = nullptr;
+    builtin_->Deinit();
+    delete builtin_;
+    EXPECT_EQ(core_.Alive(), 0);
+    session_.clear();
+  }
+
+  HWC3::Error Present(Display display) {
+    shared_ptr<Fence> retire_fence = nullptr;
+    return session_->PresentDisplay(display, &retire_fence);
+  }
+
+  int HandleHotplug() { return session_->HandlePluggableDisplays(false); }
+
+  // Presents on the builtin until the hotplug it deferred has been handled.
+  bool DrainPendingHotplug() {
+    auto deadline = std::chrono::steady_clock::now() + kTimeout;
+    while (session_->pending_hotplug_event_ != HWCSession::kHotPlugNone) {
+      if (std::chrono::steady_clock::now() > deadline) {
+        return false;
+      }
+      Present(HWC_DISPLAY_PRIMARY);
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    // The handler thread sets kHotPlugNone before it unlocks.
+    SCOPE_LOCK(session_->pluggable_handler_lock_);
+    return true;
+  }
+
+  std::vector<Display> Pluggables() {
+    std::vector<Display> displays;
+    for (auto &map_info : session_->map_info_pluggable_) {
+      displays.push_back(map_info.client_id);
+    }
+    return displays;
+  }
+
+  bool IsCreated(Display display) {
+    SCOPE_LOCK(HWCSession::locker_[display]);
+    return session_->hwc_display_[display] != nullptr;
+  }
+
+  PowerMode GetPowerMode(Display display) {
+    SCOPE_LOCK(HWCSession::locker_[display]);
+    HWCDisplay *hwc_display = session_->hwc_display_[display];
+    return hwc_display ? hwc_display->GetCurrentPowerMode() : PowerMode::OFF;
+  }
+
+  bool IsPowerModePending(Display display) { return HWCSession::pending_power_mode_[display]; }
+
+  void SetSecureDisplay(bool secure) {
+    std::bitset<kSecureMax> secure_sessions = 0;
+    secure_sessions[kSecureDisplay] = secure;
+    builtin_->secure_sessions_ = secure_sessions.to_ulong();
+  }
+
+  FakeCore core_;
+  android::sp<HWCSession> session_;
+  StubBuiltin *builtin_ = nullptr;
+  std::atomic<int> hotplugs_ = 0;
+
+ private:
+  void OnRefresh() {
+    std::lock_guard<std::mutex> lock(callback_lock_);
+    if (draining_) {
+      draining_ = false;
+      callback_cv_.notify_all();
+    }
+  }
+
+  onHotplug_func_t hotplug_ = [this](void *, int64_t, bool) { hotplugs_++; };
+  onRefresh_func_t refresh_ = [this](void *, int64_t) { OnRefresh(); };
+  std::mutex callback_lock_;
+  std::condition_variable callback_cv_;
+  bool draining_ = false;
+};
+
+// Presents on every display race against hotplug handling, power mode changes and secure session
+// transitions of the builtin. Each path takes the display lockers the way HWCSession does, any
+// nesting outside Locker::MultiScopeLock order can deadlock this test.
+TEST_F(HWCSessionLockingTest, PresentAndHotplugStress) {
+  std::atomic<bool> stop(false);
+  std::vector<Display> pluggables = Pluggables();
+  Watchdog watchdog(4);
+  std::vector<std::thread> threads;
+
+  threads.emplace_back([&] {
+    while (!stop) {
+      Present(HWC_DISPLAY_PRIMARY);
+    }
+    watchdog.Done();
+  });
+
+  threads.emplace_back([&] {
+    while (!stop) {
+      for (Display display : pluggables) {
+        Present(display);
+      }
+    }
+    watchdog.Done();
+  });
+
+  // Hotplug of the pluggables, which the client powers on once connected.
+  threads.emplace_back([&] {
+    for (int i = 0; i < kHotplugs; i++) {
+      core_.SetConnected((i % 2) == 0);
+      HandleHotplug();
+      for (Display display : pluggables) {
+        session_->SetPowerMode(display, INT32(PowerMode::ON));
+      }
+    }
+    stop = true;
+    watchdog.Done();
+  });
+
+  // Secure display sessions on the builtin, which pause the pluggables and defer hotplugs.
+  threads.emplace_back([&] {
+    for (int i = 0; !stop; i++) {
+      SetSecureDisplay((i % 2) == 0);
+      std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    SetSecureDisplay(false);
+    watchdog.Done();
+  });
+
+  if (!watchdog.Wait(kTimeout)) {
+    fprintf(stderr, "HWCSession display lockers deadlocked\n");
+    abort();
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  ASSERT_TRUE(DrainPendingHotplug());
+  EXPECT_GT(builtin_->frames_.load(), 0u);
+  EXPECT_GT(hotplugs_.load(), 0);
+}
+
+// Secure display on the builtin powers the pluggables off once and back on with the builtin
+// commit that ends it. In between, the pluggables present without the builtin locker.
+TEST_F(HWCSessionLockingTest, SecureSessionTransition) {
+  std::vector<Display> pluggables = Pluggables();
+  core_.SetConnected(true);
+  ASSERT_EQ(HandleHotplug(), 0);
+  for (Display display : pluggables) {
+    ASSERT_TRUE(IsCreated(display)) << display;
+    ASSERT_EQ(session_->SetPowerMode(display, INT32(PowerMode::ON)), HWC3::Error::None);
+  }
+
+  SetSecureDisplay(true);
+  EXPECT_EQ(Present(HWC_DISPLAY_PRIMARY), HWC3::Error::None);
+  for (Display display : pluggables) {
+    EXPECT_EQ(GetPowerMode(display), PowerMode::OFF) << display;
+  }
+  // Deferred until the secure session ends.
+  EXPECT_EQ(HandleHotplug(), -EAGAIN);
+
+  {
+    Locker::ScopeLock lock(HWCSession::locker_[HWC_DISPLAY_PRIMARY]);
+    std::atomic<bool> presented(false);
+    std::thread presenter([&] {
+      for (Display display : pluggables) {
+        Present(display);
+      }
+      presented = true;
+    });
+    auto deadline = std::chrono::steady_clock::now() + kTimeout;
+    while (!presented && std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_TRUE(presented) << "pluggable present waited for the builtin locker";
+    if (!presented) {
+      fprintf(stderr, "Pluggable present blocked on the builtin locker\n");
+      abort();
+    }
+    presenter.join();
+  }
+
+  SetSecureDisplay(false);
+  EXPECT_EQ(Present(HWC_DISPLAY_PRIMARY), HWC3::Error::None);
+  for (Display display : pluggables) {
+    EXPECT_FALSE(IsPowerModePending(display)) << display;
+    EXPECT_EQ(GetPowerMode(display), PowerMode::ON) << display;
+  }
+
+  ASSERT_TRUE(DrainPendingHotplug());
+}
+
+}  // namespace sdm
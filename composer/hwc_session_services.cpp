@@ -564,8 +564,7 @@ int32_t HWCSession::CWB::PostBuffer(std::shared_ptr<IDisplayConfigCallback> call
                                     const CwbConfig &cwb_config, const native_handle_t *buffer,
                                     Display display_type, int dpy_index) {
   HWC3::Error error = HWC3::Error::None;
-  auto &session_map = display_cwb_session_map_[dpy_index];
-  std::shared_ptr<QueueNode> node = nullptr;
+  auto &queue = display_cwb_queues_[dpy_index];
   uint64_t node_handle_id = 0;
   void *hdl = const_cast<native_handle_t *>(buffer);
   auto err =
@@ -575,34 +574,23 @@ int32_t HWCSession::CWB::PostBuffer(std::shared_ptr<IDisplayConfigCallback> call
     DLOGE("Buffer handle id retrieval failed!");
   }
 
+  bool queued = false;
   if (error == HWC3::Error::None) {
-    node = std::make_shared<QueueNode>(callback, cwb_config, buffer, display_type, node_handle_id);
-    if (node) {
-      // Keep CWB request handling related resources in a requested display context.
-      std::unique_lock<std::mutex> lock(session_map.lock);
-
-      // Iterate over the queue to avoid duplicate node of same buffer, because that
-      // buffer is already present in queue.
-      for (auto &qnode : session_map.queue) {
-        if (qnode->handle_id == node_handle_id) {
-          error = HWC3::Error::BadParameter;
-          DLOGW("CWB Buffer with handle id %lu is already available in Queue for processing!",
-                node_handle_id);
-          break;
-        }
-      }
-
-      // Ensure that async task runs only until all queued CWB requests have been fulfilled.
-      // If cwb queue is empty, async task has not either started or async task has finished
-      // processing previously queued cwb requests. Start new async task on such a case as
-      // currently running async task will automatically desolve without processing more requests.
-      if (error == HWC3::Error::None) {
-        session_map.queue.push_back(node);
-      }
-    } else {
+    // Keep CWB request handling related resources in a requested display context.
+    int ret = queue.Post(node_handle_id, [callback, buffer](int status) {
+      NotifyCWBStatus(status, callback, buffer);
+    });
+    if (ret == -EBUSY) {
+      error = HWC3::Error::NoResources;
+      DLOGW("CWB queue is full with %u requests for display %d!",
+            CWBRequestQueue::kMaxPendingRequests, dpy_index);
+    } else if (ret) {
+      // Same buffer is already present in queue.
       error = HWC3::Error::BadParameter;
-      DLOGE("Unable to allocate node for CWB request(handle id: %lu)!", node_handle_id);
+      DLOGW("CWB Buffer with handle id %lu is already available in Queue for processing!",
+            node_handle_id);
     }
+    queued = (ret == 0);
   }
 
   if (error == HWC3::Error::None) {
@@ -621,118 +609,37 @@ int32_t HWCSession::CWB::PostBuffer(std::shared_ptr<IDisplayConfigCallback> call
     DLOGV_IF(kTagCwb, "Successfully configured CWB buffer(handle id: %lu).", node_handle_id);
   } else {
     // Need to close and delete the cloned native handle on CWB request rejection/failure and
-    // if node is created and pushed, then need to remove from queue.
+    // if request is queued, then need to remove it again.
+    if (queued) {
+      queue.Cancel(node_handle_id);
+    }
     native_handle_close(buffer);
     native_handle_delete(const_cast<native_handle_t *>(buffer));
-    std::unique_lock<std::mutex> lock(session_map.lock);
-    // If current node is pushed in the queue, then need to remove it again on error.
-    if (node && node == session_map.queue.back()) {
-      session_map.queue.pop_back();
-    }
     return -1;
   }
 
-  std::unique_lock<std::mutex> lock(session_map.lock);
-  if (!session_map.async_thread_running && !session_map.queue.empty()) {
-    session_map.async_thread_running = true;
-    // No need to do future.get() here for previously running async task. Async method will
-    // guarantee to exit after cwb for all queued requests is indeed complete i.e. the respective
-    // fences have signaled and client is notified through registered callbacks. This will make
-    // sure that the new async task does not concurrently work with previous task. Let async
-    // running thread dissolve on its own.
-    // Check, If thread is not running, then need to re-execute the async thread.
-    session_map.future = std::async(HWCSession::CWB::AsyncTaskToProcessCWBStatus, this, dpy_index);
-  }
-
-  if (node) {
-    node->request_completed = true;
-  }
+  // Done notification may already have arrived while request was being configured.
+  queue.Configured(node_handle_id);
 
   return 0;
 }
 
 int HWCSession::CWB::OnCWBDone(int dpy_index, int32_t status, uint64_t handle_id) {
-  auto &session_map = display_cwb_session_map_[dpy_index];
-
-  {
-    std::unique_lock<std::mutex> lock(session_map.lock);
-    // No need to notify to the client, if there is no any pending CWB request in queue.
-    if (session_map.queue.empty()) {
-      return -1;
-    }
-
-    for (auto &node : session_map.queue) {
-      if (node->notified_status == kCwbNotifiedNone) {
-        // Need to wait for other notification, when notified handle id does not match with
-        // available first non-notified node buffer handle id in queue.
-        if (node->handle_id == handle_id) {
-          node->notified_status = (status) ? kCwbNotifiedFailure : kCwbNotifiedSuccess;
-          session_map.cv.notify_one();
-          return 0;
-        } else {
-          // Continue to check on not matching handle_id, to update the status of any matching
-          // node, because if notification for particular handle_id skip, then it will not update
-          // again and notification thread will wait for skipped node forever.
-          continue;
-        }
-      }
-    }
-  }
-
-  return -1;
-}
-
-void HWCSession::CWB::AsyncTaskToProcessCWBStatus(CWB *cwb, int dpy_index) {
-  cwb->ProcessCWBStatus(dpy_index);
-}
-
-void HWCSession::CWB::ProcessCWBStatus(int dpy_index) {
-  auto &session_map = display_cwb_session_map_[dpy_index];
-  while (true) {
-    std::shared_ptr<QueueNode> cwb_node = nullptr;
-    {
-      std::unique_lock<std::mutex> lock(session_map.lock);
-      // Exit thread in case of no pending CWB request in queue.
-      if (session_map.queue.empty()) {
-        // Update thread exiting status.
-        session_map.async_thread_running = false;
-        break;
-      }
-
-      cwb_node = session_map.queue.front();
-      if (!cwb_node->request_completed) {
-        // Need to continue to recheck until node specific client call completes.
-        continue;
-      } else if (cwb_node->notified_status == kCwbNotifiedNone) {
-        // Wait for the signal for availability of CWB notified node.
-        session_map.cv.wait(lock);
-        if (cwb_node->notified_status == kCwbNotifiedNone) {
-          // If any other node notified before front node, then need to continue to wait
-          // for front node, such that further client notification will be done in sequential
-          // manner.
-          DLOGW("CWB request is notified out of sequence.");
-          continue;
-        }
-      }
-      session_map.queue.pop_front();
-    }
-
-    // Notify to client, when notification is received successfully for expected input buffer.
-    NotifyCWBStatus(cwb_node->notified_status, cwb_node);
-  }
-  DLOGI("CWB queue is empty. Display: %d", dpy_index);
+  // No need to notify to the client, if there is no pending CWB request for the buffer.
+  return display_cwb_queues_[dpy_index].OnDone(handle_id, status);
 }
 
-void HWCSession::CWB::NotifyCWBStatus(int status, std::shared_ptr<QueueNode> cwb_node) {
-  // Notify client about buffer status and erase the node from pending request queue.
-  std::shared_ptr<IDisplayConfigCallback> callback = cwb_node->callback;
+void HWCSession::CWB::NotifyCWBStatus(int status, std::shared_ptr<IDisplayConfigCallback> callback,
+                                      const native_handle_t *buffer) {
+  // Notify client about buffer status, failure is reported as -1.
+  status = status ? -1 : 0;
   if (callback) {
     DLOGI("Notify the client about buffer status %d.", status);
-    callback->notifyCWBBufferDone(status, ::android::dupToAidl(cwb_node->buffer));
+    callback->notifyCWBBufferDone(status, ::android::dupToAidl(buffer));
   }
 
-  native_handle_close(cwb_node->buffer);
-  native_handle_delete(const_cast<native_handle_t *>(cwb_node->buffer));
+  native_handle_close(buffer);
+  native_handle_delete(const_cast<native_handle_t *>(buffer));
 }
 
 int HWCSession::NotifyCwbDone(int dpy_index, int32_t status, uint64_t handle_id) {
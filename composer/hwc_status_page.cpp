@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <utils/Timers.h>
+#include <utils/constants.h>
+#include <utils/debug.h>
+
+#include "hwc_status_page.h"
+
+#define __CLASS__ "HWCStatusPage"
+
+namespace sdm {
+
+int HWCStatusPage::Init() {
+  std::lock_guard<std::mutex> lock(lock_);
+  if (page_) {
+    return 0;
+  }
+
+  int fd = memfd_create("display_status_page", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+  if (fd < 0) {
+    int error = -errno;
+    DLOGE("memfd_create failed, error = %d", error);
+    return error;
+  }
+
+  int error = 0;
+  void *addr = MAP_FAILED;
+  if (ftruncate(fd, sizeof(DisplayStatusPage))) {
+    error = -errno;
+    DLOGE("ftruncate failed, error = %d", error);
+  } else {
+    addr = mmap(nullptr, sizeof(DisplayStatusPage), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED) {
+      error = -errno;
+      DLOGE("mmap failed, error = %d", error);
+    }
+  }
+
+  // Clients get a descriptor opened read only. Sealing future writes also keeps them from
+  // reopening it writable through /proc; the composer's own mapping stays writable.
+  int read_only_fd = -1;
+  if (!error) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/self/fd/%d", fd);
+    read_only_fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (read_only_fd < 0) {
+      error = -errno;
+      DLOGE("Failed to open %s read only, error = %d", path, error);
+    }
+  }
+
+  if (error) {
+    if (addr != MAP_FAILED) {
+      munmap(addr, sizeof(DisplayStatusPage));
+    }
+    close(fd);
+    return error;
+  }
+
+  int seals = F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL;
+#ifdef F_SEAL_FUTURE_WRITE
+  seals |= F_SEAL_FUTURE_WRITE;
+#endif
+  if (fcntl(fd, F_ADD_SEALS, seals)) {
+    DLOGW("Failed to seal the status page, error = %d", errno);
+  }
+
+  page_ = static_cast<DisplayStatusPage *>(addr);
+  page_->magic = kDisplayStatusPageMagic;
+  page_->version = kDisplayStatusPageVersion;
+  page_->slot_count = kDisplayStatusSlots;
+  page_->slot_size = sizeof(DisplayStatusSlot);
+  fd_ = fd;
+  read_only_fd_ = read_only_fd;
+
+  DLOGI("Display status page ready, %zu bytes", sizeof(DisplayStatusPage));
+  return 0;
+}
+
+void HWCStatusPage::Deinit() {
+  std::lock_guard<std::mutex> lock(lock_);
+  if (!page_) {
+    return;
+  }
+
+  munmap(page_, sizeof(DisplayStatusPage));
+  close(read_only_fd_);
+  close(fd_);
+  page_ = nullptr;
+  fd_ = -1;
+  read_only_fd_ = -1;
+}
+
+void HWCStatusPage::UpdateFrame(Display display, const FrameStatus &frame) {
+  std::lock_guard<std::mutex> lock(lock_);
+  DisplayStatus *status = GetStatus(display);
+  if (!status) {
+    return;
+  }
+
+  status->power_mode = UINT32(frame.power_mode);
+  status->active_config = frame.active_config;
+  status->refresh_rate = frame.refresh_rate;
+  if (frame.idle) {
+    status->flags |= kDisplayStatusIdle;
+  } else {
+    status->flags &= ~kDisplayStatusIdle;
+  }
+  status->frame_count++;
+  Publish(display);
+}
+
+void HWCStatusPage::UpdatePowerMode(Display display, PowerMode power_mode) {
+  std::lock_guard<std::mutex> lock(lock_);
+  DisplayStatus *status = GetStatus(display);
+  if (!status) {
+    return;
+  }
+
+  status->power_mode = UINT32(power_mode);
+  Publish(display);
+}
+
+void HWCStatusPage::UpdateBrightness(Display display, float brightness) {
+  std::lock_guard<std::mutex> lock(lock_);
+  DisplayStatus *status = GetStatus(display);
+  if (!status) {
+    return;
+  }
+
+  status->brightness = brightness;
+  Publish(display);
+}
+
+void HWCStatusPage::UpdateQsync(Display display, bool enabled, uint32_t refresh_rate,
+                                uint32_t qsync_refresh_rate) {
+  std::lock_guard<std::mutex> lock(lock_);
+  DisplayStatus *status = GetStatus(display);
+  if (!status) {
+    return;
+  }
+
+  if (enabled) {
+    status->flags |= kDisplayStatusQsync;
+    status->qsync_refresh_rate = qsync_refresh_rate;
+  } else {
+    status->flags &= ~kDisplayStatusQsync;
+    status->qsync_refresh_rate = 0;
+  }
+  if (refresh_rate) {
+    status->refresh_rate = refresh_rate;
+  }
+  Publish(display);
+}
+
+void HWCStatusPage::RemoveDisplay(Display display) {
+  std::lock_guard<std::mutex> lock(lock_);
+  if (!page_ || display >= kDisplayStatusSlots) {
+    return;
+  }
+
+  status_[display] = {};
+  Publish(display);
+}
+
+DisplayStatus *HWCStatusPage::GetStatus(Display display) {
+  if (!page_ || display >= kDisplayStatusSlots) {
+    return nullptr;
+  }
+
+  DisplayStatus *status = &status_[display];
+  if (!(status->flags & kDisplayStatusConnected)) {
+    *status = {};
+    status->flags = kDisplayStatusConnected;
+    status->brightness = -1.0f;
+  }
+
+  return status;
+}
+
+void HWCStatusPage::Publish(Display display) {
+  DisplayStatus &status = status_[display];
+  status.timestamp_ns = systemTime(SYSTEM_TIME_MONOTONIC);
+  WriteDisplayStatus(&page_->slots[display], status);
+}
+
+}  // namespace sdm
@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __HWC_STATUS_PAGE_H__
+#define __HWC_STATUS_PAGE_H__
+
+#include <display_status_page.h>
+#include <mutex>
+
+#include "hwc_common.h"
+
+namespace sdm {
+
+// Owns the memfd backing the display status page and is its only writer. Updates are cheap
+// (one uncontended mutex and a few stores) and never block readers, which live in other
+// processes and only hold a read-only mapping.
+class HWCStatusPage {
+ public:
+  struct FrameStatus {
+    PowerMode power_mode = PowerMode::OFF;
+    uint32_t active_config = 0;
+    uint32_t refresh_rate = 0;
+    bool idle = false;
+  };
+
+  int Init();
+  void Deinit();
+  // Read-only descriptor handed out to clients, owned by this object.
+  int GetFd() { return read_only_fd_; }
+
+  void UpdateFrame(Display display, const FrameStatus &frame);
+  void UpdatePowerMode(Display display, PowerMode power_mode);
+  void UpdateBrightness(Display display, float brightness);
+  void UpdateQsync(Display display, bool enabled, uint32_t refresh_rate,
+                   uint32_t qsync_refresh_rate);
+  void RemoveDisplay(Display display);
+
+ private:
+  DisplayStatus *GetStatus(Display display);
+  void Publish(Display display);
+
+  std::mutex lock_;
+  int fd_ = -1;
+  int read_only_fd_ = -1;
+  DisplayStatusPage *page_ = nullptr;
+  DisplayStatus status_[kDisplayStatusSlots] = {};
+};
+
+}  // namespace sdm
+
+#endif  // __HWC_STATUS_PAGE_H__
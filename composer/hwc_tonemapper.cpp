@@ -195,6 +195,7 @@ int HWCToneMapper::HandleToneMap(LayerStack *layer_stack) {
               fb_tone_map_session->UpdateBuffer(nullptr /* acquire_fence */, &layer->input_buffer);
               fb_tone_map_session->layer_index_ = INT(i);
               fb_tone_map_session->acquired_ = true;
+              FinishToneMap();
               return 0;
             }
           }
@@ -207,22 +208,26 @@ int HWCToneMapper::HandleToneMap(LayerStack *layer_stack) {
       }
 
       if (error != kErrorNone) {
+        FinishToneMap();
         Terminate();
         return -1;
       }
 
       ToneMapSession *session = tone_map_sessions_.at(session_index);
-      ToneMap(layer, session);
+      blit_requests_.emplace_back();
+      ToneMap(layer, session, &blit_requests_.back());
       DLOGI_IF(kTagClient, "Layer %d associated with session index %d", i, session_index);
       session->layer_index_ = INT(i);
     }
   }
 
+  FinishToneMap();
+
   return 0;
 }
 
-void HWCToneMapper::ToneMap(Layer *layer, ToneMapSession *session) {
-  ToneMapBlitContext ctx = {};
+void HWCToneMapper::ToneMap(Layer *layer, ToneMapSession *session, ToneMapBlitRequest *request) {
+  ToneMapBlitContext &ctx = request->ctx;
   ctx.layer = layer;
 
   uint8_t buffer_index = session->current_buffer_index_;
@@ -232,12 +237,19 @@ void HWCToneMapper::ToneMap(Layer *layer, ToneMapSession *session) {
   ctx.merged =
       Fence::Merge(session->release_fence_[buffer_index], layer->input_buffer.acquire_fence);
 
-  DTRACE_BEGIN("GPU_TM_BLIT");
-  session->tone_map_task_.PerformTask(ToneMapTaskCode::kCodeBlit, &ctx);
-  DTRACE_END();
+  request->session = session;
+  request->task_id = session->tone_map_task_.PostTask(ToneMapTaskCode::kCodeBlit, &ctx);
+}
 
-  DumpToneMapOutput(session, ctx.fence);
-  session->UpdateBuffer(ctx.fence, &layer->input_buffer);
+void HWCToneMapper::FinishToneMap() {
+  DTRACE_SCOPED();
+  for (auto &request : blit_requests_) {
+    ToneMapSession *session = request.session;
+    session->tone_map_task_.WaitTask(request.task_id);
+    DumpToneMapOutput(session, request.ctx.fence);
+    session->UpdateBuffer(request.ctx.fence, &request.ctx.layer->input_buffer);
+  }
+  blit_requests_.clear();
 }
 
 void HWCToneMapper::PostCommit(LayerStack *layer_stack) {
@@ -281,26 +293,17 @@ void HWCToneMapper::SetFrameDumpConfig(uint32_t count) {
   DLOGI("Dump FrameConfig count = %d", count);
   dump_frame_count_ = count;
   dump_frame_index_ = 0;
+  frame_dump_writer_.SetBudget(0);
 }
 
 void HWCToneMapper::DumpToneMapOutput(ToneMapSession *session, shared_ptr<Fence> acquire_fd) {
-  int error = -1;
   if (!dump_frame_count_) {
     return;
   }
 
   BufferInfo &buffer_info = session->buffer_info_[session->current_buffer_index_];
   native_handle_t *target_buffer = static_cast<native_handle_t *>(buffer_info.private_data);
-  Fence::Wait(acquire_fd);
 
-  void *base_ptr = NULL;
-  error = buffer_allocator_->MapBuffer(target_buffer, acquire_fd, &base_ptr);
-  if (error != 0) {
-    DLOGE("MapBuffer failed, base addr = %p", base_ptr);
-    return;
-  }
-
-  size_t result = 0;
   char dump_file_name[PATH_MAX];
   uint32_t width, height, size = 0;
   buffer_allocator_->GetWidth((void *)target_buffer, width);
@@ -312,13 +315,10 @@ void HWCToneMapper::DumpToneMapOutput(ToneMapSession *session, shared_ptr<Fence>
            "/tonemap_%dx%d_frame%d.raw",
            HWCDebugHandler::DumpDir(), width, height, dump_frame_index_);
 
-  if (base_ptr != nullptr) {
-    FILE *fp = fopen(dump_file_name, "w+");
-    if (fp) {
-      DLOGI("base addr = %p", base_ptr);
-      result = fwrite(base_ptr, size, 1, fp);
-      fclose(fp);
-    }
+  // Written once the blit fence signals, without holding back the composition thread.
+  if (!frame_dump_writer_.QueueBuffer(dump_file_name, buffer_info.alloc_buffer_info.fd, size,
+                                      acquire_fd)) {
+    DLOGW("Dropped tone map dump %s", dump_file_name);
   }
 
   dump_frame_count_--;
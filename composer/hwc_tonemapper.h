@@ -41,8 +41,10 @@
 #include <sys/mman.h>
 
 #include <core/layer_stack.h>
+#include <utils/frame_dump_writer.h>
 #include <utils/sys.h>
 #include <utils/sync_task.h>
+#include <deque>
 #include <vector>
 #include "hwc_buffer_sync_handler.h"
 #include "hwc_buffer_allocator.h"
@@ -102,6 +104,12 @@ class ToneMapSession : public SyncTask<ToneMapTaskCode>::TaskHandler {
   int layer_index_ = -1;
 };
 
+struct ToneMapBlitRequest {
+  ToneMapSession *session = nullptr;
+  SyncTask<ToneMapTaskCode>::TaskId task_id = 0;
+  ToneMapBlitContext ctx = {};
+};
+
 class HWCToneMapper {
  public:
   explicit HWCToneMapper(HWCBufferAllocator *allocator) : buffer_allocator_(allocator) {}
@@ -114,12 +122,16 @@ class HWCToneMapper {
   void Terminate();
 
  private:
-  void ToneMap(Layer *layer, ToneMapSession *session);
+  void ToneMap(Layer *layer, ToneMapSession *session, ToneMapBlitRequest *request);
+  void FinishToneMap();
   DisplayError AcquireToneMapSession(Layer *layer, uint32_t *sess_idx, PrimariesTransfer blend_cs);
   void DumpToneMapOutput(ToneMapSession *session, shared_ptr<sdm::Fence> acquire_fence);
 
   std::vector<ToneMapSession *> tone_map_sessions_;
+  // Blits are posted to the per session worker threads, so that sessions render concurrently.
+  std::deque<ToneMapBlitRequest> blit_requests_;
   HWCBufferAllocator *buffer_allocator_ = nullptr;
+  FrameDumpWriter frame_dump_writer_;
   uint32_t dump_frame_count_ = 0;
   uint32_t dump_frame_index_ = 0;
   int fb_session_index_ = -1;
@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <math.h>
+#include <utils/constants.h>
+#include <utils/rect.h>
+#include <vector>
+
+#include "layer_stitch_planner.h"
+
+namespace sdm {
+
+static float Area(const LayerRect &rect) {
+  return (rect.right - rect.left) * (rect.bottom - rect.top);
+}
+
+// Overlapping tiles are always merged. Disjoint ones only when their bounding box adds no
+// area, e.g. horizontally adjacent rows of the same height.
+static bool ShouldMerge(const LayerRect &rect1, const LayerRect &rect2) {
+  if (IsValid(Intersection(rect1, rect2))) {
+    return true;
+  }
+
+  return Area(Union(rect1, rect2)) <= (Area(rect1) + Area(rect2));
+}
+
+LayerRect LayerStitchPlanner::GetRegion(const Source &source) {
+  return IsValid(source.slice_rect) ? source.slice_rect : source.dst_rect;
+}
+
+uint32_t LayerStitchPlanner::Plan(uint64_t target_id, const std::vector<Source> &sources,
+                                  std::vector<Draw> *draws) {
+  draws->clear();
+  tiles_.clear();
+
+  if (GeometryChanged(target_id, sources)) {
+    for (auto &source : sources) {
+      AddDamage(GetRegion(source));
+    }
+
+    target_id_ = target_id;
+    sources_.resize(sources.size());
+    for (size_t i = 0; i < sources.size(); i++) {
+      sources_[i].width = sources[i].width;
+      sources_[i].height = sources[i].height;
+      sources_[i].dst_rect = sources[i].dst_rect;
+      sources_[i].slice_rect = sources[i].slice_rect;
+    }
+    valid_ = true;
+  } else {
+    for (size_t i = 0; i < sources.size(); i++) {
+      if (sources[i].buffer_id != sources_[i].buffer_id || sources[i].single_buffer) {
+        AddSourceDamage(sources[i]);
+      }
+    }
+  }
+
+  for (size_t i = 0; i < sources.size(); i++) {
+    sources_[i].buffer_id = sources[i].buffer_id;
+  }
+
+  for (auto &tile : tiles_) {
+    // Slices are cleared before their layer is drawn, plain destinations are overwritten.
+    bool clear = false;
+    for (auto &source : sources) {
+      if (IsValid(source.slice_rect) && IsValid(Intersection(source.slice_rect, tile))) {
+        clear = true;
+        break;
+      }
+    }
+
+    for (uint32_t i = 0; i < sources.size(); i++) {
+      if (!IsValid(Intersection(GetRegion(sources[i]), tile))) {
+        continue;
+      }
+      Draw draw = {};
+      draw.source = i;
+      draw.scissor = tile;
+      draw.clear = clear;
+      draws->push_back(draw);
+      clear = false;
+    }
+  }
+
+  return UINT32(tiles_.size());
+}
+
+bool LayerStitchPlanner::GeometryChanged(uint64_t target_id, const std::vector<Source> &sources) {
+  if (!valid_ || target_id != target_id_ || sources.size() != sources_.size()) {
+    return true;
+  }
+
+  for (size_t i = 0; i < sources.size(); i++) {
+    const Source &source = sources[i];
+    const SourceState &state = sources_[i];
+    if (source.width != state.width || source.height != state.height ||
+        !IsCongruent(source.dst_rect, state.dst_rect) ||
+        !IsCongruent(source.slice_rect, state.slice_rect)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void LayerStitchPlanner::AddSourceDamage(const Source &source) {
+  LayerRect region = GetRegion(source);
+  const LayerRect &dst = source.dst_rect;
+  LayerRect buffer = {0.0f, 0.0f, FLOAT(source.width), FLOAT(source.height)};
+
+  if (!source.dirty_regions || source.dirty_regions->empty() || !IsValid(buffer) ||
+      !IsValid(dst)) {
+    AddDamage(region);
+    return;
+  }
+
+  float scale_x = (dst.right - dst.left) / buffer.right;
+  float scale_y = (dst.bottom - dst.top) / buffer.bottom;
+  // Filtering reads one texel beyond a scaled dirty rect.
+  float pad = (scale_x != 1.0f || scale_y != 1.0f) ? 1.0f : 0.0f;
+  bool damaged = false;
+
+  for (auto &dirty : *source.dirty_regions) {
+    LayerRect rect = Intersection(dirty, buffer);
+    if (!IsValid(rect)) {
+      continue;
+    }
+    rect.left = floorf(dst.left + rect.left * scale_x - pad);
+    rect.top = floorf(dst.top + rect.top * scale_y - pad);
+    rect.right = ceilf(dst.left + rect.right * scale_x + pad);
+    rect.bottom = ceilf(dst.top + rect.bottom * scale_y + pad);
+    // Area of the slice outside dst_rect stays transparent.
+    AddDamage(Intersection(rect, dst));
+    damaged = true;
+  }
+
+  // A single empty rect means no damage. Trust it for front buffer rendering only, a new buffer
+  // is redrawn in full.
+  if (!damaged && !source.single_buffer) {
+    AddDamage(region);
+  }
+}
+
+void LayerStitchPlanner::AddDamage(LayerRect rect) {
+  if (!IsValid(rect)) {
+    return;
+  }
+
+  // Grow rect by every tile it should merge with. Rescan after each merge, the grown rect may
+  // now reach tiles which were already checked.
+  for (size_t i = 0; i < tiles_.size();) {
+    if (ShouldMerge(tiles_[i], rect)) {
+      rect = Union(tiles_[i], rect);
+      tiles_[i] = tiles_.back();
+      tiles_.pop_back();
+      i = 0;
+    } else {
+      i++;
+    }
+  }
+
+  tiles_.push_back(rect);
+}
+
+}  // namespace sdm
@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __LAYER_STITCH_PLANNER_H__
+#define __LAYER_STITCH_PLANNER_H__
+
+#include <core/layer_stack.h>
+#include <stdint.h>
+#include <vector>
+
+namespace sdm {
+
+// Plans the GL draws which render stitch layers into the stitch target. The target keeps its
+// content between frames, so only the destination tiles damaged since the previous plan are
+// redrawn. Tiles are the merged damage of all layers and never overlap. Every layer overlapping
+// a tile is drawn into it in layer stack order, clipped to the tile, so one submission with a
+// single fence covers the whole frame.
+class LayerStitchPlanner {
+ public:
+  struct Source {
+    uint64_t buffer_id = 0;
+    uint32_t width = 0;   // buffer size, dirty regions are in buffer coordinates
+    uint32_t height = 0;
+    LayerRect dst_rect = {};
+    LayerRect slice_rect = {};  // slice cleared around dst_rect, may be empty
+    const std::vector<LayerRect> *dirty_regions = nullptr;  // empty or null for full damage
+    bool single_buffer = false;  // content changes without a new buffer_id
+  };
+
+  struct Draw {
+    uint32_t source = 0;  // index in the sources passed to Plan()
+    LayerRect scissor = {};
+    bool clear = false;  // clear scissor to transparent before the draw
+  };
+
+  // Fills draws with what brings the target identified by target_id up to date with sources.
+  // Returns the number of tiles, 0 when the target is already current.
+  uint32_t Plan(uint64_t target_id, const std::vector<Source> &sources,
+                std::vector<Draw> *draws);
+
+  // Forces the next plan to redraw every layer, e.g. after the target content was lost.
+  void Reset() { valid_ = false; }
+
+ private:
+  struct SourceState {
+    uint64_t buffer_id = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    LayerRect dst_rect = {};
+    LayerRect slice_rect = {};
+  };
+
+  static LayerRect GetRegion(const Source &source);
+  bool GeometryChanged(uint64_t target_id, const std::vector<Source> &sources);
+  void AddSourceDamage(const Source &source);
+  void AddDamage(LayerRect rect);
+
+  bool valid_ = false;
+  uint64_t target_id_ = 0;
+  std::vector<SourceState> sources_;
+  std::vector<LayerRect> tiles_;
+};
+
+}  // namespace sdm
+
+#endif  // __LAYER_STITCH_PLANNER_H__
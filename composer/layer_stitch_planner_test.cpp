@@ -0,0 +1,199 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <utils/rect.h>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "layer_stitch_planner.h"
+
+namespace sdm {
+namespace {
+
+const uint64_t kTarget = 1;
+
+// Two 1080x1200 slices stacked in the stitch target, each holding an unscaled layer.
+std::vector<LayerStitchPlanner::Source> GetSources(uint64_t top_id, uint64_t bottom_id) {
+  std::vector<LayerStitchPlanner::Source> sources(2);
+  sources[0].buffer_id = top_id;
+  sources[0].width = 1080;
+  sources[0].height = 1200;
+  sources[0].dst_rect = {0.0f, 0.0f, 1080.0f, 1200.0f};
+  sources[0].slice_rect = {0.0f, 0.0f, 1080.0f, 1200.0f};
+  sources[1] = sources[0];
+  sources[1].buffer_id = bottom_id;
+  sources[1].dst_rect = {0.0f, 1200.0f, 1080.0f, 2400.0f};
+  sources[1].slice_rect = {0.0f, 1200.0f, 1080.0f, 2400.0f};
+  return sources;
+}
+
+bool Equals(const LayerRect &rect, float left, float top, float right, float bottom) {
+  return rect.left == left && rect.top == top && rect.right == right && rect.bottom == bottom;
+}
+
+}  // namespace
+
+TEST(LayerStitchPlannerTest, FirstFrameDrawsEverything) {
+  LayerStitchPlanner planner;
+  std::vector<LayerStitchPlanner::Draw> draws;
+  auto sources = GetSources(10, 20);
+
+  // Adjacent slices of the same width are one tile.
+  EXPECT_EQ(planner.Plan(kTarget, sources, &draws), 1u);
+  ASSERT_EQ(draws.size(), 2u);
+  EXPECT_EQ(draws[0].source, 0u);
+  EXPECT_EQ(draws[1].source, 1u);
+  EXPECT_TRUE(draws[0].clear);
+  EXPECT_FALSE(draws[1].clear);
+  EXPECT_TRUE(Equals(draws[0].scissor, 0, 0, 1080, 2400));
+  EXPECT_TRUE(Equals(draws[1].scissor, 0, 0, 1080, 2400));
+}
+
+TEST(LayerStitchPlannerTest, UnchangedFrameDrawsNothing) {
+  LayerStitchPlanner planner;
+  std::vector<LayerStitchPlanner::Draw> draws;
+  auto sources = GetSources(10, 20);
+
+  planner.Plan(kTarget, sources, &draws);
+  EXPECT_EQ(planner.Plan(kTarget, sources, &draws), 0u);
+  EXPECT_TRUE(draws.empty());
+
+  planner.Reset();
+  EXPECT_EQ(planner.Plan(kTarget, sources, &draws), 1u);
+  EXPECT_EQ(draws.size(), 2u);
+}
+
+TEST(LayerStitchPlannerTest, NewBufferRedrawsItsSlice) {
+  LayerStitchPlanner planner;
+  std::vector<LayerStitchPlanner::Draw> draws;
+  auto sources = GetSources(10, 20);
+  planner.Plan(kTarget, sources, &draws);
+
+  sources[1].buffer_id = 21;
+  EXPECT_EQ(planner.Plan(kTarget, sources, &draws), 1u);
+  ASSERT_EQ(draws.size(), 1u);
+  EXPECT_EQ(draws[0].source, 1u);
+  EXPECT_TRUE(draws[0].clear);
+  EXPECT_TRUE(Equals(draws[0].scissor, 0, 1200, 1080, 2400));
+}
+
+TEST(LayerStitchPlannerTest, DirtyRectsBecomeMergedTiles) {
+  LayerStitchPlanner planner;
+  std::vector<LayerStitchPlanner::Draw> draws;
+  auto sources = GetSources(10, 20);
+  planner.Plan(kTarget, sources, &draws);
+
+  // Two overlapping rects merge, a distant one stays its own tile.
+  std::vector<LayerRect> dirty = {{0.0f, 0.0f, 100.0f, 100.0f},
+                                  {50.0f, 50.0f, 200.0f, 150.0f},
+                                  {500.0f, 1000.0f, 600.0f, 1100.0f}};
+  sources[1].buffer_id = 21;
+  sources[1].dirty_regions = &dirty;
+  EXPECT_EQ(planner.Plan(kTarget, sources, &draws), 2u);
+  ASSERT_EQ(draws.size(), 2u);
+
+  std::vector<LayerRect> scissors = {draws[0].scissor, draws[1].scissor};
+  if (scissors[0].left > scissors[1].left) {
+    std::swap(scissors[0], scissors[1]);
+  }
+  EXPECT_TRUE(Equals(scissors[0], 0, 1200, 200, 1350));
+  EXPECT_TRUE(Equals(scissors[1], 500, 2200, 600, 2300));
+  EXPECT_FALSE(IsValid(Intersection(scissors[0], scissors[1])));
+}
+
+TEST(LayerStitchPlannerTest, TileAcrossSlicesDrawsBothLayers) {
+  LayerStitchPlanner planner;
+  std::vector<LayerStitchPlanner::Draw> draws;
+  auto sources = GetSources(10, 20);
+  planner.Plan(kTarget, sources, &draws);
+
+  std::vector<LayerRect> top_dirty = {{0.0f, 1100.0f, 300.0f, 1200.0f}};
+  std::vector<LayerRect> bottom_dirty = {{0.0f, 0.0f, 300.0f, 100.0f}};
+  sources[0].buffer_id = 11;
+  sources[0].dirty_regions = &top_dirty;
+  sources[1].buffer_id = 21;
+  sources[1].dirty_regions = &bottom_dirty;
+
+  // The rects are stacked across the slice boundary, which merges them into a tile covering
+  // part of both slices. Both layers are drawn in stack order, one clear.
+  EXPECT_EQ(planner.Plan(kTarget, sources, &draws), 1u);
+  ASSERT_EQ(draws.size(), 2u);
+  EXPECT_EQ(draws[0].source, 0u);
+  EXPECT_EQ(draws[1].source, 1u);
+  EXPECT_TRUE(draws[0].clear);
+  EXPECT_FALSE(draws[1].clear);
+  EXPECT_TRUE(Equals(draws[0].scissor, 0, 1100, 300, 1300));
+}
+
+TEST(LayerStitchPlannerTest, ScaledDirtyRectIsPadded) {
+  LayerStitchPlanner planner;
+  std::vector<LayerStitchPlanner::Draw> draws;
+  auto sources = GetSources(10, 20);
+  sources[0].width = 540;
+  sources[0].height = 600;
+  planner.Plan(kTarget, sources, &draws);
+
+  std::vector<LayerRect> dirty = {{10.0f, 10.0f, 20.0f, 20.0f}};
+  sources[0].buffer_id = 11;
+  sources[0].dirty_regions = &dirty;
+  EXPECT_EQ(planner.Plan(kTarget, sources, &draws), 1u);
+  ASSERT_EQ(draws.size(), 1u);
+  EXPECT_TRUE(Equals(draws[0].scissor, 19, 19, 41, 41));
+}
+
+TEST(LayerStitchPlannerTest, GeometryChangeRedrawsEverything) {
+  LayerStitchPlanner planner;
+  std::vector<LayerStitchPlanner::Draw> draws;
+  auto sources = GetSources(10, 20);
+  planner.Plan(kTarget, sources, &draws);
+
+  // A new stitch target has none of the previous content.
+  EXPECT_EQ(planner.Plan(kTarget + 1, sources, &draws), 1u);
+  EXPECT_EQ(draws.size(), 2u);
+
+  sources[1].slice_rect = {0.0f, 1200.0f, 1080.0f, 2000.0f};
+  sources[1].dst_rect = {0.0f, 1200.0f, 1080.0f, 2000.0f};
+  EXPECT_EQ(planner.Plan(kTarget + 1, sources, &draws), 1u);
+  EXPECT_EQ(draws.size(), 2u);
+
+  sources.pop_back();
+  EXPECT_EQ(planner.Plan(kTarget + 1, sources, &draws), 1u);
+  ASSERT_EQ(draws.size(), 1u);
+  EXPECT_TRUE(Equals(draws[0].scissor, 0, 0, 1080, 1200));
+}
+
+TEST(LayerStitchPlannerTest, EmptyDamageFallsBackToSlice) {
+  LayerStitchPlanner planner;
+  std::vector<LayerStitchPlanner::Draw> draws;
+  auto sources = GetSources(10, 20);
+  planner.Plan(kTarget, sources, &draws);
+
+  std::vector<LayerRect> dirty = {{0.0f, 0.0f, 0.0f, 0.0f}};
+  sources[0].buffer_id = 11;
+  sources[0].dirty_regions = &dirty;
+  EXPECT_EQ(planner.Plan(kTarget, sources, &draws), 1u);
+  ASSERT_EQ(draws.size(), 1u);
+  EXPECT_TRUE(Equals(draws[0].scissor, 0, 0, 1080, 1200));
+}
+
+TEST(LayerStitchPlannerTest, SingleBufferUsesDamageOnly) {
+  LayerStitchPlanner planner;
+  std::vector<LayerStitchPlanner::Draw> draws;
+  auto sources = GetSources(10, 20);
+  sources[0].single_buffer = true;
+  planner.Plan(kTarget, sources, &draws);
+
+  std::vector<LayerRect> dirty = {{0.0f, 0.0f, 0.0f, 0.0f}};
+  sources[0].dirty_regions = &dirty;
+  EXPECT_EQ(planner.Plan(kTarget, sources, &draws), 0u);
+  EXPECT_TRUE(draws.empty());
+
+  dirty[0] = {100.0f, 100.0f, 200.0f, 200.0f};
+  EXPECT_EQ(planner.Plan(kTarget, sources, &draws), 1u);
+  ASSERT_EQ(draws.size(), 1u);
+  EXPECT_TRUE(Equals(draws[0].scissor, 100, 100, 200, 200));
+}
+
+}  // namespace sdm
@@ -0,0 +1,345 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <utils/Log.h>
+#include <algorithm>
+
+#include "CpuTonemapper.h"
+
+namespace {
+
+typedef float float4 __attribute__((vector_size(16)));
+
+inline float4 decode1010102(uint32_t v)
+{
+  float4 c = {float(v & 0x3ff), float((v >> 10) & 0x3ff), float((v >> 20) & 0x3ff),
+              float(v >> 30)};
+  const float4 scale = {1.0f / 1023.0f, 1.0f / 1023.0f, 1.0f / 1023.0f, 1.0f / 3.0f};
+  return c * scale;
+}
+
+inline float4 decode8888(uint32_t v)
+{
+  float4 c = {float(v & 0xff), float((v >> 8) & 0xff), float((v >> 16) & 0xff), float(v >> 24)};
+  return c * (1.0f / 255.0f);
+}
+
+inline float4 clamp01(float4 v)
+{
+  for (int i = 0; i < 4; i++) {
+    v[i] = std::min(std::max(v[i], 0.0f), 1.0f);
+  }
+  return v;
+}
+
+// Position of v on a table of size entries, split into the lower entry and the fraction towards
+// the next one. Equivalent to GL_LINEAR sampling with the ScaleOffset of the shaders.
+inline void tablePosition(float v, int size, int *index, float *fraction)
+{
+  float pos = v * float(size - 1);
+  int i = std::min(int(pos), size - 2);
+  *index = i;
+  *fraction = pos - float(i);
+}
+
+}  // namespace
+
+//-----------------------------------------------------------------------------
+CpuTonemapper::CpuTonemapper()
+//-----------------------------------------------------------------------------
+{
+  type = TONEMAP_FORWARD;
+  interpolation = kTrilinear;
+  lutSize = 0;
+  jobSrc = NULL;
+  jobDst = NULL;
+  numTiles = 0;
+  nextTile = 0;
+  jobSerial = 0;
+  activeWorkers = 0;
+  exitWorkers = false;
+}
+
+//-----------------------------------------------------------------------------
+CpuTonemapper::~CpuTonemapper()
+//-----------------------------------------------------------------------------
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    exitWorkers = true;
+  }
+  jobCv.notify_all();
+
+  for (auto &worker : workers) {
+    worker.join();
+  }
+}
+
+//-----------------------------------------------------------------------------
+CpuTonemapper *CpuTonemapper::build(int type, void *colorMap, int colorMapSize, void *lutXform,
+                                    int lutXformSize, Interpolation interpolation, int numThreads)
+//-----------------------------------------------------------------------------
+{
+  if (!colorMap || colorMapSize <= 0) {
+    ALOGE("Invalid Color Map size = %d", colorMapSize);
+    return NULL;
+  }
+
+  CpuTonemapper *tonemapper = new CpuTonemapper();
+  tonemapper->type = type;
+  tonemapper->interpolation = interpolation;
+  tonemapper->lutSize = colorMapSize;
+
+  // Decode the tables once, so that sampling is plain float arithmetic.
+  const uint32_t *packedLut = static_cast<const uint32_t *>(colorMap);
+  size_t lutEntries = size_t(colorMapSize) * colorMapSize * colorMapSize;
+  tonemapper->lut.resize(lutEntries);
+  for (size_t i = 0; i < lutEntries; i++) {
+    tonemapper->lut[i] = decode1010102(packedLut[i]);
+  }
+
+  if (lutXform && lutXformSize > 0) {
+    const uint32_t *packedXform = static_cast<const uint32_t *>(lutXform);
+    tonemapper->xform.resize(lutXformSize);
+    for (int i = 0; i < lutXformSize; i++) {
+      tonemapper->xform[i] = decode1010102(packedXform[i]);
+    }
+  }
+
+  if (numThreads <= 0) {
+    numThreads = std::max(1, int(std::thread::hardware_concurrency()));
+  }
+  // Calling thread processes tiles as well.
+  for (int i = 1; i < numThreads; i++) {
+    tonemapper->workers.push_back(std::thread(&CpuTonemapper::workerLoop, tonemapper));
+  }
+
+  return tonemapper;
+}
+
+//-----------------------------------------------------------------------------
+int CpuTonemapper::blit(const Image &dst, const Image &src)
+//-----------------------------------------------------------------------------
+{
+  if (!dst.data || !src.data || dst.width != src.width || dst.height != src.height ||
+      src.width <= 0 || src.height <= 0 || src.stride < src.width * 4 ||
+      dst.stride < dst.width * 4) {
+    ALOGE("Invalid blit src %dx%d stride %d, dst %dx%d stride %d", src.width, src.height,
+          src.stride, dst.width, dst.height, dst.stride);
+    return -1;
+  }
+
+  std::unique_lock<std::mutex> lock(mutex);
+  jobSrc = &src;
+  jobDst = &dst;
+  numTiles = (src.height + kTileRows - 1) / kTileRows;
+  nextTile = 0;
+  activeWorkers = int(workers.size());
+  jobSerial++;
+  lock.unlock();
+  jobCv.notify_all();
+
+  runTiles();
+
+  lock.lock();
+  doneCv.wait(lock, [this] { return activeWorkers == 0; });
+  jobSrc = NULL;
+  jobDst = NULL;
+
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+void CpuTonemapper::workerLoop()
+//-----------------------------------------------------------------------------
+{
+  uint64_t lastJob = 0;
+  std::unique_lock<std::mutex> lock(mutex);
+  while (true) {
+    jobCv.wait(lock, [this, lastJob] { return exitWorkers || jobSerial != lastJob; });
+    if (exitWorkers) {
+      return;
+    }
+    lastJob = jobSerial;
+
+    lock.unlock();
+    runTiles();
+    lock.lock();
+
+    if (--activeWorkers == 0) {
+      doneCv.notify_all();
+    }
+  }
+}
+
+//-----------------------------------------------------------------------------
+void CpuTonemapper::runTiles()
+//-----------------------------------------------------------------------------
+{
+  for (int tile = nextTile++; tile < numTiles; tile = nextTile++) {
+    int firstRow = tile * kTileRows;
+    processRows(firstRow, std::min(firstRow + kTileRows, jobSrc->height));
+  }
+}
+
+//-----------------------------------------------------------------------------
+void CpuTonemapper::processRows(int firstRow, int lastRow)
+//-----------------------------------------------------------------------------
+{
+  const Image &src = *jobSrc;
+  const Image &dst = *jobDst;
+
+  for (int y = firstRow; y < lastRow; y++) {
+    for (int x = 0; x < src.width; x++) {
+      float4 color = load(src, x, y);
+      float alpha = color[3];
+      float4 out = color;
+
+      if (type == TONEMAP_INVERSE) {
+        // Source is premultiplied, fully transparent pixels pass through unchanged.
+        if (alpha > 0.0f) {
+          out = transform(color / alpha) * alpha;
+        }
+      } else {
+        out = transform(color);
+      }
+      out[3] = alpha;
+
+      store(dst, x, y, out);
+    }
+  }
+}
+
+//-----------------------------------------------------------------------------
+CpuTonemapper::float4 CpuTonemapper::load(const Image &image, int x, int y) const
+//-----------------------------------------------------------------------------
+{
+  const uint8_t *row = static_cast<const uint8_t *>(image.data) + size_t(y) * image.stride;
+  uint32_t v = reinterpret_cast<const uint32_t *>(row)[x];
+  return (image.format == kRGBA1010102) ? decode1010102(v) : decode8888(v);
+}
+
+//-----------------------------------------------------------------------------
+void CpuTonemapper::store(const Image &image, int x, int y, float4 color) const
+//-----------------------------------------------------------------------------
+{
+  uint8_t *row = static_cast<uint8_t *>(image.data) + size_t(y) * image.stride;
+  uint32_t *pixel = reinterpret_cast<uint32_t *>(row) + x;
+  color = clamp01(color);
+
+  if (image.format == kRGBA1010102) {
+    const float4 scale = {1023.0f, 1023.0f, 1023.0f, 3.0f};
+    float4 v = color * scale + 0.5f;
+    *pixel = uint32_t(v[0]) | (uint32_t(v[1]) << 10) | (uint32_t(v[2]) << 20) |
+             (uint32_t(v[3]) << 30);
+  } else {
+    float4 v = color * 255.0f + 0.5f;
+    *pixel = uint32_t(v[0]) | (uint32_t(v[1]) << 8) | (uint32_t(v[2]) << 16) |
+             (uint32_t(v[3]) << 24);
+  }
+}
+
+//-----------------------------------------------------------------------------
+CpuTonemapper::float4 CpuTonemapper::transform(float4 rgb) const
+//-----------------------------------------------------------------------------
+{
+  rgb = clamp01(rgb);
+  if (!xform.empty()) {
+    rgb = sampleXform(rgb);
+  }
+
+  return (interpolation == kTetrahedral) ? sampleTetrahedral(rgb) : sampleTrilinear(rgb);
+}
+
+//-----------------------------------------------------------------------------
+CpuTonemapper::float4 CpuTonemapper::sampleXform(float4 rgb) const
+//-----------------------------------------------------------------------------
+{
+  int size = int(xform.size());
+  if (size == 1) {
+    return xform[0];
+  }
+
+  // Each channel is looked up in its own channel of the table.
+  float4 out = rgb;
+  for (int c = 0; c < 3; c++) {
+    int i = 0;
+    float f = 0.0f;
+    tablePosition(rgb[c], size, &i, &f);
+    out[c] = xform[i][c] + (xform[i + 1][c] - xform[i][c]) * f;
+  }
+  return out;
+}
+
+//-----------------------------------------------------------------------------
+CpuTonemapper::float4 CpuTonemapper::sampleTrilinear(float4 rgb) const
+//-----------------------------------------------------------------------------
+{
+  int size = lutSize;
+  if (size == 1) {
+    return lut[0];
+  }
+
+  int r, g, b;
+  float fr, fg, fb;
+  tablePosition(rgb[0], size, &r, &fr);
+  tablePosition(rgb[1], size, &g, &fg);
+  tablePosition(rgb[2], size, &b, &fb);
+
+  // Red varies fastest in the table, as in the GL_TEXTURE_3D upload.
+  const float4 *c000 = &lut[(size_t(b) * size + g) * size + r];
+  const size_t dg = size;
+  const size_t db = size_t(size) * size;
+
+  float4 c00 = c000[0] + (c000[1] - c000[0]) * fr;
+  float4 c10 = c000[dg] + (c000[dg + 1] - c000[dg]) * fr;
+  float4 c01 = c000[db] + (c000[db + 1] - c000[db]) * fr;
+  float4 c11 = c000[db + dg] + (c000[db + dg + 1] - c000[db + dg]) * fr;
+  float4 c0 = c00 + (c10 - c00) * fg;
+  float4 c1 = c01 + (c11 - c01) * fg;
+  return c0 + (c1 - c0) * fb;
+}
+
+//-----------------------------------------------------------------------------
+CpuTonemapper::float4 CpuTonemapper::sampleTetrahedral(float4 rgb) const
+//-----------------------------------------------------------------------------
+{
+  int size = lutSize;
+  if (size == 1) {
+    return lut[0];
+  }
+
+  int r, g, b;
+  float fr, fg, fb;
+  tablePosition(rgb[0], size, &r, &fr);
+  tablePosition(rgb[1], size, &g, &fg);
+  tablePosition(rgb[2], size, &b, &fb);
+
+  const float4 *c = &lut[(size_t(b) * size + g) * size + r];
+  const size_t dg = size;
+  const size_t db = size_t(size) * size;
+  const float4 c000 = c[0];
+  const float4 c111 = c[db + dg + 1];
+
+  // Walk from c000 to c111 through the tetrahedron which contains the sample, 4 taps instead of
+  // the 8 of trilinear.
+  if (fr > fg) {
+    if (fg > fb) {
+      return c000 + (c[1] - c000) * fr + (c[dg + 1] - c[1]) * fg + (c111 - c[dg + 1]) * fb;
+    } else if (fr > fb) {
+      return c000 + (c[1] - c000) * fr + (c[db + 1] - c[1]) * fb + (c111 - c[db + 1]) * fg;
+    } else {
+      return c000 + (c[db] - c000) * fb + (c[db + 1] - c[db]) * fr + (c111 - c[db + 1]) * fg;
+    }
+  } else {
+    if (fb > fg) {
+      return c000 + (c[db] - c000) * fb + (c[db + dg] - c[db]) * fg + (c111 - c[db + dg]) * fr;
+    } else if (fb > fr) {
+      return c000 + (c[dg] - c000) * fg + (c[db + dg] - c[dg]) * fb + (c111 - c[db + dg]) * fr;
+    } else {
+      return c000 + (c[dg] - c000) * fg + (c[dg + 1] - c[dg]) * fr + (c111 - c[dg + 1]) * fb;
+    }
+  }
+}
@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __TONEMAPPER_CPUTONEMAPPER_H__
+#define __TONEMAPPER_CPUTONEMAPPER_H__
+
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Same as Tonemapper.h, which can not be included without GL headers.
+#define TONEMAP_FORWARD 0
+#define TONEMAP_INVERSE 1
+
+// CPU implementation of the Tonemapper pipeline: the optional non-uniform 1D transform, the 3D
+// LUT and, for TONEMAP_INVERSE, alpha unpremultiply and premultiply. Tables are sampled at texel
+// centers like the GL_LINEAR textures of the GPU path. Pixels are processed with 4 lane float
+// vectors and the image is split in bands of rows which are shared by a pool of worker threads.
+// Serves as reference for the GPU path on hosts, and as fallback for regions which are too small
+// to justify creating a GPU context.
+class CpuTonemapper {
+ public:
+  enum Interpolation {
+    kTrilinear,
+    kTetrahedral,
+  };
+
+  enum PixelFormat {
+    kRGBA8888,     // 8 bits per channel, R in the lowest byte
+    kRGBA1010102,  // R in the lowest 10 bits, 2 bit alpha in the highest bits
+  };
+
+  struct Image {
+    void *data;
+    int width;
+    int height;
+    int stride;  // in bytes
+    PixelFormat format;
+  };
+
+  ~CpuTonemapper();
+  // colorMap and lutXform are packed like the GPU textures, GL_UNSIGNED_INT_2_10_10_10_REV.
+  // numThreads of 0 uses all cores.
+  static CpuTonemapper *build(int type, void *colorMap, int colorMapSize, void *lutXform,
+                              int lutXformSize, Interpolation interpolation = kTrilinear,
+                              int numThreads = 0);
+  // Source and destination must have the same dimensions. Returns 0 on success.
+  int blit(const Image &dst, const Image &src);
+
+ private:
+  typedef float float4 __attribute__((vector_size(16)));
+
+  static const int kTileRows = 16;
+
+  CpuTonemapper();
+  CpuTonemapper(const CpuTonemapper &) = delete;
+  CpuTonemapper &operator=(const CpuTonemapper &) = delete;
+
+  void workerLoop();
+  void runTiles();
+  void processRows(int firstRow, int lastRow);
+  float4 load(const Image &image, int x, int y) const;
+  void store(const Image &image, int x, int y, float4 color) const;
+  float4 transform(float4 rgb) const;
+  float4 sampleXform(float4 rgb) const;
+  float4 sampleTrilinear(float4 rgb) const;
+  float4 sampleTetrahedral(float4 rgb) const;
+
+  int type;
+  Interpolation interpolation;
+  int lutSize;
+  std::vector<float4> lut;
+  std::vector<float4> xform;
+
+  // Current blit, shared with workers.
+  const Image *jobSrc;
+  const Image *jobDst;
+  int numTiles;
+  std::atomic<int> nextTile;
+
+  std::mutex mutex;
+  std::condition_variable jobCv;
+  std::condition_variable doneCv;
+  uint64_t jobSerial;
+  int activeWorkers;
+  bool exitWorkers;
+  std::vector<std::thread> workers;
+};
+
+#endif  //__TONEMAPPER_CPUTONEMAPPER_H__
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include "EGLImageCache.h"
+
+//-----------------------------------------------------------------------------
+EGLImageCache::EGLImageCache(EGLImageShim *shim, uint32_t maxEntries, uint64_t maxBytes)
+//-----------------------------------------------------------------------------
+    : shim(shim), maxEntries(maxEntries), maxBytes(maxBytes)
+{
+}
+
+//-----------------------------------------------------------------------------
+EGLImageCache::~EGLImageCache()
+//-----------------------------------------------------------------------------
+{
+  clear();
+}
+
+//-----------------------------------------------------------------------------
+EGLImageBuffer *EGLImageCache::get(const Key &key, uint64_t size, const void *handle)
+//-----------------------------------------------------------------------------
+{
+  auto it = entries.find(key);
+  if (it != entries.end()) {
+    hits++;
+    lru.splice(lru.begin(), lru, it->second);
+    return it->second->image;
+  }
+
+  misses++;
+  EGLImageBuffer *image = shim->createImage(handle);
+  if (!image) {
+    return nullptr;
+  }
+
+  lru.push_front({key, size, image});
+  entries[key] = lru.begin();
+  bytes += size;
+  evict();
+
+  return image;
+}
+
+//-----------------------------------------------------------------------------
+void EGLImageCache::evict()
+//-----------------------------------------------------------------------------
+{
+  while (lru.size() > kMinResident && (lru.size() > maxEntries || bytes > maxBytes)) {
+    Entry &oldest = lru.back();
+    shim->destroyImage(oldest.image);
+    bytes -= oldest.size;
+    entries.erase(oldest.key);
+    lru.pop_back();
+    evictions++;
+  }
+}
+
+//-----------------------------------------------------------------------------
+void EGLImageCache::clear()
+//-----------------------------------------------------------------------------
+{
+  for (auto &entry : lru) {
+    shim->destroyImage(entry.image);
+  }
+  lru.clear();
+  entries.clear();
+  bytes = 0;
+}
+
+//-----------------------------------------------------------------------------
+EGLImageCache::Stats EGLImageCache::getStats() const
+//-----------------------------------------------------------------------------
+{
+  return {hits, misses, evictions, uint32_t(lru.size()), bytes};
+}
@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __TONEMAPPER_EGLIMAGECACHE_H__
+#define __TONEMAPPER_EGLIMAGECACHE_H__
+
+#include <stdint.h>
+#include <list>
+#include <map>
+#include <tuple>
+
+class EGLImageBuffer;
+
+// Creates and destroys the images held by EGLImageCache. The default implementation wraps the
+// gralloc handle into an EGLImageKHR, tests inject their own.
+class EGLImageShim {
+ public:
+  virtual ~EGLImageShim() {}
+  virtual EGLImageBuffer *createImage(const void *handle) = 0;
+  virtual void destroyImage(EGLImageBuffer *image) = 0;
+};
+
+// LRU cache of EGL images, bounded by entry count and by the bytes of the buffers they pin.
+// Keyed by gralloc buffer id, generation of the backing memory and format, so that a handle
+// which is reallocated or reformatted never resolves to a stale image.
+class EGLImageCache {
+ public:
+  struct Key {
+    uint64_t bufferId;
+    uint64_t generation;
+    int format;
+
+    bool operator<(const Key &other) const {
+      return std::tie(bufferId, generation, format) <
+             std::tie(other.bufferId, other.generation, other.format);
+    }
+  };
+
+  struct Stats {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+    uint32_t entries;
+    uint64_t bytes;
+  };
+
+  // A blit holds its source and destination image at once, so the two most recently returned
+  // images are never evicted, even if that exceeds the budget.
+  static const uint32_t kMinResident = 2;
+
+  EGLImageCache(EGLImageShim *shim, uint32_t maxEntries, uint64_t maxBytes);
+  ~EGLImageCache();
+
+  // Returns the cached image for key, or creates one from handle. size is the byte size of the
+  // buffer, accounted against the budget.
+  EGLImageBuffer *get(const Key &key, uint64_t size, const void *handle);
+  void clear();
+  Stats getStats() const;
+
+ private:
+  struct Entry {
+    Key key;
+    uint64_t size;
+    EGLImageBuffer *image;
+  };
+
+  EGLImageCache(const EGLImageCache &) = delete;
+  EGLImageCache &operator=(const EGLImageCache &) = delete;
+
+  void evict();
+
+  EGLImageShim *shim;
+  uint32_t maxEntries;
+  uint64_t maxBytes;
+  uint64_t bytes = 0;
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+  uint64_t evictions = 0;
+  std::list<Entry> lru = {};  // most recently used first
+  std::map<Key, std::list<Entry>::iterator> entries = {};
+};
+
+#endif  // __TONEMAPPER_EGLIMAGECACHE_H__
@@ -26,55 +26,15 @@
 
 #include "EGLImageWrapper.h"
 #include <cutils/native_handle.h>
+#include <gr_utils.h>
 #include <QtiGralloc.h>
 #include <QtiGrallocPriv.h>
 #include <ui/GraphicBuffer.h>
-#include <fcntl.h>
-#include <string>
-#include <map>
-#include <utility>
 #include <sys/stat.h>
 
-using std::string;
-using std::map;
-using std::pair;
 using aidl::android::hardware::graphics::common::StandardMetadataType;
 using private_handle_t = qtigralloc::private_handle_t;
 
-static string pidString = std::to_string(getpid());
-
-//-----------------------------------------------------------------------------
-static string get_ion_buff_str(int buff_fd)
-//-----------------------------------------------------------------------------
-{
-  string retStr = {};
-  if (buff_fd >= 0) {
-    struct stat stat1;
-    fstat(buff_fd, &stat1);
-    retStr = std::to_string(stat1.st_ino);
-  }
-
-  return retStr;
-}
-
-//-----------------------------------------------------------------------------
-void EGLImageWrapper::DeleteEGLImageCallback::operator()(int& buffInt, EGLImageBuffer*& eglImage)
-//-----------------------------------------------------------------------------
-{
-  if (eglImage != 0) {
-    delete eglImage;
-  }
-
-  if (!mapClearPending) {
-    for (auto it = buffStrbuffIntMapPtr->begin(); it != buffStrbuffIntMapPtr->end(); it++) {
-      if (it->second == buffInt /* counter */) {
-        buffStrbuffIntMapPtr->erase(it);
-        return;
-      }
-    }
-  }
-}
-
 //-----------------------------------------------------------------------------
 EGLImageWrapper::EGLImageWrapper()
 //-----------------------------------------------------------------------------
@@ -93,30 +53,20 @@ EGLImageWrapper::~EGLImageWrapper()
 void EGLImageWrapper::Init()
 //-----------------------------------------------------------------------------
 {
-  eglImageBufferCache = new android::LruCache<int, EGLImageBuffer*>(32);
-  callback = new DeleteEGLImageCallback(&buffStrbuffIntMap);
-  eglImageBufferCache->setOnEntryRemovedListener(callback);
+  eglImageCache = new EGLImageCache(&shim, kMaxCachedImages, kMaxCachedBytes);
 }
 
 //-----------------------------------------------------------------------------
 void EGLImageWrapper::Deinit()
 //-----------------------------------------------------------------------------
 {
-  if (eglImageBufferCache != 0) {
-    if (callback != 0) {
-      callback->mapClearPending = true;
-    }
-    eglImageBufferCache->clear();
-    delete eglImageBufferCache;
-    eglImageBufferCache = 0;
-    buffStrbuffIntMap.clear();
-  }
-
-  if (callback != 0) {
-    delete callback;
-    callback = 0;
+  if (eglImageCache != nullptr) {
+    EGLImageCache::Stats stats = eglImageCache->getStats();
+    ALOGI("EGLImage cache hits %llu misses %llu evictions %llu", (unsigned long long)stats.hits,
+          (unsigned long long)stats.misses, (unsigned long long)stats.evictions);
+    delete eglImageCache;
+    eglImageCache = nullptr;
   }
-
 }
 
 //-----------------------------------------------------------------------------
@@ -160,27 +110,42 @@ static EGLImageBuffer *L_wrap(const private_handle_t *src)
   return result;
 }
 
+//-----------------------------------------------------------------------------
+EGLImageBuffer *EGLImageWrapper::GrallocImageShim::createImage(const void *handle)
+//-----------------------------------------------------------------------------
+{
+  return L_wrap(static_cast<const private_handle_t *>(handle));
+}
+
+//-----------------------------------------------------------------------------
+void EGLImageWrapper::GrallocImageShim::destroyImage(EGLImageBuffer *image)
+//-----------------------------------------------------------------------------
+{
+  // Releases the GL objects and the EGLImageKHR.
+  delete image;
+}
+
 //-----------------------------------------------------------------------------
 EGLImageBuffer *EGLImageWrapper::wrap(const void *pvt_handle)
 //-----------------------------------------------------------------------------
 {
   const private_handle_t *src = static_cast<const private_handle_t *>(pvt_handle);
 
-  string buffStr = get_ion_buff_str(src->fd);
-  EGLImageBuffer* eglImage = nullptr;
-  if (!buffStr.empty()) {
-    auto it = buffStrbuffIntMap.find(buffStr);
-    if (it != buffStrbuffIntMap.end()) {
-      eglImage = eglImageBufferCache->get(it->second);
-    } else {
-        eglImage = L_wrap(src);
-        buffStrbuffIntMap.insert(pair<string, int>(buffStr, buffInt));
-        eglImageBufferCache->put(buffInt, eglImage);
-        buffInt++;
-    }
-  } else {
+  // The buffer id is reused when a handle is imported again, the dma-buf inode identifies the
+  // memory behind it.
+  struct stat bufStat;
+  if (src->fd < 0 || fstat(src->fd, &bufStat) != 0) {
     ALOGE("Could not provide an eglImage for fd = %d, EGLImageWrapper = %p", src->fd, this);
+    return nullptr;
   }
 
-  return eglImage;
+  EGLImageCache::Key key = {src->id, uint64_t(bufStat.st_ino), src->format};
+  return eglImageCache->get(key, src->size, pvt_handle);
+}
+
+//-----------------------------------------------------------------------------
+EGLImageCache::Stats EGLImageWrapper::getStats() const
+//-----------------------------------------------------------------------------
+{
+  return eglImageCache->getStats();
 }
@@ -17,37 +17,40 @@
  * limitations under the License.
  */
 
+/*
+ * Changes from Qualcomm Innovation Center are provided under the following license:
+ *
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
 #ifndef __TONEMAPPER_EGLIMAGEWRAPPER_H__
 #define __TONEMAPPER_EGLIMAGEWRAPPER_H__
 
-#include <utils/LruCache.h>
-#include <string>
-#include <map>
-#include <gr_utils.h>
 #include "EGLImageBuffer.h"
-
-using std::string;
-using std::map;
+#include "EGLImageCache.h"
 
 class EGLImageWrapper {
  private:
-  class DeleteEGLImageCallback : public android::OnEntryRemoved<int, EGLImageBuffer*> {
+  // Creates EGLImageBuffers from gralloc handles, destroying one releases its EGLImageKHR.
+  class GrallocImageShim : public EGLImageShim {
    public:
-     explicit DeleteEGLImageCallback(map<string, int>* mapPtr) { buffStrbuffIntMapPtr = mapPtr; }
-     void operator()(int& buffInt, EGLImageBuffer*& eglImage);
-     map<string, int>* buffStrbuffIntMapPtr = nullptr;
-     bool mapClearPending = false;
+    EGLImageBuffer *createImage(const void *handle) override;
+    void destroyImage(EGLImageBuffer *image) override;
   };
 
-  android::LruCache<int, EGLImageBuffer *>* eglImageBufferCache;
-  map<string, int> buffStrbuffIntMap = {};
-  DeleteEGLImageCallback* callback = 0;
-  uint64_t buffInt = 0;
+  // An image pins its buffer, bound the memory held alive by cached images.
+  static const uint32_t kMaxCachedImages = 32;
+  static const uint64_t kMaxCachedBytes = 128 * 1024 * 1024;
+
+  GrallocImageShim shim;
+  EGLImageCache *eglImageCache = nullptr;
 
  public:
   EGLImageWrapper();
   ~EGLImageWrapper();
   EGLImageBuffer* wrap(const void *pvt_handle);
+  EGLImageCache::Stats getStats() const;
   void Init();
   void Deinit();
 };
@@ -0,0 +1,319 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "CpuTonemapper.h"
+using namespace testing;
+
+namespace {
+
+uint32_t pack1010102(double r, double g, double b, double a)
+{
+  auto q = [](double v, double max) {
+    return uint32_t(lround(std::min(std::max(v, 0.0), 1.0) * max));
+  };
+  return q(r, 1023) | (q(g, 1023) << 10) | (q(b, 1023) << 20) | (q(a, 3) << 30);
+}
+
+double channel(uint32_t v, int c)
+{
+  return (c == 3) ? double(v >> 30) / 3.0 : double((v >> (10 * c)) & 0x3ff) / 1023.0;
+}
+
+struct Tables {
+  explicit Tables(int size, int xformSize = 0)
+      : size(size), lut(size * size * size), xform(xformSize) {}
+
+  template <typename F>
+  void fillLut(F f)
+  {
+    for (int b = 0; b < size; b++) {
+      for (int g = 0; g < size; g++) {
+        for (int r = 0; r < size; r++) {
+          double out[3];
+          f(double(r) / (size - 1), double(g) / (size - 1), double(b) / (size - 1), out);
+          lut[(b * size + g) * size + r] = pack1010102(out[0], out[1], out[2], 1.0);
+        }
+      }
+    }
+  }
+
+  int size;
+  std::vector<uint32_t> lut;
+  std::vector<uint32_t> xform;
+};
+
+// Straightforward double precision model of the GPU shaders, used to produce the golden images.
+double lerp(double a, double b, double f) { return a + (b - a) * f; }
+
+double sample1D(const std::vector<uint32_t> &table, int c, double v)
+{
+  double pos = std::min(std::max(v, 0.0), 1.0) * (table.size() - 1);
+  size_t i = std::min(size_t(floor(pos)), table.size() - 2);
+  return lerp(channel(table[i], c), channel(table[i + 1], c), pos - i);
+}
+
+void goldenPixel(const Tables &t, bool inverse, const double in[4], double out[4])
+{
+  double a = in[3];
+  out[3] = a;
+  if (inverse && a <= 0.0) {
+    std::copy(in, in + 3, out);
+    return;
+  }
+
+  double rgb[3];
+  for (int c = 0; c < 3; c++) {
+    rgb[c] = std::min(std::max(inverse ? in[c] / a : in[c], 0.0), 1.0);
+    if (!t.xform.empty()) {
+      rgb[c] = sample1D(t.xform, c, rgb[c]);
+    }
+  }
+
+  int s = t.size;
+  int idx[3];
+  double f[3];
+  for (int c = 0; c < 3; c++) {
+    double pos = rgb[c] * (s - 1);
+    idx[c] = std::min(int(floor(pos)), s - 2);
+    f[c] = pos - idx[c];
+  }
+  for (int c = 0; c < 3; c++) {
+    auto at = [&](int dr, int dg, int db) {
+      return channel(t.lut[((idx[2] + db) * s + idx[1] + dg) * s + idx[0] + dr], c);
+    };
+    double c00 = lerp(at(0, 0, 0), at(1, 0, 0), f[0]);
+    double c10 = lerp(at(0, 1, 0), at(1, 1, 0), f[0]);
+    double c01 = lerp(at(0, 0, 1), at(1, 0, 1), f[0]);
+    double c11 = lerp(at(0, 1, 1), at(1, 1, 1), f[0]);
+    double c0 = lerp(c00, c10, f[1]);
+    double c1 = lerp(c01, c11, f[1]);
+    out[c] = lerp(c0, c1, f[2]) * (inverse ? a : 1.0);
+  }
+}
+
+std::vector<uint32_t> goldenImage(const Tables &t, bool inverse, const std::vector<uint32_t> &src)
+{
+  std::vector<uint32_t> dst(src.size());
+  for (size_t i = 0; i < src.size(); i++) {
+    double in[4], out[4];
+    for (int c = 0; c < 4; c++) {
+      in[c] = channel(src[i], c);
+    }
+    goldenPixel(t, inverse, in, out);
+    dst[i] = pack1010102(out[0], out[1], out[2], out[3]);
+  }
+  return dst;
+}
+
+std::vector<uint32_t> randomImage(int width, int height, bool premultiplied, uint32_t seed)
+{
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<double> dist(0.0, 1.0);
+  std::vector<uint32_t> image(width * height);
+  for (auto &pixel : image) {
+    double a = premultiplied ? double(rng() % 4) / 3.0 : 1.0;
+    pixel = pack1010102(dist(rng) * a, dist(rng) * a, dist(rng) * a, a);
+  }
+  return image;
+}
+
+CpuTonemapper::Image wrap(std::vector<uint32_t> &pixels, int width, int height)
+{
+  return {pixels.data(), width, height, width * 4, CpuTonemapper::kRGBA1010102};
+}
+
+// Both sides are quantized to 10 bits, allow for one step of rounding difference.
+MATCHER_P(WithinOneStep, expected, "")
+{
+  for (size_t i = 0; i < arg.size(); i++) {
+    for (int c = 0; c < 4; c++) {
+      int shift = 10 * c;
+      int mask = (c == 3) ? 0x3 : 0x3ff;
+      int a = (arg[i] >> shift) & mask;
+      int e = (expected[i] >> shift) & mask;
+      if (abs(a - e) > 1) {
+        *result_listener << "pixel " << i << " channel " << c << ": " << a << " vs " << e;
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+void toneCurve(double r, double g, double b, double out[3])
+{
+  // Arbitrary smooth, non-separable mapping.
+  out[0] = pow(r, 1.0 / 2.2) * 0.8 + b * 0.2;
+  out[1] = g * g;
+  out[2] = 0.5 * (r + b) * (1.0 - 0.3 * g);
+}
+
+}  // namespace
+
+TEST(CpuTonemapperTest, IdentityLut)
+{
+  Tables t(17);
+  t.fillLut([](double r, double g, double b, double out[3]) {
+    out[0] = r;
+    out[1] = g;
+    out[2] = b;
+  });
+  const int w = 64, h = 37;
+  auto src = randomImage(w, h, false, 1);
+  std::vector<uint32_t> dst(src.size());
+
+  std::unique_ptr<CpuTonemapper> tm(CpuTonemapper::build(TONEMAP_FORWARD, t.lut.data(), t.size,
+                                                          NULL, 0));
+  ASSERT_THAT(tm, NotNull());
+  ASSERT_THAT(tm->blit(wrap(dst, w, h), wrap(src, w, h)), Eq(0));
+  EXPECT_THAT(dst, WithinOneStep(src));
+}
+
+TEST(CpuTonemapperTest, ForwardMatchesGolden)
+{
+  Tables t(33);
+  t.fillLut(toneCurve);
+  const int w = 50, h = 41;
+  auto src = randomImage(w, h, false, 2);
+  std::vector<uint32_t> dst(src.size());
+
+  std::unique_ptr<CpuTonemapper> tm(CpuTonemapper::build(TONEMAP_FORWARD, t.lut.data(), t.size,
+                                                          NULL, 0));
+  ASSERT_THAT(tm->blit(wrap(dst, w, h), wrap(src, w, h)), Eq(0));
+  EXPECT_THAT(dst, WithinOneStep(goldenImage(t, false, src)));
+}
+
+TEST(CpuTonemapperTest, NonUniformXformMatchesGolden)
+{
+  Tables t(17, 64);
+  t.fillLut(toneCurve);
+  for (size_t i = 0; i < t.xform.size(); i++) {
+    double v = pow(double(i) / (t.xform.size() - 1), 2.4);
+    t.xform[i] = pack1010102(v, 1.0 - v, sqrt(v), 1.0);
+  }
+  const int w = 31, h = 17;
+  auto src = randomImage(w, h, false, 3);
+  std::vector<uint32_t> dst(src.size());
+
+  std::unique_ptr<CpuTonemapper> tm(CpuTonemapper::build(
+      TONEMAP_FORWARD, t.lut.data(), t.size, t.xform.data(), int(t.xform.size())));
+  ASSERT_THAT(tm->blit(wrap(dst, w, h), wrap(src, w, h)), Eq(0));
+  EXPECT_THAT(dst, WithinOneStep(goldenImage(t, false, src)));
+}
+
+TEST(CpuTonemapperTest, InverseHandlesPremultipliedAlpha)
+{
+  Tables t(17);
+  t.fillLut(toneCurve);
+  const int w = 40, h = 20;
+  auto src = randomImage(w, h, true, 4);
+  std::vector<uint32_t> dst(src.size());
+
+  std::unique_ptr<CpuTonemapper> tm(CpuTonemapper::build(TONEMAP_INVERSE, t.lut.data(), t.size,
+                                                          NULL, 0));
+  ASSERT_THAT(tm->blit(wrap(dst, w, h), wrap(src, w, h)), Eq(0));
+  EXPECT_THAT(dst, WithinOneStep(goldenImage(t, true, src)));
+  for (size_t i = 0; i < src.size(); i++) {
+    if ((src[i] >> 30) == 0) {
+      ASSERT_THAT(dst[i], Eq(src[i]));
+    }
+  }
+}
+
+TEST(CpuTonemapperTest, TetrahedralIsExactOnLinearLut)
+{
+  // Both interpolations reproduce an affine mapping exactly, so they only differ by rounding.
+  Tables t(9);
+  t.fillLut([](double r, double g, double b, double out[3]) {
+    out[0] = 0.5 * r + 0.25 * g + 0.25 * b;
+    out[1] = 0.1 + 0.8 * g;
+    out[2] = 1.0 - b;
+  });
+  const int w = 64, h = 16;
+  auto src = randomImage(w, h, false, 5);
+  std::vector<uint32_t> trilinear(src.size());
+  std::vector<uint32_t> tetrahedral(src.size());
+
+  std::unique_ptr<CpuTonemapper> tri(CpuTonemapper::build(TONEMAP_FORWARD, t.lut.data(), t.size,
+                                                           NULL, 0, CpuTonemapper::kTrilinear));
+  std::unique_ptr<CpuTonemapper> tet(CpuTonemapper::build(TONEMAP_FORWARD, t.lut.data(), t.size,
+                                                           NULL, 0, CpuTonemapper::kTetrahedral));
+  ASSERT_THAT(tri->blit(wrap(trilinear, w, h), wrap(src, w, h)), Eq(0));
+  ASSERT_THAT(tet->blit(wrap(tetrahedral, w, h), wrap(src, w, h)), Eq(0));
+  EXPECT_THAT(tetrahedral, WithinOneStep(trilinear));
+}
+
+TEST(CpuTonemapperTest, ThreadCountDoesNotChangeOutput)
+{
+  Tables t(33);
+  t.fillLut(toneCurve);
+  // Height which is not a multiple of the tile size.
+  const int w = 128, h = 101;
+  auto src = randomImage(w, h, false, 6);
+  std::vector<uint32_t> single(src.size());
+  std::vector<uint32_t> multi(src.size());
+
+  std::unique_ptr<CpuTonemapper> one(CpuTonemapper::build(TONEMAP_FORWARD, t.lut.data(), t.size,
+                                                           NULL, 0, CpuTonemapper::kTrilinear, 1));
+  std::unique_ptr<CpuTonemapper> many(CpuTonemapper::build(TONEMAP_FORWARD, t.lut.data(), t.size,
+                                                            NULL, 0, CpuTonemapper::kTrilinear, 4));
+  ASSERT_THAT(one->blit(wrap(single, w, h), wrap(src, w, h)), Eq(0));
+  for (int i = 0; i < 3; i++) {
+    ASSERT_THAT(many->blit(wrap(multi, w, h), wrap(src, w, h)), Eq(0));
+    EXPECT_THAT(multi, ContainerEq(single));
+  }
+}
+
+TEST(CpuTonemapperTest, ConvertsFormats)
+{
+  Tables t(2);
+  t.fillLut([](double r, double g, double b, double out[3]) {
+    out[0] = r;
+    out[1] = g;
+    out[2] = b;
+  });
+  // 10 bit source with an 8 bit destination, padded rows.
+  const int w = 3, h = 2, dstStride = 16;
+  std::vector<uint32_t> src = {pack1010102(0, 0, 0, 1),   pack1010102(1, 0.5, 0, 1),
+                               pack1010102(0, 0, 1, 0),   pack1010102(1, 1, 1, 1),
+                               pack1010102(0.25, 0.75, 0.5, 1), pack1010102(0, 1, 0, 1)};
+  std::vector<uint8_t> dst(dstStride * h, 0xee);
+
+  std::unique_ptr<CpuTonemapper> tm(CpuTonemapper::build(TONEMAP_FORWARD, t.lut.data(), t.size,
+                                                          NULL, 0));
+  CpuTonemapper::Image dstImage = {dst.data(), w, h, dstStride, CpuTonemapper::kRGBA8888};
+  ASSERT_THAT(tm->blit(dstImage, wrap(src, w, h)), Eq(0));
+
+  EXPECT_THAT(std::vector<uint8_t>(dst.begin(), dst.begin() + 4), ElementsAre(0, 0, 0, 255));
+  EXPECT_THAT(std::vector<uint8_t>(dst.begin() + 4, dst.begin() + 8),
+              ElementsAre(255, 128, 0, 255));
+  EXPECT_THAT(std::vector<uint8_t>(dst.begin() + 8, dst.begin() + 12), ElementsAre(0, 0, 255, 0));
+  // Row padding is left alone.
+  EXPECT_THAT(std::vector<uint8_t>(dst.begin() + 12, dst.begin() + 16), Each(0xee));
+  EXPECT_THAT(std::vector<uint8_t>(dst.begin() + 16, dst.begin() + 20), Each(255));
+}
+
+TEST(CpuTonemapperTest, RejectsInvalidInput)
+{
+  Tables t(2);
+  EXPECT_THAT(CpuTonemapper::build(TONEMAP_FORWARD, t.lut.data(), 0, NULL, 0), IsNull());
+  EXPECT_THAT(CpuTonemapper::build(TONEMAP_FORWARD, NULL, 17, NULL, 0), IsNull());
+
+  std::unique_ptr<CpuTonemapper> tm(CpuTonemapper::build(TONEMAP_FORWARD, t.lut.data(), t.size,
+                                                          NULL, 0));
+  std::vector<uint32_t> a(16), b(16);
+  EXPECT_THAT(tm->blit(wrap(a, 4, 4), wrap(b, 2, 8)), Ne(0));
+  EXPECT_THAT(tm->blit(wrap(a, 4, 4), {NULL, 4, 4, 16, CpuTonemapper::kRGBA1010102}), Ne(0));
+}
@@ -0,0 +1,188 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <stdint.h>
+#include <set>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "EGLImageCache.h"
+using namespace testing;
+
+namespace {
+
+// Hands out opaque image pointers which are never dereferenced, and records destruction.
+class FakeShim : public EGLImageShim {
+ public:
+  EGLImageBuffer *createImage(const void *handle) override
+  {
+    created.push_back(handle);
+    if (failCreate) {
+      return nullptr;
+    }
+    EGLImageBuffer *image = reinterpret_cast<EGLImageBuffer *>(uintptr_t(++nextImage));
+    live.insert(image);
+    return image;
+  }
+
+  void destroyImage(EGLImageBuffer *image) override
+  {
+    EXPECT_THAT(live.erase(image), Eq(1u)) << "image destroyed twice or never created";
+    destroyed.push_back(image);
+  }
+
+  bool failCreate = false;
+  uintptr_t nextImage = 0;
+  std::vector<const void *> created;
+  std::vector<EGLImageBuffer *> destroyed;
+  std::set<EGLImageBuffer *> live;
+};
+
+const void *handle(int i)
+{
+  return reinterpret_cast<const void *>(uintptr_t(0x1000 + i));
+}
+
+const uint64_t kMiB = 1024 * 1024;
+
+}  // namespace
+
+TEST(EGLImageCacheTest, HitReturnsSameImage)
+{
+  FakeShim shim;
+  EGLImageCache cache(&shim, 8, 64 * kMiB);
+
+  EGLImageBuffer *image = cache.get({1, 100, 1}, kMiB, handle(1));
+  ASSERT_THAT(image, NotNull());
+  EXPECT_THAT(cache.get({1, 100, 1}, kMiB, handle(1)), Eq(image));
+
+  EGLImageCache::Stats stats = cache.getStats();
+  EXPECT_THAT(stats.hits, Eq(1u));
+  EXPECT_THAT(stats.misses, Eq(1u));
+  EXPECT_THAT(stats.entries, Eq(1u));
+  EXPECT_THAT(stats.bytes, Eq(kMiB));
+  EXPECT_THAT(shim.created, SizeIs(1));
+}
+
+TEST(EGLImageCacheTest, GenerationAndFormatAreDistinct)
+{
+  FakeShim shim;
+  EGLImageCache cache(&shim, 8, 64 * kMiB);
+
+  // Same buffer id backed by new memory, or reinterpreted with another format, must not hit.
+  EGLImageBuffer *a = cache.get({1, 100, 1}, kMiB, handle(1));
+  EGLImageBuffer *b = cache.get({1, 101, 1}, kMiB, handle(1));
+  EGLImageBuffer *c = cache.get({1, 100, 2}, kMiB, handle(1));
+  EXPECT_THAT(b, Ne(a));
+  EXPECT_THAT(c, Ne(a));
+  EXPECT_THAT(c, Ne(b));
+  EXPECT_THAT(cache.getStats().misses, Eq(3u));
+  EXPECT_THAT(cache.getStats().hits, Eq(0u));
+}
+
+TEST(EGLImageCacheTest, EvictsLeastRecentlyUsedOverEntryLimit)
+{
+  FakeShim shim;
+  EGLImageCache cache(&shim, 3, 64 * kMiB);
+
+  EGLImageBuffer *a = cache.get({1, 1, 1}, kMiB, handle(1));
+  EGLImageBuffer *b = cache.get({2, 2, 1}, kMiB, handle(2));
+  cache.get({3, 3, 1}, kMiB, handle(3));
+  // Touch a, so b is the oldest.
+  cache.get({1, 1, 1}, kMiB, handle(1));
+  cache.get({4, 4, 1}, kMiB, handle(4));
+
+  EXPECT_THAT(shim.destroyed, ElementsAre(b));
+  EXPECT_THAT(cache.getStats().evictions, Eq(1u));
+  EXPECT_THAT(cache.getStats().entries, Eq(3u));
+  EXPECT_THAT(cache.get({1, 1, 1}, kMiB, handle(1)), Eq(a));
+}
+
+TEST(EGLImageCacheTest, EvictsOverByteBudget)
+{
+  FakeShim shim;
+  EGLImageCache cache(&shim, 32, 10 * kMiB);
+
+  EGLImageBuffer *a = cache.get({1, 1, 1}, 4 * kMiB, handle(1));
+  EGLImageBuffer *b = cache.get({2, 2, 1}, 4 * kMiB, handle(2));
+  cache.get({3, 3, 1}, 1 * kMiB, handle(3));
+  EXPECT_THAT(shim.destroyed, IsEmpty());
+
+  // 17 MiB in total, the two oldest have to go.
+  cache.get({4, 4, 1}, 8 * kMiB, handle(4));
+  EXPECT_THAT(shim.destroyed, ElementsAre(a, b));
+  EXPECT_THAT(cache.getStats().bytes, Eq(9 * kMiB));
+  EXPECT_THAT(cache.getStats().evictions, Eq(2u));
+}
+
+TEST(EGLImageCacheTest, KeepsSourceAndDestinationOfABlit)
+{
+  FakeShim shim;
+  EGLImageCache cache(&shim, 1, 1 * kMiB);
+
+  // Both images of a blit exceed the budget on their own, neither may be destroyed while the
+  // other is looked up.
+  EGLImageBuffer *dst = cache.get({1, 1, 1}, 8 * kMiB, handle(1));
+  EGLImageBuffer *src = cache.get({2, 2, 1}, 8 * kMiB, handle(2));
+  EXPECT_THAT(shim.destroyed, IsEmpty());
+  EXPECT_THAT(shim.live, UnorderedElementsAre(dst, src));
+
+  cache.get({3, 3, 1}, 8 * kMiB, handle(3));
+  EXPECT_THAT(shim.destroyed, ElementsAre(dst));
+  EXPECT_THAT(cache.getStats().entries, Eq(EGLImageCache::kMinResident));
+}
+
+TEST(EGLImageCacheTest, FailedCreateIsNotCached)
+{
+  FakeShim shim;
+  EGLImageCache cache(&shim, 8, 64 * kMiB);
+
+  shim.failCreate = true;
+  EXPECT_THAT(cache.get({1, 1, 1}, kMiB, handle(1)), IsNull());
+  shim.failCreate = false;
+  EXPECT_THAT(cache.get({1, 1, 1}, kMiB, handle(1)), NotNull());
+
+  EXPECT_THAT(cache.getStats().misses, Eq(2u));
+  EXPECT_THAT(cache.getStats().entries, Eq(1u));
+}
+
+TEST(EGLImageCacheTest, ClearAndDestructionReleaseAllImages)
+{
+  FakeShim shim;
+  {
+    EGLImageCache cache(&shim, 8, 64 * kMiB);
+    for (int i = 0; i < 5; i++) {
+      cache.get({uint64_t(i), 1, 1}, kMiB, handle(i));
+    }
+    cache.clear();
+    EXPECT_THAT(shim.live, IsEmpty());
+    EXPECT_THAT(cache.getStats().bytes, Eq(0u));
+    EXPECT_THAT(cache.getStats().entries, Eq(0u));
+
+    cache.get({7, 1, 1}, kMiB, handle(7));
+  }
+  EXPECT_THAT(shim.live, IsEmpty());
+  EXPECT_THAT(shim.destroyed, SizeIs(6));
+}
+
+TEST(EGLImageCacheTest, LongSessionStaysBounded)
+{
+  FakeShim shim;
+  EGLImageCache cache(&shim, 32, 64 * kMiB);
+
+  // A video session cycling through buffer queues of 4 buffers, reallocated every 50 frames.
+  for (int frame = 0; frame < 10000; frame++) {
+    uint64_t generation = uint64_t(frame / 50);
+    uint64_t id = generation * 4 + uint64_t(frame % 4);
+    ASSERT_THAT(cache.get({id, generation, 1}, 12 * kMiB, handle(int(id))), NotNull());
+    ASSERT_THAT(cache.getStats().bytes, Le(64 * kMiB));
+  }
+
+  EGLImageCache::Stats stats = cache.getStats();
+  EXPECT_THAT(stats.misses, Eq(200u * 4));
+  EXPECT_THAT(stats.hits, Eq(10000u - 200 * 4));
+  EXPECT_THAT(shim.live.size(), Eq(size_t(stats.entries)));
+}
@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __DISPLAY_CONFIG_BATCH_H__
+#define __DISPLAY_CONFIG_BATCH_H__
+
+#include <config/client_interface.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace DisplayConfig {
+
+// Queues DisplayConfig queries and sends them to the display service in a single transaction,
+// instead of one binder round trip per query. Outputs and per-call errors are written when
+// Execute() returns; an output is left untouched if its call failed. Falls back to one
+// transaction per call on services without batch support. Only clients created through
+// ClientInterface::Create can execute batches.
+//
+//   ClientBatch batch;
+//   int connected_err, count_err;
+//   batch.IsDisplayConnected(DisplayType::kPrimary, &connected, &connected_err);
+//   batch.GetConfigCount(DisplayType::kPrimary, &count, &count_err);
+//   int err = batch.Execute(intf);
+class ClientBatch {
+ public:
+  void IsDisplayConnected(DisplayType dpy, bool *connected, int *error);
+  void GetConfigCount(DisplayType dpy, uint32_t *count, int *error);
+  void GetActiveConfig(DisplayType dpy, uint32_t *config, int *error);
+  void GetDisplayAttributes(uint32_t config_index, DisplayType dpy, Attributes *attributes,
+                            int *error);
+  void GetPanelBrightness(uint32_t *level, int *error);
+  void GetActiveBuiltinDisplayAttributes(Attributes *attr, int *error);
+  void GetWriteBackCapabilities(bool *is_wb_ubwc_supported, int *error);
+  void IsHDRSupported(uint32_t disp_id, bool *supported, int *error);
+  void IsWCGSupported(uint32_t disp_id, bool *supported, int *error);
+  void IsBuiltInDisplay(uint32_t disp_id, bool *is_builtin, int *error);
+  void IsSmartPanelConfig(uint32_t disp_id, uint32_t config_id, bool *is_smart, int *error);
+  void IsRCSupported(uint32_t disp_id, bool *supported, int *error);
+  void GetDisplayHwId(uint32_t disp_id, uint32_t *display_hw_id, int *error);
+  void GetDisplayType(uint64_t physical_disp_id, DisplayType *disp_type, int *error);
+
+  // Returns 0 if the queued calls were executed, their own results are in their error outputs.
+  // Returns -EINVAL for an intf without batch support, or the transport error if a transaction
+  // failed, which is also the error output of the calls it carried. The queue is cleared either
+  // way.
+  int Execute(ClientInterface *intf);
+  void Clear();
+  size_t GetCount() { return calls_.size(); }
+
+ private:
+  struct Call {
+    uint32_t op_code;
+    std::vector<uint8_t> input;
+    void *output;
+    size_t output_size;
+    int *error;
+  };
+
+  void Queue(uint32_t op_code, const void *input, size_t input_size, void *output,
+             size_t output_size, int *error);
+
+  std::vector<Call> calls_;
+};
+
+}  // namespace DisplayConfig
+
+#endif  // __DISPLAY_CONFIG_BATCH_H__
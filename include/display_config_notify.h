@@ -0,0 +1,19 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __DISPLAY_CONFIG_NOTIFY_H__
+#define __DISPLAY_CONFIG_NOTIFY_H__
+
+namespace DisplayConfig {
+
+// Invalidates the display properties DisplayConfig clients cache: config count and attributes,
+// HDR/WCG capabilities, refresh rates, bit clocks and display ids. Call on hotplug, on mode
+// switches and on any config change made outside of DisplayConfig, e.g. through qservice.
+// No-op until DeviceInterface::RegisterDevice() succeeded.
+void NotifyDisplayConfigChanged();
+
+}  // namespace DisplayConfig
+
+#endif  // __DISPLAY_CONFIG_NOTIFY_H__
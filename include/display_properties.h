@@ -123,6 +123,8 @@
 #define ENABLE_FORCE_SPLIT                   DISPLAY_PROP("enable_force_split")
 #define DISABLE_GPU_COLOR_CONVERT            DISPLAY_PROP("disable_gpu_color_convert")
 #define ENABLE_ASYNC_VDS_CREATION            DISPLAY_PROP("enable_async_vds_creation")
+// Largest virtual display output in pixels converted to YUV on the CPU, 0 always uses the GPU
+#define CPU_COLOR_CONVERT_MAX_PIXELS         DISPLAY_PROP("cpu_color_convert_max_pixels")
 #define ENABLE_HISTOGRAM_INTR                DISPLAY_PROP("enable_hist_intr")
 #define DISABLE_MMRM_PROP                    DISPLAY_PROP("disable_mmrm_prop")
 #define DEFER_FPS_FRAME_COUNT                DISPLAY_PROP("defer_fps_frame_count")
@@ -139,6 +141,10 @@
 // Allows color management(tonemapping) in native mode (native mode is considered BT709+sRGB)
 #define ALLOW_TONEMAP_NATIVE                 DISPLAY_PROP("allow_tonemap_native")
 #define ENABLE_METADATA_DUMPING              DISPLAY_PROP("enable_metadata_dump")
+// Upper bound in MB on the data written by one frame dump session, 0 for no limit
+#define FRAME_DUMP_BUDGET_MB                 DISPLAY_PROP("frame_dump_budget_mb")
+// Rediscover hardware capabilities on every start instead of reusing the persisted snapshot
+#define DISABLE_HW_INFO_SNAPSHOT_PROP        DISPLAY_PROP("disable_hw_info_snapshot")
 
 // RC
 #define ENABLE_ROUNDED_CORNER                DISPLAY_PROP("enable_rounded_corner")
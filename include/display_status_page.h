@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __DISPLAY_STATUS_PAGE_H__
+#define __DISPLAY_STATUS_PAGE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <type_traits>
+
+namespace sdm {
+
+// Layout of the read-only page the composer publishes for clients polling display state at
+// display rate. Clients get the page through IQService::GET_DISPLAY_STATUS_PAGE (see
+// qdutils::getDisplayStatusPage()), map it once and read it without any IPC.
+// Every slot is a seqlock: the sequence is odd while the composer updates the slot, readers
+// retry until they copied it between two equal, even sequence values.
+
+const uint32_t kDisplayStatusPageMagic = 0x44535350;  // 'DSSP'
+const uint32_t kDisplayStatusPageVersion = 1;
+const uint32_t kDisplayStatusSlots = 16;  // Indexed by HWC display id
+const uint32_t kDisplayStatusReadAttempts = 1000;
+
+enum DisplayStatusFlags : uint32_t {
+  kDisplayStatusConnected = 1 << 0,
+  kDisplayStatusIdle = 1 << 1,
+  kDisplayStatusQsync = 1 << 2,
+};
+
+struct DisplayStatus {
+  uint32_t flags;               // DisplayStatusFlags
+  uint32_t power_mode;          // composer3 PowerMode
+  uint32_t active_config;
+  uint32_t refresh_rate;        // Hz
+  uint32_t qsync_refresh_rate;  // Hz, valid with kDisplayStatusQsync
+  float brightness;             // 0.0 to 1.0, -1.0 if off or never set
+  uint64_t frame_count;         // Commits published on this display
+  int64_t timestamp_ns;         // CLOCK_MONOTONIC of the last update
+};
+
+const uint32_t kDisplayStatusWords = sizeof(DisplayStatus) / sizeof(uint32_t);
+
+struct alignas(64) DisplayStatusSlot {
+  std::atomic<uint32_t> sequence;
+  std::atomic<uint32_t> data[kDisplayStatusWords];
+};
+
+struct DisplayStatusPage {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t slot_count;
+  uint32_t slot_size;
+  DisplayStatusSlot slots[kDisplayStatusSlots];
+};
+
+static_assert(std::is_trivially_copyable<DisplayStatus>::value, "copied word by word");
+static_assert(sizeof(DisplayStatus) % sizeof(uint32_t) == 0, "no partial words");
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "shared across processes");
+static_assert(sizeof(DisplayStatusPage) <= 4096, "fits one page");
+
+// Writers must be serialized by the caller.
+inline void WriteDisplayStatus(DisplayStatusSlot *slot, const DisplayStatus &status) {
+  uint32_t data[kDisplayStatusWords];
+  memcpy(data, &status, sizeof(status));
+
+  // Release stores keep the odd sequence ahead of the data, readers which see any new word
+  // then also see the sequence change. No standalone fences, which sanitizers do not model.
+  uint32_t sequence = slot->sequence.load(std::memory_order_relaxed);
+  slot->sequence.store(sequence + 1, std::memory_order_relaxed);
+  for (uint32_t i = 0; i < kDisplayStatusWords; i++) {
+    slot->data[i].store(data[i], std::memory_order_release);
+  }
+  slot->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+// Single attempt, fails if the slot was updated while it was copied.
+inline bool TryReadDisplayStatus(const DisplayStatusSlot *slot, DisplayStatus *status) {
+  uint32_t sequence = slot->sequence.load(std::memory_order_acquire);
+  if (sequence & 1) {
+    return false;
+  }
+
+  uint32_t data[kDisplayStatusWords];
+  for (uint32_t i = 0; i < kDisplayStatusWords; i++) {
+    data[i] = slot->data[i].load(std::memory_order_acquire);
+  }
+  if (slot->sequence.load(std::memory_order_relaxed) != sequence) {
+    return false;
+  }
+
+  memcpy(status, data, sizeof(*status));
+  return true;
+}
+
+inline bool ReadDisplayStatus(const DisplayStatusPage *page, uint32_t display,
+                              DisplayStatus *status) {
+  if (!page || !status || display >= page->slot_count || display >= kDisplayStatusSlots) {
+    return false;
+  }
+
+  for (uint32_t attempt = 0; attempt < kDisplayStatusReadAttempts; attempt++) {
+    if (TryReadDisplayStatus(&page->slots[display], status)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+}  // namespace sdm
+
+#endif  // __DISPLAY_STATUS_PAGE_H__
@@ -14,14 +14,25 @@
  * limitations under the License.
  */
 
+/*
+ * Changes from Qualcomm Innovation Center are provided under the following license:
+ *
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
 #include <signal.h>
 #include <unistd.h>
+#include <array>
 #include <chrono>
 #include <fstream>
 #include <iostream>
 #include <thread>
 
+#include "hist_simd.h"
 #include "histogram_collector.h"
+#include "histogram_stream.h"
+#include "ringbuffer.h"
 
 void sigint_handler(int) {}
 
@@ -32,9 +43,79 @@ void show_usage(char *progname) {
             << "\t-h      display this help message\n"
             << "\t-o      write output to specified filename\n"
             << "\t-t NUM  Collect results over NUM seconds, and then exit\n"
-            << "\t-m NUM  Only store the last NUM frames of statistics\n";
+            << "\t-m NUM  Only store the last NUM frames of statistics\n"
+            << "\t-s FILE Stream every sampled frame to FILE in binary\n"
+            << "\t-r FILE Replay a binary stream from FILE instead of sampling\n";
 }
 
+namespace {
+// Same as the collector's default.
+constexpr size_t kDefaultMaxFrames = 300;
+
+// Replayed frames carry their own timestamps, time only moves when a frame is inserted.
+struct ReplayTimeKeeper : histogram::TimeKeeper {
+  nsecs_t current_time() const final { return now; }
+  nsecs_t now = 0;
+};
+
+int replay(char const *stream_filename, size_t max_frames) {
+  histogram::StreamReader reader;
+  if (!reader.open(stream_filename)) {
+    std::cerr << "Error, could not open stream: " << stream_filename << "\n";
+    return EXIT_FAILURE;
+  }
+
+  auto tk = std::make_unique<ReplayTimeKeeper>();
+  auto *replay_time = tk.get();
+  auto rb = histogram::Ringbuffer::create(max_frames, std::move(tk));
+
+  uint64_t frames = 0;
+  nsecs_t first = 0;
+  nsecs_t timestamp = 0;
+  drm_msm_hist frame = {};
+  std::chrono::nanoseconds insert_time(0);
+  while (reader.read(timestamp, frame)) {
+    if (frames && timestamp < replay_time->now) {
+      std::cerr << "Error, timestamps go backwards at frame " << frames << "\n";
+      return EXIT_FAILURE;
+    }
+    if (!frames)
+      first = timestamp;
+    replay_time->now = timestamp;
+
+    auto begin = std::chrono::steady_clock::now();
+    rb->insert(frame, timestamp);
+    insert_time += std::chrono::steady_clock::now() - begin;
+    frames++;
+  }
+
+  auto begin = std::chrono::steady_clock::now();
+  uint64_t num_frames = 0;
+  std::array<uint64_t, HIST_V_SIZE> bins;
+  std::tie(num_frames, bins) = rb->collect_ringbuffer_all();
+  auto collect_time = std::chrono::steady_clock::now() - begin;
+
+  std::array<uint64_t, 8> buckets;
+  histogram::bins_rebucket(buckets.data(), buckets.size(), bins.data(), bins.size());
+
+  std::cout << "Replayed " << frames << " frames over "
+            << std::chrono::duration_cast<std::chrono::milliseconds>(
+                   std::chrono::nanoseconds(timestamp - first)).count()
+            << " ms, ringbuffer holds " << num_frames << "\n";
+  if (frames) {
+    std::cout << "\tinsert: " << insert_time.count() / frames << " ns/frame, collect: "
+              << std::chrono::duration_cast<std::chrono::nanoseconds>(collect_time).count()
+              << " ns\n";
+  }
+  std::cout << "\tbucket\t: # of displayed pixels at bucket value, newest frame excluded\n";
+  for (auto i = 0u; i < buckets.size(); i++) {
+    std::cout << "\t" << i << "\t: " << buckets[i] << '\n';
+  }
+
+  return EXIT_SUCCESS;
+}
+}  // namespace
+
 int main(int argc, char **argv) {
   struct sigaction sigHandler;
   sigHandler.sa_handler = sigint_handler;
@@ -44,8 +125,11 @@ int main(int argc, char **argv) {
 
   int c;
   char *output_filename = NULL;
+  char *stream_filename = NULL;
+  char *replay_filename = NULL;
   int timeout = -1;
-  while ((c = getopt(argc, argv, "o:t:h")) != -1) {
+  long max_frames = 0;
+  while ((c = getopt(argc, argv, "o:t:m:s:r:h")) != -1) {
     switch (c) {
       case 'o':
         output_filename = optarg;
@@ -53,6 +137,19 @@ int main(int argc, char **argv) {
       case 't':
         timeout = strtol(optarg, NULL, 10);
         break;
+      case 'm':
+        max_frames = strtol(optarg, NULL, 10);
+        if (max_frames <= 0) {
+          show_usage(argv[0]);
+          return EXIT_FAILURE;
+        }
+        break;
+      case 's':
+        stream_filename = optarg;
+        break;
+      case 'r':
+        replay_filename = optarg;
+        break;
       default:
       case 'h':
         show_usage(argv[0]);
@@ -60,8 +157,27 @@ int main(int argc, char **argv) {
     }
   }
 
+  if (replay_filename) {
+    return replay(replay_filename,
+                  max_frames ? static_cast<size_t>(max_frames) : kDefaultMaxFrames);
+  }
+
   histogram::HistogramCollector histogram;
-  histogram.start();
+  histogram::StreamWriter stream;
+  if (stream_filename) {
+    if (!stream.open(stream_filename)) {
+      std::cerr << "Error, could not open stream: " << stream_filename << "\n";
+      return EXIT_FAILURE;
+    }
+    histogram.set_frame_listener([&stream](nsecs_t timestamp, drm_msm_hist const &frame) {
+      stream.write(timestamp, frame);
+    });
+  }
+  if (max_frames) {
+    histogram.start(static_cast<uint64_t>(max_frames));
+  } else {
+    histogram.start();
+  }
 
   bool cancelled_during_wait = false;
   if (timeout > 0) {
@@ -78,6 +194,11 @@ int main(int argc, char **argv) {
   std::cout << "Sampling results:\n";
 
   histogram.stop();
+  if (stream_filename) {
+    stream.close();
+    std::cout << "Streamed " << stream.records_written() << " frames to: " << stream_filename
+              << '\n';
+  }
 
   if (cancelled_during_wait) {
     std::cout << "Timed histogram collection cancelled via signal\n";
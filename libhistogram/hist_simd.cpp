@@ -0,0 +1,254 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include "hist_simd.h"
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+uint64_t histogram::scalar::bins_sum(uint32_t const *bins, size_t count) {
+  uint64_t sum = 0;
+  for (auto i = 0u; i < count; i++)
+    sum += bins[i];
+  return sum;
+}
+
+void histogram::scalar::bins_accumulate(uint64_t *acc, uint32_t const *bins, uint64_t weight,
+                                        size_t count) {
+  for (auto i = 0u; i < count; i++)
+    acc[i] += bins[i] * weight;
+}
+
+void histogram::scalar::bins_window(uint64_t *out, uint64_t const *end, uint64_t const *begin,
+                                    uint32_t const *bins, uint64_t weight, size_t count) {
+  for (auto i = 0u; i < count; i++)
+    out[i] = end[i] - begin[i] + bins[i] * weight;
+}
+
+void histogram::scalar::bins_rebucket(uint64_t *out, size_t num_buckets, uint64_t const *bins,
+                                      size_t count) {
+  auto const group = count / num_buckets;
+  for (auto b = 0u; b < num_buckets; b++) {
+    uint64_t sum = 0;
+    for (auto i = 0u; i < group; i++)
+      sum += bins[b * group + i];
+    out[b] = sum;
+  }
+}
+
+// Every implementation provides the same kernels: lanes, the number of bins per step, and load,
+// widening multiply by weight, add and sub on vectors of 64 bit lanes. Bins which do not fill a
+// vector are left to the scalar implementation.
+namespace {
+
+#if defined(__ARM_NEON)
+
+constexpr char kImplementation[] = "neon";
+constexpr size_t kLanes = 4;  // two uint64x2_t per step
+struct Vec {
+  uint64x2_t lo;
+  uint64x2_t hi;
+};
+struct Weight {
+  uint32x2_t lo;
+  uint32x2_t hi;
+};
+
+inline Weight make_weight(uint64_t weight) {
+  return {vdup_n_u32(static_cast<uint32_t>(weight)),
+          vdup_n_u32(static_cast<uint32_t>(weight >> 32))};
+}
+inline Vec zero() { return {vdupq_n_u64(0), vdupq_n_u64(0)}; }
+inline Vec load(uint64_t const *p) { return {vld1q_u64(p), vld1q_u64(p + 2)}; }
+inline void store(uint64_t *p, Vec v) {
+  vst1q_u64(p, v.lo);
+  vst1q_u64(p + 2, v.hi);
+}
+inline Vec widen(uint32_t const *p) {
+  uint32x4_t b = vld1q_u32(p);
+  return {vmovl_u32(vget_low_u32(b)), vmovl_u32(vget_high_u32(b))};
+}
+// Low 64 bits of bins * weight, from two 32x32 bit products.
+inline uint64x2_t mul_half(uint32x2_t b, Weight w) {
+  return vaddq_u64(vmull_u32(b, w.lo), vshlq_n_u64(vmull_u32(b, w.hi), 32));
+}
+inline Vec mul(uint32_t const *p, Weight w) {
+  uint32x4_t b = vld1q_u32(p);
+  return {mul_half(vget_low_u32(b), w), mul_half(vget_high_u32(b), w)};
+}
+inline Vec add(Vec a, Vec b) { return {vaddq_u64(a.lo, b.lo), vaddq_u64(a.hi, b.hi)}; }
+inline Vec sub(Vec a, Vec b) { return {vsubq_u64(a.lo, b.lo), vsubq_u64(a.hi, b.hi)}; }
+inline uint64_t reduce(Vec v) {
+  uint64x2_t s = vaddq_u64(v.lo, v.hi);
+  return vgetq_lane_u64(s, 0) + vgetq_lane_u64(s, 1);
+}
+
+#elif defined(__AVX2__)
+
+constexpr char kImplementation[] = "avx2";
+constexpr size_t kLanes = 4;
+typedef __m256i Vec;
+struct Weight {
+  __m256i lo;
+  __m256i hi;
+};
+
+inline Weight make_weight(uint64_t weight) {
+  return {_mm256_set1_epi64x(static_cast<int64_t>(weight & 0xffffffff)),
+          _mm256_set1_epi64x(static_cast<int64_t>(weight >> 32))};
+}
+inline Vec zero() { return _mm256_setzero_si256(); }
+inline Vec load(uint64_t const *p) {
+  return _mm256_loadu_si256(reinterpret_cast<__m256i const *>(p));
+}
+inline void store(uint64_t *p, Vec v) { _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), v); }
+inline Vec widen(uint32_t const *p) {
+  return _mm256_cvtepu32_epi64(_mm_loadu_si128(reinterpret_cast<__m128i const *>(p)));
+}
+// Low 64 bits of bins * weight, from two 32x32 bit products.
+inline Vec mul(uint32_t const *p, Weight w) {
+  Vec b = widen(p);
+  return _mm256_add_epi64(_mm256_mul_epu32(b, w.lo),
+                          _mm256_slli_epi64(_mm256_mul_epu32(b, w.hi), 32));
+}
+inline Vec add(Vec a, Vec b) { return _mm256_add_epi64(a, b); }
+inline Vec sub(Vec a, Vec b) { return _mm256_sub_epi64(a, b); }
+inline uint64_t reduce(Vec v) {
+  uint64_t lanes[2];
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(lanes),
+                   _mm_add_epi64(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1)));
+  return lanes[0] + lanes[1];
+}
+
+#elif defined(__SSE2__)
+
+constexpr char kImplementation[] = "sse2";
+constexpr size_t kLanes = 4;  // two __m128i per step
+struct Vec {
+  __m128i lo;
+  __m128i hi;
+};
+struct Weight {
+  __m128i lo;
+  __m128i hi;
+};
+
+inline Weight make_weight(uint64_t weight) {
+  return {_mm_set1_epi64x(static_cast<int64_t>(weight & 0xffffffff)),
+          _mm_set1_epi64x(static_cast<int64_t>(weight >> 32))};
+}
+inline Vec zero() { return {_mm_setzero_si128(), _mm_setzero_si128()}; }
+inline Vec load(uint64_t const *p) {
+  return {_mm_loadu_si128(reinterpret_cast<__m128i const *>(p)),
+          _mm_loadu_si128(reinterpret_cast<__m128i const *>(p + 2))};
+}
+inline void store(uint64_t *p, Vec v) {
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(p), v.lo);
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(p + 2), v.hi);
+}
+inline Vec widen(uint32_t const *p) {
+  __m128i b = _mm_loadu_si128(reinterpret_cast<__m128i const *>(p));
+  return {_mm_unpacklo_epi32(b, _mm_setzero_si128()), _mm_unpackhi_epi32(b, _mm_setzero_si128())};
+}
+// Low 64 bits of bins * weight, from two 32x32 bit products.
+inline __m128i mul_half(__m128i b, Weight w) {
+  return _mm_add_epi64(_mm_mul_epu32(b, w.lo), _mm_slli_epi64(_mm_mul_epu32(b, w.hi), 32));
+}
+inline Vec mul(uint32_t const *p, Weight w) {
+  Vec b = widen(p);
+  return {mul_half(b.lo, w), mul_half(b.hi, w)};
+}
+inline Vec add(Vec a, Vec b) { return {_mm_add_epi64(a.lo, b.lo), _mm_add_epi64(a.hi, b.hi)}; }
+inline Vec sub(Vec a, Vec b) { return {_mm_sub_epi64(a.lo, b.lo), _mm_sub_epi64(a.hi, b.hi)}; }
+inline uint64_t reduce(Vec v) {
+  uint64_t lanes[2];
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(lanes), _mm_add_epi64(v.lo, v.hi));
+  return lanes[0] + lanes[1];
+}
+
+#else
+
+constexpr char kImplementation[] = "scalar";
+
+#endif
+
+}  // namespace
+
+#if defined(__ARM_NEON) || defined(__AVX2__) || defined(__SSE2__)
+
+uint64_t histogram::bins_sum(uint32_t const *bins, size_t count) {
+  auto const vector_count = count - (count % kLanes);
+  Vec acc = zero();
+  for (auto i = 0u; i < vector_count; i += kLanes)
+    acc = add(acc, widen(bins + i));
+  return reduce(acc) + scalar::bins_sum(bins + vector_count, count - vector_count);
+}
+
+void histogram::bins_accumulate(uint64_t *acc, uint32_t const *bins, uint64_t weight,
+                                size_t count) {
+  auto const vector_count = count - (count % kLanes);
+  auto const w = make_weight(weight);
+  for (auto i = 0u; i < vector_count; i += kLanes)
+    store(acc + i, add(load(acc + i), mul(bins + i, w)));
+  scalar::bins_accumulate(acc + vector_count, bins + vector_count, weight, count - vector_count);
+}
+
+void histogram::bins_window(uint64_t *out, uint64_t const *end, uint64_t const *begin,
+                            uint32_t const *bins, uint64_t weight, size_t count) {
+  auto const vector_count = count - (count % kLanes);
+  auto const w = make_weight(weight);
+  for (auto i = 0u; i < vector_count; i += kLanes)
+    store(out + i, add(sub(load(end + i), load(begin + i)), mul(bins + i, w)));
+  scalar::bins_window(out + vector_count, end + vector_count, begin + vector_count,
+                      bins + vector_count, weight, count - vector_count);
+}
+
+void histogram::bins_rebucket(uint64_t *out, size_t num_buckets, uint64_t const *bins,
+                              size_t count) {
+  auto const group = count / num_buckets;
+  if (group % kLanes) {
+    scalar::bins_rebucket(out, num_buckets, bins, count);
+    return;
+  }
+
+  for (auto b = 0u; b < num_buckets; b++) {
+    Vec acc = zero();
+    for (auto i = 0u; i < group; i += kLanes)
+      acc = add(acc, load(bins + b * group + i));
+    out[b] = reduce(acc);
+  }
+}
+
+#else
+
+uint64_t histogram::bins_sum(uint32_t const *bins, size_t count) {
+  return scalar::bins_sum(bins, count);
+}
+
+void histogram::bins_accumulate(uint64_t *acc, uint32_t const *bins, uint64_t weight,
+                                size_t count) {
+  scalar::bins_accumulate(acc, bins, weight, count);
+}
+
+void histogram::bins_window(uint64_t *out, uint64_t const *end, uint64_t const *begin,
+                            uint32_t const *bins, uint64_t weight, size_t count) {
+  scalar::bins_window(out, end, begin, bins, weight, count);
+}
+
+void histogram::bins_rebucket(uint64_t *out, size_t num_buckets, uint64_t const *bins,
+                              size_t count) {
+  scalar::bins_rebucket(out, num_buckets, bins, count);
+}
+
+#endif
+
+char const *histogram::bins_implementation() {
+  return kImplementation;
+}
@@ -0,0 +1,42 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef HISTOGRAM_HIST_SIMD_H_
+#define HISTOGRAM_HIST_SIMD_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Bin loops which run for every histogram event and every collection. The vector implementation
+// is picked at build time from the target ISA (NEON, AVX2 or SSE2), anything else uses the
+// scalar one. All arithmetic is modulo 2^64, so every implementation returns the exact same bits.
+namespace histogram {
+
+// Sum of count bins.
+uint64_t bins_sum(uint32_t const *bins, size_t count);
+// acc[i] += bins[i] * weight
+void bins_accumulate(uint64_t *acc, uint32_t const *bins, uint64_t weight, size_t count);
+// out[i] = end[i] - begin[i] + bins[i] * weight
+void bins_window(uint64_t *out, uint64_t const *end, uint64_t const *begin,
+                 uint32_t const *bins, uint64_t weight, size_t count);
+// Sums count bins into num_buckets buckets of count / num_buckets consecutive bins each.
+// count must be a multiple of num_buckets.
+void bins_rebucket(uint64_t *out, size_t num_buckets, uint64_t const *bins, size_t count);
+
+// Name of the implementation selected at build time.
+char const *bins_implementation();
+
+// Reference implementations, used as fallback and to validate the vector ones.
+namespace scalar {
+uint64_t bins_sum(uint32_t const *bins, size_t count);
+void bins_accumulate(uint64_t *acc, uint32_t const *bins, uint64_t weight, size_t count);
+void bins_window(uint64_t *out, uint64_t const *end, uint64_t const *begin,
+                 uint32_t const *bins, uint64_t weight, size_t count);
+void bins_rebucket(uint64_t *out, size_t num_buckets, uint64_t const *bins, size_t count);
+}  // namespace scalar
+
+}  // namespace histogram
+
+#endif  // HISTOGRAM_HIST_SIMD_H_
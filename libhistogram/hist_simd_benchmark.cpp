@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <array>
+#include <numeric>
+
+#include <benchmark/benchmark.h>
+#include <display/drm/msm_drm_pp.h>
+#include "hist_simd.h"
+
+// Per event and per collection cost of the bin loops, for the build selected implementation
+// against the scalar one. Run with --benchmark_filter to compare a single kernel.
+namespace {
+struct Bins {
+  Bins() {
+    std::iota(bins.begin(), bins.end(), 1u);
+    std::iota(acc.begin(), acc.end(), 1ull << 40);
+    std::iota(begin.begin(), begin.end(), 1ull << 20);
+  }
+  std::array<uint32_t, HIST_V_SIZE> bins;
+  std::array<uint64_t, HIST_V_SIZE> acc;
+  std::array<uint64_t, HIST_V_SIZE> begin;
+  std::array<uint64_t, HIST_V_SIZE> out;
+};
+
+template <uint64_t (*Sum)(uint32_t const *, size_t)>
+void BM_Sum(benchmark::State &state) {
+  Bins b;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(Sum(b.bins.data(), HIST_V_SIZE));
+  }
+}
+
+template <void (*Accumulate)(uint64_t *, uint32_t const *, uint64_t, size_t)>
+void BM_Accumulate(benchmark::State &state) {
+  Bins b;
+  for (auto _ : state) {
+    Accumulate(b.acc.data(), b.bins.data(), 16, HIST_V_SIZE);
+    benchmark::ClobberMemory();
+  }
+}
+
+template <void (*Window)(uint64_t *, uint64_t const *, uint64_t const *, uint32_t const *,
+                         uint64_t, size_t)>
+void BM_Window(benchmark::State &state) {
+  Bins b;
+  for (auto _ : state) {
+    Window(b.out.data(), b.acc.data(), b.begin.data(), b.bins.data(), 16, HIST_V_SIZE);
+    benchmark::ClobberMemory();
+  }
+}
+
+template <void (*Rebucket)(uint64_t *, size_t, uint64_t const *, size_t)>
+void BM_Rebucket(benchmark::State &state) {
+  Bins b;
+  for (auto _ : state) {
+    Rebucket(b.out.data(), 8, b.acc.data(), HIST_V_SIZE);
+    benchmark::ClobberMemory();
+  }
+}
+}  // namespace
+
+BENCHMARK_TEMPLATE(BM_Sum, histogram::scalar::bins_sum);
+BENCHMARK_TEMPLATE(BM_Sum, histogram::bins_sum);
+BENCHMARK_TEMPLATE(BM_Accumulate, histogram::scalar::bins_accumulate);
+BENCHMARK_TEMPLATE(BM_Accumulate, histogram::bins_accumulate);
+BENCHMARK_TEMPLATE(BM_Window, histogram::scalar::bins_window);
+BENCHMARK_TEMPLATE(BM_Window, histogram::bins_window);
+BENCHMARK_TEMPLATE(BM_Rebucket, histogram::scalar::bins_rebucket);
+BENCHMARK_TEMPLATE(BM_Rebucket, histogram::bins_rebucket);
+
+BENCHMARK_MAIN();
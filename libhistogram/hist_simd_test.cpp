@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <limits>
+#include <random>
+#include <vector>
+
+#include <display/drm/msm_drm_pp.h>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "hist_simd.h"
+using namespace testing;
+
+// Compares the build selected implementation bit for bit against the scalar one, including bin
+// counts which leave a remainder for the vector loops, and values which wrap around 64 bits.
+class HistSimdTest : public ::testing::TestWithParam<size_t> {
+ protected:
+  void SetUp() {
+    size_t count = GetParam();
+    bins.resize(count);
+    acc.resize(count);
+    begin.resize(count);
+    for (auto i = 0u; i < count; i++) {
+      bins[i] = bin_dist(rng);
+      acc[i] = wide_dist(rng);
+      begin[i] = wide_dist(rng);
+    }
+    // Extremes, so that carries between the 32 bit halves of the products are exercised.
+    if (count > 1) {
+      bins[0] = std::numeric_limits<uint32_t>::max();
+      acc[count - 1] = std::numeric_limits<uint64_t>::max();
+    }
+  }
+
+  std::vector<uint64_t> weights() {
+    return {0, 1, 16, 0xffffffff, 0x100000000, 0x123456789abcdef, wide_dist(rng),
+            std::numeric_limits<uint64_t>::max()};
+  }
+
+  std::mt19937_64 rng{GetParam()};
+  std::uniform_int_distribution<uint32_t> bin_dist;
+  std::uniform_int_distribution<uint64_t> wide_dist;
+  std::vector<uint32_t> bins;
+  std::vector<uint64_t> acc;
+  std::vector<uint64_t> begin;
+};
+
+TEST_P(HistSimdTest, SumMatchesScalar) {
+  EXPECT_THAT(histogram::bins_sum(bins.data(), bins.size()),
+              Eq(histogram::scalar::bins_sum(bins.data(), bins.size())));
+}
+
+TEST_P(HistSimdTest, AccumulateMatchesScalar) {
+  for (auto weight : weights()) {
+    auto expected = acc;
+    auto actual = acc;
+    histogram::scalar::bins_accumulate(expected.data(), bins.data(), weight, bins.size());
+    histogram::bins_accumulate(actual.data(), bins.data(), weight, bins.size());
+    EXPECT_THAT(actual, ContainerEq(expected)) << "weight " << weight;
+  }
+}
+
+TEST_P(HistSimdTest, WindowMatchesScalar) {
+  for (auto weight : weights()) {
+    std::vector<uint64_t> expected(bins.size());
+    std::vector<uint64_t> actual(bins.size());
+    histogram::scalar::bins_window(expected.data(), acc.data(), begin.data(), bins.data(), weight,
+                                   bins.size());
+    histogram::bins_window(actual.data(), acc.data(), begin.data(), bins.data(), weight,
+                           bins.size());
+    EXPECT_THAT(actual, ContainerEq(expected)) << "weight " << weight;
+  }
+}
+
+TEST_P(HistSimdTest, RebucketMatchesScalar) {
+  for (size_t buckets : {1, 2, 4, 8, 16}) {
+    if (!acc.size() || (acc.size() % buckets))
+      continue;
+    std::vector<uint64_t> expected(buckets);
+    std::vector<uint64_t> actual(buckets);
+    histogram::scalar::bins_rebucket(expected.data(), buckets, acc.data(), acc.size());
+    histogram::bins_rebucket(actual.data(), buckets, acc.data(), acc.size());
+    EXPECT_THAT(actual, ContainerEq(expected)) << "buckets " << buckets;
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(BinCounts, HistSimdTest, Values(0, 1, 3, 4, 7, 16, 33, HIST_V_SIZE));
+
+TEST(HistSimdScalarTest, ScalarMatchesDefinition) {
+  uint32_t bins[] = {1, 2, std::numeric_limits<uint32_t>::max()};
+  uint64_t acc[] = {10, 20, 30};
+  histogram::scalar::bins_accumulate(acc, bins, 3, 3);
+  EXPECT_THAT(acc, ElementsAre(13, 26, 30 + 3ull * std::numeric_limits<uint32_t>::max()));
+  EXPECT_THAT(histogram::scalar::bins_sum(bins, 3), Eq(3ull + std::numeric_limits<uint32_t>::max()));
+}
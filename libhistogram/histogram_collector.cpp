@@ -22,7 +22,9 @@
  * SPDX-License-Identifier: BSD-3-Clause-Clear
  */
 
+#include <errno.h>
 #include <fcntl.h>
+#include <inttypes.h>
 #include <log/log.h>
 #include <pthread.h>
 #include <sys/epoll.h>
@@ -34,6 +36,7 @@
 #include <ctime>
 #include <fstream>
 #include <iomanip>
+#include <limits>
 #include <memory>
 #include <sstream>
 #include <tuple>
@@ -44,13 +47,45 @@
 #include <xf86drm.h>
 #include <xf86drmMode.h>
 
+#include "hist_simd.h"
 #include "histogram_collector.h"
 #include "ringbuffer.h"
 
 constexpr static auto implementation_defined_max_frame_ringbuffer = 300;
 
+namespace {
+struct DrmBlobSource final : histogram::BlobSource {
+  // Reads the blob straight into the caller's buffer, drmModeGetPropertyBlob would allocate and
+  // copy on every event.
+  bool read(int fd, histogram::BlobId id, drm_msm_hist &hist) final {
+    struct drm_mode_get_blob get_blob = {};
+    get_blob.blob_id = id;
+    get_blob.length = sizeof(hist);
+    get_blob.data = reinterpret_cast<uint64_t>(&hist);
+    if (drmIoctl(fd, DRM_IOCTL_MODE_GETPROPBLOB, &get_blob)) {
+      ALOGW("Failed to read histogram blob-id: %X, errno %d", id, errno);
+      return false;
+    }
+    // Kernel only copies the blob if the sizes match, and reports the actual size.
+    return get_blob.length == sizeof(hist);
+  }
+};
+}  // namespace
+
+struct histogram::HistogramCollector::BlobWork {
+  drm_msm_hist hist;
+  uint32_t width;
+  uint32_t height;
+  nsecs_t timestamp;
+};
+
 histogram::HistogramCollector::HistogramCollector()
-    : histogram(histogram::Ringbuffer::create(implementation_defined_max_frame_ringbuffer,
+    : HistogramCollector(std::make_unique<DrmBlobSource>()) {}
+
+histogram::HistogramCollector::HistogramCollector(std::unique_ptr<BlobSource> blob_source)
+    : blobwork(std::make_unique<SpscQueue<BlobWork, kMaxQueuedEvents>>()),
+      blob_source(std::move(blob_source)),
+      histogram(histogram::Ringbuffer::create(implementation_defined_max_frame_ringbuffer,
                                               std::make_unique<histogram::DefaultTimeKeeper>())) {}
 
 histogram::HistogramCollector::~HistogramCollector() {
@@ -61,14 +96,11 @@ namespace {
 static constexpr size_t numBuckets = 8;
 static_assert((HIST_V_SIZE % numBuckets) == 0,
               "histogram cannot be rebucketed to smaller number of buckets");
-static constexpr int bucket_compression = HIST_V_SIZE / numBuckets;
 
 std::array<uint64_t, numBuckets> rebucketTo8Buckets(
     std::array<uint64_t, HIST_V_SIZE> const &frame) {
   std::array<uint64_t, numBuckets> bins;
-  bins.fill(0);
-  for (auto i = 0u; i < HIST_V_SIZE; i++)
-    bins[i / bucket_compression] += frame[i];
+  histogram::bins_rebucket(bins.data(), numBuckets, frame.data(), HIST_V_SIZE);
   return bins;
 }
 }  // namespace
@@ -80,7 +112,10 @@ std::string histogram::HistogramCollector::Dump() const {
   std::array<uint64_t, numBuckets> samples = rebucketTo8Buckets(all_sample_buckets);
 
   std::stringstream ss;
+  auto stats = event_stats();
   ss << "Color Sampling, dark (0.0) to light (1.0): sampled frames: " << num_frames << '\n';
+  ss << "\tevents received: " << stats.received << ", dropped: " << stats.dropped
+     << ", rejected: " << stats.rejected << ", max queued: " << stats.max_queued << '\n';
   if (num_frames == 0) {
     ss << "\tno color statistics collected\n";
     return ss.str();
@@ -168,25 +203,63 @@ void histogram::HistogramCollector::stop() {
 
   if (monitoring_thread.joinable())
     monitoring_thread.join();
+
+  // Consumer is gone, events queued after it exited belong to the stopped session.
+  while (blobwork->front()) {
+    blobwork->pop_front();
+  }
+}
+
+void histogram::HistogramCollector::set_frame_listener(FrameListener listener) {
+  std::unique_lock<decltype(mutex)> lk(mutex);
+  if (started) {
+    ALOGW("Frame listener can only be changed while stopped");
+    return;
+  }
+  frame_listener = listener;
+}
+
+histogram::HistogramCollector::EventStats histogram::HistogramCollector::event_stats() const {
+  return {events_received, events_dropped, events_rejected, max_queued_events};
 }
 
 void histogram::HistogramCollector::notify_histogram_event(int blob_source_fd, BlobId id,
                                                            uint32_t width, uint32_t height) {
-  std::unique_lock<decltype(mutex)> lk(mutex);
   if (!started) {
     ALOGW("Discarding event blob-id: %X", id);
     return;
   }
-  if (work_available) {
-    ALOGI("notified of histogram event before consuming last one. prior event discarded");
+
+  events_received++;
+  BlobWork *work = blobwork->back();
+  if (!work) {
+    // Log at powers of two only, sustained overflow must not flood the log from the event thread.
+    auto dropped = ++events_dropped;
+    if ((dropped & (dropped - 1)) == 0) {
+      ALOGI("histogram event queue full, %" PRIu64 " events dropped", dropped);
+    }
+    return;
+  }
+
+  work->timestamp = systemTime(SYSTEM_TIME_MONOTONIC);
+  work->width = width;
+  work->height = height;
+  // Copy the blob right away, by the time the consumer runs it may hold a later frame.
+  if (!blob_source->read(blob_source_fd, id, work->hist)) {
+    events_rejected++;
+    return;
   }
+  blobwork->commit_back();
 
-  panel_width_ = width;
-  panel_height_ = height;
+  auto queued = blobwork->size();
+  if (queued > max_queued_events) {
+    max_queued_events = queued;
+  }
 
-  work_available = true;
-  blobwork = HistogramCollector::BlobWork{blob_source_fd, id};
-  cv.notify_all();
+  if (consumer_sleeping) {
+    std::lock_guard<decltype(mutex)> lk(mutex);
+    cv.notify_all();
+  }
 }
 
 void histogram::HistogramCollector::blob_processing_thread() {
@@ -195,55 +268,54 @@ void histogram::HistogramCollector::blob_processing_thread() {
   std::unique_lock<decltype(mutex)> lk(mutex);
 
   while (true) {
-    cv.wait(lk, [this] { return !started || work_available; });
+    // Announce before checking the queue, see notify_histogram_event.
+    consumer_sleeping = true;
+    cv.wait(lk, [this] { return !started || !blobwork->empty(); });
+    consumer_sleeping = false;
     if (!started) {
       return;
     }
-
-    auto work = blobwork;
-    work_available = false;
     lk.unlock();
 
-    drmModePropertyBlobPtr blob = drmModeGetPropertyBlob(work.fd, work.id);
-    if (!blob || !blob->data) {
-      lk.lock();
-      continue;
-    }
-
-    bool pass = hist_data_validate(*static_cast<struct drm_msm_hist *>(blob->data));
-    if (pass) {
-      histogram->insert(*static_cast<struct drm_msm_hist *>(blob->data));
+    // Drain everything which arrived since the last wakeup in one go.
+    while (BlobWork *work = blobwork->front()) {
+      process_blob(*work);
+      blobwork->pop_front();
     }
-    drmModeFreePropertyBlob(blob);
 
     lk.lock();
   }
 }
 
-bool histogram::HistogramCollector::hist_data_validate(struct drm_msm_hist const &hist) {
-  uint32_t hist_checksum = 0;
-  uint32_t pixels_sum = panel_width_ * panel_height_;
+void histogram::HistogramCollector::process_blob(BlobWork const &work) {
+  if (!hist_data_validate(work.hist, work.width, work.height)) {
+    events_rejected++;
+    return;
+  }
 
-  if (pixels_sum == 0) {
-    ALOGI("Invalid panel_width %u, height  %u", panel_width_, panel_height_);
-    return false;
+  if (frame_listener) {
+    frame_listener(work.timestamp, work.hist);
   }
+  histogram->insert(work.hist, work.timestamp);
+}
 
-  for (int i = 0; i < HIST_V_SIZE; i++) {
-    // To handle the sum of abnormal histogram exceeding the maximum value of uint32_t
-    if (std::numeric_limits<uint32_t>::max() - hist.data[i] < hist_checksum) {
-      ALOGI("Overflow issue, hist.data[i] %u, current hist_checksum %u, hist_checksum %u", i, hist.data[i],
-            hist_checksum);
-      return false;
-    }
-    // Accumulate hist bin data
-    hist_checksum += hist.data[i];
+bool histogram::HistogramCollector::hist_data_validate(struct drm_msm_hist const &hist,
+                                                       uint32_t width, uint32_t height) {
+  uint64_t pixels_sum = static_cast<uint64_t>(width) * height;
+
+  if (pixels_sum == 0 || pixels_sum > std::numeric_limits<uint32_t>::max()) {
+    ALOGI("Invalid panel_width %u, height  %u", width, height);
+    return false;
   }
 
+  // Sum of HIST_V_SIZE 32 bit bins can not overflow 64 bits. Abnormal sums beyond uint32_t are
+  // caught by the comparison.
+  uint64_t hist_checksum = bins_sum(hist.data, HIST_V_SIZE);
+
   // Hist data is valid when the sum of all hist data equals the total number of pixels
   if (pixels_sum != hist_checksum) {
-    ALOGI("Invalid hsit data, panel_width %u, height %u, hist_checksum %u", panel_width_,
-          panel_height_, hist_checksum);
+    ALOGI("Invalid hist data, panel_width %u, height %u, hist_checksum %" PRIu64, width, height,
+          hist_checksum);
     return false;
   }
 
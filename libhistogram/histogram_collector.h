@@ -24,7 +24,11 @@
 #ifndef HISTOGRAM_HISTOGRAM_COLLECTOR_H_
 #define HISTOGRAM_HISTOGRAM_COLLECTOR_H_
 #include <android-base/thread_annotations.h>
+#include <utils/Timers.h>
+#include <atomic>
 #include <condition_variable>
+#include <functional>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <thread>
@@ -34,25 +38,52 @@
 #undef HWC2_INCLUDE_STRINGIFICATION
 #undef HWC2_USE_CPP11
 
+#include "spsc_queue.h"
+
 // number of enums in hwc2_format_color_component_t;
 #define NUM_HISTOGRAM_COLOR_COMPONENTS 4
 
+struct drm_msm_hist;
+
 namespace histogram {
 typedef uint32_t BlobId;
 
+// Reads the histogram blob of an event, called on the thread notifying the event. Default
+// implementation copies the DRM property blob.
+struct BlobSource {
+  virtual bool read(int fd, BlobId id, drm_msm_hist &hist) = 0;
+  virtual ~BlobSource() = default;
+};
+
 class Ringbuffer;
 class HistogramCollector {
  public:
   HistogramCollector();
+  explicit HistogramCollector(std::unique_ptr<BlobSource> blob_source);
   ~HistogramCollector();
 
+  struct EventStats {
+    uint64_t received;
+    uint64_t dropped;   // queue was full
+    uint64_t rejected;  // blob could not be read or failed validation
+    uint64_t max_queued;
+  };
+  // Includes the event being processed, its histogram stays in the queue until it is inserted.
+  static constexpr size_t kMaxQueuedEvents = 32;
+
+  // Invoked on the blob processing thread for every validated frame. Must be set before start().
+  typedef std::function<void(nsecs_t timestamp, drm_msm_hist const &frame)> FrameListener;
+  void set_frame_listener(FrameListener listener);
+
   void start();
   void start(uint64_t max_frames);
   void stop();
 
+  // Must only be called from a single thread at a time.
   void notify_histogram_event(int blob_source_fd, BlobId id, uint32_t width, uint32_t height);
 
   std::string Dump() const;
+  EventStats event_stats() const;
 
   HWC2::Error collect(uint64_t max_frames, uint64_t timestamp,
                       int32_t samples_size[NUM_HISTOGRAM_COLOR_COMPONENTS],
@@ -63,26 +94,35 @@ class HistogramCollector {
  private:
   HistogramCollector(HistogramCollector const &) = delete;
   HistogramCollector &operator=(HistogramCollector const &) = delete;
+  // Copy of an event's histogram along with the panel size it is validated against.
+  struct BlobWork;
+
   void blob_processing_thread();
-  bool hist_data_validate(struct drm_msm_hist const &hist);
+  void process_blob(BlobWork const &work);
+  bool hist_data_validate(struct drm_msm_hist const &hist, uint32_t width, uint32_t height);
 
   std::condition_variable cv;
   std::mutex mutable mutex;
-  bool started /* GUARDED_BY(mutex) */ = false;
+  std::atomic<bool> started{false}; /* written with mutex held */
 
-  struct BlobWork {
-    int fd; /* non-owning! */
-    BlobId id;
-  } blobwork /* GUARDED_BY(mutex) */;
-  // no optional in c++14.
-  bool work_available = false; /* GUARDED_BY(mutex) */
-  ;
+  // Producer is the event thread, consumer the blob processing thread. The producer only takes
+  // the mutex to wake up the consumer when it announced that it is going to sleep. The blob is
+  // read into its queue entry when the event is notified, the driver may reuse it for a later
+  // frame before the consumer gets to it.
+  std::unique_ptr<SpscQueue<BlobWork, kMaxQueuedEvents>> const blobwork;
+  std::atomic<bool> consumer_sleeping{false};
+
+  std::atomic<uint64_t> events_received{0};
+  std::atomic<uint64_t> events_dropped{0};
+  std::atomic<uint64_t> events_rejected{0};
+  std::atomic<uint64_t> max_queued_events{0};
 
   std::thread monitoring_thread;
 
+  std::unique_ptr<BlobSource> const blob_source;
+  FrameListener frame_listener;
+
   std::unique_ptr<histogram::Ringbuffer> histogram;
-  uint32_t panel_width_ = 0;
-  uint32_t panel_height_ = 0;
 };
 
 }  // namespace histogram
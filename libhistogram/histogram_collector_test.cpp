@@ -0,0 +1,239 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <display/drm/msm_drm_pp.h>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "histogram_collector.h"
+using namespace testing;
+using namespace std::chrono_literals;
+
+namespace {
+constexpr uint32_t kWidth = 16;
+constexpr uint32_t kHeight = HIST_V_SIZE / kWidth;
+constexpr histogram::BlobId kInvalidBlob = 0xdead;
+
+// Serves histograms with all pixels in a single bin, which can be changed per blob id like the
+// driver reusing a blob for a later frame. Reading kInvalidBlob fails.
+struct FakeBlobSource : histogram::BlobSource {
+  bool read(int, histogram::BlobId id, drm_msm_hist &hist) final {
+    std::lock_guard<std::mutex> lk(mutex);
+    reads++;
+    if (id == kInvalidBlob) {
+      return false;
+    }
+    auto it = bins.find(id);
+    auto bin = it == bins.end() ? 0u : it->second;
+    for (auto i = 0u; i < HIST_V_SIZE; i++) {
+      hist.data[i] = i == bin ? kWidth * kHeight : 0;
+    }
+    return true;
+  }
+
+  void set_bin(histogram::BlobId id, uint32_t bin) {
+    std::lock_guard<std::mutex> lk(mutex);
+    bins[id] = bin;
+  }
+
+  uint32_t read_count() {
+    std::lock_guard<std::mutex> lk(mutex);
+    return reads;
+  }
+
+  std::mutex mutex;
+  std::map<histogram::BlobId, uint32_t> bins;
+  uint32_t reads = 0;
+};
+
+// Records the bin of every frame the collector takes. Can hold the blob processing thread
+// inside a frame, to make events pile up in the collector while its thread is busy.
+struct FrameGate {
+  void on_frame(drm_msm_hist const &frame) {
+    std::unique_lock<std::mutex> lk(mutex);
+    processing = true;
+    cv.notify_all();
+    cv.wait(lk, [this] { return !blocked; });
+    for (auto i = 0u; i < HIST_V_SIZE; i++) {
+      if (frame.data[i]) {
+        seen_bins.push_back(i);
+        break;
+      }
+    }
+    frames++;
+    cv.notify_all();
+  }
+
+  void block() {
+    std::lock_guard<std::mutex> lk(mutex);
+    blocked = true;
+    processing = false;
+  }
+
+  void unblock() {
+    std::lock_guard<std::mutex> lk(mutex);
+    blocked = false;
+    cv.notify_all();
+  }
+
+  bool wait_processing() {
+    std::unique_lock<std::mutex> lk(mutex);
+    return cv.wait_for(lk, 5s, [this] { return processing; });
+  }
+
+  uint32_t frame_count() {
+    std::lock_guard<std::mutex> lk(mutex);
+    return frames;
+  }
+
+  bool wait_frames(uint32_t count) {
+    std::unique_lock<std::mutex> lk(mutex);
+    return cv.wait_for(lk, 5s, [this, count] { return frames >= count; });
+  }
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  bool blocked = false;
+  bool processing = false;
+  uint32_t frames = 0;
+  std::vector<uint32_t> seen_bins;
+};
+}  // namespace
+
+class HistogramCollectorTest : public ::testing::Test {
+ protected:
+  void SetUp() {
+    auto source = std::make_unique<FakeBlobSource>();
+    blob_source = source.get();
+    collector = std::make_unique<histogram::HistogramCollector>(std::move(source));
+    collector->set_frame_listener(
+        [this](nsecs_t, drm_msm_hist const &frame) { gate.on_frame(frame); });
+    collector->start();
+  }
+
+  void TearDown() {
+    gate.unblock();
+    collector->stop();
+  }
+
+  uint64_t collected_frames() {
+    int32_t samples_size[NUM_HISTOGRAM_COLOR_COMPONENTS];
+    uint64_t num_frames = 0;
+    collector->collect(0, 0, samples_size, nullptr, &num_frames);
+    return num_frames;
+  }
+
+  FakeBlobSource *blob_source;
+  FrameGate gate;
+  std::unique_ptr<histogram::HistogramCollector> collector;
+};
+
+TEST_F(HistogramCollectorTest, BurstWithinCapacityIsLossless) {
+  static constexpr auto kCapacity = histogram::HistogramCollector::kMaxQueuedEvents;
+  gate.block();
+
+  // First event holds the thread inside the frame listener, its queue entry stays in use.
+  collector->notify_histogram_event(0, 1, kWidth, kHeight);
+  ASSERT_TRUE(gate.wait_processing());
+  for (auto i = 1u; i < kCapacity; i++) {
+    collector->notify_histogram_event(0, i + 1, kWidth, kHeight);
+  }
+
+  gate.unblock();
+  ASSERT_TRUE(gate.wait_frames(kCapacity));
+  collector->stop();
+
+  auto stats = collector->event_stats();
+  EXPECT_THAT(stats.received, Eq(kCapacity));
+  EXPECT_THAT(stats.dropped, Eq(0));
+  EXPECT_THAT(stats.rejected, Eq(0));
+  EXPECT_THAT(stats.max_queued, Eq(kCapacity));
+  EXPECT_THAT(collected_frames(), Eq(kCapacity));
+}
+
+TEST_F(HistogramCollectorTest, OverflowIsAccounted) {
+  static constexpr auto kCapacity = histogram::HistogramCollector::kMaxQueuedEvents;
+  static constexpr auto kOverflow = 5u;
+  gate.block();
+
+  collector->notify_histogram_event(0, 1, kWidth, kHeight);
+  ASSERT_TRUE(gate.wait_processing());
+  for (auto i = 1u; i < kCapacity + kOverflow; i++) {
+    collector->notify_histogram_event(0, i + 1, kWidth, kHeight);
+  }
+  EXPECT_THAT(collector->event_stats().dropped, Eq(kOverflow));
+  // Dropped events are not read.
+  EXPECT_THAT(blob_source->read_count(), Eq(kCapacity));
+
+  gate.unblock();
+  ASSERT_TRUE(gate.wait_frames(kCapacity));
+  collector->stop();
+
+  auto stats = collector->event_stats();
+  EXPECT_THAT(stats.received, Eq(kCapacity + kOverflow));
+  EXPECT_THAT(stats.dropped, Eq(kOverflow));
+  EXPECT_THAT(collected_frames(), Eq(kCapacity));
+}
+
+TEST_F(HistogramCollectorTest, BlobIsCopiedWhenNotified) {
+  gate.block();
+  collector->notify_histogram_event(0, 1, kWidth, kHeight);
+  ASSERT_TRUE(gate.wait_processing());
+
+  // Queued frames must keep their contents when the driver reuses the blob afterwards.
+  blob_source->set_bin(2, 5);
+  collector->notify_histogram_event(0, 2, kWidth, kHeight);
+  blob_source->set_bin(2, 9);
+  collector->notify_histogram_event(0, 2, kWidth, kHeight);
+  blob_source->set_bin(2, 200);
+
+  gate.unblock();
+  ASSERT_TRUE(gate.wait_frames(3));
+  collector->stop();
+  EXPECT_THAT(gate.seen_bins, ElementsAre(0, 5, 9));
+}
+
+TEST_F(HistogramCollectorTest, InvalidBlobsAreRejected) {
+  collector->notify_histogram_event(0, kInvalidBlob, kWidth, kHeight);
+  // Checksum does not match the panel size.
+  collector->notify_histogram_event(0, 1, kWidth, kHeight + 1);
+  collector->notify_histogram_event(0, 2, kWidth, kHeight);
+  ASSERT_TRUE(gate.wait_frames(1));
+  collector->stop();
+
+  auto stats = collector->event_stats();
+  EXPECT_THAT(stats.received, Eq(3));
+  EXPECT_THAT(stats.rejected, Eq(2));
+  EXPECT_THAT(collected_frames(), Eq(1));
+}
+
+TEST_F(HistogramCollectorTest, ConcurrentProducerKeepsAllSamples) {
+  static constexpr auto kEvents = 2000u;
+  // Producer paces itself on the queue depth, like a display at a high refresh rate whose
+  // consumer occasionally falls behind. A frame leaves the queue only after its listener returned.
+  std::thread producer([this] {
+    for (auto i = 0u; i < kEvents; i++) {
+      while (collector->event_stats().received - gate.frame_count() >=
+             histogram::HistogramCollector::kMaxQueuedEvents - 1) {
+        std::this_thread::yield();
+      }
+      collector->notify_histogram_event(0, i + 1, kWidth, kHeight);
+    }
+  });
+  producer.join();
+  ASSERT_TRUE(gate.wait_frames(kEvents));
+  collector->stop();
+
+  auto stats = collector->event_stats();
+  EXPECT_THAT(stats.received, Eq(kEvents));
+  EXPECT_THAT(stats.dropped, Eq(0));
+  EXPECT_THAT(collected_frames(), Eq(kEvents));
+}
@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <errno.h>
+#include <log/log.h>
+#include <string.h>
+
+#include "histogram_stream.h"
+
+namespace {
+constexpr char kMagic[4] = {'H', 'S', 'T', 'R'};
+constexpr uint32_t kVersion = 1;
+// Fully buffered, so that frames reach the file in large writes.
+constexpr size_t kBufferSize = 64 * sizeof(histogram::StreamRecord);
+}  // namespace
+
+histogram::StreamWriter::~StreamWriter() {
+  close();
+}
+
+bool histogram::StreamWriter::open(std::string const &path) {
+  close();
+  file = fopen(path.c_str(), "wb");
+  if (!file) {
+    ALOGE("Failed to open %s, errno %d", path.c_str(), errno);
+    return false;
+  }
+  setvbuf(file, nullptr, _IOFBF, kBufferSize);
+
+  StreamHeader header = {};
+  memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.num_bins = HIST_V_SIZE;
+  header.record_size = sizeof(StreamRecord);
+  if (fwrite(&header, sizeof(header), 1, file) != 1) {
+    close();
+    return false;
+  }
+
+  records = 0;
+  return true;
+}
+
+bool histogram::StreamWriter::write(nsecs_t timestamp, drm_msm_hist const &frame) {
+  if (!file)
+    return false;
+
+  StreamRecord record;
+  record.timestamp = timestamp;
+  memcpy(record.bins, frame.data, sizeof(record.bins));
+  if (fwrite(&record, sizeof(record), 1, file) != 1)
+    return false;
+
+  records++;
+  return true;
+}
+
+void histogram::StreamWriter::close() {
+  if (file) {
+    fclose(file);
+    file = nullptr;
+  }
+}
+
+histogram::StreamReader::~StreamReader() {
+  close();
+}
+
+bool histogram::StreamReader::open(std::string const &path) {
+  close();
+  file = fopen(path.c_str(), "rb");
+  if (!file) {
+    ALOGE("Failed to open %s, errno %d", path.c_str(), errno);
+    return false;
+  }
+  setvbuf(file, nullptr, _IOFBF, kBufferSize);
+
+  StreamHeader header = {};
+  if ((fread(&header, sizeof(header), 1, file) != 1) ||
+      memcmp(header.magic, kMagic, sizeof(kMagic)) || (header.version != kVersion) ||
+      (header.num_bins != HIST_V_SIZE) || (header.record_size != sizeof(StreamRecord))) {
+    ALOGE("%s is not a histogram stream of %d bins", path.c_str(), HIST_V_SIZE);
+    close();
+    return false;
+  }
+
+  return true;
+}
+
+bool histogram::StreamReader::read(nsecs_t &timestamp, drm_msm_hist &frame) {
+  StreamRecord record;
+  if (!file || (fread(&record, sizeof(record), 1, file) != 1))
+    return false;
+
+  timestamp = record.timestamp;
+  memcpy(frame.data, record.bins, sizeof(record.bins));
+  return true;
+}
+
+void histogram::StreamReader::close() {
+  if (file) {
+    fclose(file);
+    file = nullptr;
+  }
+}
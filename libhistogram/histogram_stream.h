@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef HISTOGRAM_HISTOGRAM_STREAM_H_
+#define HISTOGRAM_HISTOGRAM_STREAM_H_
+
+#include <display/drm/msm_drm_pp.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <utils/Timers.h>
+#include <string>
+
+// Binary stream of timestamped histogram frames. A StreamHeader is followed by fixed size
+// StreamRecords in host byte order, so records can be written and read without any parsing.
+namespace histogram {
+
+struct StreamHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t num_bins;
+  uint32_t record_size;
+};
+
+struct StreamRecord {
+  int64_t timestamp;  // CLOCK_MONOTONIC ns at which the frame started to be displayed
+  uint32_t bins[HIST_V_SIZE];
+};
+
+class StreamWriter {
+ public:
+  StreamWriter() = default;
+  ~StreamWriter();
+
+  bool open(std::string const &path);
+  bool write(nsecs_t timestamp, drm_msm_hist const &frame);
+  void close();
+  uint64_t records_written() const { return records; }
+
+ private:
+  StreamWriter(StreamWriter const &) = delete;
+  StreamWriter &operator=(StreamWriter const &) = delete;
+
+  FILE *file = nullptr;
+  uint64_t records = 0;
+};
+
+class StreamReader {
+ public:
+  StreamReader() = default;
+  ~StreamReader();
+
+  // Fails if the stream was recorded with a different record layout.
+  bool open(std::string const &path);
+  // Returns false at the end of the stream, or on a truncated record.
+  bool read(nsecs_t &timestamp, drm_msm_hist &frame);
+  void close();
+
+ private:
+  StreamReader(StreamReader const &) = delete;
+  StreamReader &operator=(StreamReader const &) = delete;
+
+  FILE *file = nullptr;
+};
+
+}  // namespace histogram
+
+#endif  // HISTOGRAM_HISTOGRAM_STREAM_H_
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <stdio.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "histogram_stream.h"
+using namespace testing;
+
+class HistogramStreamTest : public ::testing::Test {
+ protected:
+  void SetUp() {
+    char path_template[] = "/tmp/histogram_stream_XXXXXX";
+    int fd = mkstemp(path_template);
+    ASSERT_THAT(fd, Ge(0));
+    close(fd);
+    path = path_template;
+  }
+
+  void TearDown() { unlink(path.c_str()); }
+
+  std::string path;
+};
+
+TEST_F(HistogramStreamTest, RoundTrip) {
+  std::vector<drm_msm_hist> frames(3);
+  for (auto f = 0u; f < frames.size(); f++) {
+    for (auto i = 0u; i < HIST_V_SIZE; i++) {
+      frames[f].data[i] = f * HIST_V_SIZE + i;
+    }
+  }
+
+  histogram::StreamWriter writer;
+  ASSERT_TRUE(writer.open(path));
+  for (auto f = 0u; f < frames.size(); f++) {
+    ASSERT_TRUE(writer.write(1000 * (f + 1), frames[f]));
+  }
+  EXPECT_THAT(writer.records_written(), Eq(frames.size()));
+  writer.close();
+
+  histogram::StreamReader reader;
+  ASSERT_TRUE(reader.open(path));
+  nsecs_t timestamp = 0;
+  drm_msm_hist frame = {};
+  for (auto f = 0u; f < frames.size(); f++) {
+    ASSERT_TRUE(reader.read(timestamp, frame));
+    EXPECT_THAT(timestamp, Eq(1000 * (f + 1)));
+    EXPECT_THAT(frame.data, ElementsAreArray(frames[f].data));
+  }
+  EXPECT_FALSE(reader.read(timestamp, frame));
+}
+
+TEST_F(HistogramStreamTest, RejectsForeignFile) {
+  FILE *file = fopen(path.c_str(), "wb");
+  ASSERT_THAT(file, NotNull());
+  fputs("bucket 0 to 0.125: 42\n", file);
+  fclose(file);
+
+  histogram::StreamReader reader;
+  EXPECT_FALSE(reader.open(path));
+}
+
+TEST_F(HistogramStreamTest, StopsAtTruncatedRecord) {
+  drm_msm_hist frame = {};
+  histogram::StreamWriter writer;
+  ASSERT_TRUE(writer.open(path));
+  ASSERT_TRUE(writer.write(1, frame));
+  ASSERT_TRUE(writer.write(2, frame));
+  writer.close();
+  ASSERT_THAT(truncate(path.c_str(), sizeof(histogram::StreamHeader) +
+                                         sizeof(histogram::StreamRecord) + 8), Eq(0));
+
+  histogram::StreamReader reader;
+  ASSERT_TRUE(reader.open(path));
+  nsecs_t timestamp = 0;
+  EXPECT_TRUE(reader.read(timestamp, frame));
+  EXPECT_FALSE(reader.read(timestamp, frame));
+}
@@ -25,8 +25,8 @@
 #include <log/log.h>
 #include <unistd.h>
 #include <algorithm>
-#include <iostream>
 
+#include "hist_simd.h"
 #include "ringbuffer.h"
 
 nsecs_t histogram::DefaultTimeKeeper::current_time() const {
@@ -34,7 +34,15 @@ nsecs_t histogram::DefaultTimeKeeper::current_time() const {
 }
 
 histogram::Ringbuffer::Ringbuffer(size_t ringbuffer_size, std::unique_ptr<histogram::TimeKeeper> tk)
-    : rb_max_size(ringbuffer_size), timekeeper(std::move(tk)), cumulative_frame_count(0) {
+    : start_timestamps(ringbuffer_size, 0),
+      prefix_bins(ringbuffer_size * HIST_V_SIZE, 0),
+      rb_max_size(ringbuffer_size),
+      rb_size(0),
+      rb_head(0),
+      newest_frame{},
+      timekeeper(std::move(tk)),
+      cumulative_frame_count(0) {
+  replaced_bins.fill(0);
   cumulative_bins.fill(0);
 }
 
@@ -46,56 +54,79 @@ std::unique_ptr<histogram::Ringbuffer> histogram::Ringbuffer::create(
       new histogram::Ringbuffer(ringbuffer_size, std::move(tk)));
 }
 
+size_t histogram::Ringbuffer::slot(size_t age) const {
+  return (rb_head + rb_max_size - age) % rb_max_size;
+}
+
 void histogram::Ringbuffer::update_cumulative(nsecs_t now, uint64_t &count,
                                               std::array<uint64_t, HIST_V_SIZE> &bins) const {
-  if (ringbuffer.empty())
+  if (rb_size == 0)
     return;
 
   count++;
-  ALOGI("count : %llu", static_cast<unsigned long long>(count));
+  ALOGV("count : %llu", static_cast<unsigned long long>(count));
 
   const auto delta = std::chrono::duration_cast<std::chrono::milliseconds>(
-      std::chrono::nanoseconds(now - ringbuffer.front().start_timestamp));
+      std::chrono::nanoseconds(now - start_timestamps[rb_head]));
 
   for (auto i = 0u; i < bins.size(); i++) {
-    ALOGI("histogram.data[%d]: %u\n", i, ringbuffer.front().histogram.data[i]);
-    auto const increment = ringbuffer.front().histogram.data[i] * delta.count();
+    auto const increment = newest_frame.data[i] * delta.count();
     // Check increment non-0 to avoid overflow in the next hist event
     if (CC_UNLIKELY(increment && ((bins[i] + increment < bins[i]) ||
-                                  (increment < ringbuffer.front().histogram.data[i])))) {
+                                  (increment < newest_frame.data[i])))) {
       bins[i] = std::numeric_limits<uint64_t>::max();
     } else {
       bins[i] += increment;
     }
-    ALOGI("bins[%d]: %llu\n", i, static_cast<unsigned long long>(bins[i]));
   }
 }
 
 void histogram::Ringbuffer::insert(drm_msm_hist const &frame) {
-  std::cout << "Enter insert ringbuffer" << std::endl;
+  insert(frame, timekeeper->current_time());
+}
 
+void histogram::Ringbuffer::insert(drm_msm_hist const &frame, nsecs_t now) {
   std::unique_lock<decltype(mutex)> lk(mutex);
-  auto now = timekeeper->current_time();
 
-  std::cout << "update cumulative count" << std::endl;
   update_cumulative(now, cumulative_frame_count, cumulative_bins);
 
-  if (ringbuffer.size() == rb_max_size)
-    ringbuffer.pop_back();
-  if (!ringbuffer.empty())
-    ringbuffer.front().end_timestamp = now;
+  if (rb_size != 0) {
+    // Newest frame was displayed until now, fold it into the running prefix.
+    const auto delta = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::nanoseconds(now - start_timestamps[rb_head]));
+    bins_accumulate(replaced_bins.data(), newest_frame.data, static_cast<uint64_t>(delta.count()),
+                    HIST_V_SIZE);
+    rb_head = (rb_head + 1) % rb_max_size;
+  }
+  if (rb_size < rb_max_size)
+    rb_size++;
 
-  std::cout << "Exit insert ringbuffer" << std::endl;
-  ringbuffer.push_front({frame, now, 0});
+  start_timestamps[rb_head] = now;
+  std::copy(replaced_bins.begin(), replaced_bins.end(), &prefix_bins[rb_head * HIST_V_SIZE]);
+  newest_frame = frame;
 }
 
 bool histogram::Ringbuffer::resize(size_t ringbuffer_size) {
   std::unique_lock<decltype(mutex)> lk(mutex);
   if (ringbuffer_size == 0)
     return false;
+
+  // Keep the newest frames, oldest of them in slot 0.
+  auto keep = std::min(rb_size, ringbuffer_size);
+  std::vector<nsecs_t> timestamps(ringbuffer_size, 0);
+  std::vector<uint64_t> prefixes(ringbuffer_size * HIST_V_SIZE, 0);
+  for (auto i = 0u; i < keep; i++) {
+    auto from = slot(keep - 1 - i);
+    timestamps[i] = start_timestamps[from];
+    std::copy(&prefix_bins[from * HIST_V_SIZE], &prefix_bins[from * HIST_V_SIZE] + HIST_V_SIZE,
+              &prefixes[i * HIST_V_SIZE]);
+  }
+
+  start_timestamps.swap(timestamps);
+  prefix_bins.swap(prefixes);
   rb_max_size = ringbuffer_size;
-  if (ringbuffer.size() > rb_max_size)
-    ringbuffer.resize(rb_max_size);
+  rb_size = keep;
+  rb_head = keep ? keep - 1 : 0;
   return true;
 }
 
@@ -108,12 +139,12 @@ histogram::Ringbuffer::Sample histogram::Ringbuffer::collect_cumulative() const
 
 histogram::Ringbuffer::Sample histogram::Ringbuffer::collect_ringbuffer_all() const {
   std::unique_lock<decltype(mutex)> lk(mutex);
-  return collect_max(ringbuffer.size(), lk);
+  return collect_max(rb_size, lk);
 }
 
 histogram::Ringbuffer::Sample histogram::Ringbuffer::collect_after(nsecs_t timestamp) const {
   std::unique_lock<decltype(mutex)> lk(mutex);
-  return collect_max_after(timestamp, ringbuffer.size(), lk);
+  return collect_max_after(timestamp, rb_size, lk);
 }
 
 histogram::Ringbuffer::Sample histogram::Ringbuffer::collect_max(uint32_t max_frames) const {
@@ -129,33 +160,37 @@ histogram::Ringbuffer::Sample histogram::Ringbuffer::collect_max_after(nsecs_t t
 
 histogram::Ringbuffer::Sample histogram::Ringbuffer::collect_max(
     uint32_t max_frames, std::unique_lock<std::mutex> const &) const {
-  auto collect_first = std::min(static_cast<size_t>(max_frames), ringbuffer.size());
+  auto collect_first = std::min(static_cast<size_t>(max_frames), rb_size);
   if (collect_first == 0)
     return {0, {}};
+
+  // Frames replaced within the window, followed by the newest frame which is still displayed.
+  // Unsigned arithmetic keeps the difference exact even if the running prefix wrapped.
+  const uint64_t *window_begin = &prefix_bins[slot(collect_first - 1) * HIST_V_SIZE];
+  const auto time_displayed = std::chrono::nanoseconds(timekeeper->current_time() -
+                                                       start_timestamps[rb_head]);
+  const auto delta = std::chrono::duration_cast<std::chrono::milliseconds>(time_displayed);
   std::array<uint64_t, HIST_V_SIZE> bins;
-  bins.fill(0);
-  for (auto it = ringbuffer.begin(); it != ringbuffer.end() &&
-    it != ringbuffer.begin() + collect_first; it++) {
-    nsecs_t end_timestamp = it->end_timestamp;
-    if (it == ringbuffer.begin()) {
-      end_timestamp = timekeeper->current_time();
-    }
-    const auto time_displayed = std::chrono::nanoseconds(end_timestamp - it->start_timestamp);
-    const auto delta = std::chrono::duration_cast<std::chrono::milliseconds>(time_displayed);
-    for (auto i = 0u; i < HIST_V_SIZE; i++) {
-      bins[i] += it->histogram.data[i] * delta.count();
-    }
-  }
+  bins_window(bins.data(), replaced_bins.data(), window_begin, newest_frame.data,
+              static_cast<uint64_t>(delta.count()), HIST_V_SIZE);
   return {collect_first, bins};
 }
 
 histogram::Ringbuffer::Sample histogram::Ringbuffer::collect_max_after(
     nsecs_t timestamp, uint32_t max_frames, std::unique_lock<std::mutex> const &lk) const {
-  auto ts_filter_begin = std::lower_bound(
-      ringbuffer.begin(), ringbuffer.end(), HistogramEntry{{}, timestamp, 0},
-      [](auto const &a, auto const &b) { return a.start_timestamp >= b.start_timestamp; });
+  // Start timestamps decrease with age, find the number of frames which started at or after
+  // timestamp.
+  size_t low = 0;
+  size_t high = rb_size;
+  while (low < high) {
+    auto mid = low + (high - low) / 2;
+    if (start_timestamps[slot(mid)] >= timestamp) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
 
-  auto collect_last = std::min(std::distance(ringbuffer.begin(), ts_filter_begin),
-                               static_cast<std::ptrdiff_t>(max_frames));
+  auto collect_last = std::min(low, static_cast<size_t>(max_frames));
   return collect_max(collect_last, lk);
 }
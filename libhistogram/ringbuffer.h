@@ -23,10 +23,10 @@
 #include <xf86drm.h>
 #include <xf86drmMode.h>
 #include <array>
-#include <deque>
 #include <memory>
 #include <mutex>
 #include <tuple>
+#include <vector>
 
 namespace histogram {
 
@@ -48,6 +48,9 @@ class Ringbuffer {
  public:
   static std::unique_ptr<Ringbuffer> create(size_t ringbuffer_size, std::unique_ptr<TimeKeeper> tk);
   void insert(drm_msm_hist const &frame);
+  // Inserts a frame which started to be displayed at timestamp. Timestamps must not decrease
+  // between insertions, and must not be ahead of the timekeeper.
+  void insert(drm_msm_hist const &frame, nsecs_t timestamp);
   bool resize(size_t ringbuffer_size);
 
   using Sample = std::tuple<uint64_t /* numFrames */, std::array<uint64_t, HIST_V_SIZE> /* bins */>;
@@ -68,15 +71,20 @@ class Ringbuffer {
                            std::unique_lock<std::mutex> const &) const;
   void update_cumulative(nsecs_t now, uint64_t &count,
                          std::array<uint64_t, HIST_V_SIZE> &bins) const;
+  // Slot of the frame inserted age frames before the newest one.
+  size_t slot(size_t age) const;
 
   std::mutex mutable mutex;
-  struct HistogramEntry {
-    drm_msm_hist histogram;
-    nsecs_t start_timestamp;
-    nsecs_t end_timestamp;
-  };
-  std::deque<HistogramEntry> ringbuffer;
+  // Fixed capacity ring, stored as structure of arrays. Every slot keeps the time weighted bins
+  // of all frames which were replaced before it was inserted, so the weight of any window of
+  // frames is the difference of two prefixes plus the still displayed newest frame.
+  std::vector<nsecs_t> start_timestamps;
+  std::vector<uint64_t> prefix_bins;  // rb_max_size rows of HIST_V_SIZE
   size_t rb_max_size;
+  size_t rb_size;
+  size_t rb_head;  // slot of the newest frame
+  drm_msm_hist newest_frame;
+  std::array<uint64_t, HIST_V_SIZE> replaced_bins;
   std::unique_ptr<TimeKeeper> const timekeeper;
 
   uint64_t cumulative_frame_count;
@@ -15,7 +15,9 @@
  */
 
 #include <chrono>
+#include <deque>
 #include <numeric>
+#include <random>
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
@@ -377,6 +379,24 @@ TEST_F(RingbufferTestCases, TestCumulativeCountsSaturate) {
   EXPECT_THAT(bins, Each(std::numeric_limits<uint64_t>::max()));
 }
 
+TEST_F(RingbufferTestCases, InsertWithTimestampTest) {
+  auto tk = std::make_shared<TickingTimeKeeper>();
+  auto rb = histogram::Ringbuffer::create(4, std::make_unique<TimeKeeperWrapper>(tk));
+
+  // Frames queued earlier are weighted by their own timestamps, not by the time of insertion.
+  tk->increment_by(10ms);
+  rb->insert(frame0, toNsecs(2ms));
+  rb->insert(frame1, toNsecs(5ms));
+
+  std::tie(numFrames, bins) = rb->collect_ringbuffer_all();
+  EXPECT_THAT(numFrames, Eq(2));
+  EXPECT_THAT(bins, Each(fill_frame0 * 3 + fill_frame1 * 5));
+
+  std::tie(numFrames, bins) = rb->collect_after(toNsecs(3ms));
+  EXPECT_THAT(numFrames, Eq(1));
+  EXPECT_THAT(bins, Each(fill_frame1 * 5));
+}
+
 TEST_F(RingbufferTestCases, TimeWeightingTest) {
   static constexpr int numInsertions = 4u;
   auto tk = std::make_shared<TickingTimeKeeper>();
@@ -407,6 +427,143 @@ TEST_F(RingbufferTestCases, TimeWeightingTest) {
   }
 }
 
+// Straightforward per-frame accumulation, used as reference for the prefix based ringbuffer.
+class ReferenceRingbuffer {
+ public:
+  explicit ReferenceRingbuffer(size_t size) : max_size(size) {}
+
+  void insert(drm_msm_hist const &frame, nsecs_t now) {
+    if (entries.size() == max_size)
+      entries.pop_back();
+    if (!entries.empty())
+      entries.front().end = now;
+    entries.push_front({frame, now, 0});
+  }
+
+  void resize(size_t size) {
+    max_size = size;
+    if (entries.size() > max_size)
+      entries.resize(max_size);
+  }
+
+  histogram::Ringbuffer::Sample collect_max(size_t max_frames, nsecs_t now) const {
+    auto count = std::min(max_frames, entries.size());
+    std::array<uint64_t, HIST_V_SIZE> bins;
+    bins.fill(0);
+    for (auto i = 0u; i < count; i++) {
+      auto end = (i == 0) ? now : entries[i].end;
+      uint64_t weight = toMs(std::chrono::nanoseconds(end - entries[i].start));
+      for (auto j = 0u; j < HIST_V_SIZE; j++) {
+        bins[j] += entries[i].frame.data[j] * weight;
+      }
+    }
+    if (count == 0)
+      return {0, {}};
+    return {count, bins};
+  }
+
+  histogram::Ringbuffer::Sample collect_max_after(nsecs_t timestamp, size_t max_frames,
+                                                  nsecs_t now) const {
+    size_t count = 0;
+    while (count < entries.size() && entries[count].start >= timestamp)
+      count++;
+    return collect_max(std::min(count, max_frames), now);
+  }
+
+  size_t size() const { return entries.size(); }
+
+ private:
+  struct Entry {
+    drm_msm_hist frame;
+    nsecs_t start;
+    nsecs_t end;
+  };
+  size_t max_size;
+  std::deque<Entry> entries;
+};
+
+class RingbufferEquivalenceTest : public ::testing::TestWithParam<size_t> {
+ protected:
+  void insertRandomFrame() {
+    drm_msm_hist frame = {};
+    for (auto i = 0u; i < HIST_V_SIZE; i++) {
+      frame.data[i] = bin_dist(rng);
+    }
+    rb->insert(frame);
+    ref->insert(frame, tk->current_time());
+    timestamps.push_back(tk->current_time());
+    tk->increment_by(std::chrono::microseconds(time_dist(rng)));
+  }
+
+  void expectSameSamples() {
+    auto now = tk->current_time();
+    EXPECT_THAT(rb->collect_ringbuffer_all(), Eq(ref->collect_max(ref->size(), now)));
+    for (uint32_t max_frames = 0; max_frames <= ref->size() + 1; max_frames++) {
+      EXPECT_THAT(rb->collect_max(max_frames), Eq(ref->collect_max(max_frames, now)));
+    }
+    // Probe exact insertion times as well as times in between and outside of the ring.
+    std::vector<nsecs_t> probes = {0, now, now + 1};
+    for (auto ts : timestamps) {
+      probes.push_back(ts);
+      probes.push_back(ts + 1);
+    }
+    for (auto ts : probes) {
+      EXPECT_THAT(rb->collect_after(ts), Eq(ref->collect_max_after(ts, ref->size(), now)));
+      EXPECT_THAT(rb->collect_max_after(ts, 2), Eq(ref->collect_max_after(ts, 2, now)));
+    }
+  }
+
+  void SetUp() {
+    tk = std::make_shared<TickingTimeKeeper>();
+    rb = histogram::Ringbuffer::create(GetParam(), std::make_unique<TimeKeeperWrapper>(tk));
+    ref = std::make_unique<ReferenceRingbuffer>(GetParam());
+  }
+
+  std::mt19937 rng{GetParam()};
+  std::uniform_int_distribution<uint32_t> bin_dist{0, 1u << 20};
+  std::uniform_int_distribution<uint32_t> time_dist{0, 50000};
+  std::shared_ptr<TickingTimeKeeper> tk;
+  std::unique_ptr<histogram::Ringbuffer> rb;
+  std::unique_ptr<ReferenceRingbuffer> ref;
+  std::deque<nsecs_t> timestamps;
+};
+
+TEST_P(RingbufferEquivalenceTest, MatchesReferenceOnInsert) {
+  expectSameSamples();
+  for (auto i = 0u; i < 3 * GetParam() + 2; i++) {
+    insertRandomFrame();
+    expectSameSamples();
+  }
+}
+
+TEST_P(RingbufferEquivalenceTest, MatchesReferenceOnResize) {
+  std::uniform_int_distribution<size_t> size_dist{1, 2 * GetParam()};
+  for (auto i = 0u; i < 4 * GetParam(); i++) {
+    insertRandomFrame();
+    if (i % 3 == 0) {
+      auto size = size_dist(rng);
+      ASSERT_TRUE(rb->resize(size));
+      ref->resize(size);
+    }
+    expectSameSamples();
+  }
+}
+
+TEST_P(RingbufferEquivalenceTest, MatchesReferenceWithZeroDurationFrames) {
+  for (auto i = 0u; i < 2 * GetParam(); i++) {
+    insertRandomFrame();
+    // Several frames inserted at the same timestamp must all be collected.
+    drm_msm_hist frame = {};
+    frame.data[0] = i;
+    rb->insert(frame);
+    ref->insert(frame, tk->current_time());
+    timestamps.push_back(tk->current_time());
+    expectSameSamples();
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(Sizes, RingbufferEquivalenceTest, Values(1, 2, 3, 7, 16));
+
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
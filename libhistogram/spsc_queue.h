@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef HISTOGRAM_SPSC_QUEUE_H_
+#define HISTOGRAM_SPSC_QUEUE_H_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace histogram {
+
+// Bounded lock-free queue for exactly one producer thread and one consumer thread.
+// Head and tail only ever increase, the slot is their value modulo the capacity.
+template <typename T, size_t Capacity>
+class SpscQueue {
+  static_assert(Capacity && ((Capacity & (Capacity - 1)) == 0),
+                "queue capacity must be a power of two");
+
+ public:
+  // Producer side. Returns false, leaving the queue untouched, when it is full.
+  bool push(T const &item) {
+    T *slot = back();
+    if (!slot)
+      return false;
+    *slot = item;
+    commit_back();
+    return true;
+  }
+
+  // Producer side, in place. Returns the slot of the next item, nullptr when the queue is full.
+  // What is written to it only becomes visible to the consumer with commit_back().
+  T *back() {
+    auto tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_.load(std::memory_order_acquire) == Capacity)
+      return nullptr;
+    return &slots_[tail & (Capacity - 1)];
+  }
+
+  void commit_back() {
+    // seq_cst, so that a consumer announcing that it goes to sleep is observed afterwards.
+    tail_.store(tail_.load(std::memory_order_relaxed) + 1, std::memory_order_seq_cst);
+  }
+
+  // Consumer side. Returns false when the queue is empty.
+  bool pop(T &item) {
+    T *slot = front();
+    if (!slot)
+      return false;
+    item = *slot;
+    pop_front();
+    return true;
+  }
+
+  // Consumer side, in place. Returns the oldest item, nullptr when the queue is empty. It stays
+  // valid until pop_front() hands the slot back to the producer.
+  T *front() {
+    auto head = head_.load(std::memory_order_relaxed);
+    if (head == tail_.load(std::memory_order_acquire))
+      return nullptr;
+    return &slots_[head & (Capacity - 1)];
+  }
+
+  void pop_front() {
+    head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+
+  // May be stale by the time it returns when called from the producer.
+  size_t size() const {
+    return tail_.load(std::memory_order_seq_cst) - head_.load(std::memory_order_acquire);
+  }
+  bool empty() const { return size() == 0; }
+  static constexpr size_t capacity() { return Capacity; }
+
+ private:
+  std::array<T, Capacity> slots_;
+  // Separate cache lines, so that producer and consumer do not invalidate each other.
+  alignas(64) std::atomic<size_t> head_{0};
+  alignas(64) std::atomic<size_t> tail_{0};
+};
+
+}  // namespace histogram
+
+#endif  // HISTOGRAM_SPSC_QUEUE_H_
@@ -0,0 +1,242 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <utility>
+
+#include "qdcm_blob.h"
+
+namespace qdcm {
+
+uint64_t BlobChecksum(const uint8_t *data, size_t size) {
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for (size_t i = 0; i < size; i++) {
+    hash ^= data[i];
+    hash *= 0x100000001b3ULL;
+  }
+
+  return hash;
+}
+
+int QDCMBlob::Open(const char *path, bool verify) {
+  Close();
+
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return -errno;
+  }
+
+  struct stat st = {};
+  if (fstat(fd, &st)) {
+    int error = -errno;
+    close(fd);
+    return error;
+  }
+
+  if (st.st_size < static_cast<off_t>(sizeof(BlobHeader))) {
+    close(fd);
+    return -EINVAL;
+  }
+
+  void *addr = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+  int error = (addr == MAP_FAILED) ? -errno : 0;
+  close(fd);
+  if (error) {
+    return error;
+  }
+
+  data_ = static_cast<const uint8_t *>(addr);
+  size_ = static_cast<size_t>(st.st_size);
+  mapped_ = true;
+  error = Validate(verify);
+  if (error) {
+    Close();
+  }
+
+  return error;
+}
+
+int QDCMBlob::Attach(const void *data, size_t size, bool verify) {
+  Close();
+  if (!data || (reinterpret_cast<uintptr_t>(data) % kBlobAlignment)) {
+    return -EINVAL;
+  }
+
+  data_ = static_cast<const uint8_t *>(data);
+  size_ = size;
+  int error = Validate(verify);
+  if (error) {
+    Close();
+  }
+
+  return error;
+}
+
+void QDCMBlob::Close() {
+  if (mapped_) {
+    munmap(const_cast<uint8_t *>(data_), size_);
+  }
+
+  data_ = nullptr;
+  size_ = 0;
+  mapped_ = false;
+  header_ = nullptr;
+  modes_ = nullptr;
+  features_ = nullptr;
+  strings_ = nullptr;
+}
+
+int QDCMBlob::Validate(bool verify) {
+  if (size_ < sizeof(BlobHeader)) {
+    return -EINVAL;
+  }
+
+  const BlobHeader *header = reinterpret_cast<const BlobHeader *>(data_);
+  if (header->magic != kBlobMagic || header->version != kBlobVersion ||
+      header->size != size_) {
+    return -EINVAL;
+  }
+
+  // 64 bit math, none of the 32 bit fields can overflow it.
+  uint64_t modes_end = uint64_t(header->modes_offset) + uint64_t(header->mode_count) *
+                       sizeof(ModeEntry);
+  uint64_t features_end = uint64_t(header->features_offset) +
+                          uint64_t(header->feature_count) * sizeof(FeatureEntry);
+  uint64_t strings_end = uint64_t(header->strings_offset) + header->strings_size;
+  if ((header->modes_offset % alignof(ModeEntry)) || modes_end > size_ ||
+      (header->features_offset % alignof(FeatureEntry)) || features_end > size_ ||
+      !header->strings_size || strings_end > size_) {
+    return -EINVAL;
+  }
+
+  const char *strings = reinterpret_cast<const char *>(data_ + header->strings_offset);
+  if (strings[header->strings_size - 1] != '\0' || header->panel_name >= header->strings_size) {
+    return -EINVAL;
+  }
+
+  const ModeEntry *modes = reinterpret_cast<const ModeEntry *>(data_ + header->modes_offset);
+  for (uint32_t i = 0; i < header->mode_count; i++) {
+    const ModeEntry &mode = modes[i];
+    if (mode.name >= header->strings_size || mode.color_primaries >= header->strings_size ||
+        mode.gamma_transfer >= header->strings_size ||
+        mode.render_intent_name >= header->strings_size || mode.merge_id >= header->strings_size ||
+        uint64_t(mode.first_feature) + mode.feature_count > header->feature_count) {
+      return -EINVAL;
+    }
+  }
+
+  const FeatureEntry *features =
+      reinterpret_cast<const FeatureEntry *>(data_ + header->features_offset);
+  for (uint32_t i = 0; i < header->feature_count; i++) {
+    const FeatureEntry &feature = features[i];
+    if (feature.name >= header->strings_size || feature.offset > size_ ||
+        feature.size > size_ - feature.offset) {
+      return -EINVAL;
+    }
+  }
+
+  if (verify && BlobChecksum(data_ + sizeof(BlobHeader), size_ - sizeof(BlobHeader)) !=
+      header->checksum) {
+    return -EBADMSG;
+  }
+
+  header_ = header;
+  modes_ = modes;
+  features_ = features;
+  strings_ = strings;
+
+  return 0;
+}
+
+const char *QDCMBlob::GetString(uint32_t offset) const {
+  if (!header_ || offset >= header_->strings_size) {
+    return nullptr;
+  }
+
+  return strings_ + offset;
+}
+
+const char *QDCMBlob::GetPanelName() const {
+  return header_ ? GetString(header_->panel_name) : nullptr;
+}
+
+const ModeEntry *QDCMBlob::GetMode(uint32_t index) const {
+  return (index < GetModeCount()) ? &modes_[index] : nullptr;
+}
+
+const ModeEntry *QDCMBlob::FindMode(const char *name) const {
+  if (!name) {
+    return nullptr;
+  }
+
+  for (uint32_t i = 0; i < GetModeCount(); i++) {
+    if (!strcmp(GetString(modes_[i].name), name)) {
+      return &modes_[i];
+    }
+  }
+
+  return nullptr;
+}
+
+const ModeEntry *QDCMBlob::FindMode(int32_t render_intent, DynamicRange dynamic_range,
+                                    const char *color_primaries,
+                                    const char *gamma_transfer) const {
+  auto less = [](const ModeEntry &mode, const std::pair<int32_t, uint32_t> &key) {
+    return (mode.render_intent != key.first) ? (mode.render_intent < key.first) :
+                                               (mode.dynamic_range < key.second);
+  };
+
+  const ModeEntry *end = modes_ + GetModeCount();
+  auto key = std::make_pair(render_intent, uint32_t(dynamic_range));
+  for (const ModeEntry *mode = std::lower_bound(modes_, end, key, less);
+       mode != end && mode->render_intent == render_intent &&
+       mode->dynamic_range == dynamic_range; mode++) {
+    if ((!color_primaries || !strcmp(GetString(mode->color_primaries), color_primaries)) &&
+        (!gamma_transfer || !strcmp(GetString(mode->gamma_transfer), gamma_transfer))) {
+      return mode;
+    }
+  }
+
+  return nullptr;
+}
+
+int QDCMBlob::GetFeature(const ModeEntry &mode, uint32_t index, Feature *feature) const {
+  if (!header_ || !feature || index >= mode.feature_count) {
+    return -EINVAL;
+  }
+
+  const FeatureEntry &entry = features_[mode.first_feature + index];
+  feature->name = GetString(entry.name);
+  feature->data = data_ + entry.offset;
+  feature->size = entry.size;
+
+  return 0;
+}
+
+int QDCMBlob::GetFeature(const ModeEntry &mode, const char *name, Feature *feature) const {
+  if (!header_ || !name || !feature) {
+    return -EINVAL;
+  }
+
+  const FeatureEntry *begin = features_ + mode.first_feature;
+  const FeatureEntry *end = begin + mode.feature_count;
+  const FeatureEntry *entry = std::lower_bound(begin, end, name,
+      [this](const FeatureEntry &entry, const char *name) {
+        return strcmp(GetString(entry.name), name) < 0;
+      });
+  if (entry == end || strcmp(GetString(entry->name), name)) {
+    return -ENOENT;
+  }
+
+  return GetFeature(mode, uint32_t(entry - begin), feature);
+}
+
+}  // namespace qdcm
@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __QDCM_BLOB_H__
+#define __QDCM_BLOB_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Precompiled QDCM calibration data. qdcm_blob_compiler turns a qdcm_calib_data_*.json file into
+// one blob holding every color mode of the panel with its hex encoded feature payloads already
+// decoded, so the blob can be mapped and looked up without parsing or copying anything.
+//
+// Layout, host byte order, all offsets from the start of the blob:
+//   BlobHeader
+//   ModeEntry[mode_count]       sorted by (render_intent, dynamic_range, name)
+//   FeatureEntry[feature_count] grouped by mode, sorted by name within a mode
+//   string table                NUL terminated strings, referenced by offset into the table
+//   payloads                    kBlobAlignment aligned
+namespace qdcm {
+
+const uint32_t kBlobMagic = 0x42434451;  // 'QDCB'
+const uint32_t kBlobVersion = 1;
+const uint32_t kBlobAlignment = 8;
+
+enum DynamicRange : uint32_t {
+  kDynamicRangeSdr,
+  kDynamicRangeHdr,
+};
+
+struct BlobHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t size;      // Whole blob
+  uint64_t checksum;  // FNV-1a over everything after the header
+  uint32_t panel_name;
+  uint32_t mode_count;
+  uint32_t modes_offset;
+  uint32_t feature_count;
+  uint32_t features_offset;
+  uint32_t strings_offset;
+  uint32_t strings_size;
+  uint32_t calib_version;  // "Version" of the text, 1 when it has none
+};
+
+struct ModeEntry {
+  uint32_t name;
+  uint32_t color_primaries;
+  uint32_t gamma_transfer;
+  uint32_t render_intent_name;
+  int32_t render_intent;
+  uint32_t dynamic_range;  // DynamicRange
+  uint32_t white_point;
+  uint32_t first_feature;
+  uint32_t feature_count;
+  uint32_t merge_id;  // String, empty before calibration data version 2
+};
+
+struct FeatureEntry {
+  uint32_t name;
+  uint32_t reserved;
+  uint64_t offset;
+  uint64_t size;
+};
+
+uint64_t BlobChecksum(const uint8_t *data, size_t size);
+
+// Read only view of a blob. Open() validates the header and tables once, after that lookups are
+// binary searches over the mapped tables and payloads point straight into the mapping.
+class QDCMBlob {
+ public:
+  struct Feature {
+    const char *name = nullptr;
+    const uint8_t *data = nullptr;
+    size_t size = 0;
+  };
+
+  QDCMBlob() = default;
+  ~QDCMBlob() { Close(); }
+
+  // Returns 0 or a negative errno. The payload checksum is only checked with verify set, it
+  // touches every page of the blob.
+  int Open(const char *path, bool verify = false);
+  // Same for a blob already in memory, which must outlive this object.
+  int Attach(const void *data, size_t size, bool verify = false);
+  void Close();
+
+  const char *GetPanelName() const;
+  uint32_t GetCalibVersion() const { return header_ ? header_->calib_version : 0; }
+  uint32_t GetModeCount() const { return header_ ? header_->mode_count : 0; }
+  const ModeEntry *GetMode(uint32_t index) const;
+  const ModeEntry *FindMode(const char *name) const;
+  // First mode with this render intent and dynamic range. color_primaries and gamma_transfer
+  // narrow the match down further when not null.
+  const ModeEntry *FindMode(int32_t render_intent, DynamicRange dynamic_range,
+                            const char *color_primaries = nullptr,
+                            const char *gamma_transfer = nullptr) const;
+  const char *GetString(uint32_t offset) const;
+
+  int GetFeature(const ModeEntry &mode, const char *name, Feature *feature) const;
+  int GetFeature(const ModeEntry &mode, uint32_t index, Feature *feature) const;
+
+ private:
+  QDCMBlob(const QDCMBlob &) = delete;
+  QDCMBlob &operator=(const QDCMBlob &) = delete;
+
+  int Validate(bool verify);
+
+  const uint8_t *data_ = nullptr;
+  size_t size_ = 0;
+  bool mapped_ = false;
+  const BlobHeader *header_ = nullptr;
+  const ModeEntry *modes_ = nullptr;
+  const FeatureEntry *features_ = nullptr;
+  const char *strings_ = nullptr;
+};
+
+}  // namespace qdcm
+
+#endif  // __QDCM_BLOB_H__
@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "qdcm_blob.h"
+#include "qdcm_calib_data.h"
+
+// Compiles a qdcm_calib_data_*.json file into the blob format of qdcm_blob.h, reads the blob back
+// and checks it against the json before reporting success. With --dump, lists a blob's modes.
+
+using qdcm::CalibData;
+using qdcm::QDCMBlob;
+
+static void Usage(const char *name) {
+  fprintf(stderr, "Usage: %s <qdcm_calib_data.json> <output.blob>\n", name);
+  fprintf(stderr, "       %s --dump <input.blob>\n", name);
+}
+
+static int Dump(const char *path) {
+  QDCMBlob blob;
+  int ret = blob.Open(path, true /* verify */);
+  if (ret) {
+    fprintf(stderr, "Failed to open %s: %s\n", path, strerror(-ret));
+    return 1;
+  }
+
+  printf("panel %s, version %u, %u modes\n", blob.GetPanelName(), blob.GetCalibVersion(),
+         blob.GetModeCount());
+  for (uint32_t i = 0; i < blob.GetModeCount(); i++) {
+    const qdcm::ModeEntry *mode = blob.GetMode(i);
+    printf("  %s: intent %d (%s) %s %s/%s white point %u\n", blob.GetString(mode->name),
+           mode->render_intent, blob.GetString(mode->render_intent_name),
+           mode->dynamic_range == qdcm::kDynamicRangeHdr ? "HDR" : "SDR",
+           blob.GetString(mode->color_primaries), blob.GetString(mode->gamma_transfer),
+           mode->white_point);
+    for (uint32_t j = 0; j < mode->feature_count; j++) {
+      QDCMBlob::Feature feature;
+      blob.GetFeature(*mode, j, &feature);
+      printf("    %s: %zu bytes\n", feature.name, feature.size);
+    }
+  }
+
+  return 0;
+}
+
+static int Compile(const char *input, const char *output) {
+  std::ifstream in(input, std::ios::binary);
+  if (!in.is_open()) {
+    fprintf(stderr, "Failed to open %s\n", input);
+    return 1;
+  }
+  std::stringstream text;
+  text << in.rdbuf();
+
+  CalibData calib;
+  std::string error;
+  if (qdcm::ParseCalibJson(text.str(), &calib, &error)) {
+    fprintf(stderr, "%s: %s\n", input, error.c_str());
+    return 1;
+  }
+
+  std::vector<uint8_t> data;
+  qdcm::BuildBlob(calib, &data);
+
+  QDCMBlob blob;
+  int ret = blob.Attach(data.data(), data.size(), true /* verify */);
+  if (ret || qdcm::CompareBlob(calib, blob, &error)) {
+    fprintf(stderr, "%s: blob does not match the json: %s\n", input,
+            ret ? strerror(-ret) : error.c_str());
+    return 1;
+  }
+
+  std::ofstream out(output, std::ios::binary | std::ios::trunc);
+  out.write(reinterpret_cast<const char *>(data.data()), std::streamsize(data.size()));
+  out.close();
+  if (!out) {
+    fprintf(stderr, "Failed to write %s\n", output);
+    return 1;
+  }
+
+  printf("%s: %zu modes, %zu bytes of text, %zu byte blob\n", calib.panel_name.c_str(),
+         calib.modes.size(), text.str().size(), data.size());
+
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  if (argc != 3) {
+    Usage(argv[0]);
+    return 1;
+  }
+
+  if (!strcmp(argv[1], "--dump")) {
+    return Dump(argv[2]);
+  }
+
+  return Compile(argv[1], argv[2]);
+}
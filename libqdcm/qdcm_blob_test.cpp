@@ -0,0 +1,229 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "qdcm_blob.h"
+#include "qdcm_calib_data.h"
+
+namespace qdcm {
+namespace {
+
+// Same shape as the files under config/, with short payloads.
+const char *kCalibJson = R"({
+  "Copyright": "<!-- test -->",
+  "Version": 2,
+  "Test_panel": {
+    "sRGB": {
+      "Applicability": {
+        "ColorPrimaries": "sRGB", "GammaTransfer": "sRGB",
+        "RenderIntent": 1, "RenderIntentName": "Standard"
+      },
+      "DynamicRange": "SDR",
+      "PostBlendPCC": "0A0b0C",
+      "PostBlendGC": "00112233445566778899AABBCCDDEEFF",
+      "WhitePoint": 6500
+    },
+    "Native": {
+      "Applicability": {
+        "ColorPrimaries": "sRGB", "GammaTransfer": "sRGB",
+        "RenderIntent": 0, "RenderIntentName": "Native"
+      },
+      "DynamicRange": "SDR",
+      "PostBlendGC": "",
+      "WhitePoint": 6500
+    },
+    "P3": {
+      "Applicability": {
+        "ColorPrimaries": "P3", "GammaTransfer": "sRGB",
+        "RenderIntent": 1, "RenderIntentName": "Standard"
+      },
+      "DynamicRange": "SDR",
+      "PostBlendGamut": "DEADBEEF",
+      "WhitePoint": 6500
+    },
+    "HDR": {
+      "Applicability": {
+        "ColorPrimaries": "P3", "GammaTransfer": "sRGB",
+        "RenderIntent": 1, "RenderIntentName": "Standard"
+      },
+      "DynamicRange": "HDR",
+      "MergeId": "D65",
+      "PostBlendHdrBlob": "7B7D",
+      "PostBlendGamut": "CAFE",
+      "WhitePoint": 6500
+    }
+  }
+})";
+
+class QDCMBlobTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    std::string error;
+    ASSERT_EQ(ParseCalibJson(kCalibJson, &calib_, &error), 0) << error;
+    ASSERT_EQ(BuildBlob(calib_, &data_), 0);
+  }
+
+  CalibData calib_;
+  std::vector<uint8_t> data_;
+};
+
+}  // namespace
+
+TEST_F(QDCMBlobTest, TextPath) {
+  EXPECT_EQ(calib_.panel_name, "Test_panel");
+  EXPECT_EQ(calib_.version, 2u);
+  ASSERT_EQ(calib_.modes.size(), 4u);
+  auto srgb = std::find_if(calib_.modes.begin(), calib_.modes.end(),
+                           [](const CalibMode &mode) { return mode.name == "sRGB"; });
+  ASSERT_NE(srgb, calib_.modes.end());
+  EXPECT_EQ(srgb->render_intent, 1);
+  EXPECT_EQ(srgb->white_point, 6500u);
+  EXPECT_EQ(srgb->features.size(), 2u);
+}
+
+TEST_F(QDCMBlobTest, RoundTripMatchesTextPath) {
+  QDCMBlob blob;
+  ASSERT_EQ(blob.Attach(data_.data(), data_.size(), true /* verify */), 0);
+  std::string error;
+  EXPECT_EQ(CompareBlob(calib_, blob, &error), 0) << error;
+
+  const ModeEntry *mode = blob.FindMode("sRGB");
+  ASSERT_NE(mode, nullptr);
+  QDCMBlob::Feature feature;
+  ASSERT_EQ(blob.GetFeature(*mode, "PostBlendPCC", &feature), 0);
+  ASSERT_EQ(feature.size, 3u);
+  EXPECT_EQ(feature.data[0], 0x0a);
+  EXPECT_EQ(feature.data[1], 0x0b);
+  EXPECT_EQ(feature.data[2], 0x0c);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(feature.data) % kBlobAlignment, 0u);
+  EXPECT_GE(feature.data, data_.data());
+  EXPECT_LE(feature.data + feature.size, data_.data() + data_.size());
+  EXPECT_EQ(blob.GetFeature(*mode, "PostBlendGamut", &feature), -ENOENT);
+
+  mode = blob.FindMode("Native");
+  ASSERT_NE(mode, nullptr);
+  ASSERT_EQ(blob.GetFeature(*mode, "PostBlendGC", &feature), 0);
+  EXPECT_EQ(feature.size, 0u);
+  EXPECT_EQ(blob.FindMode("Vivid"), nullptr);
+}
+
+TEST_F(QDCMBlobTest, LookupByRenderIntent) {
+  QDCMBlob blob;
+  ASSERT_EQ(blob.Attach(data_.data(), data_.size()), 0);
+
+  const ModeEntry *mode = blob.FindMode(0, kDynamicRangeSdr);
+  ASSERT_NE(mode, nullptr);
+  EXPECT_STREQ(blob.GetString(mode->name), "Native");
+
+  mode = blob.FindMode(1, kDynamicRangeSdr, "P3");
+  ASSERT_NE(mode, nullptr);
+  EXPECT_STREQ(blob.GetString(mode->name), "P3");
+  mode = blob.FindMode(1, kDynamicRangeSdr, "sRGB", "sRGB");
+  ASSERT_NE(mode, nullptr);
+  EXPECT_STREQ(blob.GetString(mode->name), "sRGB");
+
+  mode = blob.FindMode(1, kDynamicRangeHdr);
+  ASSERT_NE(mode, nullptr);
+  EXPECT_STREQ(blob.GetString(mode->name), "HDR");
+  EXPECT_STREQ(blob.GetString(mode->merge_id), "D65");
+
+  EXPECT_EQ(blob.FindMode(1, kDynamicRangeSdr, "BT2020"), nullptr);
+  EXPECT_EQ(blob.FindMode(0, kDynamicRangeHdr), nullptr);
+  EXPECT_EQ(blob.FindMode(2, kDynamicRangeSdr), nullptr);
+}
+
+TEST_F(QDCMBlobTest, Deterministic) {
+  CalibData reversed = calib_;
+  std::reverse(reversed.modes.begin(), reversed.modes.end());
+  for (auto &mode : reversed.modes) {
+    std::reverse(mode.features.begin(), mode.features.end());
+  }
+
+  std::vector<uint8_t> data;
+  ASSERT_EQ(BuildBlob(reversed, &data), 0);
+  EXPECT_EQ(data, data_);
+}
+
+TEST_F(QDCMBlobTest, OpenMapsFile) {
+  char path[] = "/tmp/qdcm_blob_test_XXXXXX";
+  int fd = mkstemp(path);
+  ASSERT_GE(fd, 0);
+  ASSERT_EQ(write(fd, data_.data(), data_.size()), ssize_t(data_.size()));
+  close(fd);
+
+  QDCMBlob blob;
+  EXPECT_EQ(blob.Open(path, true /* verify */), 0);
+  std::string error;
+  EXPECT_EQ(CompareBlob(calib_, blob, &error), 0) << error;
+  blob.Close();
+  EXPECT_EQ(blob.GetModeCount(), 0u);
+
+  ASSERT_EQ(truncate(path, off_t(data_.size() - 1)), 0);
+  EXPECT_EQ(blob.Open(path), -EINVAL);
+  unlink(path);
+  EXPECT_EQ(blob.Open(path), -ENOENT);
+}
+
+TEST_F(QDCMBlobTest, RejectsCorruptBlob) {
+  QDCMBlob blob;
+
+  // Payload damage is only caught with verify, table damage always.
+  std::vector<uint8_t> data = data_;
+  data[data.size() - 9] ^= 0xff;
+  EXPECT_EQ(blob.Attach(data.data(), data.size(), true /* verify */), -EBADMSG);
+
+  data = data_;
+  BlobHeader *header = reinterpret_cast<BlobHeader *>(data.data());
+  FeatureEntry *features = reinterpret_cast<FeatureEntry *>(data.data() + header->features_offset);
+  features[0].size = data.size();
+  EXPECT_EQ(blob.Attach(data.data(), data.size()), -EINVAL);
+
+  data = data_;
+  header = reinterpret_cast<BlobHeader *>(data.data());
+  header->version++;
+  EXPECT_EQ(blob.Attach(data.data(), data.size()), -EINVAL);
+
+  data = data_;
+  header = reinterpret_cast<BlobHeader *>(data.data());
+  header->mode_count = 0x10000000;
+  EXPECT_EQ(blob.Attach(data.data(), data.size()), -EINVAL);
+
+  EXPECT_EQ(blob.Attach(data_.data(), sizeof(BlobHeader) - 1), -EINVAL);
+  EXPECT_EQ(blob.GetPanelName(), nullptr);
+}
+
+TEST(QDCMCalibDataTest, RejectsMalformedText) {
+  const char *bad[] = {
+    R"({"Panel": {"sRGB": {"DynamicRange": "SDR"}}})",
+    R"({"Panel": {"sRGB": {"Applicability": {"ColorPrimaries": "sRGB", "GammaTransfer": "sRGB",
+        "RenderIntent": 1}, "PostBlendGC": "ABC"}}})",
+    R"({"Panel": {"sRGB": {"Applicability": {"ColorPrimaries": "sRGB", "GammaTransfer": "sRGB",
+        "RenderIntent": 1}, "PostBlendGC": "XY"}}})",
+    R"({"Panel": {"sRGB": {"Applicability": {"ColorPrimaries": "sRGB", "GammaTransfer": "sRGB",
+        "RenderIntent": 1}, "DynamicRange": "EDR"}}})",
+    R"({"Panel": {}, "Other": {}})",
+    R"({"Copyright": ""})",
+    R"({"Version": "2", "Panel": {}})",
+    R"({"Panel": )",
+  };
+
+  for (const char *text : bad) {
+    CalibData calib;
+    std::string error;
+    EXPECT_EQ(ParseCalibJson(text, &calib, &error), -EINVAL) << text;
+    EXPECT_FALSE(error.empty());
+  }
+}
+
+}  // namespace qdcm
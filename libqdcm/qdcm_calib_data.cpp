@@ -0,0 +1,361 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <json/json.h>
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "qdcm_calib_data.h"
+
+namespace qdcm {
+
+namespace {
+
+const char *kCopyrightMember = "Copyright";
+const char *kVersionMember = "Version";
+const char *kApplicabilityMember = "Applicability";
+const char *kDynamicRangeMember = "DynamicRange";
+const char *kWhitePointMember = "WhitePoint";
+const char *kMergeIdMember = "MergeId";
+
+int HexValue(char c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  } else if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  } else if (c >= 'A' && c <= 'F') {
+    return c - 'A' + 10;
+  }
+
+  return -1;
+}
+
+bool DecodeHex(const std::string &hex, std::vector<uint8_t> *data) {
+  if (hex.size() % 2) {
+    return false;
+  }
+
+  data->resize(hex.size() / 2);
+  for (size_t i = 0; i < data->size(); i++) {
+    int high = HexValue(hex[2 * i]);
+    int low = HexValue(hex[2 * i + 1]);
+    if (high < 0 || low < 0) {
+      return false;
+    }
+    (*data)[i] = static_cast<uint8_t>((high << 4) | low);
+  }
+
+  return true;
+}
+
+int ParseApplicability(const Json::Value &value, CalibMode *mode, std::string *error) {
+  if (!value.isObject() || !value["ColorPrimaries"].isString() ||
+      !value["GammaTransfer"].isString() || !value["RenderIntent"].isInt()) {
+    *error = "mode " + mode->name + " has an invalid Applicability";
+    return -EINVAL;
+  }
+
+  mode->color_primaries = value["ColorPrimaries"].asString();
+  mode->gamma_transfer = value["GammaTransfer"].asString();
+  mode->render_intent = value["RenderIntent"].asInt();
+  mode->render_intent_name = value.get("RenderIntentName", "").asString();
+
+  return 0;
+}
+
+int ParseMode(const std::string &name, const Json::Value &value, CalibMode *mode,
+              std::string *error) {
+  mode->name = name;
+  if (!value.isObject() || !value.isMember(kApplicabilityMember)) {
+    *error = "mode " + name + " has no Applicability";
+    return -EINVAL;
+  }
+
+  for (const std::string &member : value.getMemberNames()) {
+    const Json::Value &field = value[member];
+    int ret = 0;
+    if (member == kApplicabilityMember) {
+      ret = ParseApplicability(field, mode, error);
+    } else if (member == kDynamicRangeMember) {
+      if (!field.isString() || (field.asString() != "SDR" && field.asString() != "HDR")) {
+        *error = "mode " + name + " has an invalid DynamicRange";
+        ret = -EINVAL;
+      } else {
+        mode->dynamic_range = (field.asString() == "HDR") ? kDynamicRangeHdr : kDynamicRangeSdr;
+      }
+    } else if (member == kWhitePointMember) {
+      if (!field.isUInt()) {
+        *error = "mode " + name + " has an invalid WhitePoint";
+        ret = -EINVAL;
+      } else {
+        mode->white_point = field.asUInt();
+      }
+    } else if (member == kMergeIdMember) {
+      if (!field.isString()) {
+        *error = "mode " + name + " has an invalid MergeId";
+        ret = -EINVAL;
+      } else {
+        mode->merge_id = field.asString();
+      }
+    } else {
+      // Every other member is a hex encoded feature payload.
+      CalibFeature feature;
+      feature.name = member;
+      if (!field.isString() || !DecodeHex(field.asString(), &feature.data)) {
+        *error = "mode " + name + " feature " + member + " is not a hex string";
+        ret = -EINVAL;
+      } else {
+        mode->features.push_back(std::move(feature));
+      }
+    }
+
+    if (ret) {
+      return ret;
+    }
+  }
+
+  return 0;
+}
+
+void AlignTo(std::vector<uint8_t> *blob, size_t alignment) {
+  blob->resize((blob->size() + alignment - 1) / alignment * alignment, 0);
+}
+
+template <class T> T *At(std::vector<uint8_t> *blob, size_t offset) {
+  return reinterpret_cast<T *>(blob->data() + offset);
+}
+
+}  // namespace
+
+int ParseCalibJson(const std::string &text, CalibData *calib, std::string *error) {
+  std::string ignored;
+  error = error ? error : &ignored;
+  if (!calib) {
+    *error = "no output";
+    return -EINVAL;
+  }
+
+  Json::CharReaderBuilder builder;
+  std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+  Json::Value root;
+  std::string errors;
+  if (!reader->parse(text.data(), text.data() + text.size(), &root, &errors)) {
+    *error = "malformed json: " + errors;
+    return -EINVAL;
+  }
+
+  if (!root.isObject()) {
+    *error = "top level is not an object";
+    return -EINVAL;
+  }
+
+  *calib = {};
+  for (const std::string &member : root.getMemberNames()) {
+    if (member == kCopyrightMember) {
+      continue;
+    }
+
+    if (member == kVersionMember) {
+      if (!root[member].isUInt()) {
+        *error = "invalid Version";
+        return -EINVAL;
+      }
+      calib->version = root[member].asUInt();
+      continue;
+    }
+
+    if (!calib->panel_name.empty()) {
+      *error = "more than one panel: " + calib->panel_name + ", " + member;
+      return -EINVAL;
+    }
+
+    const Json::Value &panel = root[member];
+    if (!panel.isObject()) {
+      *error = "panel " + member + " is not an object";
+      return -EINVAL;
+    }
+
+    calib->panel_name = member;
+    for (const std::string &mode_name : panel.getMemberNames()) {
+      CalibMode mode;
+      int ret = ParseMode(mode_name, panel[mode_name], &mode, error);
+      if (ret) {
+        return ret;
+      }
+      calib->modes.push_back(std::move(mode));
+    }
+  }
+
+  if (calib->panel_name.empty()) {
+    *error = "no panel";
+    return -EINVAL;
+  }
+
+  return 0;
+}
+
+int BuildBlob(const CalibData &calib, std::vector<uint8_t> *blob) {
+  if (!blob) {
+    return -EINVAL;
+  }
+
+  std::vector<const CalibMode *> modes;
+  for (auto &mode : calib.modes) {
+    modes.push_back(&mode);
+  }
+  std::sort(modes.begin(), modes.end(), [](const CalibMode *a, const CalibMode *b) {
+    return std::tie(a->render_intent, a->dynamic_range, a->name) <
+           std::tie(b->render_intent, b->dynamic_range, b->name);
+  });
+
+  std::vector<std::vector<const CalibFeature *>> features(modes.size());
+  size_t feature_count = 0;
+  for (size_t i = 0; i < modes.size(); i++) {
+    for (auto &feature : modes[i]->features) {
+      features[i].push_back(&feature);
+    }
+    std::sort(features[i].begin(), features[i].end(),
+              [](const CalibFeature *a, const CalibFeature *b) { return a->name < b->name; });
+    feature_count += features[i].size();
+  }
+
+  // Strings are deduplicated, most modes share primaries, gamma and feature names.
+  std::string strings(1, '\0');
+  auto add_string = [&strings](const std::string &value) {
+    std::string needle = value + '\0';
+    size_t pos = strings.find(needle);
+    if (pos == std::string::npos || (pos && strings[pos - 1] != '\0')) {
+      pos = strings.size();
+      strings += needle;
+    }
+    return uint32_t(pos);
+  };
+
+  blob->assign(sizeof(BlobHeader), 0);
+  size_t modes_offset = blob->size();
+  blob->resize(modes_offset + modes.size() * sizeof(ModeEntry), 0);
+  AlignTo(blob, alignof(FeatureEntry));
+  size_t features_offset = blob->size();
+  blob->resize(features_offset + feature_count * sizeof(FeatureEntry), 0);
+
+  uint32_t panel_name = add_string(calib.panel_name);
+  uint32_t feature_index = 0;
+  for (size_t i = 0; i < modes.size(); i++) {
+    ModeEntry mode = {};
+    mode.name = add_string(modes[i]->name);
+    mode.color_primaries = add_string(modes[i]->color_primaries);
+    mode.gamma_transfer = add_string(modes[i]->gamma_transfer);
+    mode.render_intent_name = add_string(modes[i]->render_intent_name);
+    mode.merge_id = add_string(modes[i]->merge_id);
+    mode.render_intent = modes[i]->render_intent;
+    mode.dynamic_range = modes[i]->dynamic_range;
+    mode.white_point = modes[i]->white_point;
+    mode.first_feature = feature_index;
+    mode.feature_count = uint32_t(features[i].size());
+    *At<ModeEntry>(blob, modes_offset + i * sizeof(ModeEntry)) = mode;
+
+    for (auto feature : features[i]) {
+      FeatureEntry entry = {};
+      entry.name = add_string(feature->name);
+      *At<FeatureEntry>(blob, features_offset + feature_index * sizeof(FeatureEntry)) = entry;
+      feature_index++;
+    }
+  }
+
+  size_t strings_offset = blob->size();
+  blob->insert(blob->end(), strings.begin(), strings.end());
+
+  // Payloads last, each aligned so LUTs can be read in place.
+  feature_index = 0;
+  for (size_t i = 0; i < modes.size(); i++) {
+    for (auto feature : features[i]) {
+      AlignTo(blob, kBlobAlignment);
+      FeatureEntry *entry =
+          At<FeatureEntry>(blob, features_offset + feature_index * sizeof(FeatureEntry));
+      entry->offset = blob->size();
+      entry->size = feature->data.size();
+      blob->insert(blob->end(), feature->data.begin(), feature->data.end());
+      feature_index++;
+    }
+  }
+  AlignTo(blob, kBlobAlignment);
+
+  BlobHeader *header = At<BlobHeader>(blob, 0);
+  header->magic = kBlobMagic;
+  header->version = kBlobVersion;
+  header->size = blob->size();
+  header->panel_name = panel_name;
+  header->mode_count = uint32_t(modes.size());
+  header->modes_offset = uint32_t(modes_offset);
+  header->feature_count = uint32_t(feature_count);
+  header->features_offset = uint32_t(features_offset);
+  header->strings_offset = uint32_t(strings_offset);
+  header->strings_size = uint32_t(strings.size());
+  header->calib_version = calib.version;
+  header->checksum = BlobChecksum(blob->data() + sizeof(BlobHeader),
+                                  blob->size() - sizeof(BlobHeader));
+
+  return 0;
+}
+
+int CompareBlob(const CalibData &calib, const QDCMBlob &blob, std::string *error) {
+  std::string ignored;
+  error = error ? error : &ignored;
+  auto differs = [error](const std::string &what) {
+    *error = what;
+    return -EBADMSG;
+  };
+
+  const char *panel_name = blob.GetPanelName();
+  if (!panel_name || calib.panel_name != panel_name) {
+    return differs("panel name");
+  }
+
+  if (blob.GetCalibVersion() != calib.version) {
+    return differs("version");
+  }
+
+  if (blob.GetModeCount() != calib.modes.size()) {
+    return differs("mode count");
+  }
+
+  for (auto &mode : calib.modes) {
+    const ModeEntry *entry = blob.FindMode(mode.name.c_str());
+    if (!entry) {
+      return differs("mode " + mode.name + " missing");
+    }
+
+    if (mode.color_primaries != blob.GetString(entry->color_primaries) ||
+        mode.gamma_transfer != blob.GetString(entry->gamma_transfer) ||
+        mode.render_intent_name != blob.GetString(entry->render_intent_name) ||
+        mode.merge_id != blob.GetString(entry->merge_id) ||
+        mode.render_intent != entry->render_intent ||
+        mode.dynamic_range != entry->dynamic_range || mode.white_point != entry->white_point) {
+      return differs("mode " + mode.name + " applicability");
+    }
+
+    if (entry->feature_count != mode.features.size()) {
+      return differs("mode " + mode.name + " feature count");
+    }
+
+    for (auto &feature : mode.features) {
+      QDCMBlob::Feature payload;
+      if (blob.GetFeature(*entry, feature.name.c_str(), &payload) ||
+          payload.size != feature.data.size() ||
+          (payload.size && memcmp(payload.data, feature.data.data(), payload.size))) {
+        return differs("mode " + mode.name + " feature " + feature.name);
+      }
+    }
+  }
+
+  return 0;
+}
+
+}  // namespace qdcm
@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __QDCM_CALIB_DATA_H__
+#define __QDCM_CALIB_DATA_H__
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "qdcm_blob.h"
+
+// Text side of the QDCM calibration data, used by qdcm_blob_compiler and as the reference the
+// blob is checked against.
+namespace qdcm {
+
+struct CalibFeature {
+  std::string name;           // PostBlendGC, PostBlendGamut, ...
+  std::vector<uint8_t> data;  // Decoded from the hex string
+};
+
+struct CalibMode {
+  std::string name;
+  std::string color_primaries;
+  std::string gamma_transfer;
+  std::string render_intent_name;
+  std::string merge_id;
+  int32_t render_intent = 0;
+  DynamicRange dynamic_range = kDynamicRangeSdr;
+  uint32_t white_point = 0;
+  std::vector<CalibFeature> features;
+};
+
+struct CalibData {
+  uint32_t version = 1;
+  std::string panel_name;
+  std::vector<CalibMode> modes;
+};
+
+// Parses the contents of a qdcm_calib_data_*.json file. Returns 0 or a negative errno, with a
+// description of the first problem in error.
+int ParseCalibJson(const std::string &text, CalibData *calib, std::string *error);
+
+// Lays calib out as described in qdcm_blob.h. Modes and features are sorted, so the same data
+// always compiles to the same bytes.
+int BuildBlob(const CalibData &calib, std::vector<uint8_t> *blob);
+
+// Checks that every mode and feature of calib reads back the same from blob, and nothing else
+// is in there. Returns 0 or -EBADMSG with the first difference in error.
+int CompareBlob(const CalibData &calib, const QDCMBlob &blob, std::string *error);
+
+}  // namespace qdcm
+
+#endif  // __QDCM_CALIB_DATA_H__
@@ -61,12 +61,15 @@
 * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+#include <errno.h>
 #include <fcntl.h>
 #include <stdio.h>
+#include <sys/mman.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
 #include <display_config.h>
+#include <display_status_page.h>
 #include <QServiceUtils.h>
 #include <qd_utils.h>
 
@@ -370,6 +373,47 @@ int GetDisplayPortId(int dpy, int *port_id) {
     return err;
 }
 
+const sdm::DisplayStatusPage *getDisplayStatusPage() {
+    sp<IQService> binder = getBinder();
+    Parcel inParcel, outParcel;
+    if(binder == nullptr) {
+        return nullptr;
+    }
+
+    status_t err = binder->dispatch(IQService::GET_DISPLAY_STATUS_PAGE, &inParcel, &outParcel);
+    if(!err) {
+        err = outParcel.readInt32();
+    }
+    // Owned by outParcel, the mapping outlives it.
+    int fd = err ? -1 : outParcel.readFileDescriptor();
+    if(fd < 0) {
+        ALOGE("%s() failed with err %d", __FUNCTION__, err);
+        return nullptr;
+    }
+
+    void *addr = mmap(nullptr, sizeof(sdm::DisplayStatusPage), PROT_READ, MAP_SHARED, fd, 0);
+    if(addr == MAP_FAILED) {
+        ALOGE("%s() mmap failed with err %d", __FUNCTION__, errno);
+        return nullptr;
+    }
+
+    auto page = static_cast<const sdm::DisplayStatusPage *>(addr);
+    if(page->magic != sdm::kDisplayStatusPageMagic ||
+       page->version != sdm::kDisplayStatusPageVersion) {
+        ALOGE("%s() unsupported page magic 0x%x version %u", __FUNCTION__, page->magic,
+              page->version);
+        munmap(addr, sizeof(sdm::DisplayStatusPage));
+        return nullptr;
+    }
+    return page;
+}
+
+void releaseDisplayStatusPage(const sdm::DisplayStatusPage *page) {
+    if(page) {
+        munmap(const_cast<sdm::DisplayStatusPage *>(page), sizeof(sdm::DisplayStatusPage));
+    }
+}
+
 }// namespace
 
 // ----------------------------------------------------------------------------
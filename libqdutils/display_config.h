@@ -69,6 +69,10 @@
 #include <vector>
 #include <hardware/hwcomposer.h>
 
+namespace sdm {
+struct DisplayStatusPage;
+}
+
 // This header is for clients to use to set/get global display configuration.
 // Only primary and external displays are supported here.
 
@@ -201,6 +205,13 @@ int setPanelLuminanceAttributes(int dpy, float min_lum, float max_lum);
 // Get the port id for a given display id
 int GetDisplayPortId(int dpy, int *port_id);
 
+// Maps the composer's read-only display status page, see display_status_page.h.
+// Read it with sdm::ReadDisplayStatus() as often as needed, no binder call is involved.
+// Returns nullptr on error. Release with releaseDisplayStatusPage().
+const sdm::DisplayStatusPage *getDisplayStatusPage();
+
+void releaseDisplayStatusPage(const sdm::DisplayStatusPage *page);
+
 }; //namespace
 
 
@@ -0,0 +1,183 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "display_status_page.h"
+
+namespace sdm {
+namespace {
+
+// Every field is derived from one value, a torn read shows up as a mismatch.
+DisplayStatus MakeStatus(uint32_t value) {
+  DisplayStatus status = {};
+  status.flags = kDisplayStatusConnected | (value & kDisplayStatusIdle);
+  status.power_mode = value ^ 0x5a5a5a5a;
+  status.active_config = value;
+  status.refresh_rate = value * 3;
+  status.qsync_refresh_rate = ~value;
+  status.brightness = static_cast<float>(value & 0xffff);
+  status.frame_count = value;
+  status.timestamp_ns = -static_cast<int64_t>(value);
+  return status;
+}
+
+bool IsConsistent(const DisplayStatus &status) {
+  uint32_t value = status.active_config;
+  DisplayStatus expected = MakeStatus(value);
+  return memcmp(&status, &expected, sizeof(status)) == 0;
+}
+
+class DisplayStatusPageTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    fd_ = memfd_create("display_status_page_test", MFD_CLOEXEC);
+    ASSERT_GE(fd_, 0);
+    ASSERT_EQ(ftruncate(fd_, sizeof(DisplayStatusPage)), 0);
+    void *addr = mmap(nullptr, sizeof(DisplayStatusPage), PROT_READ | PROT_WRITE, MAP_SHARED,
+                      fd_, 0);
+    ASSERT_NE(addr, MAP_FAILED);
+    writer_ = static_cast<DisplayStatusPage *>(addr);
+    writer_->magic = kDisplayStatusPageMagic;
+    writer_->version = kDisplayStatusPageVersion;
+    writer_->slot_count = kDisplayStatusSlots;
+    writer_->slot_size = sizeof(DisplayStatusSlot);
+
+    // Readers go through a second, read-only descriptor and mapping like clients do.
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/self/fd/%d", fd_);
+    read_only_fd_ = open(path, O_RDONLY | O_CLOEXEC);
+    ASSERT_GE(read_only_fd_, 0);
+    addr = mmap(nullptr, sizeof(DisplayStatusPage), PROT_READ, MAP_SHARED, read_only_fd_, 0);
+    ASSERT_NE(addr, MAP_FAILED);
+    reader_ = static_cast<const DisplayStatusPage *>(addr);
+  }
+
+  void TearDown() override {
+    if (reader_) {
+      munmap(const_cast<DisplayStatusPage *>(reader_), sizeof(DisplayStatusPage));
+    }
+    if (writer_) {
+      munmap(writer_, sizeof(DisplayStatusPage));
+    }
+    if (read_only_fd_ >= 0) {
+      close(read_only_fd_);
+    }
+    if (fd_ >= 0) {
+      close(fd_);
+    }
+  }
+
+  int fd_ = -1;
+  int read_only_fd_ = -1;
+  DisplayStatusPage *writer_ = nullptr;
+  const DisplayStatusPage *reader_ = nullptr;
+};
+
+}  // namespace
+
+TEST_F(DisplayStatusPageTest, RoundTrip) {
+  DisplayStatus status = {};
+  ASSERT_TRUE(ReadDisplayStatus(reader_, 1, &status));
+  EXPECT_EQ(status.flags, 0u);
+
+  WriteDisplayStatus(&writer_->slots[1], MakeStatus(60));
+  ASSERT_TRUE(ReadDisplayStatus(reader_, 1, &status));
+  EXPECT_TRUE(IsConsistent(status));
+  EXPECT_EQ(status.refresh_rate, 180u);
+  EXPECT_EQ(reader_->slots[1].sequence.load(), 2u);
+
+  EXPECT_FALSE(ReadDisplayStatus(reader_, kDisplayStatusSlots, &status));
+  EXPECT_FALSE(ReadDisplayStatus(nullptr, 0, &status));
+}
+
+TEST_F(DisplayStatusPageTest, ReadOnlyForClients) {
+  void *addr = mmap(nullptr, sizeof(DisplayStatusPage), PROT_READ | PROT_WRITE, MAP_SHARED,
+                    read_only_fd_, 0);
+  EXPECT_EQ(addr, MAP_FAILED);
+}
+
+TEST_F(DisplayStatusPageTest, UpdateInProgressIsNotRead) {
+  WriteDisplayStatus(&writer_->slots[0], MakeStatus(1));
+  writer_->slots[0].sequence.fetch_add(1);
+
+  DisplayStatus status = {};
+  EXPECT_FALSE(TryReadDisplayStatus(&reader_->slots[0], &status));
+  EXPECT_FALSE(ReadDisplayStatus(reader_, 0, &status));
+
+  writer_->slots[0].sequence.fetch_add(1);
+  EXPECT_TRUE(ReadDisplayStatus(reader_, 0, &status));
+  EXPECT_TRUE(IsConsistent(status));
+}
+
+TEST_F(DisplayStatusPageTest, ConcurrentWritersAndReaders) {
+  const uint32_t kWriters = 4;
+  const uint32_t kReaders = 4;
+  const uint32_t kSlots = 2;
+  const uint32_t kUpdatesPerWriter = 20000;
+
+  // Writers are serialized, like HWCStatusPage does, readers take no lock at all.
+  std::mutex writer_lock;
+  uint32_t next_value[kSlots] = {};
+  std::atomic<uint32_t> writers_done(0);
+  std::atomic<uint64_t> torn(0);
+  std::atomic<uint64_t> reads(0);
+
+  std::vector<std::thread> threads;
+  for (uint32_t w = 0; w < kWriters; w++) {
+    threads.emplace_back([&, w] {
+      for (uint32_t i = 0; i < kUpdatesPerWriter; i++) {
+        uint32_t slot = (w + i) % kSlots;
+        std::lock_guard<std::mutex> lock(writer_lock);
+        WriteDisplayStatus(&writer_->slots[slot], MakeStatus(++next_value[slot]));
+      }
+      writers_done++;
+    });
+  }
+
+  for (uint32_t r = 0; r < kReaders; r++) {
+    threads.emplace_back([&] {
+      uint64_t last[kSlots] = {};
+      bool finished = false;
+      while (!finished) {
+        finished = (writers_done == kWriters);
+        for (uint32_t slot = 0; slot < kSlots; slot++) {
+          DisplayStatus status = {};
+          if (!ReadDisplayStatus(reader_, slot, &status)) {
+            continue;
+          }
+          reads++;
+          if (!IsConsistent(status) || status.frame_count < last[slot]) {
+            torn++;
+          }
+          last[slot] = status.frame_count;
+        }
+      }
+    });
+  }
+
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(torn.load(), 0u);
+  EXPECT_GT(reads.load(), 0u);
+  for (uint32_t slot = 0; slot < kSlots; slot++) {
+    DisplayStatus status = {};
+    ASSERT_TRUE(ReadDisplayStatus(reader_, slot, &status));
+    EXPECT_EQ(status.frame_count, next_value[slot]);
+    EXPECT_EQ(reader_->slots[slot].sequence.load(), 2 * next_value[slot]);
+  }
+}
+
+}  // namespace sdm
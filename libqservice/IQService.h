@@ -129,6 +129,8 @@ public:
       SET_DEMURA_STATE = 60,                   // Enable/disable demura feature
       SET_DEMURA_CONFIG = 61,                  // Set the demura configuration index
       SET_BPP_MODE = 62,                       // Set Panel bpp to 24bpp or 30bpp
+      GET_DISPLAY_STATUS_PAGE = 63,            // Get the read-only display status page memfd
+      RELOAD_DEBUG_PROPERTIES = 64,            // Re-read the debug properties SDM caches
       COMMAND_LIST_END = 400,
     };
 
@@ -228,6 +228,7 @@ DRMDppsManagerIntf *DRMManager::GetDppsMgrIntf() {
 }
 
 int DRMManager::RegisterDisplay(DRMDisplayType disp_type, DRMDisplayToken *token) {
+  lock_guard<mutex> lock(display_lock_);
   int ret = conn_mgr_->Reserve(disp_type, token);
   if (ret) {
     if (ret == -ENODEV) {
@@ -276,6 +277,7 @@ int DRMManager::RegisterDisplay(DRMDisplayType disp_type, DRMDisplayToken *token
 }
 
 int DRMManager::RegisterDisplay(int32_t display_id, DRMDisplayToken *token) {
+  lock_guard<mutex> lock(display_lock_);
   int ret = conn_mgr_->Reserve(display_id, token);
   if (ret) {
     DRM_LOGE("Error reserving connector %d. Error = %d (%s)", display_id, ret, strerror(abs(ret)));
@@ -320,6 +322,7 @@ int DRMManager::RegisterDisplay(int32_t display_id, DRMDisplayToken *token) {
 }
 
 void DRMManager::UnregisterDisplay(DRMDisplayToken *token) {
+  lock_guard<mutex> lock(display_lock_);
   conn_mgr_->Free(token);
   encoder_mgr_->Free(token);
   crtc_mgr_->Free(token);
@@ -94,6 +94,9 @@ class DRMManager : public DRMManagerInterface {
   DRMCrtcManager *crtc_mgr_ = {};
   DRMDppsManagerIntf *dpps_mgr_intf_ = {};
   DRMPanelFeatureMgrIntf *panel_feature_mgr_intf_ = {};
+  // Displays may be created from several threads. Connector, encoder and crtc are reserved as one
+  // step, so that two displays never pick the same free encoder or crtc.
+  std::mutex display_lock_;
 
   static DRMManager *s_drm_instance;
   static std::mutex s_lock;
@@ -0,0 +1,221 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <utils/constants.h>
+#include <utils/fence.h>
+#include <atomic>
+#include <new>
+#include <vector>
+
+#include "frame_replay.h"
+#include "stub_hw.h"
+
+namespace {
+
+// Heap use is only counted while the core is inside Prepare() or Commit().
+std::atomic<bool> g_count_allocs {false};
+std::atomic<uint64_t> g_allocs {0};
+std::atomic<uint64_t> g_alloc_bytes {0};
+
+void *CountedAlloc(size_t size) {
+  if (g_count_allocs.load(std::memory_order_relaxed)) {
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    g_alloc_bytes.fetch_add(size, std::memory_order_relaxed);
+  }
+  void *ptr = malloc(size ? size : 1);
+  if (!ptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+}  // namespace
+
+void *operator new(size_t size) { return CountedAlloc(size); }
+void *operator new[](size_t size) { return CountedAlloc(size); }
+void operator delete(void *ptr) noexcept { free(ptr); }
+void operator delete[](void *ptr) noexcept { free(ptr); }
+void operator delete(void *ptr, size_t) noexcept { free(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { free(ptr); }
+
+namespace sdm {
+
+using display::DebugHandler;
+
+namespace {
+
+struct Snapshot {
+  uint64_t cpu_ns = 0;
+  uint64_t wall_ns = 0;
+};
+
+uint64_t GetTimeNs(clockid_t clock) {
+  struct timespec ts = {};
+  clock_gettime(clock, &ts);
+  return UINT64(ts.tv_sec) * 1000000000ULL + UINT64(ts.tv_nsec);
+}
+
+Snapshot Now() {
+  return {GetTimeNs(CLOCK_THREAD_CPUTIME_ID), GetTimeNs(CLOCK_MONOTONIC)};
+}
+
+}  // namespace
+
+void ReplayDebugHandler::Error(const char *format, ...) {
+  va_list args;
+  va_start(args, format);
+  vfprintf(stderr, format, args);
+  fputc('\n', stderr);
+  va_end(args);
+}
+
+int FrameReplay::Init() {
+  DebugHandler::Set(&debug_handler_);
+  StubHW::Install(&trace_);
+  Fence::Set(&sync_handler_);
+
+  DisplayError error = CoreInterface::CreateCore(&buffer_allocator_, &sync_handler_,
+                                                 &socket_handler_, nullptr, &core_intf_);
+  if (error != kErrorNone) {
+    fprintf(stderr, "CreateCore failed %d\n", error);
+    return -ENODEV;
+  }
+
+  error = core_intf_->CreateDisplay(0, &event_handler_, &display_intf_);
+  if (error != kErrorNone) {
+    fprintf(stderr, "CreateDisplay failed %d\n", error);
+    return -ENODEV;
+  }
+
+  shared_ptr<Fence> release_fence = nullptr;
+  error = display_intf_->SetDisplayState(kStateOn, false, &release_fence);
+  if (error != kErrorNone) {
+    fprintf(stderr, "SetDisplayState failed %d\n", error);
+    return -ENODEV;
+  }
+
+  // Same client target HWCDisplay appends: display sized, composed by the GPU.
+  const TraceDisplay &display = trace_.display;
+  client_target_.composition = kCompositionGPUTarget;
+  client_target_.input_buffer.format = kFormatRGBA8888;
+  client_target_.input_buffer.width = display.width;
+  client_target_.input_buffer.height = display.height;
+  client_target_.input_buffer.unaligned_width = display.width;
+  client_target_.input_buffer.unaligned_height = display.height;
+  client_target_.input_buffer.planes[0].stride = display.width * 4;
+  client_target_.input_buffer.size = display.width * display.height * 4;
+  client_target_.src_rect = {0.0f, 0.0f, FLOAT(display.width), FLOAT(display.height)};
+  client_target_.dst_rect = client_target_.src_rect;
+  client_target_.blending = kBlendingPremultiplied;
+  client_target_.plane_alpha = 255;
+  client_target_.frame_rate = display.fps;
+
+  return 0;
+}
+
+void FrameReplay::Deinit() {
+  if (display_intf_) {
+    core_intf_->DestroyDisplay(display_intf_);
+    display_intf_ = nullptr;
+  }
+  if (core_intf_) {
+    CoreInterface::DestroyCore();
+    core_intf_ = nullptr;
+  }
+  DebugHandler::Set(nullptr);
+}
+
+void FrameReplay::BuildLayerStack(const TraceFrame &frame, uint64_t frame_number) {
+  layers_ = frame.layers;
+  layer_stack_.layers.clear();
+
+  for (auto &layer : layers_) {
+    // Updating layers get a new buffer every frame, the others keep theirs.
+    if (layer.flags.updating) {
+      layer.input_buffer.buffer_id = (UINT64(layer.layer_id) << 32) | (frame_number + 1);
+      layer.update_mask.set(kSurfaceDamage);
+    }
+    layer.geometry_changes = frame.geometry_changed ? GeometryChanges::kDefault :
+                                                      GeometryChanges::kNone;
+    layer.composition = kCompositionGPU;
+    layer_stack_.layers.push_back(&layer);
+  }
+
+  client_target_.input_buffer.buffer_id = frame_number + 1;
+  client_target_.composition = kCompositionGPUTarget;
+  client_target_.geometry_changes = frame.geometry_changed ? GeometryChanges::kDefault :
+                                                             GeometryChanges::kNone;
+  layer_stack_.layers.push_back(&client_target_);
+
+  layer_stack_.flags = {};
+  layer_stack_.flags.geometry_changed = frame.geometry_changed;
+  layer_stack_.retire_fence = nullptr;
+}
+
+FrameStats FrameReplay::ReplayFrame(const TraceFrame &frame, uint64_t frame_number) {
+  FrameStats stats;
+  StubHWStats &hw_stats = StubHW::GetStats();
+
+  BuildLayerStack(frame, frame_number);
+  StubHW::RejectValidates(frame.validate_failures);
+
+  uint64_t validates = hw_stats.validates;
+  uint64_t rejected = hw_stats.rejected_validates;
+  uint64_t sys_calls = hw_stats.sys_calls;
+  debug_handler_.reads_ = 0;
+  g_allocs = 0;
+  g_alloc_bytes = 0;
+
+  debug_handler_.counting_ = true;
+  g_count_allocs = true;
+  Snapshot start = Now();
+  stats.error = display_intf_->Prepare(&layer_stack_);
+  Snapshot prepared = Now();
+  if (stats.error == kErrorNone) {
+    stats.error = display_intf_->Commit(&layer_stack_);
+  }
+  Snapshot committed = Now();
+  g_count_allocs = false;
+  debug_handler_.counting_ = false;
+
+  stats.prepare_cpu_ns = prepared.cpu_ns - start.cpu_ns;
+  stats.prepare_wall_ns = prepared.wall_ns - start.wall_ns;
+  stats.commit_cpu_ns = committed.cpu_ns - prepared.cpu_ns;
+  stats.commit_wall_ns = committed.wall_ns - prepared.wall_ns;
+  stats.allocs = g_allocs;
+  stats.alloc_bytes = g_alloc_bytes;
+  stats.validates = hw_stats.validates - validates;
+  stats.retries = hw_stats.rejected_validates - rejected;
+  stats.sys_calls = hw_stats.sys_calls - sys_calls;
+  stats.property_reads = debug_handler_.reads_;
+
+  return stats;
+}
+
+int FrameReplay::Run(uint32_t warmup, std::vector<FrameStats> *stats) {
+  uint64_t frame_number = 0;
+  stats->reserve(trace_.GetFrameCount());
+
+  for (const auto &frame : trace_.frames) {
+    for (uint32_t i = 0; i < frame.repeat; i++, frame_number++) {
+      FrameStats frame_stats = ReplayFrame(frame, frame_number);
+      if (frame_stats.error != kErrorNone && frame_stats.error != kErrorNotValidated) {
+        fprintf(stderr, "Frame %" PRIu64 " failed %d\n", frame_number, frame_stats.error);
+      }
+      if (frame_number >= warmup) {
+        stats->push_back(frame_stats);
+      }
+    }
+  }
+
+  return 0;
+}
+
+}  // namespace sdm
@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __FRAME_REPLAY_H__
+#define __FRAME_REPLAY_H__
+
+#include <core/buffer_allocator.h>
+#include <core/buffer_sync_handler.h>
+#include <core/core_interface.h>
+#include <core/display_interface.h>
+#include <core/socket_handler.h>
+#include <debug_handler.h>
+#include <errno.h>
+#include <atomic>
+#include <sstream>
+#include <vector>
+
+#include "frame_trace.h"
+
+// Drives Prepare() and Commit() of the display core on the stub backend with the frames of a
+// trace, measuring each frame. Allocations are counted through the global operator new this
+// module replaces, so only one FrameReplay should run at a time.
+//
+// Only the core is measured: DisplayBuiltIn, CompManager, the strategy and ResourceDefault. The
+// stub backend replaces the whole DAL, so HWDeviceDRM and its DRM calls, including the mode
+// index lookups behind mode switches, are not part of the numbers.
+namespace sdm {
+
+struct FrameStats {
+  uint64_t prepare_cpu_ns = 0;
+  uint64_t prepare_wall_ns = 0;
+  uint64_t commit_cpu_ns = 0;
+  uint64_t commit_wall_ns = 0;
+  uint64_t allocs = 0;
+  uint64_t alloc_bytes = 0;
+  uint64_t validates = 0;
+  uint64_t retries = 0;         // Validate() calls the backend rejected
+  uint64_t sys_calls = 0;       // Device accesses through the Sys table
+  uint64_t property_reads = 0;  // DebugHandler::GetProperty() calls
+  DisplayError error = kErrorNone;
+};
+
+// Answers every property with its default and counts the reads made while a frame is measured.
+class ReplayDebugHandler : public display::DebugHandler {
+ public:
+  virtual void Error(const char *format, ...);
+  virtual void Warning(const char *, ...) { }
+  virtual void Info(const char *, ...) { }
+  virtual void Debug(const char *, ...) { }
+  virtual void Verbose(const char *, ...) { }
+  virtual void BeginTrace(const char *, const char *, const char *) { }
+  virtual void EndTrace() { }
+  virtual int GetProperty(const char *, int *) { return CountRead(); }
+  virtual int GetProperty(const char *, char *) { return CountRead(); }
+
+  std::atomic<bool> counting_ {false};
+  std::atomic<uint64_t> reads_ {0};
+
+ private:
+  int CountRead() {
+    if (counting_.load(std::memory_order_relaxed)) {
+      reads_++;
+    }
+    return -1;
+  }
+};
+
+// The stub backend never allocates or waits, neither should the core on the frame path.
+class ReplayBufferAllocator : public BufferAllocator {
+ public:
+  virtual int AllocateBuffer(BufferInfo *buffer_info) { return -ENOMEM; }
+  virtual int FreeBuffer(BufferInfo *buffer_info) { return 0; }
+  virtual uint32_t GetBufferSize(BufferInfo *buffer_info) { return 0; }
+  virtual int GetAllocatedBufferInfo(const BufferConfig &buffer_config,
+                                     AllocatedBufferInfo *allocated_buffer_info) {
+    return -ENOTSUP;
+  }
+};
+
+class ReplaySyncHandler : public BufferSyncHandler {
+ public:
+  virtual int SyncWait(int fd, int timeout) { return 0; }
+  virtual int SyncMerge(int fd1, int fd2, int *merged_fd) {
+    *merged_fd = -1;
+    return 0;
+  }
+  virtual void GetSyncInfo(int fd, std::ostringstream *os) { }
+};
+
+class ReplaySocketHandler : public SocketHandler {
+ public:
+  virtual int GetSocketFd(SocketType socket_type) { return -1; }
+};
+
+class ReplayEventHandler : public DisplayEventHandler {
+ public:
+  virtual DisplayError VSync(const DisplayEventVSync &vsync) { return kErrorNone; }
+  virtual DisplayError Refresh() { return kErrorNone; }
+  virtual DisplayError CECMessage(char *message) { return kErrorNone; }
+  virtual DisplayError HistogramEvent(int source_fd, uint32_t blob_id) { return kErrorNone; }
+  virtual DisplayError HandleEvent(DisplayEvent event) { return kErrorNone; }
+  virtual void MMRMEvent(bool restricted) { }
+};
+
+class FrameReplay {
+ public:
+  explicit FrameReplay(const FrameTrace &trace) : trace_(trace) {}
+  ~FrameReplay() { Deinit(); }
+  int Init();
+  void Deinit();
+  // Replays every frame of the trace, the first warmup frames are not reported.
+  int Run(uint32_t warmup, std::vector<FrameStats> *stats);
+
+ private:
+  void BuildLayerStack(const TraceFrame &frame, uint64_t frame_number);
+  FrameStats ReplayFrame(const TraceFrame &frame, uint64_t frame_number);
+
+  const FrameTrace &trace_;
+  ReplayDebugHandler debug_handler_;
+  ReplayBufferAllocator buffer_allocator_;
+  ReplaySyncHandler sync_handler_;
+  ReplaySocketHandler socket_handler_;
+  ReplayEventHandler event_handler_;
+  CoreInterface *core_intf_ = nullptr;
+  DisplayInterface *display_intf_ = nullptr;
+  std::vector<Layer> layers_;
+  Layer client_target_;
+  LayerStack layer_stack_;
+};
+
+}  // namespace sdm
+
+#endif  // __FRAME_REPLAY_H__
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "frame_replay.h"
+#include "frame_trace.h"
+
+namespace sdm {
+namespace {
+
+// Geometry changes, steady frames, partial damage, a rejected Validate() and a scaled video layer.
+const char *kTrace = R"({
+  "frames": [
+    {"geometry_changed": true, "layers": [
+      {"name": "Wallpaper", "format": "RGBA_8888_UBWC", "blending": "opaque", "updating": false},
+      {"name": "App", "format": "RGBA_8888_UBWC"},
+      {"name": "StatusBar", "dst": [0, 0, 1080, 96], "updating": false}
+    ]},
+    {"repeat": 30, "layers": [
+      {"name": "Wallpaper", "format": "RGBA_8888_UBWC", "blending": "opaque", "updating": false},
+      {"name": "App", "format": "RGBA_8888_UBWC", "dirty": [[0, 200, 1080, 400]]},
+      {"name": "StatusBar", "dst": [0, 0, 1080, 96], "updating": false}
+    ]},
+    {"geometry_changed": true, "validate_failures": 1, "layers": [
+      {"name": "App", "format": "RGBA_8888_UBWC", "updating": false},
+      {"name": "Video", "format": "Y_CBCR_420_VENUS_UBWC", "buffer": [1920, 1080],
+       "dst": [0, 800, 1080, 1408], "blending": "opaque"}
+    ]},
+    {"repeat": 30, "layers": [
+      {"name": "App", "format": "RGBA_8888_UBWC", "updating": false},
+      {"name": "Video", "format": "Y_CBCR_420_VENUS_UBWC", "buffer": [1920, 1080],
+       "dst": [0, 800, 1080, 1408], "blending": "opaque"}
+    ]}
+  ]
+})";
+
+void Replay(const FrameTrace &trace, std::vector<FrameStats> *stats) {
+  FrameReplay replay(trace);
+  ASSERT_EQ(replay.Init(), 0);
+  ASSERT_EQ(replay.Run(0, stats), 0);
+  ASSERT_EQ(stats->size(), trace.GetFrameCount());
+}
+
+}  // namespace
+
+// Properties are snapshotted by Debug and at init, Prepare() and Commit() must not read any.
+// Composition results depend on whether the strategy extension is present, so only the reads
+// and device accesses are checked.
+TEST(FrameReplayTest, NoPropertyReadsOnFramePath) {
+  FrameTrace trace;
+  std::string error;
+  ASSERT_EQ(ParseFrameTrace(kTrace, &trace, &error), 0) << error;
+
+  std::vector<FrameStats> stats;
+  Replay(trace, &stats);
+  for (size_t i = 0; i < stats.size(); i++) {
+    EXPECT_EQ(stats[i].property_reads, 0u) << "frame " << i;
+    EXPECT_EQ(stats[i].sys_calls, 0u) << "frame " << i;
+  }
+}
+
+TEST(FrameReplayTest, NoPropertyReadsOnSyntheticTrace) {
+  FrameTrace trace;
+  GenerateFrameTrace(120, 6, 20, &trace);
+
+  std::vector<FrameStats> stats;
+  Replay(trace, &stats);
+  for (size_t i = 0; i < stats.size(); i++) {
+    EXPECT_EQ(stats[i].property_reads, 0u) << "frame " << i;
+    EXPECT_EQ(stats[i].sys_calls, 0u) << "frame " << i;
+  }
+}
+
+}  // namespace sdm
@@ -0,0 +1,469 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <errno.h>
+#include <json/json.h>
+#include <utils/constants.h>
+#include <utils/formats.h>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "frame_trace.h"
+
+namespace sdm {
+
+namespace {
+
+// Roughly a current mobile SDE, used for anything the trace leaves out.
+void SetDefaultHWResource(HWResourceInfo *hw_resource) {
+  *hw_resource = {};
+  hw_resource->hw_version = 0x90000000;
+  hw_resource->num_vig_pipe = 4;
+  hw_resource->num_dma_pipe = 4;
+  hw_resource->num_blending_stages = 11;
+  hw_resource->max_scale_up = 20;
+  hw_resource->max_scale_down = 4;
+  hw_resource->max_mixer_width = 2560;
+  hw_resource->max_pipe_width = 2560;
+  hw_resource->max_pipe_width_dma = 2560;
+  hw_resource->max_scaler_pipe_width = 2560;
+  hw_resource->max_sde_clk = 514000000;
+  hw_resource->max_bandwidth_low = 9600000;
+  hw_resource->max_bandwidth_high = 9600000;
+  hw_resource->is_src_split = true;
+  hw_resource->has_ubwc = true;
+}
+
+void AddPipes(HWResourceInfo *hw_resource) {
+  hw_resource->hw_pipes.clear();
+  uint32_t id = 1;
+  for (uint32_t i = 0; i < hw_resource->num_vig_pipe; i++) {
+    HWPipeCaps pipe = {};
+    pipe.type = kPipeTypeVIG;
+    pipe.id = id++;
+    hw_resource->hw_pipes.push_back(pipe);
+  }
+  for (uint32_t i = 0; i < hw_resource->num_rgb_pipe; i++) {
+    HWPipeCaps pipe = {};
+    pipe.type = kPipeTypeRGB;
+    pipe.id = id++;
+    hw_resource->hw_pipes.push_back(pipe);
+  }
+  for (uint32_t i = 0; i < hw_resource->num_dma_pipe; i++) {
+    HWPipeCaps pipe = {};
+    pipe.type = kPipeTypeDMA;
+    pipe.id = id++;
+    pipe.max_rects = 2;
+    hw_resource->hw_pipes.push_back(pipe);
+  }
+}
+
+bool FindFormat(const std::string &name, LayerBufferFormat *format) {
+  static std::map<std::string, LayerBufferFormat> formats;
+  if (formats.empty()) {
+    // Format groups start at multiples of 0x100, see LayerBufferFormat.
+    for (uint32_t value = 0; value < 0x400; value++) {
+      LayerBufferFormat candidate = static_cast<LayerBufferFormat>(value);
+      std::string candidate_name = GetFormatString(candidate);
+      if (candidate_name != "Unknown") {
+        formats[candidate_name] = candidate;
+      }
+    }
+  }
+
+  auto it = formats.find(name);
+  if (it == formats.end()) {
+    return false;
+  }
+  *format = it->second;
+
+  return true;
+}
+
+bool ParseRect(const Json::Value &value, LayerRect *rect) {
+  if (!value.isArray() || value.size() != 4) {
+    return false;
+  }
+  for (Json::ArrayIndex i = 0; i < 4; i++) {
+    if (!value[i].isNumeric()) {
+      return false;
+    }
+  }
+
+  rect->left = value[0].asFloat();
+  rect->top = value[1].asFloat();
+  rect->right = value[2].asFloat();
+  rect->bottom = value[3].asFloat();
+
+  return (rect->right > rect->left) && (rect->bottom > rect->top);
+}
+
+bool ParseRects(const Json::Value &value, std::vector<LayerRect> *rects) {
+  if (!value.isArray()) {
+    return false;
+  }
+
+  rects->clear();
+  for (auto &item : value) {
+    LayerRect rect = {};
+    if (!ParseRect(item, &rect)) {
+      return false;
+    }
+    rects->push_back(rect);
+  }
+
+  return true;
+}
+
+bool ParseUInt(const Json::Value &parent, const char *member, uint32_t *out) {
+  if (!parent.isMember(member)) {
+    return true;
+  }
+  if (!parent[member].isUInt()) {
+    return false;
+  }
+  *out = parent[member].asUInt();
+
+  return true;
+}
+
+bool ParseBool(const Json::Value &parent, const char *member, bool *out) {
+  if (!parent.isMember(member)) {
+    return true;
+  }
+  if (!parent[member].isBool()) {
+    return false;
+  }
+  *out = parent[member].asBool();
+
+  return true;
+}
+
+bool ParseString(const Json::Value &parent, const char *member, std::string *out) {
+  if (!parent.isMember(member)) {
+    return true;
+  }
+  if (!parent[member].isString()) {
+    return false;
+  }
+  *out = parent[member].asString();
+
+  return true;
+}
+
+void SetBuffer(LayerBufferFormat format, uint32_t width, uint32_t height, LayerBuffer *buffer) {
+  buffer->format = format;
+  buffer->width = width;
+  buffer->height = height;
+  buffer->unaligned_width = width;
+  buffer->unaligned_height = height;
+  buffer->size = UINT32(GetBufferFormatBpp(format) * FLOAT(width) * FLOAT(height));
+  buffer->planes[0].stride = UINT32(GetBufferFormatBpp(format) * FLOAT(width));
+  buffer->flags.video = !IsRgbFormat(format);
+}
+
+int ParseDisplay(const Json::Value &value, TraceDisplay *display, std::string *error) {
+  if (!value.isObject() || !ParseUInt(value, "width", &display->width) ||
+      !ParseUInt(value, "height", &display->height) || !ParseUInt(value, "fps", &display->fps) ||
+      !display->width || !display->height || !display->fps) {
+    *error = "invalid display";
+    return -EINVAL;
+  }
+
+  std::string mode = "video";
+  if (!ParseString(value, "panel_mode", &mode)) {
+    *error = "invalid panel_mode";
+    return -EINVAL;
+  } else if (mode == "video") {
+    display->mode = kModeVideo;
+  } else if (mode == "command") {
+    display->mode = kModeCommand;
+  } else {
+    *error = "invalid panel_mode " + mode;
+    return -EINVAL;
+  }
+
+  return 0;
+}
+
+int ParseHWResource(const Json::Value &value, HWResourceInfo *hw_resource, std::string *error) {
+  if (!value.isObject() || !ParseUInt(value, "vig", &hw_resource->num_vig_pipe) ||
+      !ParseUInt(value, "rgb", &hw_resource->num_rgb_pipe) ||
+      !ParseUInt(value, "dma", &hw_resource->num_dma_pipe) ||
+      !ParseUInt(value, "blending_stages", &hw_resource->num_blending_stages) ||
+      !ParseUInt(value, "max_mixer_width", &hw_resource->max_mixer_width) ||
+      !ParseUInt(value, "max_pipe_width", &hw_resource->max_pipe_width) ||
+      !ParseUInt(value, "max_scale_up", &hw_resource->max_scale_up) ||
+      !ParseUInt(value, "max_scale_down", &hw_resource->max_scale_down) ||
+      !ParseBool(value, "src_split", &hw_resource->is_src_split) ||
+      !ParseBool(value, "ubwc", &hw_resource->has_ubwc)) {
+    *error = "invalid hw";
+    return -EINVAL;
+  }
+
+  if (!(hw_resource->num_vig_pipe + hw_resource->num_rgb_pipe + hw_resource->num_dma_pipe)) {
+    *error = "hw has no pipes";
+    return -EINVAL;
+  }
+
+  return 0;
+}
+
+int ParseLayer(const Json::Value &value, uint32_t index, const TraceDisplay &display,
+               Layer *layer, std::string *error) {
+  std::string where = "layer " + std::to_string(index);
+  if (!value.isObject()) {
+    *error = where + " is not an object";
+    return -EINVAL;
+  }
+
+  uint32_t id = index + 1;
+  if (!ParseUInt(value, "id", &id)) {
+    *error = where + " has an invalid id";
+    return -EINVAL;
+  }
+  layer->layer_id = id;
+  layer->layer_name = where;
+  if (!ParseString(value, "name", &layer->layer_name)) {
+    *error = where + " has an invalid name";
+    return -EINVAL;
+  }
+
+  layer->dst_rect = {0.0f, 0.0f, FLOAT(display.width), FLOAT(display.height)};
+  if (value.isMember("dst") && !ParseRect(value["dst"], &layer->dst_rect)) {
+    *error = where + " has an invalid dst";
+    return -EINVAL;
+  }
+
+  LayerBufferFormat format = kFormatRGBA8888;
+  std::string format_name = GetFormatString(format);
+  if (!ParseString(value, "format", &format_name) || !FindFormat(format_name, &format)) {
+    *error = where + " has an unknown format";
+    return -EINVAL;
+  }
+
+  uint32_t width = UINT32(layer->dst_rect.right - layer->dst_rect.left);
+  uint32_t height = UINT32(layer->dst_rect.bottom - layer->dst_rect.top);
+  if (value.isMember("buffer")) {
+    const Json::Value &size = value["buffer"];
+    if (!size.isArray() || size.size() != 2 || !size[0].isUInt() || !size[1].isUInt() ||
+        !size[0].asUInt() || !size[1].asUInt()) {
+      *error = where + " has an invalid buffer size";
+      return -EINVAL;
+    }
+    width = size[0].asUInt();
+    height = size[1].asUInt();
+  }
+  SetBuffer(format, width, height, &layer->input_buffer);
+
+  layer->src_rect = {0.0f, 0.0f, FLOAT(width), FLOAT(height)};
+  if (value.isMember("src") && !ParseRect(value["src"], &layer->src_rect)) {
+    *error = where + " has an invalid src";
+    return -EINVAL;
+  }
+
+  layer->dirty_regions = {layer->src_rect};
+  if (value.isMember("dirty") && !ParseRects(value["dirty"], &layer->dirty_regions)) {
+    *error = where + " has an invalid dirty region";
+    return -EINVAL;
+  }
+  layer->visible_regions = {layer->dst_rect};
+
+  std::string blending = "premultiplied";
+  if (!ParseString(value, "blending", &blending)) {
+    *error = where + " has an invalid blending";
+    return -EINVAL;
+  } else if (blending == "premultiplied") {
+    layer->blending = kBlendingPremultiplied;
+  } else if (blending == "opaque") {
+    layer->blending = kBlendingOpaque;
+  } else if (blending == "coverage") {
+    layer->blending = kBlendingCoverage;
+  } else {
+    *error = where + " has an invalid blending " + blending;
+    return -EINVAL;
+  }
+
+  uint32_t alpha = 0xff;
+  uint32_t rotation = 0;
+  bool updating = true;
+  bool skip = false;
+  bool video = layer->input_buffer.flags.video;
+  if (!ParseUInt(value, "alpha", &alpha) || alpha > 0xff ||
+      !ParseUInt(value, "rotation", &rotation) || (rotation % 90) || rotation >= 360 ||
+      !ParseBool(value, "flip_h", &layer->transform.flip_horizontal) ||
+      !ParseBool(value, "flip_v", &layer->transform.flip_vertical) ||
+      !ParseBool(value, "updating", &updating) || !ParseBool(value, "skip", &skip) ||
+      !ParseBool(value, "video", &video)) {
+    *error = where + " has invalid properties";
+    return -EINVAL;
+  }
+  layer->plane_alpha = UINT8(alpha);
+  layer->transform.rotation = FLOAT(rotation);
+  layer->flags.updating = updating;
+  layer->flags.skip = skip;
+  layer->input_buffer.flags.video = video;
+  layer->frame_rate = display.fps;
+
+  uint64_t buffer_id = id;
+  if (value.isMember("buffer_id")) {
+    if (!value["buffer_id"].isUInt64()) {
+      *error = where + " has an invalid buffer_id";
+      return -EINVAL;
+    }
+    buffer_id = value["buffer_id"].asUInt64();
+  }
+  layer->input_buffer.buffer_id = buffer_id;
+  layer->input_buffer.handle_id = buffer_id;
+
+  return 0;
+}
+
+int ParseFrame(const Json::Value &value, size_t index, const TraceDisplay &display,
+               TraceFrame *frame, std::string *error) {
+  std::string where = "frame " + std::to_string(index);
+  if (!value.isObject() || !value["layers"].isArray() ||
+      !ParseBool(value, "geometry_changed", &frame->geometry_changed) ||
+      !ParseUInt(value, "validate_failures", &frame->validate_failures) ||
+      !ParseUInt(value, "repeat", &frame->repeat) || !frame->repeat) {
+    *error = where + " is invalid";
+    return -EINVAL;
+  }
+
+  const Json::Value &layers = value["layers"];
+  for (Json::ArrayIndex i = 0; i < layers.size(); i++) {
+    Layer layer;
+    int ret = ParseLayer(layers[i], i, display, &layer, error);
+    if (ret) {
+      *error = where + ": " + *error;
+      return ret;
+    }
+    frame->layers.push_back(layer);
+  }
+
+  return 0;
+}
+
+}  // namespace
+
+size_t FrameTrace::GetFrameCount() const {
+  size_t count = 0;
+  for (auto &frame : frames) {
+    count += frame.repeat;
+  }
+
+  return count;
+}
+
+int ParseFrameTrace(const std::string &text, FrameTrace *trace, std::string *error) {
+  std::string ignored;
+  error = error ? error : &ignored;
+
+  Json::CharReaderBuilder builder;
+  std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+  Json::Value root;
+  std::string errors;
+  if (!reader->parse(text.data(), text.data() + text.size(), &root, &errors)) {
+    *error = "malformed json: " + errors;
+    return -EINVAL;
+  }
+
+  if (!root.isObject() || !root["frames"].isArray() || !root["frames"].size()) {
+    *error = "no frames";
+    return -EINVAL;
+  }
+
+  *trace = {};
+  SetDefaultHWResource(&trace->hw_resource);
+  int ret = 0;
+  if (root.isMember("display")) {
+    ret = ParseDisplay(root["display"], &trace->display, error);
+  }
+  if (!ret && root.isMember("hw")) {
+    ret = ParseHWResource(root["hw"], &trace->hw_resource, error);
+  }
+  if (ret) {
+    return ret;
+  }
+  AddPipes(&trace->hw_resource);
+
+  const Json::Value &frames = root["frames"];
+  trace->frames.resize(frames.size());
+  for (Json::ArrayIndex i = 0; i < frames.size(); i++) {
+    ret = ParseFrame(frames[i], i, trace->display, &trace->frames[i], error);
+    if (ret) {
+      return ret;
+    }
+  }
+
+  return 0;
+}
+
+int LoadFrameTrace(const char *path, FrameTrace *trace, std::string *error) {
+  std::ifstream in(path);
+  if (!in.is_open()) {
+    if (error) {
+      *error = std::string("cannot open ") + path;
+    }
+    return -ENOENT;
+  }
+
+  std::stringstream text;
+  text << in.rdbuf();
+
+  return ParseFrameTrace(text.str(), trace, error);
+}
+
+void GenerateFrameTrace(uint32_t frame_count, uint32_t layer_count, uint32_t geometry_period,
+                        FrameTrace *trace) {
+  *trace = {};
+  SetDefaultHWResource(&trace->hw_resource);
+  AddPipes(&trace->hw_resource);
+
+  const TraceDisplay &display = trace->display;
+  float width = FLOAT(display.width);
+  float height = FLOAT(display.height);
+  float band = height / FLOAT(layer_count ? layer_count : 1);
+
+  TraceFrame frame;
+  for (uint32_t i = 0; i < layer_count; i++) {
+    Layer layer;
+    // A full screen layer at the bottom, the others cover the lower part of the display from
+    // one band further down each, like a status bar, app and navigation bar stack.
+    layer.dst_rect = {0.0f, band * FLOAT(i), width, height};
+    uint32_t layer_height = UINT32(layer.dst_rect.bottom - layer.dst_rect.top);
+    SetBuffer(kFormatRGBA8888, display.width, layer_height, &layer.input_buffer);
+    layer.src_rect = {0.0f, 0.0f, width, FLOAT(layer_height)};
+    layer.visible_regions = {layer.dst_rect};
+    layer.blending = i ? kBlendingPremultiplied : kBlendingOpaque;
+    layer.layer_id = i + 1;
+    layer.layer_name = "Synthetic" + std::to_string(i);
+    layer.frame_rate = display.fps;
+    layer.input_buffer.buffer_id = layer.layer_id;
+    layer.input_buffer.handle_id = layer.layer_id;
+    bool top = (i + 1 == layer_count);
+    layer.flags.updating = top;
+    if (top) {
+      layer.dirty_regions = {layer.src_rect};
+    }
+    frame.layers.push_back(layer);
+  }
+
+  for (uint32_t i = 0; i < frame_count; i++) {
+    frame.geometry_changed = !i || (geometry_period && !(i % geometry_period));
+    if (!trace->frames.empty() && !frame.geometry_changed &&
+        !trace->frames.back().geometry_changed) {
+      trace->frames.back().repeat++;
+      continue;
+    }
+    trace->frames.push_back(frame);
+  }
+}
+
+}  // namespace sdm
@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __FRAME_TRACE_H__
+#define __FRAME_TRACE_H__
+
+#include <core/layer_stack.h>
+#include <private/hw_info_types.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// A frame trace is the sequence of layer stacks a client hands to one built-in display, together
+// with the display mode and the SDE resources the stub backend should report. Traces are json:
+//
+// {
+//   "display": {"width": 1080, "height": 2400, "fps": 60, "panel_mode": "video"},
+//   "hw": {"vig": 4, "dma": 4, "blending_stages": 11, "max_mixer_width": 2560, ...},
+//   "frames": [
+//     {"repeat": 120, "geometry_changed": false, "validate_failures": 0, "layers": [
+//       {"id": 1, "name": "Wallpaper", "format": "RGBA_8888", "buffer": [1080, 2400],
+//        "src": [0, 0, 1080, 2400], "dst": [0, 0, 1080, 2400], "dirty": [[0, 0, 1080, 200]],
+//        "blending": "premultiplied", "alpha": 255, "updating": true}
+//     ]}
+//   ]
+// }
+//
+// Everything except the layer list can be left out. Rects are [left, top, right, bottom], src and
+// dirty in buffer space, dst in display space. The client target is not part of the trace, the
+// replayer appends it.
+namespace sdm {
+
+struct TraceDisplay {
+  uint32_t width = 1080;
+  uint32_t height = 2400;
+  uint32_t fps = 60;
+  HWDisplayMode mode = kModeVideo;
+};
+
+struct TraceFrame {
+  std::vector<Layer> layers;
+  bool geometry_changed = false;
+  uint32_t validate_failures = 0;  // Validate() calls the backend rejects before accepting
+  uint32_t repeat = 1;             // Times this frame is replayed back to back
+};
+
+struct FrameTrace {
+  TraceDisplay display;
+  HWResourceInfo hw_resource;
+  std::vector<TraceFrame> frames;
+
+  // Frames after expanding repeats.
+  size_t GetFrameCount() const;
+};
+
+// Parses a json trace. Returns 0 or -EINVAL with the first problem in error.
+int ParseFrameTrace(const std::string &text, FrameTrace *trace, std::string *error);
+int LoadFrameTrace(const char *path, FrameTrace *trace, std::string *error);
+
+// Builds a trace without a recording: layer_count full width layers stacked over the display of
+// which the top one updates every frame, and a geometry change every geometry_period frames
+// (never if 0).
+void GenerateFrameTrace(uint32_t frame_count, uint32_t layer_count, uint32_t geometry_period,
+                        FrameTrace *trace);
+
+}  // namespace sdm
+
+#endif  // __FRAME_TRACE_H__
@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <errno.h>
+#include <utils/constants.h>
+#include <string>
+
+#include <gtest/gtest.h>
+#include "frame_trace.h"
+
+namespace sdm {
+namespace {
+
+const char *kTrace = R"({
+  "display": {"width": 1440, "height": 3200, "fps": 120, "panel_mode": "command"},
+  "hw": {"vig": 2, "dma": 6, "blending_stages": 9, "max_mixer_width": 2048},
+  "frames": [
+    {"geometry_changed": true, "validate_failures": 2, "layers": [
+      {"id": 7, "name": "Video", "format": "Y_CBCR_420_VENUS_UBWC", "buffer": [1920, 1080],
+       "src": [0, 0, 1920, 1080], "dst": [0, 1000, 1440, 1810], "blending": "opaque",
+       "rotation": 90, "buffer_id": 42},
+      {"name": "Controls", "dst": [0, 3000, 1440, 3200], "alpha": 128, "updating": false,
+       "dirty": [[0, 0, 100, 100], [200, 0, 300, 100]]}
+    ]},
+    {"repeat": 30, "layers": []}
+  ]
+})";
+
+}  // namespace
+
+TEST(FrameTraceTest, Parse) {
+  FrameTrace trace;
+  std::string error;
+  ASSERT_EQ(ParseFrameTrace(kTrace, &trace, &error), 0) << error;
+
+  EXPECT_EQ(trace.display.width, 1440u);
+  EXPECT_EQ(trace.display.height, 3200u);
+  EXPECT_EQ(trace.display.fps, 120u);
+  EXPECT_EQ(trace.display.mode, kModeCommand);
+  EXPECT_EQ(trace.hw_resource.num_vig_pipe, 2u);
+  EXPECT_EQ(trace.hw_resource.num_dma_pipe, 6u);
+  EXPECT_EQ(trace.hw_resource.num_blending_stages, 9u);
+  EXPECT_EQ(trace.hw_resource.max_mixer_width, 2048u);
+  EXPECT_EQ(trace.hw_resource.hw_pipes.size(), 8u);
+
+  ASSERT_EQ(trace.frames.size(), 2u);
+  EXPECT_EQ(trace.GetFrameCount(), 31u);
+  const TraceFrame &frame = trace.frames[0];
+  EXPECT_TRUE(frame.geometry_changed);
+  EXPECT_EQ(frame.validate_failures, 2u);
+  EXPECT_EQ(frame.repeat, 1u);
+  ASSERT_EQ(frame.layers.size(), 2u);
+
+  const Layer &video = frame.layers[0];
+  EXPECT_EQ(video.layer_id, 7u);
+  EXPECT_EQ(video.input_buffer.format, kFormatYCbCr420SPVenusUbwc);
+  EXPECT_EQ(video.input_buffer.unaligned_width, 1920u);
+  EXPECT_TRUE(video.input_buffer.flags.video);
+  EXPECT_EQ(video.input_buffer.buffer_id, 42u);
+  EXPECT_EQ(video.dst_rect.bottom, 1810.0f);
+  EXPECT_EQ(video.transform.rotation, 90.0f);
+  EXPECT_EQ(video.blending, kBlendingOpaque);
+  EXPECT_TRUE(video.flags.updating);
+
+  // Defaults: id from the position, RGBA buffer the size of dst, full damage unless given.
+  const Layer &controls = frame.layers[1];
+  EXPECT_EQ(controls.layer_id, 2u);
+  EXPECT_EQ(controls.input_buffer.format, kFormatRGBA8888);
+  EXPECT_FALSE(controls.input_buffer.flags.video);
+  EXPECT_EQ(controls.input_buffer.unaligned_height, 200u);
+  EXPECT_EQ(controls.src_rect.right, 1440.0f);
+  EXPECT_EQ(controls.plane_alpha, 128u);
+  EXPECT_EQ(controls.blending, kBlendingPremultiplied);
+  EXPECT_FALSE(controls.flags.updating);
+  ASSERT_EQ(controls.dirty_regions.size(), 2u);
+  EXPECT_EQ(controls.dirty_regions[1].left, 200.0f);
+
+  EXPECT_FALSE(trace.frames[1].geometry_changed);
+  EXPECT_EQ(trace.frames[1].repeat, 30u);
+}
+
+TEST(FrameTraceTest, RejectsMalformed) {
+  const char *bad[] = {
+    R"({"frames": []})",
+    R"({"frames": [{"layers": [{"format": "RGBA_9999"}]}]})",
+    R"({"frames": [{"layers": [{"dst": [0, 0, 10]}]}]})",
+    R"({"frames": [{"layers": [{"alpha": 256}]}]})",
+    R"({"frames": [{"layers": [{"rotation": 45}]}]})",
+    R"({"frames": [{"layers": [{"blending": "additive"}]}]})",
+    R"({"frames": [{"repeat": 0, "layers": []}]})",
+    R"({"display": {"panel_mode": "burst"}, "frames": [{"layers": []}]})",
+    R"({"hw": {"vig": "4"}, "frames": [{"layers": []}]})",
+    R"({"frames": [{"layers": [{"name": 3}]}]})",
+    R"({"frames": )",
+  };
+
+  for (const char *text : bad) {
+    FrameTrace trace;
+    std::string error;
+    EXPECT_EQ(ParseFrameTrace(text, &trace, &error), -EINVAL) << text;
+    EXPECT_FALSE(error.empty());
+  }
+
+  FrameTrace trace;
+  EXPECT_EQ(LoadFrameTrace("/nonexistent/trace.json", &trace, nullptr), -ENOENT);
+}
+
+TEST(FrameTraceTest, Generate) {
+  FrameTrace trace;
+  GenerateFrameTrace(100, 3, 25, &trace);
+
+  // Geometry changes at 0, 25, 50 and 75, each followed by one repeated steady frame.
+  EXPECT_EQ(trace.GetFrameCount(), 100u);
+  ASSERT_EQ(trace.frames.size(), 8u);
+  for (size_t i = 0; i < trace.frames.size(); i++) {
+    const TraceFrame &frame = trace.frames[i];
+    EXPECT_EQ(frame.geometry_changed, !(i % 2)) << i;
+    EXPECT_EQ(frame.repeat, (i % 2) ? 24u : 1u) << i;
+    ASSERT_EQ(frame.layers.size(), 3u);
+    EXPECT_FALSE(frame.layers[0].flags.updating);
+    EXPECT_FALSE(frame.layers[1].flags.updating);
+    EXPECT_TRUE(frame.layers[2].flags.updating);
+  }
+
+  const TraceFrame &frame = trace.frames[0];
+  EXPECT_EQ(frame.layers[0].blending, kBlendingOpaque);
+  EXPECT_EQ(frame.layers[0].dst_rect.bottom, FLOAT(trace.display.height));
+  EXPECT_EQ(frame.layers[2].dst_rect.top, FLOAT(trace.display.height) * 2 / 3);
+  EXPECT_GT(trace.hw_resource.hw_pipes.size(), 0u);
+
+  GenerateFrameTrace(10, 1, 0, &trace);
+  ASSERT_EQ(trace.frames.size(), 2u);
+  EXPECT_EQ(trace.frames[1].repeat, 9u);
+}
+
+}  // namespace sdm
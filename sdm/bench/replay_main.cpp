@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+// Replays a frame trace through Prepare() and Commit() of the display core on the stub backend and
+// reports per frame CPU time, heap allocations, strategy retries, device accesses and property
+// reads, so changes to the core can be compared without a device:
+//
+//   sdm_frame_replay [-o frames.csv] [-w warmup] trace.json
+//   sdm_frame_replay [-o frames.csv] [-w warmup] --synthetic <frames> <layers> <geometry period>
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <utils/constants.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "frame_replay.h"
+#include "frame_trace.h"
+
+namespace sdm {
+
+namespace {
+
+void PrintCsv(FILE *file, const std::vector<FrameStats> &stats) {
+  fprintf(file, "frame,prepare_cpu_ns,prepare_wall_ns,commit_cpu_ns,commit_wall_ns,allocs,"
+                "alloc_bytes,validates,retries,sys_calls,property_reads,error\n");
+  for (size_t i = 0; i < stats.size(); i++) {
+    const FrameStats &s = stats[i];
+    fprintf(file, "%zu,%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64
+                  ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%d\n", i, s.prepare_cpu_ns,
+            s.prepare_wall_ns, s.commit_cpu_ns, s.commit_wall_ns, s.allocs, s.alloc_bytes,
+            s.validates, s.retries, s.sys_calls, s.property_reads, s.error);
+  }
+}
+
+void PrintSummary(const char *name, std::vector<uint64_t> values) {
+  if (values.empty()) {
+    return;
+  }
+
+  std::sort(values.begin(), values.end());
+  uint64_t total = 0;
+  for (auto value : values) {
+    total += value;
+  }
+  size_t count = values.size();
+  printf("%-16s mean %10" PRIu64 "  p50 %10" PRIu64 "  p99 %10" PRIu64 "  max %10" PRIu64 "\n",
+         name, total / count, values[count / 2], values[std::min(count - 1, count * 99 / 100)],
+         values.back());
+}
+
+template <class T>
+std::vector<uint64_t> Collect(const std::vector<FrameStats> &stats, T get) {
+  std::vector<uint64_t> values;
+  values.reserve(stats.size());
+  for (const auto &s : stats) {
+    values.push_back(get(s));
+  }
+  return values;
+}
+
+void Usage(const char *name) {
+  fprintf(stderr, "usage: %s [-o frames.csv] [-w warmup] trace.json\n"
+                  "       %s [-o frames.csv] [-w warmup] --synthetic <frames> <layers> <period>\n",
+          name, name);
+}
+
+}  // namespace
+
+int Main(int argc, char **argv) {
+  const char *csv_path = nullptr;
+  const char *trace_path = nullptr;
+  uint32_t warmup = 0;
+  bool synthetic = false;
+  uint32_t frames = 0, layers = 0, period = 0;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-o") && i + 1 < argc) {
+      csv_path = argv[++i];
+    } else if (!strcmp(argv[i], "-w") && i + 1 < argc) {
+      warmup = UINT32(strtoul(argv[++i], nullptr, 0));
+    } else if (!strcmp(argv[i], "--synthetic") && i + 3 < argc) {
+      synthetic = true;
+      frames = UINT32(strtoul(argv[++i], nullptr, 0));
+      layers = UINT32(strtoul(argv[++i], nullptr, 0));
+      period = UINT32(strtoul(argv[++i], nullptr, 0));
+    } else if (argv[i][0] != '-' && !trace_path) {
+      trace_path = argv[i];
+    } else {
+      Usage(argv[0]);
+      return -EINVAL;
+    }
+  }
+
+  FrameTrace trace;
+  if (synthetic) {
+    if (!frames || !layers) {
+      Usage(argv[0]);
+      return -EINVAL;
+    }
+    GenerateFrameTrace(frames, layers, period, &trace);
+  } else if (trace_path) {
+    std::string error;
+    int status = LoadFrameTrace(trace_path, &trace, &error);
+    if (status) {
+      fprintf(stderr, "%s: %s\n", trace_path, error.c_str());
+      return status;
+    }
+  } else {
+    Usage(argv[0]);
+    return -EINVAL;
+  }
+
+  FrameReplay replay(trace);
+  std::vector<FrameStats> stats;
+  int status = replay.Init();
+  if (!status) {
+    status = replay.Run(warmup, &stats);
+  }
+  replay.Deinit();
+  if (status) {
+    return status;
+  }
+
+  if (csv_path) {
+    FILE *file = fopen(csv_path, "w");
+    if (!file) {
+      fprintf(stderr, "Cannot write %s\n", csv_path);
+      return -errno;
+    }
+    PrintCsv(file, stats);
+    fclose(file);
+  }
+
+  printf("%zu frames (%u warmup) on %ux%u@%u\n", stats.size(), warmup, trace.display.width,
+         trace.display.height, trace.display.fps);
+  PrintSummary("prepare cpu ns", Collect(stats, [](const FrameStats &s) {
+    return s.prepare_cpu_ns;
+  }));
+  PrintSummary("commit cpu ns", Collect(stats, [](const FrameStats &s) {
+    return s.commit_cpu_ns;
+  }));
+  PrintSummary("frame wall ns", Collect(stats, [](const FrameStats &s) {
+    return s.prepare_wall_ns + s.commit_wall_ns;
+  }));
+  PrintSummary("allocs", Collect(stats, [](const FrameStats &s) { return s.allocs; }));
+  PrintSummary("alloc bytes", Collect(stats, [](const FrameStats &s) { return s.alloc_bytes; }));
+  PrintSummary("retries", Collect(stats, [](const FrameStats &s) { return s.retries; }));
+  PrintSummary("sys calls", Collect(stats, [](const FrameStats &s) { return s.sys_calls; }));
+  PrintSummary("property reads", Collect(stats, [](const FrameStats &s) {
+    return s.property_reads;
+  }));
+
+  return 0;
+}
+
+}  // namespace sdm
+
+int main(int argc, char **argv) {
+  return sdm::Main(argc, argv);
+}
@@ -0,0 +1,288 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <errno.h>
+#include <utils/debug.h>
+#include <utils/sys.h>
+
+#include "stub_hw.h"
+
+#define __CLASS__ "StubHW"
+
+namespace sdm {
+
+namespace {
+
+const uint32_t kStubDpi = 400;
+
+// Nothing on the frame path should reach a device, these only record that something tried.
+#ifdef TRUSTED_VM
+int StubIoctl(int, unsigned long int, ...) {  // NOLINT
+#else
+int StubIoctl(int, int, ...) {
+#endif
+  StubHW::GetStats().sys_calls++;
+  errno = ENODEV;
+  return -1;
+}
+
+int StubAccess(const char *, int) {
+  StubHW::GetStats().sys_calls++;
+  errno = ENODEV;
+  return -1;
+}
+
+int StubOpen(const char *, int, ...) {
+  StubHW::GetStats().sys_calls++;
+  errno = ENODEV;
+  return -1;
+}
+
+int StubPoll(struct pollfd *, nfds_t, int) {
+  StubHW::GetStats().sys_calls++;
+  errno = ENODEV;
+  return -1;
+}
+
+ssize_t StubPread(int, void *, size_t, off_t) {
+  StubHW::GetStats().sys_calls++;
+  errno = ENODEV;
+  return -1;
+}
+
+ssize_t StubPwrite(int, const void *, size_t, off_t) {
+  StubHW::GetStats().sys_calls++;
+  errno = ENODEV;
+  return -1;
+}
+
+}  // namespace
+
+const FrameTrace *StubHW::trace_ = nullptr;
+std::atomic<uint32_t> StubHW::reject_validates_ {0};
+StubHWStats StubHW::stats_;
+
+void StubHW::Install(const FrameTrace *trace) {
+  trace_ = trace;
+  Sys::ioctl_ = StubIoctl;
+  Sys::access_ = StubAccess;
+  Sys::open_ = StubOpen;
+  Sys::poll_ = StubPoll;
+  Sys::pread_ = StubPread;
+  Sys::pwrite_ = StubPwrite;
+}
+
+bool StubHW::ConsumeReject() {
+  uint32_t count = reject_validates_;
+  while (count && !reject_validates_.compare_exchange_weak(count, count - 1)) {}
+  return (count != 0);
+}
+
+DisplayError StubHWInfo::GetHWResourceInfo(HWResourceInfo *hw_resource) {
+  *hw_resource = StubHW::GetTrace()->hw_resource;
+  return kErrorNone;
+}
+
+DisplayError StubHWInfo::GetFirstDisplayInterfaceType(HWDisplayInterfaceInfo *hw_disp_info) {
+  hw_disp_info->type = kBuiltIn;
+  hw_disp_info->is_connected = true;
+  return kErrorNone;
+}
+
+DisplayError StubHWInfo::GetDisplaysStatus(HWDisplaysInfo *hw_displays_info) {
+  HWDisplayInfo &info = (*hw_displays_info)[0];
+  info.display_id = 0;
+  info.display_type = kBuiltIn;
+  info.is_connected = true;
+  info.is_primary = true;
+  info.max_linewidth = StubHW::GetTrace()->hw_resource.max_mixer_width;
+  return kErrorNone;
+}
+
+DisplayError StubHWInfo::GetMaxDisplaysSupported(DisplayType type, int32_t *max_displays) {
+  *max_displays = (type == kBuiltIn) ? 1 : 0;
+  return kErrorNone;
+}
+
+DisplayError StubHWDevice::Init() {
+  const FrameTrace *trace = StubHW::GetTrace();
+  if (!trace) {
+    DLOGE("No trace installed");
+    return kErrorNotSupported;
+  }
+
+  const TraceDisplay &display = trace->display;
+  uint32_t max_mixer_width = trace->hw_resource.max_mixer_width;
+  display_attributes_.x_pixels = display.width;
+  display_attributes_.y_pixels = display.height;
+  display_attributes_.x_dpi = kStubDpi;
+  display_attributes_.y_dpi = kStubDpi;
+  display_attributes_.fps = display.fps;
+  display_attributes_.vsync_period_ns = UINT32(1000000000L / display.fps);
+  display_attributes_.h_total = display.width;
+  display_attributes_.v_total = display.height;
+  display_attributes_.smart_panel = (display.mode == kModeCommand);
+  display_attributes_.is_device_split = (max_mixer_width && display.width > max_mixer_width);
+  display_attributes_.topology = display_attributes_.is_device_split ? kDualLM : kSingleLM;
+  display_attributes_.topology_num_split = display_attributes_.is_device_split ? 2 : 1;
+
+  mixer_attributes_.width = display.width;
+  mixer_attributes_.height = display.height;
+  mixer_attributes_.split_type = display_attributes_.is_device_split ? kDualSplit : kNoSplit;
+  mixer_attributes_.split_left = display_attributes_.is_device_split ? display.width / 2 :
+                                                                       display.width;
+
+  hw_panel_info_.port = kPortDSI;
+  hw_panel_info_.mode = display.mode;
+  hw_panel_info_.min_fps = display.fps;
+  hw_panel_info_.max_fps = display.fps;
+  hw_panel_info_.is_primary_panel = true;
+  hw_panel_info_.split_info.left_split = mixer_attributes_.split_left;
+  hw_panel_info_.split_info.right_split = display.width - mixer_attributes_.split_left;
+  snprintf(hw_panel_info_.panel_name, sizeof(hw_panel_info_.panel_name), "stub %ux%u@%u",
+           display.width, display.height, display.fps);
+
+  return kErrorNone;
+}
+
+DisplayError StubHWDevice::GetDisplayId(int32_t *display_id) {
+  *display_id = display_id_;
+  return kErrorNone;
+}
+
+DisplayError StubHWDevice::GetActiveConfig(uint32_t *active_config) {
+  *active_config = 0;
+  return kErrorNone;
+}
+
+DisplayError StubHWDevice::GetDefaultConfig(uint32_t *default_config) {
+  *default_config = 0;
+  return kErrorNone;
+}
+
+DisplayError StubHWDevice::GetNumDisplayAttributes(uint32_t *count) {
+  *count = 1;
+  return kErrorNone;
+}
+
+DisplayError StubHWDevice::GetDisplayAttributes(uint32_t index,
+                                                HWDisplayAttributes *display_attributes) {
+  if (index != 0) {
+    return kErrorParameters;
+  }
+  *display_attributes = display_attributes_;
+  return kErrorNone;
+}
+
+DisplayError StubHWDevice::GetHWPanelInfo(HWPanelInfo *panel_info) {
+  *panel_info = hw_panel_info_;
+  return kErrorNone;
+}
+
+DisplayError StubHWDevice::SetDisplayAttributes(uint32_t index) {
+  return (index == 0) ? kErrorNone : kErrorParameters;
+}
+
+DisplayError StubHWDevice::Validate(HWLayersInfo *hw_layers_info) {
+  StubHWStats &stats = StubHW::GetStats();
+  stats.validates++;
+  if (StubHW::ConsumeReject()) {
+    stats.rejected_validates++;
+    return kErrorNotValidated;
+  }
+  return kErrorNone;
+}
+
+DisplayError StubHWDevice::Commit(HWLayersInfo *hw_layers_info) {
+  StubHW::GetStats().commits++;
+  return kErrorNone;
+}
+
+DisplayError StubHWDevice::SetDisplayMode(const HWDisplayMode hw_display_mode) {
+  hw_panel_info_.mode = hw_display_mode;
+  return kErrorNone;
+}
+
+DisplayError StubHWDevice::SetRefreshRate(uint32_t refresh_rate) {
+  return (refresh_rate == display_attributes_.fps) ? kErrorNone : kErrorNotSupported;
+}
+
+DisplayError StubHWDevice::SetMixerAttributes(const HWMixerAttributes &mixer_attributes) {
+  mixer_attributes_ = mixer_attributes;
+  return kErrorNone;
+}
+
+DisplayError StubHWDevice::GetMixerAttributes(HWMixerAttributes *mixer_attributes) {
+  *mixer_attributes = mixer_attributes_;
+  return kErrorNone;
+}
+
+DisplayError StubHWDevice::GetFeatureSupportStatus(const HWFeature feature, uint32_t *status) {
+  *status = 0;
+  return kErrorNone;
+}
+
+// The harness links these in place of the DAL's factories.
+int32_t HWInfoInterface::ref_count_ = 0;
+HWInfoInterface *HWInfoInterface::intf_ = nullptr;
+
+DisplayError HWInfoInterface::Create(HWInfoInterface **intf) {
+  if (!intf_) {
+    intf_ = new StubHWInfo();
+  }
+  ref_count_++;
+  *intf = intf_;
+  return kErrorNone;
+}
+
+DisplayError HWInfoInterface::Destroy(HWInfoInterface *intf) {
+  if (ref_count_ > 0 && !--ref_count_) {
+    delete intf_;
+    intf_ = nullptr;
+  }
+  return kErrorNone;
+}
+
+DisplayError HWInterface::Create(int32_t display_id, DisplayType type,
+                                 HWInfoInterface *hw_info_intf,
+                                 BufferAllocator *buffer_allocator, HWInterface **intf) {
+  if (type != kBuiltIn) {
+    DLOGE("Only built-in displays are stubbed, type %d", type);
+    return kErrorNotSupported;
+  }
+
+  HWInterface *hw = new StubHWDevice(display_id);
+  DisplayError error = hw->Init();
+  if (error != kErrorNone) {
+    delete hw;
+    return error;
+  }
+  *intf = hw;
+
+  return kErrorNone;
+}
+
+DisplayError HWInterface::Destroy(HWInterface *intf) {
+  if (intf) {
+    intf->Deinit();
+    delete intf;
+  }
+  return kErrorNone;
+}
+
+DisplayError HWEventsInterface::Create(int display_id, DisplayType display_type,
+                                       HWEventHandler *event_handler,
+                                       const std::vector<HWEvent> &event_list,
+                                       const HWInterface *hw_intf, HWEventsInterface **intf) {
+  *intf = new StubHWEvents();
+  return kErrorNone;
+}
+
+DisplayError HWEventsInterface::Destroy(HWEventsInterface *intf) {
+  delete intf;
+  return kErrorNone;
+}
+
+}  // namespace sdm
@@ -0,0 +1,190 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __STUB_HW_H__
+#define __STUB_HW_H__
+
+#include <private/hw_events_interface.h>
+#include <private/hw_info_interface.h>
+#include <private/hw_interface.h>
+#include <atomic>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "frame_trace.h"
+
+// Backend that stands in for the DAL when the core is linked into sdm_frame_replay. It provides
+// HWInfoInterface::Create(), HWInterface::Create() and HWEventsInterface::Create() for one
+// built-in display described by a FrameTrace, and accepts every frame without touching a device.
+namespace sdm {
+
+struct StubHWStats {
+  std::atomic<uint64_t> validates {0};
+  std::atomic<uint64_t> rejected_validates {0};
+  std::atomic<uint64_t> commits {0};
+  std::atomic<uint64_t> sys_calls {0};  // Device accesses through the Sys table
+};
+
+class StubHW {
+ public:
+  // Makes the factories return stubs for trace, and points the device facing entries of the Sys
+  // table at stubs that fail with ENODEV and count in stats. Call before creating the core.
+  static void Install(const FrameTrace *trace);
+  // The next count Validate() calls fail, like a commit the driver rejects.
+  static void RejectValidates(uint32_t count) { reject_validates_ = count; }
+  static StubHWStats &GetStats() { return stats_; }
+  static const FrameTrace *GetTrace() { return trace_; }
+  static bool ConsumeReject();
+
+ private:
+  static const FrameTrace *trace_;
+  static std::atomic<uint32_t> reject_validates_;
+  static StubHWStats stats_;
+};
+
+class StubHWInfo : public HWInfoInterface {
+ public:
+  virtual DisplayError Init() { return kErrorNone; }
+  virtual DisplayError GetHWResourceInfo(HWResourceInfo *hw_resource);
+  virtual DisplayError GetFirstDisplayInterfaceType(HWDisplayInterfaceInfo *hw_disp_info);
+  virtual DisplayError GetDisplaysStatus(HWDisplaysInfo *hw_displays_info);
+  virtual DisplayError GetMaxDisplaysSupported(DisplayType type, int32_t *max_displays);
+  virtual DisplayError GetRequiredDemuraFetchResourceCount(
+      std::map<uint32_t, uint8_t> *required_demura_fetch_cnt) {
+    return kErrorNotSupported;
+  }
+  virtual DisplayError GetDemuraPanelIds(std::vector<uint64_t> *panel_ids) {
+    return kErrorNotSupported;
+  }
+  virtual DisplayError GetPanelBootParamString(std::string *panel_boot_param_string) {
+    return kErrorNotSupported;
+  }
+  virtual uint32_t GetMaxMixerCount() { return 2; }
+};
+
+class StubHWDevice : public HWInterface {
+ public:
+  explicit StubHWDevice(int32_t display_id) : display_id_(display_id) {}
+  virtual DisplayError Init();
+  virtual DisplayError Deinit() { return kErrorNone; }
+  virtual DisplayError GetDisplayId(int32_t *display_id);
+  virtual DisplayError GetActiveConfig(uint32_t *active_config);
+  virtual DisplayError GetDefaultConfig(uint32_t *default_config);
+  virtual DisplayError GetNumDisplayAttributes(uint32_t *count);
+  virtual DisplayError GetDisplayAttributes(uint32_t index,
+                                            HWDisplayAttributes *display_attributes);
+  virtual DisplayError GetHWPanelInfo(HWPanelInfo *panel_info);
+  virtual DisplayError SetDisplayAttributes(uint32_t index);
+  virtual DisplayError SetDisplayAttributes(const HWDisplayAttributes &display_attributes) {
+    return kErrorNotSupported;
+  }
+  virtual DisplayError GetConfigIndex(char *mode, uint32_t *index) { return kErrorNotSupported; }
+  virtual DisplayError PowerOn(const HWQosData &qos_data, SyncPoints *sync_points) {
+    return kErrorNone;
+  }
+  virtual DisplayError PowerOff(bool teardown, SyncPoints *sync_points) { return kErrorNone; }
+  virtual DisplayError Doze(const HWQosData &qos_data, SyncPoints *sync_points) {
+    return kErrorNone;
+  }
+  virtual DisplayError DozeSuspend(const HWQosData &qos_data, SyncPoints *sync_points) {
+    return kErrorNone;
+  }
+  virtual DisplayError Standby(SyncPoints *sync_points) { return kErrorNone; }
+  virtual DisplayError Validate(HWLayersInfo *hw_layers_info);
+  virtual DisplayError Commit(HWLayersInfo *hw_layers_info);
+  virtual DisplayError Flush(HWLayersInfo *hw_layers_info) { return kErrorNone; }
+  virtual DisplayError GetPPFeaturesVersion(PPFeatureVersion *vers) { return kErrorNotSupported; }
+  virtual DisplayError SetPPFeature(PPFeatureInfo *feature) { return kErrorNotSupported; }
+  virtual DisplayError SetVSyncState(bool enable) { return kErrorNone; }
+  virtual void SetIdleTimeoutMs(uint32_t timeout_ms) {}
+  virtual DisplayError SetDisplayMode(const HWDisplayMode hw_display_mode);
+  virtual DisplayError SetBppMode(uint32_t bpp) { return kErrorNotSupported; }
+  virtual DisplayError SetRefreshRate(uint32_t refresh_rate);
+  virtual DisplayError SetPanelBrightness(int level) { return kErrorNone; }
+  virtual DisplayError GetHWScanInfo(HWScanInfo *scan_info) { return kErrorNotSupported; }
+  virtual DisplayError GetVideoFormat(uint32_t config_index, uint32_t *video_format) {
+    return kErrorNotSupported;
+  }
+  virtual DisplayError GetMaxCEAFormat(uint32_t *max_cea_format) { return kErrorNotSupported; }
+  virtual DisplayError SetCursorPosition(HWLayersInfo *hw_layers_info, int x, int y) {
+    return kErrorNotSupported;
+  }
+  virtual DisplayError OnMinHdcpEncryptionLevelChange(uint32_t min_enc_level) {
+    return kErrorNotSupported;
+  }
+  virtual DisplayError GetPanelBrightness(int *level) { return kErrorNotSupported; }
+  virtual DisplayError SetAutoRefresh(bool enable) { return kErrorNone; }
+  virtual DisplayError SetScaleLutConfig(HWScaleLutInfo *lut_info) { return kErrorNone; }
+  virtual DisplayError UnsetScaleLutConfig() { return kErrorNone; }
+  virtual DisplayError SetMixerAttributes(const HWMixerAttributes &mixer_attributes);
+  virtual DisplayError GetMixerAttributes(HWMixerAttributes *mixer_attributes);
+  virtual DisplayError DumpDebugData() { return kErrorNone; }
+  virtual DisplayError SetDppsFeature(void *payload, size_t size) { return kErrorNotSupported; }
+  virtual DisplayError GetDppsFeatureInfo(void *payload, size_t size) {
+    return kErrorNotSupported;
+  }
+  virtual DisplayError HandleSecureEvent(SecureEvent secure_event, const HWQosData &qos_data) {
+    return kErrorNotSupported;
+  }
+  virtual DisplayError ControlIdlePowerCollapse(bool enable, bool synchronous) {
+    return kErrorNone;
+  }
+  virtual DisplayError SetDisplayDppsAdROI(void *payload) { return kErrorNotSupported; }
+  virtual DisplayError SetJitterConfig(uint32_t jitter_type, float value, uint32_t time) {
+    return kErrorNotSupported;
+  }
+  virtual DisplayError SetDynamicDSIClock(uint64_t bit_clk_rate) { return kErrorNotSupported; }
+  virtual DisplayError GetDynamicDSIClock(uint64_t *bit_clk_rate) { return kErrorNotSupported; }
+  virtual DisplayError GetDisplayIdentificationData(uint8_t *out_port, uint32_t *out_data_size,
+                                                    uint8_t *out_data) {
+    return kErrorNotSupported;
+  }
+  virtual DisplayError SetFrameTrigger(FrameTriggerMode mode) { return kErrorNone; }
+  virtual DisplayError SetBLScale(uint32_t level) { return kErrorNotSupported; }
+  virtual DisplayError GetPanelBlMaxLvl(uint32_t *max_bl) { return kErrorNotSupported; }
+  virtual DisplayError SetPPConfig(void *payload, size_t size) { return kErrorNotSupported; }
+  virtual DisplayError GetPanelBrightnessBasePath(std::string *base_path) const {
+    return kErrorNotSupported;
+  }
+  virtual DisplayError SetBlendSpace(const PrimariesTransfer &blend_space) { return kErrorNone; }
+  virtual DisplayError EnableSelfRefresh(SelfRefreshState self_refresh_state) {
+    return kErrorNone;
+  }
+  virtual PanelFeaturePropertyIntf *GetPanelFeaturePropertyIntf() { return nullptr; }
+  virtual DisplayError GetFeatureSupportStatus(const HWFeature feature, uint32_t *status);
+  virtual void FlushConcurrentWriteback() {}
+  virtual DisplayError SetAlternateDisplayConfig(uint32_t *alt_config) {
+    return kErrorNotSupported;
+  }
+  virtual DisplayError GetQsyncFps(uint32_t *qsync_fps) { return kErrorNotSupported; }
+  virtual DisplayError UpdateTransferTime(uint32_t transfer_time) { return kErrorNotSupported; }
+  virtual DisplayError CancelDeferredPowerMode() { return kErrorNone; }
+  virtual void HandleCwbTeardown(bool sync_teardown) {}
+  virtual void SetDestScalarData(const DestScaleInfoMap dest_scale_info_map) {}
+
+ private:
+  int32_t display_id_ = -1;
+  HWDisplayAttributes display_attributes_ = {};
+  HWMixerAttributes mixer_attributes_ = {};
+  HWPanelInfo hw_panel_info_ = {};
+};
+
+class StubHWEvents : public HWEventsInterface {
+ public:
+  virtual DisplayError Init(int display_id, DisplayType display_type,
+                            HWEventHandler *event_handler, const std::vector<HWEvent> &event_list,
+                            const HWInterface *hw_intf) {
+    return kErrorNone;
+  }
+  virtual DisplayError Deinit() { return kErrorNone; }
+  virtual DisplayError SetEventState(HWEvent event, bool enable, void *aux = nullptr) {
+    return kErrorNone;
+  }
+};
+
+}  // namespace sdm
+
+#endif  // __STUB_HW_H__
@@ -41,6 +41,10 @@
 #include <stdint.h>
 #include <errno.h>
 #include <debug_handler.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
 #include <core/display_interface.h>
 #include <display_properties.h>
 
@@ -48,9 +52,55 @@ namespace sdm {
 
 using display::DebugHandler;
 
+// Values behind the Debug getters, read from the property service in one go. Strings are kept
+// unparsed so malformed values fail in the getter that uses them, like a direct read would.
+struct DebugProperties {
+  static const size_t kValueMax = 92;  // PROPERTY_VALUE_MAX
+
+  int composition_mask = 0;
+  char hdmi_config_index[kValueMax] = {};
+  int idle_time_active_ms = 0;
+  int idle_time_inactive_ms = 0;
+  int disable_rotator_downscale = 0;
+  int enable_rotator_ui = 0;
+  int disable_decimation = 0;
+  int primary_mixer_stages = -1;
+  int external_mixer_stages = -1;
+  int virtual_mixer_stages = -1;
+  int max_upscale = 0;
+  int video_mode_panel = 0;
+  int disable_rotator_ubwc = 0;
+  int disable_rotator_split = 0;
+  int disable_scaler = 0;
+  int disable_ubwc = 0;
+  int disable_avr = 0;
+  int disable_external_animation = 0;
+  int disable_partial_split = 0;
+  int prefer_source_split = 0;
+  char disable_inline_rotator[kValueMax] = "0";
+  char disable_offline_rotator[kValueMax] = "0";
+  bool has_mixer_resolution = false;
+  char mixer_resolution[kValueMax] = {};
+  bool has_window_rect[2] = {};  // Primary, secondary
+  char window_rect[2][kValueMax] = {};
+  bool has_null_display_resolution = false;
+  char null_display_resolution[kValueMax] = {};
+  bool has_simulated_config = false;
+  char simulated_config[kValueMax] = {};
+  int max_secondary_fetch_layers = 0;
+  int cwb_downscale_x = 0;
+  int cwb_downscale_y = 0;
+  int enable_inline_writeback = 0;
+};
+
 class Debug {
  public:
   static inline DebugHandler* Get() { return DebugHandler::Get(); }
+  // The getters below read a snapshot of their properties taken on first use, so they can be
+  // called from the frame path. ReloadProperties() publishes a new one, e.g. on a debug command.
+  // Snapshots are immutable and never freed, so the pointer stays valid after a reload.
+  static const DebugProperties *GetProperties();
+  static void ReloadProperties();
   static int GetSimulationFlag();
   static bool GetExternalResolution(char *val);
   static void GetIdleTimeoutMs(uint32_t *active_ms, uint32_t *inactive_ms);
@@ -76,9 +126,18 @@ class Debug {
   static int GetReducedConfig(uint32_t *num_vig_pipes, uint32_t *num_dma_pipes);
   static int GetSecondaryMaxFetchLayers();
   static bool IsIWEEnabled();
+  // Direct reads from the property service, not for the frame path.
   static int GetProperty(const char *property_name, char *value);
   static int GetProperty(const char *property_name, int *value);
   static void DumpCodeCoverage();
+
+ private:
+  static const DebugProperties *LoadProperties();
+
+  static std::atomic<const DebugProperties *> properties_;
+  // Every snapshot taken, reloads are rare debug commands. Guarded by reload_lock_.
+  static std::vector<std::unique_ptr<const DebugProperties>> snapshots_;
+  static std::mutex reload_lock_;
 };
 
 }  // namespace sdm
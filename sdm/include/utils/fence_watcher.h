@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __FENCE_WATCHER_H__
+#define __FENCE_WATCHER_H__
+
+#include <utils/fence.h>
+#include <stdint.h>
+#include <chrono>
+#include <condition_variable>   // NOLINT
+#include <functional>
+#include <future>   // NOLINT
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <utility>
+
+namespace sdm {
+
+// Single epoll based thread which watches registered fences and invokes their completions on
+// signal or timeout. Callers which only need to act after a fence signals register a callback
+// instead of parking their own thread in Fence::Wait.
+// Any pollable fd which becomes readable on signal can be watched, i.e. sync files or eventfds.
+class FenceWatcher {
+ public:
+  // status is 0 when fence signaled, -ETIME on timeout, or negative errno on poll errors.
+  // Callbacks run on the watcher thread and must not block.
+  typedef std::function<void(int status)> Callback;
+  typedef uint64_t WatchId;
+  static constexpr WatchId kInvalidWatchId = 0;
+
+  static FenceWatcher *GetInstance();
+
+  // Fence is duped internally, caller retains ownership. Null fence is treated as signaled and
+  // callback is invoked synchronously on the caller thread, in which case kInvalidWatchId is
+  // returned. Negative timeout means wait forever.
+  WatchId Watch(const shared_ptr<Fence> &fence, int timeout_ms, Callback callback);
+  WatchId Watch(int fd, int timeout_ms, Callback callback);
+
+  // Returns a future which is ready with the wait status once the fence signals or times out.
+  std::shared_future<int> WaitAsync(const shared_ptr<Fence> &fence, int timeout_ms);
+
+  // Removes a pending watch without invoking its callback. If the callback is being executed on
+  // the watcher thread, blocks until it returns. Returns false if callback has already run.
+  bool Cancel(WatchId id);
+
+  uint32_t GetPendingCount();
+
+ private:
+  typedef std::chrono::steady_clock::time_point TimePoint;
+
+  struct Entry {
+    int fd = -1;
+    bool has_deadline = false;
+    TimePoint deadline = {};
+    Callback callback = nullptr;
+  };
+
+  static constexpr int kMaxEvents = 16;
+
+  FenceWatcher();
+  ~FenceWatcher();
+  FenceWatcher(const FenceWatcher &) = delete;
+  FenceWatcher &operator=(const FenceWatcher &) = delete;
+
+  void WatcherThread();
+  int GetWaitTimeout();
+  void RemoveEntryLocked(WatchId id, std::map<WatchId, Entry>::iterator it);
+  void Wakeup();
+
+  int epoll_fd_ = -1;
+  int wakeup_fd_ = -1;
+  bool exit_ = false;
+  WatchId next_id_ = 1;
+  std::map<WatchId, Entry> entries_ = {};
+  std::set<std::pair<TimePoint, WatchId>> deadlines_ = {};
+  std::set<WatchId> dispatching_ = {};
+  std::mutex mutex_;
+  std::condition_variable running_cv_;
+  std::thread watcher_thread_;
+};
+
+}  // namespace sdm
+
+#endif  // __FENCE_WATCHER_H__
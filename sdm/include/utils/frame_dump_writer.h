@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __FRAME_DUMP_WRITER_H__
+#define __FRAME_DUMP_WRITER_H__
+
+#include <utils/fence.h>
+#include <utils/fence_watcher.h>
+#include <stdint.h>
+#include <condition_variable>   // NOLINT
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace sdm {
+
+// Writes frame dumps to file on a background thread, so that enabling dumps does not change the
+// timing of the composition thread. Callers only dup the buffer fd and its fence. Fences are
+// handed to FenceWatcher, the worker thread only picks up jobs whose fence has signaled, so one
+// slow producer does not hold back dumps queued behind it. Mapping and file I/O happen on the
+// worker thread.
+// Jobs are dropped, not queued, once the pending queue is full or the byte budget is consumed.
+class FrameDumpWriter {
+ public:
+  struct Stats {
+    uint32_t written = 0;
+    uint32_t failed = 0;
+    uint32_t dropped_queue_full = 0;
+    uint32_t dropped_budget = 0;
+    uint64_t bytes_written = 0;
+  };
+
+  static constexpr uint32_t kDefaultMaxPending = 8;
+
+  explicit FrameDumpWriter(uint32_t max_pending = kDefaultMaxPending);
+  ~FrameDumpWriter();
+
+  // Starts a new dump session. Zero byte budget means unlimited. Stats are reset.
+  void SetBudget(uint64_t max_bytes);
+
+  // Dumps size bytes of a dma-buf once fence signals. fd is duped, caller retains ownership.
+  bool QueueBuffer(const std::string &file_name, int fd, uint32_t size,
+                   const shared_ptr<Fence> &fence);
+  // Dumps a copy of data. Used for small payloads and buffers which the caller recycles.
+  bool QueueData(const std::string &file_name, const void *data, size_t size);
+
+  // Blocks until all queued jobs are written.
+  void Flush();
+  Stats GetStats();
+
+ private:
+  struct Job {
+    std::string file_name = "";
+    int fd = -1;
+    uint32_t size = 0;
+    shared_ptr<Fence> fence = nullptr;
+    std::vector<uint8_t> data = {};
+    uint64_t seq = 0;
+    bool ready = false;
+    int status = 0;  // fence wait status, valid once ready
+    FenceWatcher::WatchId watch_id = FenceWatcher::kInvalidWatchId;
+  };
+
+  FrameDumpWriter(const FrameDumpWriter &) = delete;
+  FrameDumpWriter &operator=(const FrameDumpWriter &) = delete;
+
+  bool ReserveLocked(size_t size);
+  void OnFenceDone(uint64_t seq, int status);
+  bool HasReadyJobLocked();
+  void WriterThread();
+  int WriteJob(const Job &job);
+  int WriteFile(const std::string &file_name, const void *data, size_t size);
+
+  uint32_t max_pending_ = kDefaultMaxPending;
+  uint64_t max_bytes_ = 0;
+  uint64_t reserved_bytes_ = 0;
+  uint64_t next_seq_ = 1;
+  bool busy_ = false;
+  bool exit_ = false;
+  Stats stats_ = {};
+  std::deque<Job> jobs_ = {};
+  std::mutex mutex_;
+  std::condition_variable job_cv_;
+  std::condition_variable idle_cv_;
+  std::thread writer_thread_;
+};
+
+}  // namespace sdm
+
+#endif  // __FRAME_DUMP_WRITER_H__
@@ -125,6 +125,34 @@ class Locker {
     Locker &locker_;
   };
 
+  // Acquires lockers selected by mask in ascending index order and releases them in reverse
+  // order. Paths which need to hold more than one locker of an array must use this, so that they
+  // can not deadlock against each other.
+  class MultiScopeLock {
+   public:
+    MultiScopeLock(Locker *lockers, uint32_t count, uint64_t mask)
+      : lockers_(lockers), count_(count), mask_(mask) {
+      for (uint32_t i = 0; i < count_; i++) {
+        if (mask_ & (1ULL << i)) {
+          lockers_[i].Lock();
+        }
+      }
+    }
+
+    ~MultiScopeLock() {
+      for (uint32_t i = count_; i > 0; i--) {
+        if (mask_ & (1ULL << (i - 1))) {
+          lockers_[i - 1].Unlock();
+        }
+      }
+    }
+
+   private:
+    Locker *lockers_;
+    uint32_t count_;
+    uint64_t mask_;
+  };
+
   Locker() : sequence_wait_(0) {
 #ifdef SDM_VIRTUAL_DRIVER
     pthread_mutexattr_t attr;
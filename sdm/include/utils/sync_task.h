@@ -27,18 +27,33 @@
 * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+/*
+ * Changes from Qualcomm Innovation Center are provided under the following license:
+ *
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
 #ifndef __SYNC_TASK_H__
 #define __SYNC_TASK_H__
 
+#include <stdint.h>
 #include <thread>
 #include <mutex>
 #include <condition_variable>   // NOLINT
+#include <deque>
+#include <utility>
 
 namespace sdm {
 
+// Runs tasks in order on a dedicated worker thread, i.e. for work bound to a thread local EGL
+// context. PerformTask blocks until the task is done. PostTask queues the task and returns right
+// away, so that the caller can overlap its own work and wait for completion later.
 template <class TaskCode>
 class SyncTask {
  public:
+  typedef uint64_t TaskId;
+
   // This class need to be overridden by caller to pass on a task context.
   class TaskContext {
    public:
@@ -52,44 +67,54 @@ class SyncTask {
     virtual void OnTask(const TaskCode &task_code, TaskContext *task_context) = 0;
   };
 
-  explicit SyncTask(TaskHandler &task_handler) : task_handler_(task_handler) {
-    // Block caller thread until worker thread has started and ready to listen to task commands.
-    // Worker thread will signal as soon as callback is received in the new thread.
-    std::unique_lock<std::mutex> caller_lock(caller_mutex_);
-    std::thread worker_thread(SyncTaskThread, this);
-    worker_thread_.swap(worker_thread);
-    caller_cv_.wait(caller_lock);
+  static const uint32_t kMaxPendingTasks = 4;
+
+  explicit SyncTask(TaskHandler &task_handler, uint32_t max_pending = kMaxPendingTasks)
+    : task_handler_(task_handler), max_pending_(max_pending ? max_pending : 1) {
+    // Tasks posted before the worker starts listening stay in the queue, no handshake needed.
+    worker_thread_ = std::thread(SyncTaskThread, this);
   }
 
   ~SyncTask() {
-    // Task code does not matter here.
-    PerformTask(task_code_, nullptr, true);
+    // Worker drains already queued tasks before exiting.
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      worker_thread_exit_ = true;
+    }
+    worker_cv_.notify_one();
     worker_thread_.join();
   }
 
   void PerformTask(const TaskCode &task_code, TaskContext *task_context) {
-    PerformTask(task_code, task_context, false);
+    WaitTask(PostTask(task_code, task_context));
   }
 
- private:
-  void PerformTask(const TaskCode &task_code, TaskContext *task_context, bool terminate) {
-    std::unique_lock<std::mutex> caller_lock(caller_mutex_);
+  // Task context must stay valid until the task completes. Blocks while the queue is full.
+  TaskId PostTask(const TaskCode &task_code, TaskContext *task_context) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    caller_cv_.wait(lock, [this] { return pending_tasks_.size() < max_pending_; });
+    pending_tasks_.push_back(std::make_pair(task_code, task_context));
+    TaskId task_id = ++last_posted_;
+    lock.unlock();
+    worker_cv_.notify_one();
 
-    // New scope to limit scope of worker lock to this block.
-    {
-      // Set task command code and notify worker thread.
-      std::unique_lock<std::mutex> worker_lock(worker_mutex_);
-      task_code_ = task_code;
-      task_context_ = task_context;
-      worker_thread_exit_ = terminate;
-      pending_code_ = true;
-      worker_cv_.notify_one();
-    }
+    return task_id;
+  }
 
-    // Wait for worker thread to finish and signal.
-    caller_cv_.wait(caller_lock);
+  void WaitTask(TaskId task_id) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    caller_cv_.wait(lock, [this, task_id] { return last_completed_ >= task_id; });
   }
 
+  void Flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    TaskId task_id = last_posted_;
+    caller_cv_.wait(lock, [this, task_id] { return last_completed_ >= task_id; });
+  }
+
+ private:
+  typedef std::pair<TaskCode, TaskContext *> Task;
+
   static void SyncTaskThread(SyncTask *sync_task) {
     if (sync_task) {
       sync_task->OnThreadCallback();
@@ -97,45 +122,46 @@ class SyncTask {
   }
 
   void OnThreadCallback() {
-    // Acquire worker lock and start waiting for events.
-    // Wait must start before caller thread can post events, otherwise posted events will be lost.
-    // Caller thread will be blocked until worker thread signals readiness.
-    std::unique_lock<std::mutex> worker_lock(worker_mutex_);
+    std::deque<Task> tasks;
+    std::unique_lock<std::mutex> lock(mutex_);
 
-    // New scope to limit scope of caller lock to this block.
-    {
-      // Signal caller thread that worker thread is ready to listen to events.
-      std::unique_lock<std::mutex> caller_lock(caller_mutex_);
-      caller_cv_.notify_one();
-    }
-
-    while (!worker_thread_exit_) {
+    while (true) {
       // Add predicate to handle spurious interrupts.
-      // Wait for caller thread to signal new command codes.
-      worker_cv_.wait(worker_lock, [this] { return pending_code_; });
+      worker_cv_.wait(lock, [this] { return worker_thread_exit_ || !pending_tasks_.empty(); });
+      if (pending_tasks_.empty()) {
+        break;
+      }
+
+      // Consecutive tasks are run as one batch, without handing off to callers in between.
+      tasks.swap(pending_tasks_);
+      lock.unlock();
+      caller_cv_.notify_all();
 
-      // Call task handler which is implemented by the caller.
-      if (!worker_thread_exit_) {
-        task_handler_.OnTask(task_code_, task_context_);
+      uint32_t num_tasks = 0;
+      for (auto &task : tasks) {
+        // Call task handler which is implemented by the caller.
+        task_handler_.OnTask(task.first, task.second);
+        num_tasks++;
       }
+      tasks.clear();
 
-      pending_code_ = false;
-      // Notify completion of current task to the caller thread which is blocked.
-      std::unique_lock<std::mutex> caller_lock(caller_mutex_);
-      caller_cv_.notify_one();
+      lock.lock();
+      last_completed_ += num_tasks;
+      // Notify completion to the caller threads which are waiting.
+      caller_cv_.notify_all();
     }
   }
 
   TaskHandler &task_handler_;
-  TaskCode task_code_;
-  TaskContext *task_context_ = nullptr;
+  uint32_t max_pending_ = kMaxPendingTasks;
+  std::deque<Task> pending_tasks_;
+  TaskId last_posted_ = 0;
+  TaskId last_completed_ = 0;
   std::thread worker_thread_;
-  std::mutex caller_mutex_;
-  std::mutex worker_mutex_;
+  std::mutex mutex_;
   std::condition_variable caller_cv_;
   std::condition_variable worker_cv_;
   bool worker_thread_exit_ = false;
-  bool pending_code_ = false;
 };
 
 }  // namespace sdm
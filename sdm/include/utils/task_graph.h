@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __TASK_GRAPH_H__
+#define __TASK_GRAPH_H__
+
+#include <core/sdm_types.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <chrono>
+#include <condition_variable>   // NOLINT
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace sdm {
+
+// One shot graph of startup stages. Every stage runs on its own thread as soon as the stages it
+// depends on completed, so independent ioctl, sysfs and dlopen bound work overlaps. Work which
+// shares state that is not thread safe belongs in one stage. A stage whose
+// dependency failed is skipped and reports that error. Stages may only depend on stages added
+// before them, which keeps the graph acyclic.
+class TaskGraph {
+ public:
+  typedef uint32_t TaskId;
+  typedef std::function<DisplayError()> Task;
+
+  static const TaskId kInvalidTaskId = UINT32_MAX;
+
+  TaskId Add(const char *name, Task task, const std::vector<TaskId> &dependencies = {}) {
+    Stage stage = {};
+    stage.name = name;
+    stage.task = std::move(task);
+    for (TaskId dependency : dependencies) {
+      if (dependency < stages_.size()) {
+        stage.dependencies.push_back(dependency);
+      }
+    }
+    stages_.push_back(std::move(stage));
+
+    return TaskId(stages_.size() - 1);
+  }
+
+  // Blocks until every stage completed or was skipped.
+  void Run() {
+    start_ = Clock::now();
+    std::vector<std::thread> threads;
+    threads.reserve(stages_.size());
+    for (TaskId id = 0; id < stages_.size(); id++) {
+      threads.emplace_back(&TaskGraph::RunStage, this, id);
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    end_ = Clock::now();
+  }
+
+  DisplayError GetError(TaskId id) {
+    return (id < stages_.size()) ? stages_[id].error : kErrorParameters;
+  }
+
+  // Per stage timing relative to Run(), in the order stages were added.
+  std::string Dump() {
+    std::string dump = "total " + std::to_string(ToUs(end_ - start_)) + " us";
+    for (auto &stage : stages_) {
+      char line[128];
+      if (stage.skipped) {
+        snprintf(line, sizeof(line), "; %s skipped (error %d)", stage.name, stage.error);
+      } else {
+        snprintf(line, sizeof(line), "; %s start %lld us took %lld us%s", stage.name,
+                 static_cast<long long>(ToUs(stage.start - start_)),
+                 static_cast<long long>(ToUs(stage.end - stage.start)),
+                 stage.error != kErrorNone ? " failed" : "");
+      }
+      dump += line;
+    }
+
+    return dump;
+  }
+
+ private:
+  typedef std::chrono::steady_clock Clock;
+
+  struct Stage {
+    const char *name;
+    Task task;
+    std::vector<TaskId> dependencies;
+    DisplayError error;
+    bool done;
+    bool skipped;
+    Clock::time_point start;
+    Clock::time_point end;
+  };
+
+  static int64_t ToUs(Clock::duration duration) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+  }
+
+  void RunStage(TaskId id) {
+    Stage &stage = stages_[id];
+    DisplayError error = kErrorNone;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      for (TaskId dependency : stage.dependencies) {
+        cv_.wait(lock, [this, dependency] { return stages_[dependency].done; });
+        if (error == kErrorNone) {
+          error = stages_[dependency].error;
+        }
+      }
+    }
+
+    bool skipped = (error != kErrorNone);
+    Clock::time_point start = Clock::now();
+    if (!skipped) {
+      error = stage.task();
+    }
+    Clock::time_point end = Clock::now();
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stage.error = error;
+      stage.skipped = skipped;
+      stage.start = start;
+      stage.end = end;
+      stage.done = true;
+    }
+    cv_.notify_all();
+  }
+
+  std::vector<Stage> stages_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  Clock::time_point start_;
+  Clock::time_point end_;
+};
+
+}  // namespace sdm
+
+#endif  // __TASK_GRAPH_H__
@@ -256,44 +256,71 @@ ColorManagerProxy *ColorManagerProxy::CreateColorManagerProxy(DisplayType type,
       return color_manager_proxy;
     }
 
-    // 3. instantiate concrete create_stc_intf_ from libsnapdragoncolor_manager.so
-    color_manager_proxy->stc_intf_ = create_stc_intf_(STC_REVISION_MAJOR, STC_REVISION_MINOR);
-    if (!color_manager_proxy->stc_intf_) {
-      DLOGW("Unable to instantiate concrete StcInterface from %s", STCMGR_LIBRARY_NAME);
-      delete color_manager_proxy;
-      color_manager_proxy = NULL;
-      return color_manager_proxy;
-    } else {
-      int err = color_manager_proxy->stc_intf_->Init(hw_attr.panel_name);
-      if (err) {
-        DLOGW("Failed to init Stc interface, err %d", err);
-        delete color_manager_proxy->stc_intf_;
-        color_manager_proxy->stc_intf_ = NULL;
-      } else {
-        // pass the display interface to STC manager for digital dimming
-        ScPayload payload;
-        payload.len = sizeof(disp_intf);
-        payload.prop = snapdragoncolor::kDisplayIntf;
-        payload.payload = reinterpret_cast<uint64_t>(disp_intf);
-        int ret = color_manager_proxy->stc_intf_->SetProperty(payload);
-        if (ret) {
-          DLOGW("Failed to SetProperty, property = %d error = %d", payload.prop, ret);
-        }
-      }
-
-      if (color_manager_proxy->HasNativeModeSupport()) {
-        color_manager_proxy->curr_mode_.gamut = allow_tonemap_native ?
-                                                ColorPrimaries_BT709_5 : ColorPrimaries_Max;
-        color_manager_proxy->curr_mode_.gamma = allow_tonemap_native ?
-                                                Transfer_sRGB : Transfer_Max;
-        color_manager_proxy->curr_mode_.intent = snapdragoncolor::kNative;
-      }
-    }
+    // 3. The Stc interface is created by GetStcIntf() on the first client request that needs
+    // the panel's mode assets, see GetStcIntf().
+    color_manager_proxy->disp_intf_ = disp_intf;
+    color_manager_proxy->allow_tonemap_native_ = allow_tonemap_native;
   }
 
   return color_manager_proxy;
 }
 
+// Returns the Stc interface, creating it on the first call with create set. Creating it loads
+// the mode assets of the panel, so only client requests (mode list and mode set, color
+// transform, calibration, render intent queries, LTM PCC) pass create. The per frame calls
+// pass false and never wait on init_lock_, they skip their Stc work until the assets are
+// loaded.
+ScPostBlendInterface *ColorManagerProxy::GetStcIntf(bool create) {
+  if (stc_intf_init_done_.load(std::memory_order_acquire)) {
+    return stc_intf_;
+  }
+  if (!create) {
+    return NULL;
+  }
+
+  lock_guard<mutex> lock(init_lock_);
+  if (!stc_intf_init_done_.load(std::memory_order_relaxed)) {
+    CreateStcIntf();
+    stc_intf_init_done_.store(true, std::memory_order_release);
+  }
+
+  return stc_intf_;
+}
+
+// Called by GetStcIntf() with init_lock_ held.
+void ColorManagerProxy::CreateStcIntf() {
+  // instantiate concrete create_stc_intf_ from libsnapdragoncolor_manager.so
+  stc_intf_ = create_stc_intf_(STC_REVISION_MAJOR, STC_REVISION_MINOR);
+  if (!stc_intf_) {
+    DLOGW("Unable to instantiate concrete StcInterface from %s", STCMGR_LIBRARY_NAME);
+    return;
+  }
+
+  int err = stc_intf_->Init(pp_hw_attributes_.panel_name);
+  if (err) {
+    DLOGW("Failed to init Stc interface, err %d", err);
+    delete stc_intf_;
+    stc_intf_ = NULL;
+    return;
+  }
+
+  // pass the display interface to STC manager for digital dimming
+  ScPayload payload;
+  payload.len = sizeof(disp_intf_);
+  payload.prop = snapdragoncolor::kDisplayIntf;
+  payload.payload = reinterpret_cast<uint64_t>(disp_intf_);
+  int ret = stc_intf_->SetProperty(payload);
+  if (ret) {
+    DLOGW("Failed to SetProperty, property = %d error = %d", payload.prop, ret);
+  }
+
+  if (HasNativeModeSupport()) {
+    curr_mode_.gamut = allow_tonemap_native_ ? ColorPrimaries_BT709_5 : ColorPrimaries_Max;
+    curr_mode_.gamma = allow_tonemap_native_ ? Transfer_sRGB : Transfer_Max;
+    curr_mode_.intent = snapdragoncolor::kNative;
+  }
+}
+
 ColorManagerProxy::~ColorManagerProxy() {
   if (destroy_intf_)
     destroy_intf_(display_id_);
@@ -319,7 +346,11 @@ DisplayError ColorManagerProxy::ColorSVCRequestRoute(const PPDisplayAPIPayload &
   // feature list with paramaters being transformed into target requirement.
   ret = color_intf_->ColorSVCRequestRoute(in_payload, out_payload, &pp_features_, pending_action);
 
-  if (!stc_intf_) {
+  // Only the render intent queries need the Stc interface, Prepare() routes a request per frame.
+  bool render_intents = pending_action && (pending_action->action == kGetNumRenderIntents ||
+                                           pending_action->action == kGetRenderIntents);
+  ScPostBlendInterface *stc_intf = (!ret && render_intents) ? GetStcIntf() : NULL;
+  if (!stc_intf) {
     return ret;
   }
 
@@ -329,7 +360,7 @@ DisplayError ColorManagerProxy::ColorSVCRequestRoute(const PPDisplayAPIPayload &
     payload.len = sizeof(num_render_intent);
     payload.prop = snapdragoncolor::kGetNumRenderIntents;
     payload.payload = reinterpret_cast<uint64_t>(&num_render_intent);
-    int err = stc_intf_->GetProperty(&payload);
+    int err = stc_intf->GetProperty(&payload);
     if (err) {
       DLOGE("Failed to get number of render intents, err %d", err);
       return kErrorUndefined;
@@ -354,7 +385,7 @@ DisplayError ColorManagerProxy::ColorSVCRequestRoute(const PPDisplayAPIPayload &
     payload.len = sizeof(render_intent_map);
     payload.prop = snapdragoncolor::kGetRenderIntents;
     payload.payload = reinterpret_cast<uint64_t>(&render_intent_map);
-    int err = stc_intf_->GetProperty(&payload);
+    int err = stc_intf->GetProperty(&payload);
     if (err) {
       DLOGE("Failed to get number of render intents, err %d", err);
       return kErrorUndefined;
@@ -443,7 +474,9 @@ void PPHWAttributes::Set(const HWResourceInfo &hw_res,
 
 bool ColorManagerProxy::NeedAssetsUpdate() {
   bool need_update = false;
-  if (!stc_intf_) {
+  // Called every frame, assets that were never loaded can't need an update.
+  ScPostBlendInterface *stc_intf = GetStcIntf(false /* create */);
+  if (!stc_intf) {
     return need_update;
   }
   ScPayload payload;
@@ -451,10 +484,11 @@ bool ColorManagerProxy::NeedAssetsUpdate() {
   payload.len = sizeof(need_update);
   payload.prop = kNeedsUpdate;
   payload.payload = reinterpret_cast<uint64_t>(&need_update);
-  stc_intf_->GetProperty(&payload);
+  stc_intf->GetProperty(&payload);
   return need_update;
 }
 
+// Called by CreateStcIntf() with init_lock_ held.
 bool ColorManagerProxy::HasNativeModeSupport() {
   bool native_mode_support = false;
   if (!stc_intf_) {
@@ -462,7 +496,15 @@ bool ColorManagerProxy::HasNativeModeSupport() {
   }
 
   snapdragoncolor::ColorModeList stc_color_modes = {};
-  ColorMgrGetStcModes(&stc_color_modes);
+  ScPayload payload;
+  payload.len = sizeof(ColorModeList);
+  payload.prop = kModeList;
+  payload.payload = reinterpret_cast<uint64_t>(&stc_color_modes);
+  int err = stc_intf_->GetProperty(&payload);
+  if (err) {
+    DLOGE("Failed to get Stc color modes, err %d", err);
+    return native_mode_support;
+  }
   for (auto &iter : stc_color_modes.list) {
     if (iter.intent == snapdragoncolor::kNative) {
       native_mode_support = true;
@@ -502,7 +544,8 @@ DisplayError ColorManagerProxy::ColorMgrSetColorTransform(uint32_t length,
     return kErrorParameters;
   }
 
-  if (!stc_intf_) {
+  ScPostBlendInterface *stc_intf = GetStcIntf();
+  if (!stc_intf) {
     DLOGW("STC interface is NULL");
     return kErrorNone;
   }
@@ -516,7 +559,7 @@ DisplayError ColorManagerProxy::ColorMgrSetColorTransform(uint32_t length,
   in_data.prop = snapdragoncolor::kSetColorTransform;
   in_data.len = sizeof(color_transform);
   in_data.payload = reinterpret_cast<uint64_t>(&color_transform);
-  int result = stc_intf_->SetProperty(in_data);
+  int result = stc_intf->SetProperty(in_data);
   if (result) {
     DLOGE("Failed to SetProperty prop = %d, error = %d", in_data.prop, result);
     return kErrorUndefined;
@@ -535,6 +578,8 @@ DisplayError ColorManagerProxy::ColorMgrCombineColorModes() {
 
 DisplayError ColorManagerProxy::ColorMgrSetModeWithRenderIntent(int32_t color_mode_id,
                                          const PrimariesTransfer &blend_space, uint32_t intent) {
+  // Load the mode assets for the next Validate(), loading defaults curr_mode_.
+  GetStcIntf();
   cur_blend_space_ = blend_space;
   cur_intent_ = intent;
   cur_mode_id_ = color_mode_id;
@@ -617,7 +662,9 @@ DisplayError ColorManagerProxy::ApplySwAssets() {
     return error;
   }
 
-  if (!stc_intf_) {
+  // needs_update_ and apply_mode_ are only set once the assets are loaded.
+  ScPostBlendInterface *stc_intf = GetStcIntf(false /* create */);
+  if (!stc_intf) {
     DLOGE("STC interface is NULL");
     return kErrorUndefined;
   }
@@ -635,7 +682,7 @@ DisplayError ColorManagerProxy::ApplySwAssets() {
   out_data.len = sizeof(sw_params);
   out_data.payload = reinterpret_cast<uint64_t>(&sw_params);
 
-  int err = stc_intf_->ProcessOps(kScModeSwAssets, in_data, &out_data);
+  int err = stc_intf->ProcessOps(kScModeSwAssets, in_data, &out_data);
   if (err) {
     DLOGE("Failed to process kScModeSwAssets, err %d", err);
     error = kErrorUndefined;
@@ -651,7 +698,8 @@ DisplayError ColorManagerProxy::ApplySwAssets() {
 }
 
 DisplayError ColorManagerProxy::NotifyDisplayCalibrationMode(bool in_calibration) {
-  if (!stc_intf_) {
+  ScPostBlendInterface *stc_intf = GetStcIntf();
+  if (!stc_intf) {
     return kErrorUndefined;
   }
 
@@ -659,7 +707,7 @@ DisplayError ColorManagerProxy::NotifyDisplayCalibrationMode(bool in_calibration
   payload.len = sizeof(in_calibration);
   payload.prop = kNotifyDisplayCalibrationMode;
   payload.payload = reinterpret_cast<uint64_t>(&in_calibration);
-  int ret = stc_intf_->SetProperty(payload);
+  int ret = stc_intf->SetProperty(payload);
   if (ret) {
     DLOGE("Failed to SetProperty, property = %d error = %d", payload.prop, ret);
     return kErrorUndefined;
@@ -703,7 +751,9 @@ DisplayError ColorManagerProxy::ConvertToPPFeatures(const HwConfigOutputParams &
 DisplayError ColorManagerProxy::UpdateModeHwassets(int32_t mode_id,
                                   snapdragoncolor::ColorMode color_mode, bool valid_meta_data,
                                   const ColorMetaData &meta_data) {
-  if (!stc_intf_) {
+  // Runs in Validate(), HDR metadata updates are skipped until a client request loads the assets.
+  ScPostBlendInterface *stc_intf = GetStcIntf(false /* create */);
+  if (!stc_intf) {
     return kErrorUndefined;
   }
 
@@ -724,7 +774,7 @@ DisplayError ColorManagerProxy::UpdateModeHwassets(int32_t mode_id,
   out_data.prop = kHwConfigPayloadParam;
   out_data.len = sizeof(hw_params);
   out_data.payload = reinterpret_cast<uint64_t>(&hw_params);
-  int result = stc_intf_->ProcessOps(kScModeRenderIntent, in_data, &out_data);
+  int result = stc_intf->ProcessOps(kScModeRenderIntent, in_data, &out_data);
   if (result) {
     DLOGE("Failed to call ProcessOps, error = %d", result);
     return kErrorUndefined;
@@ -765,7 +815,8 @@ void ColorManagerProxy::DumpColorMetaData(const ColorMetaData &color_metadata) {
 }
 
 DisplayError ColorManagerProxy::ColorMgrGetStcModes(ColorModeList *mode_list) {
-  if (!stc_intf_) {
+  ScPostBlendInterface *stc_intf = GetStcIntf();
+  if (!stc_intf) {
     DLOGE("STC interface is NULL");
     return kErrorUndefined;
   }
@@ -775,7 +826,7 @@ DisplayError ColorManagerProxy::ColorMgrGetStcModes(ColorModeList *mode_list) {
   payload.prop = kModeList;
   payload.payload = reinterpret_cast<uint64_t>(mode_list);
 
-  int err = stc_intf_->GetProperty(&payload);
+  int err = stc_intf->GetProperty(&payload);
   if (err) {
     DLOGE("Failed to get Stc color modes, err %d", err);
     return kErrorUndefined;
@@ -785,13 +836,18 @@ DisplayError ColorManagerProxy::ColorMgrGetStcModes(ColorModeList *mode_list) {
 }
 
 DisplayError ColorManagerProxy::ColorMgrSetStcMode(const ColorMode &color_mode) {
+  // The mode comes from ColorMgrGetStcModes(), so this doesn't load anything. It has to be done
+  // before curr_mode_ is set in any case, loading defaults it to the native mode.
+  GetStcIntf();
   curr_mode_ = color_mode;
   apply_mode_ = true;
   return kErrorNone;
 }
 
 DisplayError ColorManagerProxy::ColorMgrSetLtmPccConfig(void* pcc_input, size_t size) {
-  if (!stc_intf_) {
+  // Comes from the DPPS thread without the display lock, so it doesn't load the mode assets.
+  ScPostBlendInterface *stc_intf = GetStcIntf(false /* create */);
+  if (!stc_intf) {
     DLOGE("STC interface is NULL");
     return kErrorUndefined;
   }
@@ -805,7 +861,7 @@ DisplayError ColorManagerProxy::ColorMgrSetLtmPccConfig(void* pcc_input, size_t
     in_data.payload = reinterpret_cast<uint64_t>(nullptr);
     in_data.len = 0;
   }
-  int result = stc_intf_->SetProperty(in_data);
+  int result = stc_intf->SetProperty(in_data);
   if (result) {
     DLOGE("Failed to SetProperty prop = %d, error = %d", in_data.prop, result);
     return kErrorUndefined;
@@ -816,8 +872,8 @@ DisplayError ColorManagerProxy::ColorMgrSetLtmPccConfig(void* pcc_input, size_t
 DisplayError ColorManagerProxy::ConfigureCWBDither(CwbConfig *cwb_cfg, bool free_data) {
   DisplayError error = kErrorNone;
 
-  if (!stc_intf_ || (!cwb_cfg && !free_data)) {
-    DLOGE("Invalid stc_intf_ %pK, cwb_cfg %pK", stc_intf_, cwb_cfg);
+  if (!cwb_cfg && !free_data) {
+    DLOGE("Invalid cwb_cfg %pK", cwb_cfg);
     return kErrorParameters;
   }
 
@@ -834,6 +890,13 @@ DisplayError ColorManagerProxy::ConfigureCWBDither(CwbConfig *cwb_cfg, bool free
   }
   cwb_cfg->dither_info = nullptr;
 
+  // Runs in the commit path, without loaded mode assets there is no mode dither to apply.
+  ScPostBlendInterface *stc_intf = GetStcIntf(false /* create */);
+  if (!stc_intf) {
+    DLOGV_IF(kTagQDCM, "Stc mode assets not loaded, no cwb dither");
+    return kErrorNone;
+  }
+
   //<<! Only the first frame goes to get pp-dither when multi-frames need to be captured
   //<<! dither_flags is 0x0: dither settings from current color mode
   //<<! dither_flags is 0x1: dither settings from QDCM PC tool
@@ -844,7 +907,7 @@ DisplayError ColorManagerProxy::ConfigureCWBDither(CwbConfig *cwb_cfg, bool free
     output.len = sizeof(dither_hw_params);
     output.prop = snapdragoncolor::kGetGlobalDitherHwConfig;
     output.payload = reinterpret_cast<uint64_t>(&dither_hw_params);
-    int ret = stc_intf_->GetProperty(&output);
+    int ret = stc_intf->GetProperty(&output);
     if (ret) {
       DLOGE("Failed to get propety of global dither hw config");
       return kErrorUndefined;
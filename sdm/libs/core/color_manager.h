@@ -41,6 +41,7 @@
 #include <utils/debug.h>
 #include <private/hw_interface.h>
 #include <array>
+#include <atomic>
 #include <vector>
 #include <map>
 #include <string>
@@ -117,6 +118,8 @@ class ColorManagerProxy {
    * 2. Pass all display object specific informations into it.
    * 3. Populate necessary resources.
    * 4. Need get panel name for hw_panel_info_.
+   * The Stc interface, which loads the mode assets of the panel, is only created by the first
+   * client request that needs it.
    */
   static ColorManagerProxy *CreateColorManagerProxy(DisplayType type, HWInterface *hw_intf,
                                                     const HWDisplayAttributes &attribute,
@@ -177,6 +180,8 @@ class ColorManagerProxy {
                                         PPFeaturesConfig *out_data);
   typedef std::map<std::string, ConvertProc> ConvertTable;
 
+  ScPostBlendInterface *GetStcIntf(bool create = true);
+  void CreateStcIntf();
   bool NeedAssetsUpdate();
   DisplayError UpdateModeHwassets(int32_t mode_id, snapdragoncolor::ColorMode color_mode,
                                   bool valid_meta_data, const ColorMetaData &meta_data);
@@ -197,9 +202,13 @@ class ColorManagerProxy {
   uint32_t cur_intent_ = 0;
   int32_t cur_mode_id_ = -1;
   ColorMetaData meta_data_ = {};
-  snapdragoncolor::ScPostBlendInterface *stc_intf_ = NULL;
+  snapdragoncolor::ScPostBlendInterface *stc_intf_ = NULL;  // Created by GetStcIntf()
   snapdragoncolor::ColorMode curr_mode_;
   bool needs_update_ = false;
+  DisplayInterface *disp_intf_ = NULL;
+  bool allow_tonemap_native_ = false;
+  std::mutex init_lock_;  // Serializes the creation of stc_intf_, not taken per frame
+  std::atomic<bool> stc_intf_init_done_ = {false};
 };
 
 class ColorFeatureCheckingImpl : public FeatureInterface {
@@ -35,10 +35,12 @@
 #include <utils/constants.h>
 #include <utils/debug.h>
 #include <utils/locker.h>
+#include <utils/task_graph.h>
 #include <utils/utils.h>
 #include <sys/mman.h>
 #include <private/hw_info_interface.h>
 #include <map>
+#include <string>
 #include <vector>
 
 #include "color_manager.h"
@@ -72,41 +74,72 @@ DisplayError CoreImpl::Init() {
   SCOPE_LOCK(locker_);
   DisplayError error = kErrorNone;
 
+  int value = 0;
+  Debug::Get()->GetProperty(ENABLE_NULL_DISPLAY_PROP, &value);
+  enable_null_display_ = (value == 1);
+  DLOGI("property: enable_null_display_ = %d", enable_null_display_);
+
+  // Loading the extension library does not touch the hardware, overlap it with the resource
+  // discovery. Everything else stays on this thread in its original order, the DRM manager and
+  // the composition manager are not safe to use from several threads. Stages must not take
+  // locker_, held here.
+  TaskGraph startup;
+  bool extension_found = false;
+  std::string extension_error;
+  startup.Add("extension_lib", [this, &extension_found, &extension_error] {
+    extension_found = extension_lib_.Open(EXTENSION_LIBRARY_NAME);
+    if (!extension_found) {
+      // dlerror() is per thread.
+      const char *dl_error = extension_lib_.Error();
+      extension_error = dl_error ? dl_error : "";
+    }
+    return kErrorNone;
+  });
+  TaskGraph::TaskId hw_info = TaskGraph::kInvalidTaskId;
+  TaskGraph::TaskId hw_resource = TaskGraph::kInvalidTaskId;
+  if (!enable_null_display_) {
+    hw_info = startup.Add("hw_info", [this] {
+      return HWInfoInterface::Create(&hw_info_intf_);
+    });
+    hw_resource = startup.Add("hw_resource", [this] {
+      return hw_info_intf_->GetHWResourceInfo(&hw_resource_);
+    }, {hw_info});
+  }
+  startup.Run();
+  DLOGI("Startup stages: %s", startup.Dump().c_str());
+
   // Try to load extension library & get handle to its interface.
-  if (extension_lib_.Open(EXTENSION_LIBRARY_NAME)) {
+  if (extension_found) {
     if (!extension_lib_.Sym(CREATE_EXTENSION_INTERFACE_NAME,
                             reinterpret_cast<void **>(&create_extension_intf_)) ||
         !extension_lib_.Sym(DESTROY_EXTENSION_INTERFACE_NAME,
                             reinterpret_cast<void **>(&destroy_extension_intf_))) {
       DLOGE("Unable to load symbols, error = %s", extension_lib_.Error());
-      return kErrorUndefined;
+      error = kErrorUndefined;
+      goto CleanupOnError;
     }
 
     error = create_extension_intf_(EXTENSION_VERSION_TAG, &extension_intf_);
     if (error != kErrorNone) {
       DLOGE("Unable to create interface");
-      return error;
+      goto CleanupOnError;
     }
   } else {
 #ifdef TRUSTED_VM
     // Any library linked to libsdmextension is not present for LE, LE wont be able to load the
     // libsdmextension library due to undefined reference. To avoid it mark it as fatal on LE
-    DLOGE("Unable to load = %s, error = %s", EXTENSION_LIBRARY_NAME, extension_lib_.Error());
+    DLOGE("Unable to load = %s, error = %s", EXTENSION_LIBRARY_NAME, extension_error.c_str());
 #else
-    DLOGW("Unable to load = %s, error = %s", EXTENSION_LIBRARY_NAME, extension_lib_.Error());
+    DLOGW("Unable to load = %s, error = %s", EXTENSION_LIBRARY_NAME, extension_error.c_str());
 #endif
   }
 
-  int value = 0;
-  Debug::Get()->GetProperty(ENABLE_NULL_DISPLAY_PROP, &value);
-  enable_null_display_ = (value == 1);
-  DLOGI("property: enable_null_display_ = %d", enable_null_display_);
   if (enable_null_display_) {
     hw_info_intf_ = new HWInfoDefault();
     return kErrorNone;
   }
 
-  error = HWInfoInterface::Create(&hw_info_intf_);
+  error = startup.GetError(hw_info);
   if (error != kErrorNone) {
     DisplayError err = HandleNullDisplay();
 
@@ -117,7 +150,7 @@ DisplayError CoreImpl::Init() {
     return kErrorNone;
   }
 
-  error = hw_info_intf_->GetHWResourceInfo(&hw_resource_);
+  error = startup.GetError(hw_resource);
   if (error != kErrorNone) {
     goto CleanupOnError;
   }
@@ -273,48 +306,53 @@ DisplayError CoreImpl::CreateDisplay(DisplayType type, DisplayEventHandler *even
 
 DisplayError CoreImpl::CreateDisplay(int32_t display_id, DisplayEventHandler *event_handler,
                                      DisplayInterface **intf) {
-  SCOPE_LOCK(locker_);
-
   if (!event_handler || !intf) {
     return kErrorParameters;
   }
 
-  if (enable_null_display_) {
-    return CreateNullDisplayLocked(intf);
-  }
+  DisplayBase *display_base = NULL;
+  {
+    SCOPE_LOCK(locker_);
 
-  auto iter = hw_displays_info_.find(display_id);
+    if (enable_null_display_) {
+      return CreateNullDisplayLocked(intf);
+    }
 
-  if (iter == hw_displays_info_.end()) {
-    DLOGE("Spurious display id %d", display_id);
-    return kErrorParameters;
-  }
+    auto iter = hw_displays_info_.find(display_id);
 
-  DisplayBase *display_base = NULL;
-  DisplayType display_type = iter->second.display_type;
+    if (iter == hw_displays_info_.end()) {
+      DLOGE("Spurious display id %d", display_id);
+      return kErrorParameters;
+    }
 
-  switch (display_type) {
-    case kBuiltIn:
-      display_base = new DisplayBuiltIn(display_id, event_handler, hw_info_intf_,
-                                        buffer_allocator_, &comp_mgr_, ipc_intf_);
-      break;
-    case kPluggable:
-      display_base = new DisplayPluggable(display_id, event_handler, hw_info_intf_,
+    DisplayType display_type = iter->second.display_type;
+
+    switch (display_type) {
+      case kBuiltIn:
+        display_base = new DisplayBuiltIn(display_id, event_handler, hw_info_intf_,
+                                          buffer_allocator_, &comp_mgr_, ipc_intf_);
+        break;
+      case kPluggable:
+        display_base = new DisplayPluggable(display_id, event_handler, hw_info_intf_,
+                                            buffer_allocator_, &comp_mgr_);
+        break;
+      case kVirtual:
+        display_base = new DisplayVirtual(display_id, event_handler, hw_info_intf_,
                                           buffer_allocator_, &comp_mgr_);
-      break;
-    case kVirtual:
-      display_base = new DisplayVirtual(display_id, event_handler, hw_info_intf_,
-                                        buffer_allocator_, &comp_mgr_);
-      break;
-    default:
-      DLOGE("Spurious display type %d", display_type);
-      return kErrorParameters;
+        break;
+      default:
+        DLOGE("Spurious display type %d", display_type);
+        return kErrorParameters;
+    }
   }
 
   if (!display_base) {
     return kErrorMemory;
   }
 
+  // Init is the slow part of the display creation, so displays created by id are initialized off
+  // the core lock and may come up in parallel. What they share is locked on its own: DRM resource
+  // reservation by DRMManager, composition resources by CompManager.
   DisplayError error = display_base->Init();
   if (error != kErrorNone) {
     delete display_base;
@@ -93,10 +93,6 @@ DisplayError DisplayBuiltIn::Init() {
     return error;
   }
 
-  if (color_mgr_) {
-    color_mgr_->ColorMgrGetStcModes(&stc_color_modes_);
-  }
-
   if (hw_panel_info_.mode == kModeCommand && Debug::IsVideoModeEnabled()) {
     error = hw_intf_->SetDisplayMode(kModeVideo);
     if (error != kErrorNone) {
@@ -231,6 +227,14 @@ DisplayError DisplayBuiltIn::Init() {
 }
 
 DisplayError DisplayBuiltIn::Deinit() {
+  FenceWatcher::WatchId brightness_watch_id = FenceWatcher::kInvalidWatchId;
+  {
+    lock_guard<recursive_mutex> obj(brightness_lock_);
+    brightness_watch_id = brightness_watch_id_;
+  }
+  // Must be done without brightness lock, as pending callback may be waiting to acquire it.
+  FenceWatcher::GetInstance()->Cancel(brightness_watch_id);
+
   {
     ClientLock lock(disp_mutex_);
 
@@ -1004,10 +1008,16 @@ DisplayError DisplayBuiltIn::PostCommit(HWLayersInfo *hw_layers_info) {
   // Mutex scope
   {
     lock_guard<recursive_mutex> obj(brightness_lock_);
-    if (pending_brightness_) {
-      Fence::Wait(retire_fence_);
-      SetPanelBrightness(cached_brightness_);
-      pending_brightness_ = false;
+    if (pending_brightness_ && brightness_watch_id_ == FenceWatcher::kInvalidWatchId) {
+      // Apply cached brightness once retire fence signals, without stalling the commit thread.
+      brightness_watch_id_ = FenceWatcher::GetInstance()->Watch(
+          retire_fence_, kBrightnessFenceTimeoutMs, [this](int /* status */) {
+            ApplyPendingBrightness();
+          });
+      if (brightness_watch_id_ == FenceWatcher::kInvalidWatchId && pending_brightness_) {
+        Fence::Wait(retire_fence_);
+        ApplyPendingBrightness();
+      }
     }
   }
 
@@ -1524,6 +1534,15 @@ void DisplayBuiltIn::HandleBacklightEvent(float brightness_level) {
   }
 }
 
+void DisplayBuiltIn::ApplyPendingBrightness() {
+  lock_guard<recursive_mutex> obj(brightness_lock_);
+  brightness_watch_id_ = FenceWatcher::kInvalidWatchId;
+  if (pending_brightness_) {
+    SetPanelBrightness(cached_brightness_);
+    pending_brightness_ = false;
+  }
+}
+
 DisplayError DisplayBuiltIn::GetPanelBrightness(float *brightness) {
   lock_guard<recursive_mutex> obj(brightness_lock_);
 
@@ -1744,6 +1763,7 @@ DisplayError DisplayBuiltIn::GetStcColorModes(snapdragoncolor::ColorModeList *mo
     return kErrorNotSupported;
   }
 
+  FetchStcColorModes();
   mode_list->list = stc_color_modes_.list;
   return kErrorNone;
 }
@@ -2612,6 +2632,7 @@ PrimariesTransfer DisplayBuiltIn::GetBlendSpaceFromStcColorMode(
   }
 
   // Set sRGB as default blend space.
+  FetchStcColorModes();
   bool native_mode = (color_mode.intent == snapdragoncolor::kNative) ||
                      (color_mode.gamut == ColorPrimaries_Max && color_mode.gamma == Transfer_Max);
   if (stc_color_modes_.list.empty() || (native_mode && allow_tonemap_native_)) {
@@ -2624,6 +2645,16 @@ PrimariesTransfer DisplayBuiltIn::GetBlendSpaceFromStcColorMode(
   return blend_space;
 }
 
+// Fetched on first use rather than in Init(), the query loads the mode assets of the panel.
+void DisplayBuiltIn::FetchStcColorModes() {
+  if (stc_color_modes_fetched_ || !color_mgr_) {
+    return;
+  }
+
+  stc_color_modes_fetched_ = true;
+  color_mgr_->ColorMgrGetStcModes(&stc_color_modes_);
+}
+
 DisplayError DisplayBuiltIn::GetConfig(DisplayConfigFixedInfo *fixed_info) {
   ClientLock lock(disp_mutex_);
   fixed_info->is_cmdmode = (hw_panel_info_.mode == kModeCommand);
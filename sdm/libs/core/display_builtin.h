@@ -45,6 +45,7 @@
 #include <private/panel_feature_factory_intf.h>
 #include <private/hw_events_interface.h>
 #include <private/display_event_proxy_intf.h>
+#include <utils/fence_watcher.h>
 #include <string>
 #include <vector>
 
@@ -250,6 +251,7 @@ class DisplayBuiltIn : public DisplayBase, HWEventHandler, DppsPropIntf {
   void SetDeferredFpsConfig();
   void GetFpsConfig(HWDisplayAttributes *display_attributes, HWPanelInfo *panel_info);
   PrimariesTransfer GetBlendSpaceFromStcColorMode(const snapdragoncolor::ColorMode &color_mode);
+  void FetchStcColorModes();
   DisplayError SetupSPR();
   DisplayError SetupDemura();
   DisplayError SetupDemuraLayer();
@@ -275,8 +277,10 @@ class DisplayBuiltIn : public DisplayBase, HWEventHandler, DppsPropIntf {
   void NotifyDppsHdrPresent(LayerStack *layer_stack);
   bool IdleFallbackLowerFps(bool idle_screen);
   void HandleUpdateTransferTime(QSyncMode mode);
+  void ApplyPendingBrightness();
 
   const uint32_t kPuTimeOutMs = 1000;
+  const int kBrightnessFenceTimeoutMs = 1000;
   std::vector<HWEvent> event_list_;
   bool avr_prop_disabled_ = false;
   bool switch_to_cmd_ = false;
@@ -291,6 +295,7 @@ class DisplayBuiltIn : public DisplayBase, HWEventHandler, DppsPropIntf {
   float cached_brightness_ = 0.0f;
   bool pending_brightness_ = false;
   recursive_mutex brightness_lock_;
+  FenceWatcher::WatchId brightness_watch_id_ = FenceWatcher::kInvalidWatchId;
   LayerRect left_frame_roi_ = {};
   LayerRect right_frame_roi_ = {};
   Locker dpps_pu_lock_;
@@ -305,6 +310,7 @@ class DisplayBuiltIn : public DisplayBase, HWEventHandler, DppsPropIntf {
   DeferFpsConfig deferred_config_ = {};
   snapdragoncolor::ColorMode current_color_mode_ = {};
   snapdragoncolor::ColorModeList stc_color_modes_ = {};
+  bool stc_color_modes_fetched_ = false;
 
   std::shared_ptr<SPRIntf> spr_ = nullptr;
   bool needs_validate_on_pu_enable_ = false;
@@ -128,6 +128,10 @@ std::atomic<uint32_t> HWDeviceDRM::hw_dest_scaler_blocks_used_(0);
 std::mutex HWDeviceDRM::cwb_state_lock_;
 bool HWDeviceDRM::reset_planes_luts_ = true;
 
+static uint64_t GetModeKey(uint32_t width, uint32_t height, uint32_t refresh) {
+  return (UINT64(width) << 48) | (UINT64(height) << 32) | refresh;
+}
+
 static PPBlock GetPPBlock(const HWToneMapLut &lut_type) {
   PPBlock pp_block = kPPBlockMax;
   switch (lut_type) {
@@ -727,6 +731,8 @@ void HWDeviceDRM::InitializeConfigs() {
       connector_info_.modes.push_back(mode_item);
     }
   }
+  BuildModeIndex();
+
   // Update current mode with preferred mode
   for (uint32_t mode_index = 0; mode_index < connector_info_.modes.size(); mode_index++) {
       if (connector_info_.modes[mode_index].mode.type & DRM_MODE_TYPE_PREFERRED) {
@@ -751,6 +757,21 @@ void HWDeviceDRM::InitializeConfigs() {
   SetDisplaySwitchMode(current_mode_index_);
 }
 
+void HWDeviceDRM::BuildModeIndex() {
+  mode_index_.clear();
+  for (uint32_t mode_index = 0; mode_index < connector_info_.modes.size(); mode_index++) {
+    auto &mode = connector_info_.modes[mode_index].mode;
+    mode_index_[GetModeKey(mode.hdisplay, mode.vdisplay, mode.vrefresh)].push_back(mode_index);
+  }
+}
+
+const std::vector<uint32_t> &HWDeviceDRM::GetModeIndices(uint32_t width, uint32_t height,
+                                                         uint32_t refresh) const {
+  static const std::vector<uint32_t> no_modes;
+  auto it = mode_index_.find(GetModeKey(width, height, refresh));
+  return (it != mode_index_.end()) ? it->second : no_modes;
+}
+
 DisplayError HWDeviceDRM::PopulateDisplayAttributes(uint32_t index) {
   drmModeModeInfo mode = {};
   sde_drm::DRMModeInfo conn_mode = {};
@@ -1103,11 +1124,9 @@ void HWDeviceDRM::SetDisplaySwitchMode(uint32_t index) {
     panel_mode_changed_ = mode_flag;
   }
 
-  for (uint32_t mode_index = 0; mode_index < connector_info_.modes.size(); mode_index++) {
-    if ((to_set.mode.vdisplay == connector_info_.modes[mode_index].mode.vdisplay) &&
-        (to_set.mode.hdisplay == connector_info_.modes[mode_index].mode.hdisplay) &&
-        (to_set.mode.vrefresh == connector_info_.modes[mode_index].mode.vrefresh) &&
-        (mode_flag & connector_info_.modes[mode_index].cur_panel_mode)) {
+  for (uint32_t mode_index : GetModeIndices(to_set.mode.hdisplay, to_set.mode.vdisplay,
+                                            to_set.mode.vrefresh)) {
+    if (mode_flag & connector_info_.modes[mode_index].cur_panel_mode) {
       for (uint32_t submode_idx = 0; submode_idx <
            connector_info_.modes[mode_index].sub_modes.size(); submode_idx++) {
         sde_drm::DRMSubModeInfo sub_mode = connector_info_.modes[mode_index].sub_modes[submode_idx];
@@ -1125,11 +1144,9 @@ void HWDeviceDRM::SetDisplaySwitchMode(uint32_t index) {
   current_mode_index_ = index;
 
   switch_mode_valid_ = false;
-  for (uint32_t mode_index = 0; mode_index < connector_info_.modes.size(); mode_index++) {
-    if ((to_set.mode.vdisplay == connector_info_.modes[mode_index].mode.vdisplay) &&
-        (to_set.mode.hdisplay == connector_info_.modes[mode_index].mode.hdisplay) &&
-        (to_set.mode.vrefresh == connector_info_.modes[mode_index].mode.vrefresh) &&
-        (switch_mode_flag & connector_info_.modes[mode_index].cur_panel_mode)) {
+  for (uint32_t mode_index : GetModeIndices(to_set.mode.hdisplay, to_set.mode.vdisplay,
+                                            to_set.mode.vrefresh)) {
+    if (switch_mode_flag & connector_info_.modes[mode_index].cur_panel_mode) {
       for (uint32_t submode_idx = 0; submode_idx <
            connector_info_.modes[mode_index].sub_modes.size(); submode_idx++) {
         sde_drm::DRMSubModeInfo sub_mode = connector_info_.modes[mode_index].sub_modes[submode_idx];
@@ -1768,11 +1785,9 @@ void HWDeviceDRM::SetupAtomic(Fence::ScopedRef &scoped_ref, HWLayersInfo *hw_lay
 
   // Set refresh rate
   if (vrefresh_) {
-    for (uint32_t mode_index = 0; mode_index < connector_info_.modes.size(); mode_index++) {
-      if ((current_mode.mode.vdisplay == connector_info_.modes[mode_index].mode.vdisplay) &&
-          (current_mode.mode.hdisplay == connector_info_.modes[mode_index].mode.hdisplay) &&
-          (current_mode.cur_panel_mode == connector_info_.modes[mode_index].cur_panel_mode) &&
-          (vrefresh_ == connector_info_.modes[mode_index].mode.vrefresh)) {
+    for (uint32_t mode_index : GetModeIndices(current_mode.mode.hdisplay,
+                                              current_mode.mode.vdisplay, vrefresh_)) {
+      if (current_mode.cur_panel_mode == connector_info_.modes[mode_index].cur_panel_mode) {
         current_mode = connector_info_.modes[mode_index];
         break;
       }
@@ -2058,13 +2073,9 @@ DisplayError HWDeviceDRM::AtomicCommit(HWLayersInfo *hw_layers_info) {
   if (vrefresh_) {
     // Update current mode index if refresh rate is changed
     drmModeModeInfo current_mode = connector_info_.modes[current_mode_index_].mode;
-    for (uint32_t mode_index = 0; mode_index < connector_info_.modes.size(); mode_index++) {
-      if ((current_mode.vdisplay == connector_info_.modes[mode_index].mode.vdisplay) &&
-          (current_mode.hdisplay == connector_info_.modes[mode_index].mode.hdisplay) &&
-          (vrefresh_ == connector_info_.modes[mode_index].mode.vrefresh)) {
-        SetDisplaySwitchMode(mode_index);
-        break;
-      }
+    auto &mode_indices = GetModeIndices(current_mode.hdisplay, current_mode.vdisplay, vrefresh_);
+    if (!mode_indices.empty()) {
+      SetDisplaySwitchMode(mode_indices.front());
     }
     vrefresh_ = 0;
   }
@@ -2415,11 +2426,9 @@ DisplayError HWDeviceDRM::SetRefreshRate(uint32_t refresh_rate) {
 
   // Check if requested refresh rate is valid
   sde_drm::DRMModeInfo current_mode = connector_info_.modes[current_mode_index_];
-  for (uint32_t mode_index = 0; mode_index < connector_info_.modes.size(); mode_index++) {
-    if ((current_mode.mode.vdisplay == connector_info_.modes[mode_index].mode.vdisplay) &&
-        (current_mode.mode.hdisplay == connector_info_.modes[mode_index].mode.hdisplay) &&
-        (current_mode.cur_panel_mode == connector_info_.modes[mode_index].cur_panel_mode) &&
-        (refresh_rate == connector_info_.modes[mode_index].mode.vrefresh)) {
+  for (uint32_t mode_index : GetModeIndices(current_mode.mode.hdisplay,
+                                            current_mode.mode.vdisplay, refresh_rate)) {
+    if (current_mode.cur_panel_mode == connector_info_.modes[mode_index].cur_panel_mode) {
       for (uint32_t submode_idx = 0; submode_idx <
            connector_info_.modes[mode_index].sub_modes.size(); submode_idx++) {
         sde_drm::DRMSubModeInfo sub_mode = connector_info_.modes[mode_index].sub_modes[submode_idx];
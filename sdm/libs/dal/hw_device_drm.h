@@ -314,6 +314,11 @@ class HWDeviceDRM : public HWInterface {
 
  protected:
   void SetDisplaySwitchMode(uint32_t index);
+  // Rebuilds mode_index_, must follow every change of the connector_info_.modes list.
+  void BuildModeIndex();
+  // Indices of the modes with this resolution and refresh rate, in connector_info_.modes order.
+  const std::vector<uint32_t> &GetModeIndices(uint32_t width, uint32_t height,
+                                              uint32_t refresh) const;
   bool IsSeamlessTransition() {
     return (hw_panel_info_.dynamic_fps && (vrefresh_ || seamless_mode_switch_)) ||
      panel_mode_changed_ || bit_clk_rate_;
@@ -335,6 +340,9 @@ class HWDeviceDRM : public HWInterface {
   std::vector<HWDisplayAttributes> display_attributes_ = {};
   uint32_t current_mode_index_ = 0;
   sde_drm::DRMConnectorInfo connector_info_ = {};
+  // Width, height and refresh rate of a mode to all modes sharing them. Panel mode and submode
+  // are left out of the key, they can change on a mode after the list is read.
+  std::unordered_map<uint64_t, std::vector<uint32_t>> mode_index_ = {};
   bool first_cycle_ = true;
   bool first_null_cycle_ = true;
   HWMixerAttributes mixer_attributes_ = {};
@@ -77,9 +77,11 @@
 #include <string.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/utsname.h>
 #include <utils/constants.h>
 #include <utils/debug.h>
 #include <utils/sys.h>
+#include <utils/task_graph.h>
 
 #include <algorithm>
 #include <fstream>
@@ -91,6 +93,7 @@
 #include <vector>
 
 #include "hw_info_drm.h"
+#include "hw_info_snapshot.h"
 
 #ifndef DRM_FORMAT_MOD_QCOM_COMPRESSED
 #define DRM_FORMAT_MOD_QCOM_COMPRESSED fourcc_mod_code(QCOM, 1)
@@ -275,9 +278,18 @@ DisplayError HWInfoDRM::GetHWResourceInfo(HWResourceInfo *hw_resource) {
   hw_resource->separate_rotator = true;
   hw_resource->has_non_scalar_rgb = false;
 
-  GetSystemInfo(hw_resource);
-  GetHWPlanesInfo(hw_resource);
-  GetWBInfo(hw_resource);
+  // Everything but the splash state is fixed for a given kernel and hardware, reuse what an
+  // earlier instance discovered when the composer restarts.
+  int disable_snapshot = 0;
+  Debug::Get()->GetProperty(DISABLE_HW_INFO_SNAPSHOT_PROP, &disable_snapshot);
+  HWInfoSnapshot snapshot(kSnapshotPath, GetSnapshotKey());
+  if (disable_snapshot || snapshot.Load(hw_resource) != kErrorNone) {
+    DiscoverHWResourceInfo(hw_resource);
+    if (!disable_snapshot) {
+      snapshot.Store(*hw_resource);
+    }
+  }
+  UpdateSplashInfo(hw_resource);
 
   // Disable destination scalar count to 0 if extension library is not present or disabled
   // through property
@@ -327,10 +339,6 @@ DisplayError HWInfoDRM::GetHWResourceInfo(HWResourceInfo *hw_resource) {
   DLOGI("\tFudge_factor = %d", hw_resource->extra_fudge_factor);
   DLOGI("\tib_fudge_factor = %f", hw_resource->ib_fudge_factor);
 
-  if (hw_resource->separate_rotator || hw_resource->num_dma_pipe) {
-    GetHWRotatorInfo(hw_resource);
-  }
-
   DLOGI("Has Support for multiple bw limits shown below");
   for (int index = 0; index < kBwModeMax; index++) {
     DLOGI("Mode-index=%d  total_bw_limit=%" PRIu64 " and pipe_bw_limit=%" PRIu64, index,
@@ -346,6 +354,83 @@ DisplayError HWInfoDRM::GetHWResourceInfo(HWResourceInfo *hw_resource) {
   return kErrorNone;
 }
 
+void HWInfoDRM::DiscoverHWResourceInfo(HWResourceInfo *hw_resource) {
+  // The DRM manager is not thread safe, its queries stay on one stage in their original order:
+  // the writeback probe registers and unregisters a display. Only the V4L2 rotator probe, plain
+  // sysfs and video node ioctls, runs next to it and fills its own copy merged below.
+  HWResourceInfo rot_resource;
+  TaskGraph discovery;
+  discovery.Add("drm", [this, hw_resource] {
+    GetSystemInfo(hw_resource);
+    GetHWPlanesInfo(hw_resource);
+    GetWBInfo(hw_resource);
+    return kErrorNone;
+  });
+  discovery.Add("rotator", [this, &rot_resource] {
+    return GetHWRotatorInfo(&rot_resource);
+  });
+  discovery.Run();
+  DLOGI("Discovery stages: %s", discovery.Dump().c_str());
+
+  if (hw_resource->separate_rotator || hw_resource->num_dma_pipe) {
+    FormatsMap &fmts_map = hw_resource->supported_formats_map;
+    hw_resource->hw_rot_info = rot_resource.hw_rot_info;
+    for (auto sub_blk_type : {kHWRotatorInput, kHWRotatorOutput}) {
+      auto rot_fmts = rot_resource.supported_formats_map.find(sub_blk_type);
+      if (rot_fmts != rot_resource.supported_formats_map.end()) {
+        fmts_map.erase(sub_blk_type);
+        fmts_map.insert(*rot_fmts);
+      }
+    }
+  }
+}
+
+string HWInfoDRM::GetSnapshotKey() {
+  // Covers everything discovery depends on: the kernel and vendor builds, the CRTC and plane
+  // capabilities sde-drm parsed at init and the properties consulted while building the pipe
+  // list. The sde-drm results are already in memory, hashing them is cheap next to discovery.
+  struct utsname name = {};
+  uname(&name);
+  char fingerprint[kMaxStringLength] = {};
+  Debug::GetProperty(kBuildFingerprintProp, fingerprint);
+  DRMCrtcInfo crtc_info = {};
+  drm_mgr_intf_->GetCrtcInfo(0 /* system_info */, &crtc_info);
+  DRMPlanesInfo planes_info;
+  drm_mgr_intf_->GetPlanesInfo(&planes_info);
+  uint32_t max_vig_pipes = 0;
+  uint32_t max_dma_pipes = 0;
+  Debug::GetReducedConfig(&max_vig_pipes, &max_dma_pipes);
+  int disable_src_tonemap = 0;
+  Debug::Get()->GetProperty(DISABLE_SRC_TONEMAP_PROP, &disable_src_tonemap);
+
+  return string(name.release) + " " + name.version + " " + name.machine +
+         ";build=" + fingerprint +
+         ";drm=" + to_string(HWInfoSnapshot::HashDRMInfo(crtc_info, planes_info)) +
+         ";config=" + to_string(max_vig_pipes) + "x" + to_string(max_dma_pipes) +
+         ";tonemap=" + to_string(!disable_src_tonemap);
+}
+
+void HWInfoDRM::UpdateSplashInfo(HWResourceInfo *hw_resource) {
+  // Planes staged by the bootloader or the previous composer instance, queried on every start.
+  hw_resource->plane_to_connector.clear();
+  hw_resource->initial_demura_planes.clear();
+  MapPlaneToConnector(hw_resource);
+  GetInitialDemuraInfo(hw_resource);
+
+  for (auto &pipe_caps : hw_resource->hw_pipes) {
+    pipe_caps.cont_splash_disp_id = -1;
+    pipe_caps.splash_type = kSplashNone;
+    auto it = hw_resource->plane_to_connector.find(pipe_caps.id);
+    if (it != hw_resource->plane_to_connector.end()) {
+      pipe_caps.cont_splash_disp_id = it->second;
+      auto it2 = std::find(hw_resource->initial_demura_planes.begin(),
+                           hw_resource->initial_demura_planes.end(), pipe_caps.id);
+      pipe_caps.splash_type = (it2 != hw_resource->initial_demura_planes.end()) ? kSplashDemura
+                                                                                : kSplashLayer;
+    }
+  }
+}
+
 void HWInfoDRM::GetSystemInfo(HWResourceInfo *hw_resource) {
   DRMCrtcInfo info;
   drm_mgr_intf_->GetCrtcInfo(0 /* system_info */, &info);
@@ -450,8 +535,6 @@ void HWInfoDRM::GetHWPlanesInfo(HWResourceInfo *hw_resource) {
   int disable_src_tonemap = 0;
   Debug::Get()->GetProperty(DISABLE_SRC_TONEMAP_PROP, &disable_src_tonemap);
 
-  MapPlaneToConnector(hw_resource);
-  GetInitialDemuraInfo(hw_resource);
   for (auto &pipe_obj : planes) {
     if (max_vig_pipes && max_dma_pipes) {
       uint32_t master_plane_id = pipe_obj.second.master_plane_id;
@@ -516,14 +599,6 @@ void HWInfoDRM::GetHWPlanesInfo(HWResourceInfo *hw_resource) {
         continue;  // Not adding any other pipe type
     }
     pipe_caps.id = pipe_obj.first;
-    auto it = hw_resource->plane_to_connector.find(pipe_caps.id);
-    if (it != hw_resource->plane_to_connector.end()) {
-      pipe_caps.cont_splash_disp_id = it->second;
-      auto it2 = std::find(hw_resource->initial_demura_planes.begin(),
-                           hw_resource->initial_demura_planes.end(), pipe_caps.id);
-      pipe_caps.splash_type = (it2 != hw_resource->initial_demura_planes.end()) ? kSplashDemura
-                                                                                : kSplashLayer;
-    }
     pipe_caps.master_pipe_id = pipe_obj.second.master_plane_id;
     pipe_caps.block_sec_ui = pipe_obj.second.block_sec_ui;
     DLOGI("Adding %s Pipe : Id %d, master_pipe_id : Id %d block_sec_ui: %d",
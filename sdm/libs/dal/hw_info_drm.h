@@ -71,6 +71,9 @@ class HWInfoDRM : public HWInfoInterface {
   void GetSystemInfo(HWResourceInfo *hw_resource);
   void GetHWPlanesInfo(HWResourceInfo *hw_resource);
   void GetWBInfo(HWResourceInfo *hw_resource);
+  void DiscoverHWResourceInfo(HWResourceInfo *hw_resource);
+  std::string GetSnapshotKey();
+  void UpdateSplashInfo(HWResourceInfo *hw_resource);
   DisplayError GetDynamicBWLimits(HWResourceInfo *hw_resource);
   void GetSDMFormat(uint32_t drm_format, uint64_t drm_format_modifier,
                     std::vector<LayerBufferFormat> *sdm_formats);
@@ -93,6 +96,8 @@ class HWInfoDRM : public HWInfoInterface {
 
   static const int kMaxStringLength = 1024;
   static const int kKiloUnit = 1000;
+  static constexpr const char *kSnapshotPath = "/data/vendor/display/hw_resource_info.bin";
+  static constexpr const char *kBuildFingerprintProp = "ro.vendor.build.fingerprint";
 
   static HWResourceInfo *hw_resource_;
 };
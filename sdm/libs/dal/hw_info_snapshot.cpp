@@ -0,0 +1,495 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <utils/constants.h>
+#include <utils/debug.h>
+
+#include <bitset>
+#include <fstream>
+#include <map>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "hw_info_snapshot.h"
+
+#define __CLASS__ "HWInfoSnapshot"
+
+namespace sdm {
+
+namespace {
+
+uint64_t Checksum(const char *data, size_t size, uint64_t hash = 0xcbf29ce484222325ULL) {
+  // FNV-1a, only guards against truncated or corrupted files.
+  for (size_t i = 0; i < size; i++) {
+    hash ^= static_cast<uint8_t>(data[i]);
+    hash *= 0x100000001b3ULL;
+  }
+
+  return hash;
+}
+
+// Both archives walk the same Visit() functions, so reading and writing can not drift apart.
+template <class Archive> void Visit(Archive *ar, HWDynBwLimitInfo *info) {
+  ar->Field(&info->cur_mode);
+  for (int index = 0; index < kBwModeMax; index++) {
+    ar->Field(&info->total_bw_limit[index]);
+    ar->Field(&info->pipe_bw_limit[index]);
+  }
+}
+
+template <class Archive> void Visit(Archive *ar, HWPipeCaps *caps) {
+  ar->Field(&caps->type);
+  ar->Field(&caps->id);
+  ar->Field(&caps->master_pipe_id);
+  ar->Field(&caps->max_rects);
+  ar->Field(&caps->inverse_pma);
+  ar->Field(&caps->dgm_csc_version);
+  ar->Field(&caps->tm_lut_version_map);
+  ar->Field(&caps->ucsc_block_version_map);
+  ar->Field(&caps->block_sec_ui);
+  ar->Field(&caps->cont_splash_disp_id);
+  ar->Field(&caps->splash_type);
+  ar->Field(&caps->pipe_idx);
+  ar->Field(&caps->demura_block_capability);
+}
+
+template <class Archive> void Visit(Archive *ar, HWRotatorInfo *info) {
+  ar->Field(&info->num_rotator);
+  ar->Field(&info->has_downscale);
+  ar->Field(&info->device_path);
+  ar->Field(&info->min_downscale);
+  ar->Field(&info->downscale_compression);
+  ar->Field(&info->max_line_width);
+}
+
+template <class Archive> void Visit(Archive *ar, HWDestScalarInfo *info) {
+  ar->Field(&info->count);
+  ar->Field(&info->max_input_width);
+  ar->Field(&info->max_output_width);
+  ar->Field(&info->max_scale_up);
+  ar->Field(&info->prefill_lines);
+}
+
+template <class Archive> void Visit(Archive *ar, InlineRotationInfo *info) {
+  ar->Field(&info->inrot_version);
+  ar->Field(&info->inrot_fmts_supported);
+  ar->Field(&info->max_downscale_rt);
+  ar->Field(&info->max_ds_without_pre_downscaler);
+}
+
+template <class Archive> void Visit(Archive *ar, HWResourceInfo *info) {
+  ar->Field(&info->hw_version);
+  ar->Field(&info->num_dma_pipe);
+  ar->Field(&info->num_vig_pipe);
+  ar->Field(&info->num_rgb_pipe);
+  ar->Field(&info->num_cursor_pipe);
+  ar->Field(&info->num_blending_stages);
+  ar->Field(&info->num_solidfill_stages);
+  ar->Field(&info->max_scale_up);
+  ar->Field(&info->max_scale_down);
+  ar->Field(&info->max_bandwidth_low);
+  ar->Field(&info->max_bandwidth_high);
+  ar->Field(&info->max_mixer_width);
+  ar->Field(&info->max_pipe_width);
+  ar->Field(&info->max_pipe_width_dma);
+  ar->Field(&info->max_scaler_pipe_width);
+  ar->Field(&info->max_rotation_pipe_width);
+  ar->Field(&info->max_cursor_size);
+  ar->Field(&info->max_pipe_bw);
+  ar->Field(&info->max_pipe_bw_high);
+  ar->Field(&info->max_sde_clk);
+  ar->Field(&info->clk_fudge_factor);
+  ar->Field(&info->macrotile_nv12_factor);
+  ar->Field(&info->macrotile_factor);
+  ar->Field(&info->linear_factor);
+  ar->Field(&info->scale_factor);
+  ar->Field(&info->extra_fudge_factor);
+  ar->Field(&info->amortizable_threshold);
+  ar->Field(&info->system_overhead_lines);
+  ar->Field(&info->has_ubwc);
+  ar->Field(&info->has_decimation);
+  ar->Field(&info->has_non_scalar_rgb);
+  ar->Field(&info->is_src_split);
+  ar->Field(&info->separate_rotator);
+  ar->Field(&info->has_qseed3);
+  ar->Field(&info->has_concurrent_writeback);
+  ar->Field(&info->tap_points);
+  ar->Field(&info->has_ppp);
+  ar->Field(&info->has_excl_rect);
+  ar->Field(&info->writeback_index);
+  ar->Field(&info->dyn_bw_info);
+  ar->Field(&info->hw_pipes);
+  ar->Field(&info->supported_formats_map);
+  ar->Field(&info->hw_rot_info);
+  ar->Field(&info->hw_dest_scalar_info);
+  ar->Field(&info->has_hdr);
+  ar->Field(&info->smart_dma_rev);
+  ar->Field(&info->ib_fudge_factor);
+  ar->Field(&info->undersized_prefill_lines);
+  ar->Field(&info->comp_ratio_rt_map);
+  ar->Field(&info->comp_ratio_nrt_map);
+  ar->Field(&info->cache_size);
+  ar->Field(&info->pipe_qseed3_version);
+  ar->Field(&info->min_prefill_lines);
+  ar->Field(&info->inline_rot_info);
+  ar->Field(&info->src_tone_map);
+  ar->Field(&info->secure_disp_blend_stage);
+  ar->Field(&info->line_width_constraints_count);
+  ar->Field(&info->line_width_limits);
+  ar->Field(&info->line_width_constraints);
+  ar->Field(&info->num_mnocports);
+  ar->Field(&info->mnoc_bus_width);
+  ar->Field(&info->use_baselayer_for_stage);
+  ar->Field(&info->has_micro_idle);
+  ar->Field(&info->ubwc_version);
+  ar->Field(&info->rc_total_mem_size);
+  ar->Field(&info->plane_to_connector);
+  ar->Field(&info->initial_demura_planes);
+  ar->Field(&info->demura_count);
+  ar->Field(&info->dspp_count);
+  ar->Field(&info->skip_inline_rot_threshold);
+  ar->Field(&info->has_noise_layer);
+  ar->Field(&info->dsc_block_count);
+  ar->Field(&info->ddr_version);
+}
+
+template <class Archive> void Visit(Archive *ar, sde_drm::DRMCrtcInfo *info) {
+  ar->Field(&info->has_src_split);
+  ar->Field(&info->has_hdr);
+  ar->Field(&info->max_blend_stages);
+  ar->Field(&info->max_solidfill_stages);
+  ar->Field(&info->qseed_version);
+  ar->Field(&info->smart_dma_rev);
+  ar->Field(&info->ib_fudge_factor);
+  ar->Field(&info->clk_fudge_factor);
+  ar->Field(&info->dest_scale_prefill_lines);
+  ar->Field(&info->undersized_prefill_lines);
+  ar->Field(&info->macrotile_prefill_lines);
+  ar->Field(&info->nv12_prefill_lines);
+  ar->Field(&info->linear_prefill_lines);
+  ar->Field(&info->downscale_prefill_lines);
+  ar->Field(&info->extra_prefill_lines);
+  ar->Field(&info->amortized_threshold);
+  ar->Field(&info->max_bandwidth_low);
+  ar->Field(&info->max_bandwidth_high);
+  ar->Field(&info->max_sde_clk);
+  ar->Field(&info->comp_ratio_rt_map);
+  ar->Field(&info->comp_ratio_nrt_map);
+  ar->Field(&info->hw_version);
+  ar->Field(&info->dest_scaler_count);
+  ar->Field(&info->max_dest_scaler_input_width);
+  ar->Field(&info->max_dest_scaler_output_width);
+  ar->Field(&info->max_dest_scale_up);
+  ar->Field(&info->min_prefill_lines);
+  ar->Field(&info->secure_disp_blend_stage);
+  ar->Field(&info->concurrent_writeback);
+  ar->Field(&info->tap_points);
+  ar->Field(&info->vig_limit_index);
+  ar->Field(&info->dma_limit_index);
+  ar->Field(&info->scaling_limit_index);
+  ar->Field(&info->rotation_limit_index);
+  ar->Field(&info->line_width_constraints_count);
+  ar->Field(&info->line_width_limits);
+  ar->Field(&info->num_mnocports);
+  ar->Field(&info->mnoc_bus_width);
+  ar->Field(&info->use_baselayer_for_stage);
+  ar->Field(&info->has_micro_idle);
+  ar->Field(&info->ubwc_version);
+  ar->Field(&info->has_spr);
+  ar->Field(&info->rc_total_mem_size);
+  ar->Field(&info->demura_count);
+  ar->Field(&info->dspp_count);
+  ar->Field(&info->skip_inline_rot_threshold);
+  ar->Field(&info->has_noise_layer);
+  ar->Field(&info->dsc_block_count);
+  ar->Field(&info->ddr_version);
+}
+
+template <class Archive> void Visit(Archive *ar, sde_drm::DRMPlaneTypeInfo *info) {
+  ar->Field(&info->type);
+  ar->Field(&info->master_plane_id);
+  ar->Field(&info->formats_supported);
+  ar->Field(&info->max_linewidth);
+  ar->Field(&info->max_scaler_linewidth);
+  ar->Field(&info->max_rotation_linewidth);
+  ar->Field(&info->max_upscale);
+  ar->Field(&info->max_downscale);
+  ar->Field(&info->max_horizontal_deci);
+  ar->Field(&info->max_vertical_deci);
+  ar->Field(&info->max_pipe_bandwidth);
+  ar->Field(&info->max_pipe_bandwidth_high);
+  ar->Field(&info->cache_size);
+  ar->Field(&info->has_excl_rect);
+  ar->Field(&info->qseed3_version);
+  ar->Field(&info->multirect_prop_present);
+  ar->Field(&info->inrot_version);
+  ar->Field(&info->inrot_fmts_supported);
+  ar->Field(&info->true_inline_dwnscale_rt_num);
+  ar->Field(&info->true_inline_dwnscale_rt_denom);
+  ar->Field(&info->inverse_pma);
+  ar->Field(&info->dgm_csc_version);
+  ar->Field(&info->tonemap_lut_version_map);
+  ar->Field(&info->ucsc_block_version_map);
+  ar->Field(&info->block_sec_ui);
+  ar->Field(&info->pipe_idx);
+  ar->Field(&info->demura_block_capability);
+}
+
+class SnapshotWriter {
+ public:
+  explicit SnapshotWriter(std::string *data) : data_(data) {}
+
+  template <class T> void Field(T *value) {
+    Scalar(value, std::integral_constant<bool, std::is_arithmetic<T>::value ||
+                                               std::is_enum<T>::value>());
+  }
+
+  void Field(std::string *value) {
+    uint32_t size = UINT32(value->size());
+    Field(&size);
+    data_->append(value->data(), size);
+  }
+
+  template <size_t N> void Field(std::bitset<N> *value) {
+    uint64_t bits = value->to_ullong();
+    Field(&bits);
+  }
+
+  template <class A, class B> void Field(std::pair<A, B> *value) {
+    Field(&value->first);
+    Field(&value->second);
+  }
+
+  template <class T> void Field(std::vector<T> *value) {
+    uint32_t size = UINT32(value->size());
+    Field(&size);
+    for (auto &element : *value) {
+      Field(&element);
+    }
+  }
+
+  template <class K, class V> void Field(std::map<K, V> *value) {
+    uint32_t size = UINT32(value->size());
+    Field(&size);
+    for (auto &element : *value) {
+      K key = element.first;
+      Field(&key);
+      Field(&element.second);
+    }
+  }
+
+ private:
+  template <class T> void Scalar(T *value, std::true_type) {
+    data_->append(reinterpret_cast<const char *>(value), sizeof(T));
+  }
+
+  template <class T> void Scalar(T *value, std::false_type) { Visit(this, value); }
+
+  std::string *data_;
+};
+
+// Bounds checked, the first short read fails the whole snapshot and leaves the rest untouched.
+class SnapshotReader {
+ public:
+  SnapshotReader(const char *data, size_t size) : data_(data), size_(size) {}
+  bool IsComplete() { return ok_ && (offset_ == size_); }
+
+  template <class T> void Field(T *value) {
+    Scalar(value, std::integral_constant<bool, std::is_arithmetic<T>::value ||
+                                               std::is_enum<T>::value>());
+  }
+
+  void Field(std::string *value) {
+    uint32_t size = 0;
+    Field(&size);
+    if (Fits(size)) {
+      value->assign(data_ + offset_, size);
+      offset_ += size;
+    }
+  }
+
+  template <size_t N> void Field(std::bitset<N> *value) {
+    uint64_t bits = 0;
+    Field(&bits);
+    *value = std::bitset<N>(bits);
+  }
+
+  template <class A, class B> void Field(std::pair<A, B> *value) {
+    Field(&value->first);
+    Field(&value->second);
+  }
+
+  template <class T> void Field(std::vector<T> *value) {
+    uint32_t size = 0;
+    Field(&size);
+    // Every element takes at least one byte, larger counts come from a corrupted file.
+    if (!Fits(size)) {
+      return;
+    }
+    value->clear();
+    value->resize(size);
+    for (auto &element : *value) {
+      Field(&element);
+    }
+  }
+
+  template <class K, class V> void Field(std::map<K, V> *value) {
+    uint32_t size = 0;
+    Field(&size);
+    if (!Fits(size)) {
+      return;
+    }
+    value->clear();
+    for (uint32_t i = 0; (i < size) && ok_; i++) {
+      K key = {};
+      V element = {};
+      Field(&key);
+      Field(&element);
+      (*value)[key] = std::move(element);
+    }
+  }
+
+ private:
+  bool Fits(size_t size) {
+    ok_ = ok_ && (size <= (size_ - offset_));
+    return ok_;
+  }
+
+  template <class T> void Scalar(T *value, std::true_type) {
+    if (Fits(sizeof(T))) {
+      memcpy(value, data_ + offset_, sizeof(T));
+      offset_ += sizeof(T);
+    }
+  }
+
+  template <class T> void Scalar(T *value, std::false_type) { Visit(this, value); }
+
+  const char *data_;
+  size_t size_;
+  size_t offset_ = 0;
+  bool ok_ = true;
+};
+
+}  // namespace
+
+uint64_t HWInfoSnapshot::HashDRMInfo(const sde_drm::DRMCrtcInfo &crtc_info,
+                                     const sde_drm::DRMPlanesInfo &planes_info) {
+  std::string data;
+  SnapshotWriter writer(&data);
+  sde_drm::DRMCrtcInfo crtc = crtc_info;
+  sde_drm::DRMPlanesInfo planes = planes_info;
+  writer.Field(&crtc);
+  writer.Field(&planes);
+
+  return Checksum(data.data(), data.size());
+}
+
+DisplayError HWInfoSnapshot::Load(HWResourceInfo *hw_resource) {
+  std::ifstream file(path_, std::ios::binary);
+  if (!file.is_open()) {
+    DLOGI("No snapshot at %s", path_);
+    return kErrorNotSupported;
+  }
+
+  Header header = {};
+  if (!file.read(reinterpret_cast<char *>(&header), sizeof(header)) ||
+      header.magic != kMagic || header.version != kVersion) {
+    DLOGI("Ignoring %s, unknown format", path_);
+    return kErrorNotSupported;
+  }
+
+  if (header.key_size != key_.size() || header.payload_size > kMaxSize) {
+    DLOGI("Ignoring %s, taken on different hardware or software", path_);
+    return kErrorNotSupported;
+  }
+
+  std::string data(header.key_size + header.payload_size, '\0');
+  if (!file.read(&data[0], std::streamsize(data.size())) || file.peek() != EOF) {
+    DLOGW("Ignoring %s, unexpected size", path_);
+    return kErrorNotSupported;
+  }
+
+  if (data.compare(0, key_.size(), key_)) {
+    DLOGI("Ignoring %s, taken on different hardware or software", path_);
+    return kErrorNotSupported;
+  }
+
+  if (Checksum(data.data(), data.size()) != header.checksum) {
+    DLOGW("Ignoring %s, checksum mismatch", path_);
+    return kErrorNotSupported;
+  }
+
+  HWResourceInfo snapshot;
+  SnapshotReader reader(data.data() + key_.size(), header.payload_size);
+  reader.Field(&snapshot);
+  if (!reader.IsComplete()) {
+    DLOGW("Ignoring %s, malformed payload", path_);
+    return kErrorNotSupported;
+  }
+
+  *hw_resource = std::move(snapshot);
+  DLOGI("Loaded %zu bytes from %s", data.size(), path_);
+
+  return kErrorNone;
+}
+
+DisplayError HWInfoSnapshot::Store(const HWResourceInfo &hw_resource) {
+  std::string data = key_;
+  HWResourceInfo snapshot = hw_resource;
+  SnapshotWriter writer(&data);
+  writer.Field(&snapshot);
+
+  Header header = {};
+  header.magic = kMagic;
+  header.version = kVersion;
+  header.key_size = UINT32(key_.size());
+  header.payload_size = UINT32(data.size() - key_.size());
+  header.checksum = Checksum(data.data(), data.size());
+
+  // Write aside and rename, a crash mid write must not leave a truncated snapshot behind. The
+  // data must be on disk before the rename is, or a power loss can still leave an empty file.
+  std::string temp_path = std::string(path_) + ".tmp";
+  FILE *fp = fopen(temp_path.c_str(), "wb");
+  if (!fp) {
+    DLOGW("Failed to create %s, error = %d", temp_path.c_str(), errno);
+    return kErrorResources;
+  }
+  bool written = (fwrite(&header, sizeof(header), 1, fp) == 1) &&
+                 (fwrite(data.data(), data.size(), 1, fp) == 1) && !fflush(fp) &&
+                 !fsync(fileno(fp));
+  if (fclose(fp) || !written) {
+    DLOGW("Failed to write %s, error = %d", temp_path.c_str(), errno);
+    remove(temp_path.c_str());
+    return kErrorResources;
+  }
+
+  if (rename(temp_path.c_str(), path_)) {
+    DLOGW("Failed to rename %s to %s, error = %d", temp_path.c_str(), path_, errno);
+    remove(temp_path.c_str());
+    return kErrorResources;
+  }
+
+  // Persist the rename itself. Failing that only costs a rediscovery on the next start.
+  std::string dir = path_;
+  dir = dir.substr(0, dir.find_last_of('/') + 1);
+  int dir_fd = open(dir.empty() ? "." : dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (dir_fd >= 0) {
+    fsync(dir_fd);
+    close(dir_fd);
+  }
+
+  DLOGI("Stored %zu bytes to %s", data.size(), path_);
+
+  return kErrorNone;
+}
+
+}  // namespace sdm
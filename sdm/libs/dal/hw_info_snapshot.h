@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __HW_INFO_SNAPSHOT_H__
+#define __HW_INFO_SNAPSHOT_H__
+
+#include <core/sdm_types.h>
+#include <drm_interface.h>
+#include <private/hw_info_types.h>
+#include <stdint.h>
+#include <string>
+
+namespace sdm {
+
+// Persists the discovered HWResourceInfo so that a restarted composer can skip the writeback,
+// rotator and plane capability probes. The snapshot is tagged with a caller supplied key which
+// must change whenever discovery could yield a different result (kernel and vendor builds, the
+// capabilities sde-drm parsed, properties consulted during discovery). A snapshot with a different key, version or checksum
+// is ignored and rewritten after discovery.
+class HWInfoSnapshot {
+ public:
+  HWInfoSnapshot(const char *path, const std::string &key) : path_(path), key_(key) {}
+  DisplayError Load(HWResourceInfo *hw_resource);
+  DisplayError Store(const HWResourceInfo &hw_resource);
+
+  // Hash of the capabilities sde-drm parsed at init, for use in the key. Any change in the CRTC
+  // or plane caps, e.g. from a kernel or device tree update, yields a different hash.
+  static uint64_t HashDRMInfo(const sde_drm::DRMCrtcInfo &crtc_info,
+                              const sde_drm::DRMPlanesInfo &planes_info);
+
+ private:
+  // Bump whenever HWResourceInfo or anything it contains changes layout or meaning.
+  static const uint32_t kVersion = 1;
+  static const uint32_t kMagic = 0x53574848;  // 'HHWS'
+  static const uint32_t kMaxSize = 1024 * 1024;
+
+  struct Header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t key_size;
+    uint32_t payload_size;
+    uint64_t checksum;  // Over key and payload
+  };
+
+  const char *path_;
+  std::string key_;
+};
+
+}  // namespace sdm
+
+#endif  // __HW_INFO_SNAPSHOT_H__
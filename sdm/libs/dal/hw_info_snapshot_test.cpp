@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <stdio.h>
+#include <unistd.h>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "hw_info_snapshot.h"
+
+namespace sdm {
+namespace {
+
+const char *kKey = "6.1.0 #1 SMP aarch64;build=vendor/device:14/1:user;drm=1;config=0x0;tonemap=1";
+
+// Non default values in every kind of field the snapshot walks.
+HWResourceInfo GetResourceInfo() {
+  HWResourceInfo info;
+  info.hw_version = 0x80000000;
+  info.num_vig_pipe = 4;
+  info.num_dma_pipe = 6;
+  info.max_bandwidth_high = 1ULL << 40;
+  info.clk_fudge_factor = 1.05f;
+  info.has_ubwc = true;
+  info.tap_points = {kLmTapPoint, kDemuraTapPoint};
+  info.dyn_bw_info.total_bw_limit[kBwVFEOff] = 123456789;
+
+  HWPipeCaps pipe;
+  pipe.type = kPipeTypeVIG;
+  pipe.id = 47;
+  pipe.max_rects = 2;
+  pipe.tm_lut_version_map[kDma1dGc] = 3;
+  pipe.cont_splash_disp_id = 1;
+  info.hw_pipes = {pipe, pipe};
+  info.hw_pipes[1].id = 48;
+  info.hw_pipes[1].type = kPipeTypeDMA;
+
+  info.supported_formats_map[kHWVIGPipe] = {kFormatRGBA8888, kFormatYCbCr420SemiPlanarVenus};
+  info.supported_formats_map[kHWDMAPipe] = {kFormatRGB565};
+  info.hw_rot_info.num_rotator = 1;
+  info.hw_rot_info.device_path = "/dev/video3";
+  info.hw_rot_info.min_downscale = 1.5f;
+  info.comp_ratio_rt_map[kFormatRGBA8888Ubwc] = 1.25f;
+  info.src_tone_map = 0x5;
+  info.secure_disp_blend_stage = 3;
+  info.line_width_limits = {{4096, 2560}, {5120, 4096}};
+  info.plane_to_connector = {{47, 31}, {48, 32}};
+  info.initial_demura_planes = {60};
+  info.ddr_version = kDDRVersion5x;
+
+  return info;
+}
+
+std::string ReadFile(const std::string &path) {
+  std::ifstream file(path, std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+void WriteFile(const std::string &path, const std::string &data) {
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  file.write(data.data(), std::streamsize(data.size()));
+}
+
+class HWInfoSnapshotTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    path_ = ::testing::TempDir() + "hw_info_snapshot_test_" + std::to_string(getpid());
+  }
+
+  void TearDown() override {
+    remove(path_.c_str());
+    remove((path_ + ".copy").c_str());
+  }
+
+  std::string path_;
+};
+
+}  // namespace
+
+TEST_F(HWInfoSnapshotTest, RoundTrip) {
+  HWInfoSnapshot snapshot(path_.c_str(), kKey);
+  ASSERT_EQ(snapshot.Store(GetResourceInfo()), kErrorNone);
+  EXPECT_NE(access((path_ + ".tmp").c_str(), F_OK), 0);
+
+  HWResourceInfo loaded;
+  ASSERT_EQ(snapshot.Load(&loaded), kErrorNone);
+  EXPECT_EQ(loaded.hw_version, 0x80000000u);
+  EXPECT_EQ(loaded.max_bandwidth_high, 1ULL << 40);
+  EXPECT_EQ(loaded.clk_fudge_factor, 1.05f);
+  EXPECT_EQ(loaded.tap_points, (std::vector<CwbTapPoint>{kLmTapPoint, kDemuraTapPoint}));
+  ASSERT_EQ(loaded.hw_pipes.size(), 2u);
+  EXPECT_EQ(loaded.hw_pipes[1].id, 48u);
+  EXPECT_EQ(loaded.hw_pipes[1].type, kPipeTypeDMA);
+  EXPECT_EQ(loaded.hw_pipes[0].tm_lut_version_map[kDma1dGc], 3u);
+  EXPECT_EQ(loaded.supported_formats_map[kHWVIGPipe].size(), 2u);
+  EXPECT_EQ(loaded.hw_rot_info.device_path, "/dev/video3");
+  EXPECT_EQ(loaded.src_tone_map.to_ulong(), 0x5u);
+  EXPECT_EQ(loaded.plane_to_connector[48], 32u);
+  EXPECT_EQ(loaded.ddr_version, kDDRVersion5x);
+
+  // Every visited field survives: storing what was loaded gives the same file.
+  std::string copy_path = path_ + ".copy";
+  HWInfoSnapshot copy(copy_path.c_str(), kKey);
+  ASSERT_EQ(copy.Store(loaded), kErrorNone);
+  EXPECT_EQ(ReadFile(copy_path), ReadFile(path_));
+}
+
+TEST_F(HWInfoSnapshotTest, DifferentKeyIsIgnored) {
+  ASSERT_EQ(HWInfoSnapshot(path_.c_str(), kKey).Store(GetResourceInfo()), kErrorNone);
+
+  HWResourceInfo loaded;
+  std::string other_key = kKey;
+  other_key.back() = '0';
+  EXPECT_NE(HWInfoSnapshot(path_.c_str(), other_key).Load(&loaded), kErrorNone);
+  EXPECT_NE(HWInfoSnapshot(path_.c_str(), std::string(kKey) + "x").Load(&loaded), kErrorNone);
+  EXPECT_EQ(loaded.hw_version, 0u);
+}
+
+TEST_F(HWInfoSnapshotTest, DamagedFileIsIgnored) {
+  HWInfoSnapshot snapshot(path_.c_str(), kKey);
+  HWResourceInfo loaded;
+  EXPECT_NE(snapshot.Load(&loaded), kErrorNone);
+
+  ASSERT_EQ(snapshot.Store(GetResourceInfo()), kErrorNone);
+  std::string data = ReadFile(path_);
+
+  std::string corrupted = data;
+  corrupted[corrupted.size() / 2] ^= 0x40;
+  WriteFile(path_, corrupted);
+  EXPECT_NE(snapshot.Load(&loaded), kErrorNone);
+
+  WriteFile(path_, data.substr(0, data.size() - 1));
+  EXPECT_NE(snapshot.Load(&loaded), kErrorNone);
+
+  WriteFile(path_, data + "x");
+  EXPECT_NE(snapshot.Load(&loaded), kErrorNone);
+
+  WriteFile(path_, "");
+  EXPECT_NE(snapshot.Load(&loaded), kErrorNone);
+  EXPECT_EQ(loaded.hw_version, 0u);
+
+  // Storing again replaces the damaged file.
+  ASSERT_EQ(snapshot.Store(GetResourceInfo()), kErrorNone);
+  EXPECT_EQ(snapshot.Load(&loaded), kErrorNone);
+}
+
+TEST_F(HWInfoSnapshotTest, DRMHashTracksCapabilities) {
+  sde_drm::DRMCrtcInfo crtc_info = {};
+  crtc_info.hw_version = 0x80000000;
+  crtc_info.max_blend_stages = 11;
+  sde_drm::DRMPlaneTypeInfo plane = {};
+  plane.max_linewidth = 5120;
+  plane.formats_supported = {{0x34325241, 0}};
+  sde_drm::DRMPlanesInfo planes_info = {{47, plane}, {48, plane}};
+
+  uint64_t hash = HWInfoSnapshot::HashDRMInfo(crtc_info, planes_info);
+  EXPECT_EQ(HWInfoSnapshot::HashDRMInfo(crtc_info, planes_info), hash);
+
+  sde_drm::DRMCrtcInfo other_crtc = crtc_info;
+  other_crtc.dspp_count = 2;
+  EXPECT_NE(HWInfoSnapshot::HashDRMInfo(other_crtc, planes_info), hash);
+
+  sde_drm::DRMPlanesInfo other_planes = planes_info;
+  other_planes[1].second.max_linewidth = 4096;
+  EXPECT_NE(HWInfoSnapshot::HashDRMInfo(crtc_info, other_planes), hash);
+
+  other_planes = planes_info;
+  other_planes[1].second.formats_supported.push_back({0x3231564e, 1});
+  EXPECT_NE(HWInfoSnapshot::HashDRMInfo(crtc_info, other_planes), hash);
+
+  other_planes = planes_info;
+  other_planes.pop_back();
+  EXPECT_NE(HWInfoSnapshot::HashDRMInfo(crtc_info, other_planes), hash);
+}
+
+}  // namespace sdm
@@ -184,13 +184,9 @@ DisplayError HWTVDRM::GetConfigIndex(char *mode, uint32_t *index) {
     std::string str4 = str3.substr(str3.find(':') + 1);
   }
 
-  for (size_t idex = 0; idex < connector_info_.modes.size(); idex ++) {
-    if ((height == connector_info_.modes[idex].mode.vdisplay) &&
-        (width == connector_info_.modes[idex].mode.hdisplay) &&
-        (fps == connector_info_.modes[idex].mode.vrefresh)) {
-        *index = UINT32(idex);
-        break;
-    }
+  auto &mode_indices = GetModeIndices(width, height, fps);
+  if (!mode_indices.empty()) {
+    *index = mode_indices.front();
   }
 
   return kErrorNone;
@@ -90,6 +90,7 @@ void HWVirtualDRM::ConfigureWbConnectorSecureMode(bool secure) {
 }
 
 void HWVirtualDRM::InitializeConfigs() {
+  BuildModeIndex();
   display_attributes_.resize(connector_info_.modes.size());
   for (uint32_t i = 0; i < connector_info_.modes.size(); i++) {
     PopulateDisplayAttributes(i);
@@ -35,6 +35,7 @@
  * SPDX-License-Identifier: BSD-3-Clause-Clear
  */
 
+#include <stdio.h>
 #include <stdlib.h>
 #include <utils/debug.h>
 #include <utils/constants.h>
@@ -53,154 +54,172 @@ void __llvm_profile_try_write_file(void);
 
 namespace sdm {
 
-int Debug::GetSimulationFlag() {
-  int value = 0;
-  DebugHandler::Get()->GetProperty(COMPOSITION_MASK_PROP, &value);
+std::atomic<const DebugProperties *> Debug::properties_(nullptr);
+std::vector<std::unique_ptr<const DebugProperties>> Debug::snapshots_;
+std::mutex Debug::reload_lock_;
+
+// Called with reload_lock_ held.
+const DebugProperties *Debug::LoadProperties() {
+  DebugHandler *handler = DebugHandler::Get();
+  std::unique_ptr<DebugProperties> properties = std::make_unique<DebugProperties>();
+
+  handler->GetProperty(COMPOSITION_MASK_PROP, &properties->composition_mask);
+  handler->GetProperty(HDMI_CONFIG_INDEX_PROP, properties->hdmi_config_index);
+  properties->idle_time_active_ms = IDLE_TIMEOUT_ACTIVE_MS;
+  properties->idle_time_inactive_ms = IDLE_TIMEOUT_INACTIVE_MS;
+  handler->GetProperty(IDLE_TIME_PROP, &properties->idle_time_active_ms);
+  handler->GetProperty(IDLE_TIME_INACTIVE_PROP, &properties->idle_time_inactive_ms);
+  handler->GetProperty(DISABLE_ROTATOR_DOWNSCALE_PROP, &properties->disable_rotator_downscale);
+  handler->GetProperty(ENABLE_ROTATOR_UI_PROP, &properties->enable_rotator_ui);
+  handler->GetProperty(DISABLE_DECIMATION_PROP, &properties->disable_decimation);
+  handler->GetProperty(PRIMARY_MIXER_STAGES_PROP, &properties->primary_mixer_stages);
+  handler->GetProperty(EXTERNAL_MIXER_STAGES_PROP, &properties->external_mixer_stages);
+  handler->GetProperty(VIRTUAL_MIXER_STAGES_PROP, &properties->virtual_mixer_stages);
+  handler->GetProperty(MAX_UPSCALE_PROP, &properties->max_upscale);
+  handler->GetProperty(VIDEO_MODE_PANEL_PROP, &properties->video_mode_panel);
+  handler->GetProperty(DISABLE_ROTATOR_UBWC_PROP, &properties->disable_rotator_ubwc);
+  handler->GetProperty(DISABLE_ROTATOR_SPLIT_PROP, &properties->disable_rotator_split);
+  handler->GetProperty(DISABLE_SCALER_PROP, &properties->disable_scaler);
+  handler->GetProperty(DISABLE_UBWC_PROP, &properties->disable_ubwc);
+  handler->GetProperty(DISABLE_AVR_PROP, &properties->disable_avr);
+  handler->GetProperty(DISABLE_EXTERNAL_ANIMATION_PROP,
+                       &properties->disable_external_animation);
+  handler->GetProperty(DISABLE_PARTIAL_SPLIT_PROP, &properties->disable_partial_split);
+  handler->GetProperty(PREFER_SOURCE_SPLIT_PROP, &properties->prefer_source_split);
+  handler->GetProperty(DISABLE_INLINE_ROTATOR_PROP, properties->disable_inline_rotator);
+  handler->GetProperty(DISABLE_OFFLINE_ROTATOR_PROP, properties->disable_offline_rotator);
+  properties->has_mixer_resolution =
+      !handler->GetProperty(MIXER_RESOLUTION_PROP, properties->mixer_resolution);
+  properties->has_window_rect[0] =
+      !handler->GetProperty(WINDOW_RECT_PROP, properties->window_rect[0]);
+  properties->has_window_rect[1] =
+      !handler->GetProperty(WINDOW_RECT_PROP_SECONDARY, properties->window_rect[1]);
+  properties->has_null_display_resolution =
+      !handler->GetProperty(NULL_DISPLAY_RESOLUTION_PROP, properties->null_display_resolution);
+  properties->has_simulated_config =
+      !handler->GetProperty(SIMULATED_CONFIG_PROP, properties->simulated_config);
+  handler->GetProperty(MAX_SECONDARY_FETCH_LAYERS_PROP,
+                       &properties->max_secondary_fetch_layers);
+  handler->GetProperty(ANTI_AGING_CWB_DOWNSACLE_X, &properties->cwb_downscale_x);
+  handler->GetProperty(ANTI_AGING_CWB_DOWNSACLE_Y, &properties->cwb_downscale_y);
+  handler->GetProperty(ENABLE_INLINE_WRITEBACK, &properties->enable_inline_writeback);
+
+  // Readers may still hold an older snapshot, none is freed while the process runs.
+  snapshots_.push_back(std::move(properties));
+  return snapshots_.back().get();
+}
 
-  return value;
+void Debug::ReloadProperties() {
+  std::lock_guard<std::mutex> lock(reload_lock_);
+  properties_.store(LoadProperties(), std::memory_order_release);
 }
 
-bool Debug::GetExternalResolution(char *value) {
-  uint32_t retval = 0;
-  DebugHandler::Get()->GetProperty(HDMI_CONFIG_INDEX_PROP, value);
-  if (value[0]) {
-    retval = 1;
+const DebugProperties *Debug::GetProperties() {
+  const DebugProperties *properties = properties_.load(std::memory_order_acquire);
+  if (!properties) {
+    std::lock_guard<std::mutex> lock(reload_lock_);
+    properties = properties_.load(std::memory_order_acquire);
+    if (!properties) {
+      properties = LoadProperties();
+      properties_.store(properties, std::memory_order_release);
+    }
   }
 
-  return retval;
+  return properties;
 }
 
-void Debug::GetIdleTimeoutMs(uint32_t *active_ms, uint32_t *inactive_ms) {
-  int active_val = IDLE_TIMEOUT_ACTIVE_MS;
-  int inactive_val = IDLE_TIMEOUT_INACTIVE_MS;
+int Debug::GetSimulationFlag() {
+  return GetProperties()->composition_mask;
+}
 
-  DebugHandler::Get()->GetProperty(IDLE_TIME_PROP, &active_val);
-  DebugHandler::Get()->GetProperty(IDLE_TIME_INACTIVE_PROP, &inactive_val);
+bool Debug::GetExternalResolution(char *value) {
+  auto properties = GetProperties();
+  snprintf(value, DebugProperties::kValueMax, "%s", properties->hdmi_config_index);
 
-  *active_ms = UINT32(active_val);
-  *inactive_ms = UINT32(inactive_val);
+  return (value[0] != 0);
 }
 
-bool Debug::IsRotatorDownScaleDisabled() {
-  int value = 0;
-  DebugHandler::Get()->GetProperty(DISABLE_ROTATOR_DOWNSCALE_PROP, &value);
+void Debug::GetIdleTimeoutMs(uint32_t *active_ms, uint32_t *inactive_ms) {
+  auto properties = GetProperties();
+  *active_ms = UINT32(properties->idle_time_active_ms);
+  *inactive_ms = UINT32(properties->idle_time_inactive_ms);
+}
 
-  return (value == 1);
+bool Debug::IsRotatorDownScaleDisabled() {
+  return (GetProperties()->disable_rotator_downscale == 1);
 }
 
 bool Debug::IsRotatorEnabledForUi() {
-  int value = 0;
-  DebugHandler::Get()->GetProperty(ENABLE_ROTATOR_UI_PROP, &value);
-
-  return (value == 1);
+  return (GetProperties()->enable_rotator_ui == 1);
 }
 
 bool Debug::IsDecimationDisabled() {
-  int value = 0;
-  DebugHandler::Get()->GetProperty(DISABLE_DECIMATION_PROP, &value);
-
-  return (value == 1);
+  return (GetProperties()->disable_decimation == 1);
 }
 
 int Debug::GetMaxPipesPerMixer(DisplayType display_type) {
-  int value = -1;
+  auto properties = GetProperties();
   switch (display_type) {
     case kBuiltIn:
-      DebugHandler::Get()->GetProperty(PRIMARY_MIXER_STAGES_PROP, &value);
-      break;
+      return properties->primary_mixer_stages;
     case kPluggable:
-      DebugHandler::Get()->GetProperty(EXTERNAL_MIXER_STAGES_PROP, &value);
-      break;
+      return properties->external_mixer_stages;
     case kVirtual:
-      DebugHandler::Get()->GetProperty(VIRTUAL_MIXER_STAGES_PROP, &value);
-      break;
+      return properties->virtual_mixer_stages;
     default:
       break;
   }
 
-  return value;
+  return -1;
 }
 
 int Debug::GetMaxUpscale() {
-  int value = 0;
-  DebugHandler::Get()->GetProperty(MAX_UPSCALE_PROP, &value);
-
-  return value;
+  return GetProperties()->max_upscale;
 }
 
 bool Debug::IsVideoModeEnabled() {
-  int value = 0;
-  DebugHandler::Get()->GetProperty(VIDEO_MODE_PANEL_PROP, &value);
-
-  return (value == 1);
+  return (GetProperties()->video_mode_panel == 1);
 }
 
 bool Debug::IsRotatorUbwcDisabled() {
-  int value = 0;
-  DebugHandler::Get()->GetProperty(DISABLE_ROTATOR_UBWC_PROP, &value);
-
-  return (value == 1);
+  return (GetProperties()->disable_rotator_ubwc == 1);
 }
 
 bool Debug::IsRotatorSplitDisabled() {
-  int value = 0;
-  DebugHandler::Get()->GetProperty(DISABLE_ROTATOR_SPLIT_PROP, &value);
-
-  return (value == 1);
+  return (GetProperties()->disable_rotator_split == 1);
 }
 
 bool Debug::IsScalarDisabled() {
-  int value = 0;
-  DebugHandler::Get()->GetProperty(DISABLE_SCALER_PROP, &value);
-
-  return (value == 1);
+  return (GetProperties()->disable_scaler == 1);
 }
 
 bool Debug::IsUbwcTiledFrameBuffer() {
-  int ubwc_disabled = 0;
-
-  DebugHandler::Get()->GetProperty(DISABLE_UBWC_PROP, &ubwc_disabled);
-
-  return (ubwc_disabled == 0);
+  return (GetProperties()->disable_ubwc == 0);
 }
 
 bool Debug::IsAVRDisabled() {
-  int value = 0;
-  DebugHandler::Get()->GetProperty(DISABLE_AVR_PROP, &value);
-
-  return (value == 1);
+  return (GetProperties()->disable_avr == 1);
 }
 
 bool Debug::IsExtAnimDisabled() {
-  int value = 0;
-  DebugHandler::Get()->GetProperty(DISABLE_EXTERNAL_ANIMATION_PROP, &value);
-
-  return (value == 1);
+  return (GetProperties()->disable_external_animation == 1);
 }
 
 bool Debug::IsPartialSplitDisabled() {
-  int value = 0;
-  DebugHandler::Get()->GetProperty(DISABLE_PARTIAL_SPLIT_PROP, &value);
-
-  return (value == 1);
+  return (GetProperties()->disable_partial_split == 1);
 }
 
 bool Debug::IsSrcSplitPreferred() {
-  int value = 0;
-  DebugHandler::Get()->GetProperty(PREFER_SOURCE_SPLIT_PROP, &value);
-
-  return (value == 1);
+  return (GetProperties()->prefer_source_split == 1);
 }
 
 int Debug::GetMixerResolution(uint32_t *width, uint32_t *height) {
-  char value[64] = {};
-
-  int error = DebugHandler::Get()->GetProperty(MIXER_RESOLUTION_PROP, value);
-  if (error != 0) {
+  auto properties = GetProperties();
+  if (!properties->has_mixer_resolution) {
     return -ENOTSUP;
   }
 
-  std::string str(value);
+  std::string str(properties->mixer_resolution);
 
   *width = UINT32(stoi(str));
   *height = UINT32(stoi(str.substr(str.find('x') + 1)));
@@ -209,19 +228,13 @@ int Debug::GetMixerResolution(uint32_t *width, uint32_t *height) {
 }
 
 int Debug::GetWindowRect(bool primary, float *left, float *top, float *right, float *bottom) {
-  char value[64] = {};
-  int error = -EINVAL;
-  if (primary) {
-    error = DebugHandler::Get()->GetProperty(WINDOW_RECT_PROP, value);
-  } else {
-    error = DebugHandler::Get()->GetProperty(WINDOW_RECT_PROP_SECONDARY, value);
-  }
-
-  if (error != 0) {
+  auto properties = GetProperties();
+  int index = primary ? 0 : 1;
+  if (!properties->has_window_rect[index]) {
     return -EINVAL;
   }
 
-  std::string str(value);
+  std::string str(properties->window_rect[index]);
   *left = FLOAT(stof(str));
   str = (str.substr(str.find(',') + 1));
   *top = FLOAT(stof(str));
@@ -238,14 +251,12 @@ int Debug::GetWindowRect(bool primary, float *left, float *top, float *right, fl
 }
 
 int Debug::GetReducedConfig(uint32_t *num_vig_pipes, uint32_t *num_dma_pipes) {
-  char value[64] = {};
-
-  int error = DebugHandler::Get()->GetProperty(SIMULATED_CONFIG_PROP, value);
-  if (error != 0) {
+  auto properties = GetProperties();
+  if (!properties->has_simulated_config) {
     return -ENOTSUP;
   }
 
-  std::string str(value);
+  std::string str(properties->simulated_config);
 
   *num_vig_pipes = UINT32(stoi(str));
   *num_dma_pipes = UINT32(stoi(str.substr(str.find('x') + 1)));
@@ -254,28 +265,18 @@ int Debug::GetReducedConfig(uint32_t *num_vig_pipes, uint32_t *num_dma_pipes) {
 }
 
 int Debug::GetSecondaryMaxFetchLayers() {
-  int max_secondary_fetch_layers = 0;
-  DebugHandler::Get()->GetProperty(MAX_SECONDARY_FETCH_LAYERS_PROP, &max_secondary_fetch_layers);
-
-  return std::max(max_secondary_fetch_layers, 2);
+  return std::max(GetProperties()->max_secondary_fetch_layers, 2);
 }
 
 bool Debug::IsIWEEnabled() {
-  int value = 0;
+  auto properties = GetProperties();
 
   // DNSC block will be prioritized to DemuraTn over IWE
-  DebugHandler::Get()->GetProperty(ANTI_AGING_CWB_DOWNSACLE_X, &value);
-  if (value > 1) {
-    return false;
-  }
-  DebugHandler::Get()->GetProperty(ANTI_AGING_CWB_DOWNSACLE_Y, &value);
-  if (value > 1) {
+  if (properties->cwb_downscale_x > 1 || properties->cwb_downscale_y > 1) {
     return false;
   }
 
-  DebugHandler::Get()->GetProperty(ENABLE_INLINE_WRITEBACK, &value);
-
-  return (value == 1);
+  return (properties->enable_inline_writeback == 1);
 }
 
 int Debug::GetProperty(const char *property_name, char *value) {
@@ -301,26 +302,20 @@ int Debug::GetProperty(const char *property_name, int *value) {
 }
 
 bool Debug::GetPropertyDisableInlineMode() {
-  char value[64] = "0";
-  Debug::GetProperty(DISABLE_INLINE_ROTATOR_PROP, value);
-  return (atoi(value) == 1);
+  return (atoi(GetProperties()->disable_inline_rotator) == 1);
 }
 
 bool Debug::GetPropertyDisableOfflineMode() {
-  char value[64] = "0";
-  Debug::GetProperty(DISABLE_OFFLINE_ROTATOR_PROP, value);
-  return (atoi(value) == 1);
+  return (atoi(GetProperties()->disable_offline_rotator) == 1);
 }
 
 int Debug::GetNullDisplayResolution(uint32_t *width, uint32_t *height) {
-  char value[64] = {};
-
-  int error = DebugHandler::Get()->GetProperty(NULL_DISPLAY_RESOLUTION_PROP, value);
-  if (error != 0) {
+  auto properties = GetProperties();
+  if (!properties->has_null_display_resolution) {
     return -ENOTSUP;
   }
 
-  std::string str(value);
+  std::string str(properties->null_display_resolution);
 
   *width = UINT32(stoi(str));
   *height = UINT32(stoi(str.substr(str.find('x') + 1)));
@@ -0,0 +1,222 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <string.h>
+#include <utils/constants.h>
+#include <utils/debug.h>
+#include <atomic>
+#include <map>
+#include <string>
+#include <thread>    // NOLINT
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace sdm {
+namespace {
+
+// Property service double that counts every read.
+class FakePropertyHandler : public DebugHandler {
+ public:
+  virtual void Error(const char *, ...) { }
+  virtual void Warning(const char *, ...) { }
+  virtual void Info(const char *, ...) { }
+  virtual void Debug(const char *, ...) { }
+  virtual void Verbose(const char *, ...) { }
+  virtual void BeginTrace(const char *, const char *, const char *) { }
+  virtual void EndTrace() { }
+
+  virtual int GetProperty(const char *property_name, int *value) {
+    reads_++;
+    auto it = properties_.find(property_name);
+    if (it == properties_.end()) {
+      return -1;
+    }
+    *value = std::stoi(it->second);
+    return 0;
+  }
+
+  virtual int GetProperty(const char *property_name, char *value) {
+    reads_++;
+    auto it = properties_.find(property_name);
+    if (it == properties_.end()) {
+      return -1;
+    }
+    strncpy(value, it->second.c_str(), DebugProperties::kValueMax - 1);
+    return 0;
+  }
+
+  std::map<std::string, std::string> properties_;
+  int reads_ = 0;
+};
+
+class DebugPropertiesTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    DebugHandler::Set(&handler_);
+    Debug::ReloadProperties();
+    handler_.reads_ = 0;
+  }
+
+  void TearDown() override { DebugHandler::Set(nullptr); }
+
+  // Calls every snapshot backed getter once.
+  void CallGetters() {
+    char value[DebugProperties::kValueMax] = {};
+    uint32_t width = 0, height = 0, active_ms = 0, inactive_ms = 0;
+    float left = 0, top = 0, right = 0, bottom = 0;
+    Debug::GetSimulationFlag();
+    Debug::GetExternalResolution(value);
+    Debug::GetIdleTimeoutMs(&active_ms, &inactive_ms);
+    Debug::IsRotatorDownScaleDisabled();
+    Debug::IsRotatorEnabledForUi();
+    Debug::IsDecimationDisabled();
+    Debug::GetMaxPipesPerMixer(kBuiltIn);
+    Debug::GetMaxPipesPerMixer(kPluggable);
+    Debug::GetMaxPipesPerMixer(kVirtual);
+    Debug::GetMaxUpscale();
+    Debug::IsVideoModeEnabled();
+    Debug::IsRotatorUbwcDisabled();
+    Debug::IsRotatorSplitDisabled();
+    Debug::IsScalarDisabled();
+    Debug::IsUbwcTiledFrameBuffer();
+    Debug::IsAVRDisabled();
+    Debug::IsExtAnimDisabled();
+    Debug::IsPartialSplitDisabled();
+    Debug::IsSrcSplitPreferred();
+    Debug::GetPropertyDisableInlineMode();
+    Debug::GetPropertyDisableOfflineMode();
+    Debug::GetWindowRect(true, &left, &top, &right, &bottom);
+    Debug::GetWindowRect(false, &left, &top, &right, &bottom);
+    Debug::GetMixerResolution(&width, &height);
+    Debug::GetNullDisplayResolution(&width, &height);
+    Debug::GetReducedConfig(&width, &height);
+    Debug::GetSecondaryMaxFetchLayers();
+    Debug::IsIWEEnabled();
+  }
+
+  FakePropertyHandler handler_;
+};
+
+}  // namespace
+
+TEST_F(DebugPropertiesTest, GettersDoNotReadProperties) {
+  for (int i = 0; i < 100; i++) {
+    CallGetters();
+  }
+  EXPECT_EQ(handler_.reads_, 0);
+}
+
+TEST_F(DebugPropertiesTest, Defaults) {
+  uint32_t active_ms = 0, inactive_ms = 0;
+  Debug::GetIdleTimeoutMs(&active_ms, &inactive_ms);
+  EXPECT_EQ(active_ms, UINT32(IDLE_TIMEOUT_ACTIVE_MS));
+  EXPECT_EQ(inactive_ms, UINT32(IDLE_TIMEOUT_INACTIVE_MS));
+  EXPECT_EQ(Debug::GetMaxPipesPerMixer(kBuiltIn), -1);
+  EXPECT_TRUE(Debug::IsUbwcTiledFrameBuffer());
+  EXPECT_EQ(Debug::GetSecondaryMaxFetchLayers(), 2);
+
+  uint32_t width = 0, height = 0;
+  float left = 0, top = 0, right = 0, bottom = 0;
+  char value[DebugProperties::kValueMax] = {};
+  EXPECT_EQ(Debug::GetMixerResolution(&width, &height), -ENOTSUP);
+  EXPECT_EQ(Debug::GetWindowRect(true, &left, &top, &right, &bottom), -EINVAL);
+  EXPECT_FALSE(Debug::GetExternalResolution(value));
+}
+
+TEST_F(DebugPropertiesTest, ReloadPicksUpChanges) {
+  handler_.properties_[PRIMARY_MIXER_STAGES_PROP] = "4";
+  handler_.properties_[DISABLE_UBWC_PROP] = "1";
+  handler_.properties_[IDLE_TIME_PROP] = "70";
+  handler_.properties_[MIXER_RESOLUTION_PROP] = "1920x1080";
+  handler_.properties_[WINDOW_RECT_PROP_SECONDARY] = "1,2,3,4";
+  handler_.properties_[HDMI_CONFIG_INDEX_PROP] = "3840x2160@60";
+  handler_.properties_[ENABLE_INLINE_WRITEBACK] = "1";
+
+  // Nothing changes until the snapshot is reloaded.
+  EXPECT_EQ(Debug::GetMaxPipesPerMixer(kBuiltIn), -1);
+  EXPECT_TRUE(Debug::IsUbwcTiledFrameBuffer());
+
+  Debug::ReloadProperties();
+  int reads = handler_.reads_;
+  EXPECT_GT(reads, 0);
+
+  EXPECT_EQ(Debug::GetMaxPipesPerMixer(kBuiltIn), 4);
+  EXPECT_EQ(Debug::GetMaxPipesPerMixer(kPluggable), -1);
+  EXPECT_FALSE(Debug::IsUbwcTiledFrameBuffer());
+  EXPECT_TRUE(Debug::IsIWEEnabled());
+
+  uint32_t active_ms = 0, inactive_ms = 0;
+  Debug::GetIdleTimeoutMs(&active_ms, &inactive_ms);
+  EXPECT_EQ(active_ms, 70u);
+  EXPECT_EQ(inactive_ms, UINT32(IDLE_TIMEOUT_INACTIVE_MS));
+
+  uint32_t width = 0, height = 0;
+  EXPECT_EQ(Debug::GetMixerResolution(&width, &height), 0);
+  EXPECT_EQ(width, 1920u);
+  EXPECT_EQ(height, 1080u);
+
+  float left = 0, top = 0, right = 0, bottom = 0;
+  EXPECT_EQ(Debug::GetWindowRect(true, &left, &top, &right, &bottom), -EINVAL);
+  EXPECT_EQ(Debug::GetWindowRect(false, &left, &top, &right, &bottom), 0);
+  EXPECT_EQ(left, 1.0f);
+  EXPECT_EQ(bottom, 4.0f);
+
+  char value[DebugProperties::kValueMax] = {};
+  EXPECT_TRUE(Debug::GetExternalResolution(value));
+  EXPECT_STREQ(value, "3840x2160@60");
+  EXPECT_EQ(handler_.reads_, reads);
+
+  // Properties that went away fall back to their defaults.
+  handler_.properties_.clear();
+  Debug::ReloadProperties();
+  EXPECT_EQ(Debug::GetMaxPipesPerMixer(kBuiltIn), -1);
+  EXPECT_EQ(Debug::GetMixerResolution(&width, &height), -ENOTSUP);
+  EXPECT_FALSE(Debug::IsIWEEnabled());
+}
+
+TEST_F(DebugPropertiesTest, ReloadWhileReading) {
+  // Readers must only ever see values of one snapshot, never a mix of two.
+  handler_.properties_[IDLE_TIME_PROP] = "0";
+  handler_.properties_[IDLE_TIME_INACTIVE_PROP] = "0";
+  Debug::ReloadProperties();
+
+  std::atomic<bool> done(false);
+  std::atomic<int> mismatches(0);
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 3; i++) {
+    readers.emplace_back([&done, &mismatches] {
+      while (!done) {
+        uint32_t width = 0, height = 0, active_ms = 0, inactive_ms = 0;
+        if (Debug::GetMixerResolution(&width, &height) == 0 && width != height) {
+          mismatches++;
+        }
+        Debug::GetIdleTimeoutMs(&active_ms, &inactive_ms);
+        if (active_ms != inactive_ms) {
+          mismatches++;
+        }
+      }
+    });
+  }
+
+  for (int i = 0; i < 2000; i++) {
+    std::string size = std::to_string(i % 2 ? 1080 : 2160);
+    handler_.properties_[MIXER_RESOLUTION_PROP] = size + "x" + size;
+    handler_.properties_[IDLE_TIME_PROP] = std::to_string(i);
+    handler_.properties_[IDLE_TIME_INACTIVE_PROP] = std::to_string(i);
+    Debug::ReloadProperties();
+  }
+  done = true;
+  for (auto &reader : readers) {
+    reader.join();
+  }
+
+  EXPECT_EQ(mismatches.load(), 0);
+  uint32_t active_ms = 0, inactive_ms = 0;
+  Debug::GetIdleTimeoutMs(&active_ms, &inactive_ms);
+  EXPECT_EQ(active_ms, 1999u);
+}
+
+}  // namespace sdm
@@ -0,0 +1,265 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <utils/fence_watcher.h>
+#include <utils/constants.h>
+#include <utils/debug.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <memory>
+#include <vector>
+
+#define __CLASS__ "FenceWatcher"
+
+namespace sdm {
+
+FenceWatcher *FenceWatcher::GetInstance() {
+  static FenceWatcher fence_watcher;
+  return &fence_watcher;
+}
+
+FenceWatcher::FenceWatcher() {
+  epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+  wakeup_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (epoll_fd_ < 0 || wakeup_fd_ < 0) {
+    DLOGE("Failed to create epoll/event fd. errno = %d, desc = %s", errno, strerror(errno));
+    return;
+  }
+
+  struct epoll_event event = {};
+  event.events = EPOLLIN;
+  event.data.u64 = kInvalidWatchId;
+  if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wakeup_fd_, &event) != 0) {
+    DLOGE("Failed to add wakeup fd. errno = %d, desc = %s", errno, strerror(errno));
+    return;
+  }
+
+  watcher_thread_ = std::thread(&FenceWatcher::WatcherThread, this);
+}
+
+FenceWatcher::~FenceWatcher() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    exit_ = true;
+  }
+  Wakeup();
+
+  if (watcher_thread_.joinable()) {
+    watcher_thread_.join();
+  }
+
+  for (auto &it : entries_) {
+    close(it.second.fd);
+  }
+
+  if (wakeup_fd_ >= 0) {
+    close(wakeup_fd_);
+  }
+
+  if (epoll_fd_ >= 0) {
+    close(epoll_fd_);
+  }
+}
+
+FenceWatcher::WatchId FenceWatcher::Watch(const shared_ptr<Fence> &fence, int timeout_ms,
+                                          Callback callback) {
+  if (!fence) {
+    callback(0);
+    return kInvalidWatchId;
+  }
+
+  // Dup is owned by the watcher and is released once the watch completes or gets cancelled.
+  int fd = Fence::Dup(fence);
+  if (fd < 0) {
+    DLOGE("Failed to dup fence %s", Fence::GetStr(fence).c_str());
+    return kInvalidWatchId;
+  }
+
+  WatchId id = Watch(fd, timeout_ms, callback);
+  close(fd);
+
+  return id;
+}
+
+FenceWatcher::WatchId FenceWatcher::Watch(int fd, int timeout_ms, Callback callback) {
+  if (fd < 0 || !callback || !watcher_thread_.joinable()) {
+    return kInvalidWatchId;
+  }
+
+  Entry entry = {};
+  entry.fd = dup(fd);
+  if (entry.fd < 0) {
+    DLOGE("Failed to dup fd %d. errno = %d, desc = %s", fd, errno, strerror(errno));
+    return kInvalidWatchId;
+  }
+  entry.callback = callback;
+  if (timeout_ms >= 0) {
+    entry.has_deadline = true;
+    entry.deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  WatchId id = next_id_++;
+  struct epoll_event event = {};
+  event.events = EPOLLIN;
+  event.data.u64 = id;
+  if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, entry.fd, &event) != 0) {
+    DLOGE("Failed to watch fd %d. errno = %d, desc = %s", fd, errno, strerror(errno));
+    close(entry.fd);
+    return kInvalidWatchId;
+  }
+
+  if (entry.has_deadline) {
+    deadlines_.insert(std::make_pair(entry.deadline, id));
+    // Watcher thread may be sleeping on a later deadline.
+    Wakeup();
+  }
+  entries_.emplace(id, entry);
+
+  return id;
+}
+
+std::shared_future<int> FenceWatcher::WaitAsync(const shared_ptr<Fence> &fence, int timeout_ms) {
+  auto promise = std::make_shared<std::promise<int>>();
+  std::shared_future<int> future = promise->get_future().share();
+
+  WatchId id = Watch(fence, timeout_ms, [promise](int status) { promise->set_value(status); });
+  if (fence && id == kInvalidWatchId) {
+    // Fall back to blocking wait, so that caller always gets a valid result.
+    promise->set_value(Fence::Wait(fence, timeout_ms));
+  }
+
+  return future;
+}
+
+bool FenceWatcher::Cancel(WatchId id) {
+  if (id == kInvalidWatchId) {
+    return false;
+  }
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  auto it = entries_.find(id);
+  if (it != entries_.end()) {
+    RemoveEntryLocked(id, it);
+    return true;
+  }
+
+  // Do not wait on self when cancelled from within a callback.
+  if (std::this_thread::get_id() != watcher_thread_.get_id()) {
+    running_cv_.wait(lock, [this, id] { return dispatching_.find(id) == dispatching_.end(); });
+  }
+
+  return false;
+}
+
+uint32_t FenceWatcher::GetPendingCount() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return UINT32(entries_.size());
+}
+
+void FenceWatcher::RemoveEntryLocked(WatchId id, std::map<WatchId, Entry>::iterator it) {
+  epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, it->second.fd, nullptr);
+  close(it->second.fd);
+  if (it->second.has_deadline) {
+    deadlines_.erase(std::make_pair(it->second.deadline, id));
+  }
+  entries_.erase(it);
+}
+
+void FenceWatcher::Wakeup() {
+  uint64_t value = 1;
+  if (write(wakeup_fd_, &value, sizeof(value)) < 0 && errno != EAGAIN) {
+    DLOGW("Failed to wakeup watcher thread. errno = %d, desc = %s", errno, strerror(errno));
+  }
+}
+
+int FenceWatcher::GetWaitTimeout() {
+  if (deadlines_.empty()) {
+    return -1;
+  }
+
+  auto now = std::chrono::steady_clock::now();
+  auto nearest = deadlines_.begin()->first;
+  if (nearest <= now) {
+    return 0;
+  }
+
+  // Round up, so that the thread does not spin for sub-millisecond remainders.
+  auto remaining = std::chrono::duration_cast<std::chrono::microseconds>(nearest - now);
+  return static_cast<int>((remaining.count() + 999) / 1000);
+}
+
+void FenceWatcher::WatcherThread() {
+  std::vector<std::pair<WatchId, int>> completions;
+  std::vector<Callback> callbacks;
+  struct epoll_event events[kMaxEvents];
+
+  while (true) {
+    int timeout_ms = -1;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (exit_) {
+        break;
+      }
+      timeout_ms = GetWaitTimeout();
+    }
+
+    int num_events = epoll_wait(epoll_fd_, events, kMaxEvents, timeout_ms);
+    if (num_events < 0 && errno != EINTR) {
+      DLOGE("epoll_wait failed. errno = %d, desc = %s", errno, strerror(errno));
+      break;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (int i = 0; i < num_events; i++) {
+      WatchId id = events[i].data.u64;
+      if (id == kInvalidWatchId) {
+        uint64_t value = 0;
+        if (read(wakeup_fd_, &value, sizeof(value)) < 0 && errno != EAGAIN) {
+          DLOGW("Failed to drain wakeup fd. errno = %d, desc = %s", errno, strerror(errno));
+        }
+        continue;
+      }
+
+      auto it = entries_.find(id);
+      if (it == entries_.end()) {
+        continue;
+      }
+
+      // Fence fd is readable once signaled, anything else is reported as an error.
+      int status = (events[i].events & EPOLLIN) ? 0 : -EIO;
+      completions.push_back(std::make_pair(id, status));
+      callbacks.push_back(it->second.callback);
+      dispatching_.insert(id);
+      RemoveEntryLocked(id, it);
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    while (!deadlines_.empty() && deadlines_.begin()->first <= now) {
+      WatchId id = deadlines_.begin()->second;
+      auto it = entries_.find(id);
+      completions.push_back(std::make_pair(id, -ETIME));
+      callbacks.push_back(it->second.callback);
+      dispatching_.insert(id);
+      RemoveEntryLocked(id, it);
+    }
+
+    // Callbacks run without lock, so that they can register new watches.
+    lock.unlock();
+    for (size_t i = 0; i < completions.size(); i++) {
+      callbacks.at(i)(completions.at(i).second);
+      std::lock_guard<std::mutex> dispatch_lock(mutex_);
+      dispatching_.erase(completions.at(i).first);
+      running_cv_.notify_all();
+    }
+    completions.clear();
+    callbacks.clear();
+  }
+}
+
+}  // namespace sdm
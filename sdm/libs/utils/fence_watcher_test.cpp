@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <errno.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <utils/fence_watcher.h>
+#include <atomic>
+#include <chrono>    // NOLINT
+#include <future>    // NOLINT
+#include <memory>
+
+#include <gtest/gtest.h>
+
+namespace sdm {
+namespace {
+
+// An eventfd polls readable once written to, same as a sync file once signaled.
+class EventFence {
+ public:
+  EventFence() : fd_(eventfd(0, EFD_CLOEXEC)) { }
+  ~EventFence() { close(fd_); }
+
+  int Get() const { return fd_; }
+  void Signal() {
+    uint64_t value = 1;
+    ASSERT_EQ(write(fd_, &value, sizeof(value)), ssize_t(sizeof(value)));
+  }
+
+ private:
+  int fd_ = -1;
+};
+
+// Callback which hands its status to the test thread.
+struct Completion {
+  std::promise<int> promise;
+  std::future<int> future = promise.get_future();
+
+  FenceWatcher::Callback Get() {
+    return [this](int status) { promise.set_value(status); };
+  }
+
+  bool Ready(int timeout_ms) {
+    return future.wait_for(std::chrono::milliseconds(timeout_ms)) == std::future_status::ready;
+  }
+};
+
+FenceWatcher *Watcher() {
+  return FenceWatcher::GetInstance();
+}
+
+}  // namespace
+
+TEST(FenceWatcherTest, SignalInvokesCallback) {
+  EventFence fence;
+  Completion completion;
+  auto id = Watcher()->Watch(fence.Get(), -1, completion.Get());
+  ASSERT_NE(id, FenceWatcher::kInvalidWatchId);
+
+  EXPECT_FALSE(completion.Ready(20));
+  fence.Signal();
+  ASSERT_TRUE(completion.Ready(1000));
+  EXPECT_EQ(completion.future.get(), 0);
+
+  // Completed watch is released.
+  EXPECT_FALSE(Watcher()->Cancel(id));
+  EXPECT_EQ(Watcher()->GetPendingCount(), 0u);
+}
+
+TEST(FenceWatcherTest, AlreadySignaledFence) {
+  EventFence fence;
+  fence.Signal();
+  Completion completion;
+  Watcher()->Watch(fence.Get(), -1, completion.Get());
+
+  ASSERT_TRUE(completion.Ready(1000));
+  EXPECT_EQ(completion.future.get(), 0);
+}
+
+TEST(FenceWatcherTest, TimeoutReportsEtime) {
+  EventFence fence;
+  Completion completion;
+  auto start = std::chrono::steady_clock::now();
+  Watcher()->Watch(fence.Get(), 30, completion.Get());
+
+  ASSERT_TRUE(completion.Ready(1000));
+  EXPECT_EQ(completion.future.get(), -ETIME);
+  EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(30));
+  EXPECT_EQ(Watcher()->GetPendingCount(), 0u);
+}
+
+TEST(FenceWatcherTest, ShortTimeoutFiresBeforeLongerOne) {
+  EventFence long_fence;
+  EventFence short_fence;
+  Completion long_completion;
+  Completion short_completion;
+  auto long_id = Watcher()->Watch(long_fence.Get(), 10000, long_completion.Get());
+  Watcher()->Watch(short_fence.Get(), 20, short_completion.Get());
+
+  // Watcher thread sleeping on the 10s deadline must pick up the new, nearer one.
+  ASSERT_TRUE(short_completion.Ready(1000));
+  EXPECT_EQ(short_completion.future.get(), -ETIME);
+  EXPECT_FALSE(long_completion.Ready(0));
+  EXPECT_TRUE(Watcher()->Cancel(long_id));
+}
+
+TEST(FenceWatcherTest, CancelSuppressesCallback) {
+  EventFence fence;
+  std::atomic<int> calls(0);
+  auto id = Watcher()->Watch(fence.Get(), -1, [&calls](int) { calls++; });
+  ASSERT_NE(id, FenceWatcher::kInvalidWatchId);
+  EXPECT_EQ(Watcher()->GetPendingCount(), 1u);
+
+  EXPECT_TRUE(Watcher()->Cancel(id));
+  EXPECT_EQ(Watcher()->GetPendingCount(), 0u);
+  fence.Signal();
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_EQ(calls.load(), 0);
+}
+
+TEST(FenceWatcherTest, CancelWaitsForRunningCallback) {
+  EventFence fence;
+  std::promise<void> entered;
+  std::atomic<bool> returned(false);
+  auto id = Watcher()->Watch(fence.Get(), -1, [&entered, &returned](int) {
+    entered.set_value();
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    returned = true;
+  });
+
+  fence.Signal();
+  entered.get_future().wait();
+  EXPECT_FALSE(Watcher()->Cancel(id));
+  EXPECT_TRUE(returned.load());
+}
+
+TEST(FenceWatcherTest, CallbackCanWatchAgain) {
+  EventFence first;
+  EventFence second;
+  Completion completion;
+  Watcher()->Watch(first.Get(), -1, [&second, &completion](int) {
+    Watcher()->Watch(second.Get(), -1, completion.Get());
+  });
+
+  first.Signal();
+  second.Signal();
+  ASSERT_TRUE(completion.Ready(1000));
+  EXPECT_EQ(completion.future.get(), 0);
+}
+
+TEST(FenceWatcherTest, WatchOwnsItsFd) {
+  Completion completion;
+  int fd = eventfd(0, EFD_CLOEXEC);
+  Watcher()->Watch(fd, -1, completion.Get());
+  // Caller closing its fd does not affect the watch.
+  int writer = dup(fd);
+  close(fd);
+
+  uint64_t value = 1;
+  ASSERT_EQ(write(writer, &value, sizeof(value)), ssize_t(sizeof(value)));
+  ASSERT_TRUE(completion.Ready(1000));
+  EXPECT_EQ(completion.future.get(), 0);
+  close(writer);
+}
+
+TEST(FenceWatcherTest, WaitAsync) {
+  EventFence event;
+  auto fence = Fence::Create(dup(event.Get()), "test");
+  auto future = Watcher()->WaitAsync(fence, -1);
+  EXPECT_EQ(future.wait_for(std::chrono::milliseconds(20)), std::future_status::timeout);
+
+  event.Signal();
+  ASSERT_EQ(future.wait_for(std::chrono::seconds(1)), std::future_status::ready);
+  EXPECT_EQ(future.get(), 0);
+
+  // Null fence is signaled.
+  auto null_future = Watcher()->WaitAsync(nullptr, -1);
+  ASSERT_EQ(null_future.wait_for(std::chrono::milliseconds(0)), std::future_status::ready);
+  EXPECT_EQ(null_future.get(), 0);
+}
+
+TEST(FenceWatcherTest, InvalidWatch) {
+  Completion completion;
+  EXPECT_EQ(Watcher()->Watch(-1, -1, completion.Get()), FenceWatcher::kInvalidWatchId);
+  EXPECT_FALSE(completion.Ready(0));
+  EXPECT_FALSE(Watcher()->Cancel(FenceWatcher::kInvalidWatchId));
+}
+
+}  // namespace sdm
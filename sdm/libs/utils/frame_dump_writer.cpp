@@ -0,0 +1,301 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <utils/frame_dump_writer.h>
+#include <utils/constants.h>
+#include <utils/debug.h>
+#include <errno.h>
+#include <libgen.h>
+#include <linux/dma-buf.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+#define __CLASS__ "FrameDumpWriter"
+
+namespace sdm {
+
+// Upper bound for a single fence wait, so that a job of a stuck producer does not stay queued
+// forever.
+static const int kFenceTimeoutMs = 1000;
+
+FrameDumpWriter::FrameDumpWriter(uint32_t max_pending)
+  : max_pending_(max_pending ? max_pending : kDefaultMaxPending) {
+}
+
+FrameDumpWriter::~FrameDumpWriter() {
+  std::vector<FenceWatcher::WatchId> watch_ids;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    exit_ = true;
+    for (auto &job : jobs_) {
+      if (!job.ready) {
+        watch_ids.push_back(job.watch_id);
+      }
+    }
+  }
+  job_cv_.notify_one();
+
+  // Callbacks take mutex_, cancel without holding it. Cancel also waits for a callback in flight.
+  for (auto watch_id : watch_ids) {
+    FenceWatcher::GetInstance()->Cancel(watch_id);
+  }
+
+  // Writer thread releases the jobs left on exit. Without one, there are none.
+  if (writer_thread_.joinable()) {
+    writer_thread_.join();
+  }
+}
+
+void FrameDumpWriter::SetBudget(uint64_t max_bytes) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (stats_.dropped_queue_full || stats_.dropped_budget || stats_.failed) {
+    DLOGW("Previous session: written %u (%" PRIu64 " bytes), failed %u, dropped %u on full queue,"
+          " %u on budget", stats_.written, stats_.bytes_written, stats_.failed,
+          stats_.dropped_queue_full, stats_.dropped_budget);
+  }
+
+  max_bytes_ = max_bytes;
+  reserved_bytes_ = 0;
+  stats_ = {};
+}
+
+bool FrameDumpWriter::ReserveLocked(size_t size) {
+  if (jobs_.size() >= max_pending_) {
+    stats_.dropped_queue_full++;
+    return false;
+  }
+
+  if (max_bytes_ && (reserved_bytes_ + size > max_bytes_)) {
+    stats_.dropped_budget++;
+    return false;
+  }
+
+  if (!writer_thread_.joinable()) {
+    writer_thread_ = std::thread(&FrameDumpWriter::WriterThread, this);
+  }
+  reserved_bytes_ += size;
+
+  return true;
+}
+
+bool FrameDumpWriter::QueueBuffer(const std::string &file_name, int fd, uint32_t size,
+                                  const shared_ptr<Fence> &fence) {
+  if (fd < 0 || !size) {
+    return false;
+  }
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (!ReserveLocked(size)) {
+    return false;
+  }
+
+  Job job = {};
+  job.fd = dup(fd);
+  if (job.fd < 0) {
+    DLOGE("Failed to dup fd %d. errno = %d, desc = %s", fd, errno, strerror(errno));
+    reserved_bytes_ -= size;
+    stats_.failed++;
+    return false;
+  }
+  job.file_name = file_name;
+  job.size = size;
+  job.fence = fence;
+  job.seq = next_seq_++;
+  uint64_t seq = job.seq;
+  jobs_.push_back(std::move(job));
+  lock.unlock();
+
+  // Null fence completes synchronously. Callback may also run before Watch() returns.
+  auto watch_id = FenceWatcher::GetInstance()->Watch(fence, kFenceTimeoutMs,
+                                                     [this, seq](int status) {
+                                                       OnFenceDone(seq, status);
+                                                     });
+  if (fence && watch_id == FenceWatcher::kInvalidWatchId) {
+    OnFenceDone(seq, -EIO);
+    return true;
+  }
+
+  lock.lock();
+  for (auto &pending : jobs_) {
+    if (pending.seq == seq) {
+      pending.watch_id = watch_id;
+      break;
+    }
+  }
+
+  return true;
+}
+
+bool FrameDumpWriter::QueueData(const std::string &file_name, const void *data, size_t size) {
+  if (!data || !size) {
+    return false;
+  }
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (!ReserveLocked(size)) {
+    return false;
+  }
+
+  Job job = {};
+  job.file_name = file_name;
+  job.size = UINT32(size);
+  job.data.assign(static_cast<const uint8_t *>(data), static_cast<const uint8_t *>(data) + size);
+  job.seq = next_seq_++;
+  job.ready = true;
+  jobs_.push_back(std::move(job));
+  lock.unlock();
+  job_cv_.notify_one();
+
+  return true;
+}
+
+void FrameDumpWriter::Flush() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  idle_cv_.wait(lock, [this] { return jobs_.empty() && !busy_; });
+}
+
+FrameDumpWriter::Stats FrameDumpWriter::GetStats() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+void FrameDumpWriter::OnFenceDone(uint64_t seq, int status) {
+  // Notify under lock. Once the job is written, Flush() may return and the writer may be
+  // destroyed along with job_cv_ before an unlocked notify gets to run.
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto &job : jobs_) {
+    if (job.seq == seq) {
+      job.ready = true;
+      job.status = status;
+      break;
+    }
+  }
+  job_cv_.notify_one();
+}
+
+bool FrameDumpWriter::HasReadyJobLocked() {
+  for (auto &job : jobs_) {
+    if (job.ready) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void FrameDumpWriter::WriterThread() {
+  while (true) {
+    Job job = {};
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      job_cv_.wait(lock, [this] { return exit_ || HasReadyJobLocked(); });
+      if (exit_) {
+        break;
+      }
+      // Oldest signaled job first.
+      for (auto it = jobs_.begin(); it != jobs_.end(); it++) {
+        if (it->ready) {
+          job = std::move(*it);
+          jobs_.erase(it);
+          break;
+        }
+      }
+      busy_ = true;
+    }
+
+    int ret = WriteJob(job);
+    if (job.fd >= 0) {
+      close(job.fd);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (ret == 0) {
+      stats_.written++;
+      stats_.bytes_written += job.size;
+    } else {
+      stats_.failed++;
+    }
+    busy_ = false;
+    idle_cv_.notify_all();
+  }
+
+  // Unblock Flush callers on exit, pending jobs are dropped.
+  std::lock_guard<std::mutex> lock(mutex_);
+  busy_ = false;
+  for (auto &job : jobs_) {
+    if (job.fd >= 0) {
+      close(job.fd);
+    }
+  }
+  jobs_.clear();
+  idle_cv_.notify_all();
+}
+
+int FrameDumpWriter::WriteJob(const Job &job) {
+  if (job.fd < 0) {
+    return WriteFile(job.file_name, job.data.data(), job.data.size());
+  }
+
+  if (job.status != 0) {
+    DLOGW("Fence %s wait failed for %s, status = %d", Fence::GetStr(job.fence).c_str(),
+          job.file_name.c_str(), job.status);
+    return job.status;
+  }
+
+  void *base = mmap(NULL, job.size, PROT_READ, MAP_SHARED, job.fd, 0);
+  if (base == MAP_FAILED) {
+    DLOGE("mmap failed for %s. errno = %d, desc = %s", job.file_name.c_str(), errno,
+          strerror(errno));
+    return -errno;
+  }
+
+  // Keep CPU view coherent with the producer. Not a dma-buf on failure, nothing to sync.
+  struct dma_buf_sync sync = {};
+  sync.flags = DMA_BUF_SYNC_START | DMA_BUF_SYNC_READ;
+  bool synced = (ioctl(job.fd, INT(DMA_BUF_IOCTL_SYNC), &sync) == 0);
+
+  int ret = WriteFile(job.file_name, base, job.size);
+
+  if (synced) {
+    sync.flags = DMA_BUF_SYNC_END | DMA_BUF_SYNC_READ;
+    ioctl(job.fd, INT(DMA_BUF_IOCTL_SYNC), &sync);
+  }
+  munmap(base, job.size);
+
+  return ret;
+}
+
+int FrameDumpWriter::WriteFile(const std::string &file_name, const void *data, size_t size) {
+  std::string path = file_name;
+  std::string dir_path = dirname(&path[0]);
+  if (mkdir(dir_path.c_str(), 0777) != 0 && errno != EEXIST) {
+    DLOGW("Failed to create %s directory errno = %d, desc = %s", dir_path.c_str(), errno,
+          strerror(errno));
+    return -errno;
+  }
+
+  // Even if directory exists already, need to explicitly change the permission.
+  if (chmod(dir_path.c_str(), 0777) != 0) {
+    DLOGW("Failed to change permissions on %s directory", dir_path.c_str());
+  }
+
+  size_t result = 0;
+  FILE *fp = fopen(file_name.c_str(), "w+");
+  if (fp) {
+    result = fwrite(data, size, 1, fp);
+    fclose(fp);
+  }
+  DLOGI("Frame Dump %s: is %s", file_name.c_str(), result ? "Successful" : "Failed");
+
+  return result ? 0 : -EIO;
+}
+
+}  // namespace sdm
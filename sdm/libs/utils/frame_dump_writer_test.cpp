@@ -0,0 +1,212 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <dirent.h>
+#include <stdio.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <utils/constants.h>
+#include <utils/frame_dump_writer.h>
+#include <chrono>    // NOLINT
+#include <string>
+#include <thread>    // NOLINT
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace sdm {
+namespace {
+
+// memfd stands in for the dma-buf, it maps the same way minus the cache sync ioctl.
+int CreateBuffer(const std::vector<uint8_t> &content) {
+  int fd = memfd_create("frame_dump_writer_test", MFD_CLOEXEC);
+  if (fd >= 0 && write(fd, content.data(), content.size()) != ssize_t(content.size())) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+// Returns an eventfd backed fence and the eventfd which signals it.
+shared_ptr<Fence> CreateFence(int *signal_fd) {
+  *signal_fd = eventfd(0, EFD_CLOEXEC);
+  return Fence::Create(dup(*signal_fd), "test");
+}
+
+void Signal(int signal_fd) {
+  uint64_t value = 1;
+  ASSERT_EQ(write(signal_fd, &value, sizeof(value)), ssize_t(sizeof(value)));
+}
+
+int CountOpenFds() {
+  int count = 0;
+  DIR *dir = opendir("/proc/self/fd");
+  while (dir && readdir(dir)) {
+    count++;
+  }
+  if (dir) {
+    closedir(dir);
+  }
+  return count;
+}
+
+class FrameDumpWriterTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    dir_ = ::testing::TempDir() + "frame_dump_writer_test_" + std::to_string(getpid());
+    content_.resize(4096);
+    for (size_t i = 0; i < content_.size(); i++) {
+      content_[i] = uint8_t(i * 7);
+    }
+  }
+
+  void TearDown() override {
+    for (auto &file : files_) {
+      unlink(file.c_str());
+    }
+    rmdir(dir_.c_str());
+  }
+
+  std::string FileName(const char *name) {
+    files_.push_back(dir_ + "/" + name);
+    return files_.back();
+  }
+
+  static std::vector<uint8_t> Read(const std::string &file_name) {
+    std::vector<uint8_t> data;
+    FILE *fp = fopen(file_name.c_str(), "r");
+    if (!fp) {
+      return data;
+    }
+    uint8_t buffer[1024];
+    size_t count = 0;
+    while ((count = fread(buffer, 1, sizeof(buffer), fp)) > 0) {
+      data.insert(data.end(), buffer, buffer + count);
+    }
+    fclose(fp);
+    return data;
+  }
+
+  std::string dir_;
+  std::vector<std::string> files_;
+  std::vector<uint8_t> content_;
+};
+
+}  // namespace
+
+TEST_F(FrameDumpWriterTest, WritesData) {
+  FrameDumpWriter writer;
+  std::string file_name = FileName("data.raw");
+  ASSERT_TRUE(writer.QueueData(file_name, content_.data(), content_.size()));
+  writer.Flush();
+
+  EXPECT_EQ(Read(file_name), content_);
+  FrameDumpWriter::Stats stats = writer.GetStats();
+  EXPECT_EQ(stats.written, 1u);
+  EXPECT_EQ(stats.bytes_written, content_.size());
+}
+
+TEST_F(FrameDumpWriterTest, WritesBufferOnceFenceSignals) {
+  FrameDumpWriter writer;
+  std::string file_name = FileName("buffer.raw");
+  int buffer_fd = CreateBuffer(content_);
+  int signal_fd = -1;
+  auto fence = CreateFence(&signal_fd);
+  ASSERT_TRUE(writer.QueueBuffer(file_name, buffer_fd, UINT32(content_.size()), fence));
+  // Writer holds its own dup.
+  close(buffer_fd);
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(30));
+  EXPECT_NE(access(file_name.c_str(), F_OK), 0);
+
+  Signal(signal_fd);
+  writer.Flush();
+  EXPECT_EQ(Read(file_name), content_);
+  EXPECT_EQ(writer.GetStats().written, 1u);
+  close(signal_fd);
+}
+
+TEST_F(FrameDumpWriterTest, SignaledJobIsNotHeldBack) {
+  FrameDumpWriter writer;
+  std::string blocked_name = FileName("blocked.raw");
+  std::string ready_name = FileName("ready.raw");
+  int buffer_fd = CreateBuffer(content_);
+  int signal_fd = -1;
+  auto fence = CreateFence(&signal_fd);
+
+  ASSERT_TRUE(writer.QueueBuffer(blocked_name, buffer_fd, UINT32(content_.size()), fence));
+  ASSERT_TRUE(writer.QueueBuffer(ready_name, buffer_fd, UINT32(content_.size()), nullptr));
+
+  for (int i = 0; i < 100 && writer.GetStats().written == 0; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_EQ(Read(ready_name), content_);
+  EXPECT_NE(access(blocked_name.c_str(), F_OK), 0);
+
+  Signal(signal_fd);
+  writer.Flush();
+  EXPECT_EQ(Read(blocked_name), content_);
+  close(buffer_fd);
+  close(signal_fd);
+}
+
+TEST_F(FrameDumpWriterTest, FenceTimeoutFailsJob) {
+  FrameDumpWriter writer;
+  std::string file_name = FileName("timeout.raw");
+  int buffer_fd = CreateBuffer(content_);
+  int signal_fd = -1;
+  auto fence = CreateFence(&signal_fd);
+  ASSERT_TRUE(writer.QueueBuffer(file_name, buffer_fd, UINT32(content_.size()), fence));
+  writer.Flush();
+
+  EXPECT_NE(access(file_name.c_str(), F_OK), 0);
+  EXPECT_EQ(writer.GetStats().failed, 1u);
+  close(buffer_fd);
+  close(signal_fd);
+}
+
+TEST_F(FrameDumpWriterTest, DropsOnFullQueueAndBudget) {
+  int signal_fd = -1;
+  auto fence = CreateFence(&signal_fd);
+  int buffer_fd = CreateBuffer(content_);
+  {
+    FrameDumpWriter writer(2);
+    EXPECT_TRUE(writer.QueueBuffer(FileName("a.raw"), buffer_fd, 16, fence));
+    EXPECT_TRUE(writer.QueueBuffer(FileName("b.raw"), buffer_fd, 16, fence));
+    EXPECT_FALSE(writer.QueueBuffer(FileName("c.raw"), buffer_fd, 16, fence));
+    EXPECT_EQ(writer.GetStats().dropped_queue_full, 1u);
+  }
+  {
+    FrameDumpWriter writer;
+    writer.SetBudget(content_.size());
+    EXPECT_TRUE(writer.QueueData(FileName("d.raw"), content_.data(), content_.size()));
+    EXPECT_FALSE(writer.QueueData(FileName("e.raw"), content_.data(), 1));
+    writer.Flush();
+    EXPECT_EQ(writer.GetStats().dropped_budget, 1u);
+  }
+  close(buffer_fd);
+  close(signal_fd);
+}
+
+TEST_F(FrameDumpWriterTest, DestructionReleasesPendingFds) {
+  int buffer_fd = CreateBuffer(content_);
+  int signal_fd = -1;
+  auto fence = CreateFence(&signal_fd);
+  int open_fds = CountOpenFds();
+  {
+    FrameDumpWriter writer;
+    for (int i = 0; i < 4; i++) {
+      ASSERT_TRUE(writer.QueueBuffer(FileName("pending.raw"), buffer_fd,
+                                     UINT32(content_.size()), fence));
+    }
+    EXPECT_GT(CountOpenFds(), open_fds);
+  }
+  EXPECT_EQ(CountOpenFds(), open_fds);
+  close(buffer_fd);
+  close(signal_fd);
+}
+
+}  // namespace sdm
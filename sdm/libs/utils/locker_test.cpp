@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <errno.h>
+#include <utils/locker.h>
+
+#include <gtest/gtest.h>
+
+namespace sdm {
+namespace {
+
+const uint32_t kNumDisplays = 9;
+
+bool IsLocked(Locker *locker) {
+  if (locker->TryLock() == EBUSY) {
+    return true;
+  }
+  locker->Unlock();
+  return false;
+}
+
+}  // namespace
+
+TEST(LockerTest, MultiScopeLockTakesMaskedLockers) {
+  Locker lockers[kNumDisplays];
+  {
+    Locker::MultiScopeLock lock(lockers, kNumDisplays, (1ULL << 1) | (1ULL << 5));
+    for (uint32_t i = 0; i < kNumDisplays; i++) {
+      EXPECT_EQ(IsLocked(&lockers[i]), i == 1 || i == 5) << i;
+    }
+  }
+  for (uint32_t i = 0; i < kNumDisplays; i++) {
+    EXPECT_FALSE(IsLocked(&lockers[i])) << i;
+  }
+}
+
+}  // namespace sdm
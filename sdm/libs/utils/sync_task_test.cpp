@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <utils/constants.h>
+#include <utils/sync_task.h>
+#include <atomic>
+#include <chrono>    // NOLINT
+#include <condition_variable>  // NOLINT
+#include <mutex>     // NOLINT
+#include <thread>    // NOLINT
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace sdm {
+namespace {
+
+typedef SyncTask<int> IntTask;
+
+struct ValueContext : public IntTask::TaskContext {
+  int value = 0;
+};
+
+// Records the tasks without a lock of its own, so that the sanitizer checks the handoff between
+// the worker and the callers done by SyncTask itself.
+class Recorder : public IntTask::TaskHandler {
+ public:
+  void OnTask(const int &task_code, IntTask::TaskContext *task_context) override {
+    if (task_context) {
+      static_cast<ValueContext *>(task_context)->value = task_code * 2;
+    }
+    codes_.push_back(task_code);
+  }
+
+  std::vector<int> codes_;
+};
+
+// Holds the worker in its first task until Release() is called.
+class GatedRecorder : public Recorder {
+ public:
+  void OnTask(const int &task_code, IntTask::TaskContext *task_context) override {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      started_ = true;
+      cv_.notify_all();
+      cv_.wait(lock, [this] { return released_; });
+    }
+    Recorder::OnTask(task_code, task_context);
+  }
+
+  void WaitStarted() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this] { return started_; });
+  }
+
+  void Release() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    released_ = true;
+    cv_.notify_all();
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool started_ = false;
+  bool released_ = false;
+};
+
+}  // namespace
+
+TEST(SyncTaskTest, PerformTaskRunsInOrder) {
+  Recorder recorder;
+  IntTask task(recorder);
+  ValueContext context;
+  for (int i = 0; i < 100; i++) {
+    task.PerformTask(i, &context);
+    EXPECT_EQ(context.value, i * 2);
+  }
+  ASSERT_EQ(recorder.codes_.size(), 100u);
+  for (int i = 0; i < 100; i++) {
+    EXPECT_EQ(recorder.codes_[i], i);
+  }
+}
+
+TEST(SyncTaskTest, WaitTaskCompletesPostedTask) {
+  Recorder recorder;
+  IntTask task(recorder);
+  ValueContext contexts[IntTask::kMaxPendingTasks];
+  std::vector<IntTask::TaskId> task_ids;
+  for (uint32_t i = 0; i < IntTask::kMaxPendingTasks; i++) {
+    task_ids.push_back(task.PostTask(INT(i) + 1, &contexts[i]));
+  }
+  for (uint32_t i = 0; i < IntTask::kMaxPendingTasks; i++) {
+    task.WaitTask(task_ids[i]);
+    EXPECT_EQ(contexts[i].value, (INT(i) + 1) * 2);
+  }
+}
+
+TEST(SyncTaskTest, PostTaskBlocksWhileQueueIsFull) {
+  GatedRecorder recorder;
+  IntTask task(recorder, 2);
+  task.PostTask(0, nullptr);
+  recorder.WaitStarted();
+  task.PostTask(1, nullptr);
+  task.PostTask(2, nullptr);
+
+  std::atomic<bool> posted(false);
+  std::thread poster([&task, &posted] {
+    task.PostTask(3, nullptr);
+    posted = true;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_FALSE(posted.load());
+
+  recorder.Release();
+  poster.join();
+  task.Flush();
+  EXPECT_EQ(recorder.codes_, std::vector<int>({0, 1, 2, 3}));
+}
+
+TEST(SyncTaskTest, DestructorDrainsQueuedTasks) {
+  GatedRecorder recorder;
+  {
+    IntTask task(recorder);
+    task.PostTask(0, nullptr);
+    recorder.WaitStarted();
+    task.PostTask(1, nullptr);
+    task.PostTask(2, nullptr);
+    recorder.Release();
+  }
+  EXPECT_EQ(recorder.codes_, std::vector<int>({0, 1, 2}));
+}
+
+// Several callers post and wait concurrently, each task must run exactly once.
+TEST(SyncTaskTest, ConcurrentCallers) {
+  const int kCallers = 4;
+  const int kTasks = 2000;
+  Recorder recorder;
+  IntTask task(recorder);
+  std::vector<std::thread> callers;
+  for (int caller = 0; caller < kCallers; caller++) {
+    callers.emplace_back([&task, caller] {
+      ValueContext context;
+      for (int i = 0; i < kTasks; i++) {
+        int code = caller * kTasks + i;
+        if (i % 2) {
+          task.PerformTask(code, &context);
+        } else {
+          task.WaitTask(task.PostTask(code, &context));
+        }
+        EXPECT_EQ(context.value, code * 2);
+      }
+    });
+  }
+  for (auto &caller : callers) {
+    caller.join();
+  }
+  task.Flush();
+
+  std::vector<int> seen(kCallers * kTasks, 0);
+  for (int code : recorder.codes_) {
+    seen[code]++;
+  }
+  for (int code = 0; code < kCallers * kTasks; code++) {
+    EXPECT_EQ(seen[code], 1) << code;
+  }
+}
+
+}  // namespace sdm
@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <utils/task_graph.h>
+#include <atomic>
+#include <chrono>    // NOLINT
+#include <mutex>
+#include <string>
+#include <thread>    // NOLINT
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace sdm {
+
+TEST(TaskGraphTest, RunsEveryStage) {
+  TaskGraph graph;
+  std::atomic<int> runs(0);
+  std::vector<TaskGraph::TaskId> ids;
+  for (int i = 0; i < 4; i++) {
+    ids.push_back(graph.Add("stage", [&runs] {
+      runs++;
+      return kErrorNone;
+    }));
+  }
+  graph.Run();
+
+  EXPECT_EQ(runs.load(), 4);
+  for (auto id : ids) {
+    EXPECT_EQ(graph.GetError(id), kErrorNone);
+  }
+}
+
+TEST(TaskGraphTest, DependentRunsAfterItsDependencies) {
+  TaskGraph graph;
+  std::mutex mutex;
+  std::vector<int> order;
+  auto record = [&mutex, &order] (int stage) {
+    std::lock_guard<std::mutex> lock(mutex);
+    order.push_back(stage);
+  };
+
+  auto first = graph.Add("first", [&record] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    record(0);
+    return kErrorNone;
+  });
+  auto second = graph.Add("second", [&record] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    record(1);
+    return kErrorNone;
+  });
+  graph.Add("last", [&record] {
+    record(2);
+    return kErrorNone;
+  }, {first, second});
+  graph.Run();
+
+  ASSERT_EQ(order.size(), 3u);
+  EXPECT_EQ(order[2], 2);
+}
+
+TEST(TaskGraphTest, IndependentStagesOverlap) {
+  TaskGraph graph;
+  std::atomic<int> running(0);
+  std::atomic<int> max_running(0);
+  auto stage = [&running, &max_running] {
+    int now = ++running;
+    int max = max_running.load();
+    while (now > max && !max_running.compare_exchange_weak(max, now)) {
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    running--;
+    return kErrorNone;
+  };
+  graph.Add("a", stage);
+  graph.Add("b", stage);
+  graph.Run();
+
+  EXPECT_EQ(max_running.load(), 2);
+}
+
+TEST(TaskGraphTest, FailurePropagatesToDependents) {
+  TaskGraph graph;
+  bool dependent_ran = false;
+  bool independent_ran = false;
+  auto failing = graph.Add("failing", [] { return kErrorNotSupported; });
+  auto dependent = graph.Add("dependent", [&dependent_ran] {
+    dependent_ran = true;
+    return kErrorNone;
+  }, {failing});
+  auto transitive = graph.Add("transitive", [] { return kErrorNone; }, {dependent});
+  auto independent = graph.Add("independent", [&independent_ran] {
+    independent_ran = true;
+    return kErrorNone;
+  });
+  graph.Run();
+
+  EXPECT_EQ(graph.GetError(failing), kErrorNotSupported);
+  EXPECT_FALSE(dependent_ran);
+  EXPECT_EQ(graph.GetError(dependent), kErrorNotSupported);
+  EXPECT_EQ(graph.GetError(transitive), kErrorNotSupported);
+  EXPECT_TRUE(independent_ran);
+  EXPECT_EQ(graph.GetError(independent), kErrorNone);
+
+  std::string dump = graph.Dump();
+  EXPECT_NE(dump.find("dependent skipped"), std::string::npos);
+  EXPECT_NE(dump.find("failing start"), std::string::npos);
+}
+
+TEST(TaskGraphTest, InvalidIds) {
+  TaskGraph graph;
+  // Only earlier stages can be dependencies, unknown ones are dropped.
+  auto id = graph.Add("stage", [] { return kErrorNone; }, {5});
+  graph.Run();
+
+  EXPECT_EQ(graph.GetError(id), kErrorNone);
+  EXPECT_EQ(graph.GetError(TaskGraph::kInvalidTaskId), kErrorParameters);
+}
+
+TEST(TaskGraphTest, EmptyGraph) {
+  TaskGraph graph;
+  graph.Run();
+  EXPECT_EQ(graph.Dump().find("total"), 0u);
+}
+
+}  // namespace sdm
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <errno.h>
+#include <string.h>
+
+#include "batch_codec.h"
+#include "opcode_types.h"
+
+namespace DisplayConfig {
+
+static size_t AlignBatchSize(size_t size) {
+  return (size + kBatchAlignment - 1) & ~(kBatchAlignment - 1);
+}
+
+BatchWriter::BatchWriter(std::vector<uint8_t> *stream) : stream_(stream) {
+  BatchHeader header = {kBatchVersion, 0};
+  stream_->resize(sizeof(header));
+  memcpy(stream_->data(), &header, sizeof(header));
+}
+
+void BatchWriter::Append(uint32_t op_code, int32_t error, const void *data, size_t size) {
+  BatchEntryHeader entry = {op_code, error, static_cast<uint32_t>(size), 0};
+  size_t offset = stream_->size();
+  stream_->resize(offset + sizeof(entry) + AlignBatchSize(size), 0);
+  memcpy(stream_->data() + offset, &entry, sizeof(entry));
+  if (size) {
+    memcpy(stream_->data() + offset + sizeof(entry), data, size);
+  }
+
+  count_++;
+  memcpy(stream_->data() + offsetof(BatchHeader, count), &count_, sizeof(count_));
+}
+
+int ParseBatchStream(const uint8_t *data, size_t size, std::vector<BatchEntry> *entries) {
+  BatchHeader header = {};
+  if (!data || size < sizeof(header)) {
+    return -EINVAL;
+  }
+
+  memcpy(&header, data, sizeof(header));
+  if (header.version != kBatchVersion || header.count > kMaxBatchEntries) {
+    return -EINVAL;
+  }
+
+  entries->clear();
+  entries->reserve(header.count);
+  size_t offset = sizeof(header);
+  for (uint32_t i = 0; i < header.count; i++) {
+    BatchEntryHeader entry = {};
+    if (size - offset < sizeof(entry)) {
+      return -EINVAL;
+    }
+    memcpy(&entry, data + offset, sizeof(entry));
+    offset += sizeof(entry);
+
+    size_t padded_size = AlignBatchSize(entry.size);
+    if (size - offset < padded_size) {
+      return -EINVAL;
+    }
+    entries->push_back({entry.op_code, entry.error, data + offset, entry.size});
+    offset += padded_size;
+  }
+
+  return 0;
+}
+
+int ExecuteBatch(const uint8_t *request, size_t request_size, const BatchCall &call,
+                 std::vector<uint8_t> *response) {
+  std::vector<BatchEntry> entries;
+  if (ParseBatchStream(request, request_size, &entries)) {
+    return -EBADMSG;
+  }
+
+  std::vector<uint8_t> output;
+  BatchWriter writer(response);
+  for (auto &entry : entries) {
+    if (entry.op_code == kPerformBatch || entry.op_code == kDestroy ||
+        entry.op_code == kSetCwbOutputBuffer) {
+      writer.Append(entry.op_code, -EINVAL, nullptr, 0);
+      continue;
+    }
+
+    output.clear();
+    int32_t error = call(entry.op_code, entry.data, entry.size, &output);
+    writer.Append(entry.op_code, error, output.data(), output.size());
+  }
+
+  return 0;
+}
+
+}  // namespace DisplayConfig
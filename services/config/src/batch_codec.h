@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __BATCH_CODEC_H__
+#define __BATCH_CODEC_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <functional>
+#include <vector>
+
+namespace DisplayConfig {
+
+// Stream layout of kPerformBatch requests and responses:
+//   BatchHeader, then count x (BatchEntryHeader, payload padded to kBatchAlignment).
+// Requests carry the input params of each call with error 0, responses carry the output params
+// and the error of each call, in request order.
+struct BatchHeader {
+  uint32_t version;
+  uint32_t count;
+};
+
+struct BatchEntryHeader {
+  uint32_t op_code;
+  int32_t error;
+  uint32_t size;
+  uint32_t reserved;
+};
+
+struct BatchEntry {
+  uint32_t op_code;
+  int32_t error;
+  const uint8_t *data;
+  uint32_t size;
+};
+
+static const uint32_t kBatchVersion = 1;
+static const uint32_t kMaxBatchEntries = 64;
+static const size_t kBatchAlignment = 8;
+
+class BatchWriter {
+ public:
+  explicit BatchWriter(std::vector<uint8_t> *stream);
+  void Append(uint32_t op_code, int32_t error, const void *data, size_t size);
+  uint32_t GetCount() { return count_; }
+
+ private:
+  std::vector<uint8_t> *stream_ = nullptr;
+  uint32_t count_ = 0;
+};
+
+// Splits a batch stream into its entries, which point into data. Returns -EINVAL if the stream
+// is truncated, of an unknown version or has more than kMaxBatchEntries entries.
+int ParseBatchStream(const uint8_t *data, size_t size, std::vector<BatchEntry> *entries);
+
+// Executes one call of a batch on the service side. Returns the error of the call and fills
+// output with its output params.
+typedef std::function<int32_t(uint32_t op_code, const uint8_t *input, size_t input_size,
+                              std::vector<uint8_t> *output)> BatchCall;
+
+// Service side of kPerformBatch: runs every entry of request through call and writes the
+// response stream. Calls which carry handles or tear the client down fail with -EINVAL without
+// reaching call. Returns -EBADMSG for a malformed request, so that clients can tell it from the
+// -EINVAL a service without batch support replies for the unknown op code.
+int ExecuteBatch(const uint8_t *request, size_t request_size, const BatchCall &call,
+                 std::vector<uint8_t> *response);
+
+}  // namespace DisplayConfig
+
+#endif  // __BATCH_CODEC_H__
@@ -0,0 +1,38 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __BATCH_TRANSPORT_H__
+#define __BATCH_TRANSPORT_H__
+
+#include <stdint.h>
+#include <vector>
+
+namespace DisplayConfig {
+
+class ClientInterface;
+class ConfigCache;
+
+// What ClientBatch needs from a client: raw perform() calls and the client side cache.
+// ClientInterface is a frozen public interface, so clients returned by ClientInterface::Create
+// register their transport instead of ClientInterface growing a virtual for it. Any other
+// ClientInterface implementation has none and can not execute batches.
+class BatchTransport {
+ public:
+  virtual ~BatchTransport() {}
+
+  // Returns the error of the call, -ENODEV if the service is gone or -EPIPE if the transaction
+  // failed.
+  virtual int Perform(uint32_t op_code, const std::vector<uint8_t> &input,
+                      std::vector<uint8_t> *output) = 0;
+  virtual ConfigCache *GetConfigCache() = 0;
+
+  static void Register(const ClientInterface *intf, BatchTransport *transport);
+  static void Unregister(const ClientInterface *intf);
+  static BatchTransport *Get(const ClientInterface *intf);
+};
+
+}  // namespace DisplayConfig
+
+#endif  // __BATCH_TRANSPORT_H__
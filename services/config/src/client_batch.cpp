@@ -0,0 +1,207 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <display_config_batch.h>
+#include <errno.h>
+#include <string.h>
+#include <log/log.h>
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "batch_codec.h"
+#include "batch_transport.h"
+#include "config_cache.h"
+#include "opcode_types.h"
+
+namespace DisplayConfig {
+
+static std::mutex transports_lock;
+static std::map<const ClientInterface *, BatchTransport *> transports;
+
+void BatchTransport::Register(const ClientInterface *intf, BatchTransport *transport) {
+  std::lock_guard<std::mutex> lock(transports_lock);
+  transports[intf] = transport;
+}
+
+void BatchTransport::Unregister(const ClientInterface *intf) {
+  std::lock_guard<std::mutex> lock(transports_lock);
+  transports.erase(intf);
+}
+
+BatchTransport *BatchTransport::Get(const ClientInterface *intf) {
+  std::lock_guard<std::mutex> lock(transports_lock);
+  auto it = transports.find(intf);
+  return (it == transports.end()) ? nullptr : it->second;
+}
+
+static void CompleteCall(void *output, size_t output_size, int *error, int32_t result,
+                         const uint8_t *data, size_t size) {
+  if (!result && size < output_size) {
+    result = -ENODATA;
+  }
+  if (!result && output_size) {
+    memcpy(output, data, output_size);
+  }
+  *error = result;
+}
+
+void ClientBatch::Queue(uint32_t op_code, const void *input, size_t input_size, void *output,
+                        size_t output_size, int *error) {
+  const uint8_t *bytes = reinterpret_cast<const uint8_t*>(input);
+  Call call = {op_code, std::vector<uint8_t>(bytes, bytes + input_size), output, output_size,
+               error};
+  calls_.push_back(std::move(call));
+}
+
+void ClientBatch::IsDisplayConnected(DisplayType dpy, bool *connected, int *error) {
+  Queue(kIsDisplayConnected, &dpy, sizeof(dpy), connected, sizeof(bool), error);
+}
+
+void ClientBatch::GetConfigCount(DisplayType dpy, uint32_t *count, int *error) {
+  Queue(kGetConfigCount, &dpy, sizeof(dpy), count, sizeof(uint32_t), error);
+}
+
+void ClientBatch::GetActiveConfig(DisplayType dpy, uint32_t *config, int *error) {
+  Queue(kGetActiveConfig, &dpy, sizeof(dpy), config, sizeof(uint32_t), error);
+}
+
+void ClientBatch::GetDisplayAttributes(uint32_t config_index, DisplayType dpy,
+                                       Attributes *attributes, int *error) {
+  struct AttributesParams input = {config_index, dpy};
+  Queue(kGetDisplayAttributes, &input, sizeof(input), attributes, sizeof(Attributes), error);
+}
+
+void ClientBatch::GetPanelBrightness(uint32_t *level, int *error) {
+  Queue(kGetPanelBrightness, nullptr, 0, level, sizeof(uint32_t), error);
+}
+
+void ClientBatch::GetActiveBuiltinDisplayAttributes(Attributes *attr, int *error) {
+  Queue(kGetActiveBuiltinDisplayAttributes, nullptr, 0, attr, sizeof(Attributes), error);
+}
+
+void ClientBatch::GetWriteBackCapabilities(bool *is_wb_ubwc_supported, int *error) {
+  Queue(kGetWritebackCapabilities, nullptr, 0, is_wb_ubwc_supported, sizeof(bool), error);
+}
+
+void ClientBatch::IsHDRSupported(uint32_t disp_id, bool *supported, int *error) {
+  Queue(kIsHdrSupported, &disp_id, sizeof(disp_id), supported, sizeof(bool), error);
+}
+
+void ClientBatch::IsWCGSupported(uint32_t disp_id, bool *supported, int *error) {
+  Queue(kIsWcgSupported, &disp_id, sizeof(disp_id), supported, sizeof(bool), error);
+}
+
+void ClientBatch::IsBuiltInDisplay(uint32_t disp_id, bool *is_builtin, int *error) {
+  Queue(kIsBuiltinDisplay, &disp_id, sizeof(disp_id), is_builtin, sizeof(bool), error);
+}
+
+void ClientBatch::IsSmartPanelConfig(uint32_t disp_id, uint32_t config_id, bool *is_smart,
+                                     int *error) {
+  struct SmartPanelCfgParams input = {disp_id, config_id};
+  Queue(kIsSmartPanelConfig, &input, sizeof(input), is_smart, sizeof(bool), error);
+}
+
+void ClientBatch::IsRCSupported(uint32_t disp_id, bool *supported, int *error) {
+  Queue(kIsRCSupported, &disp_id, sizeof(disp_id), supported, sizeof(bool), error);
+}
+
+void ClientBatch::GetDisplayHwId(uint32_t disp_id, uint32_t *display_hw_id, int *error) {
+  Queue(kGetDisplayHwId, &disp_id, sizeof(disp_id), display_hw_id, sizeof(uint32_t), error);
+}
+
+void ClientBatch::GetDisplayType(uint64_t physical_disp_id, DisplayType *disp_type, int *error) {
+  Queue(kGetDisplayType, &physical_disp_id, sizeof(physical_disp_id), disp_type,
+        sizeof(DisplayType), error);
+}
+
+int ClientBatch::Execute(ClientInterface *intf) {
+  BatchTransport *transport = BatchTransport::Get(intf);
+  if (!transport) {
+    Clear();
+    return -EINVAL;
+  }
+
+  ConfigCache *cache = transport->GetConfigCache();
+
+  // Calls answered by the client cache are not sent at all.
+  std::vector<size_t> pending;
+  std::vector<uint8_t> cached;
+  for (size_t i = 0; i < calls_.size(); i++) {
+    Call &call = calls_[i];
+    if (ConfigCache::IsCacheable(call.op_code) &&
+        cache->Lookup(call.op_code, call.input.data(), call.input.size(), &cached)) {
+      CompleteCall(call.output, call.output_size, call.error, 0, cached.data(), cached.size());
+    } else {
+      pending.push_back(i);
+    }
+  }
+
+  uint64_t generation = cache->GetGeneration();
+  auto complete = [cache, generation] (Call &call, int32_t result, const uint8_t *data,
+                                       size_t size) {
+    if (!result && ConfigCache::IsCacheable(call.op_code)) {
+      cache->Store(generation, call.op_code, call.input.data(), call.input.size(), data, size);
+    }
+    CompleteCall(call.output, call.output_size, call.error, result, data, size);
+  };
+
+  int ret = 0;
+  for (size_t first = 0; first < pending.size(); first += kMaxBatchEntries) {
+    size_t last = std::min(pending.size(), first + kMaxBatchEntries);
+
+    std::vector<uint8_t> request;
+    std::vector<uint8_t> response;
+    std::vector<BatchEntry> entries;
+    BatchWriter writer(&request);
+    for (size_t i = first; i < last; i++) {
+      Call &call = calls_[pending[i]];
+      writer.Append(call.op_code, 0, call.input.data(), call.input.size());
+    }
+
+    int error = transport->Perform(kPerformBatch, request, &response);
+    if (error == -EINVAL) {
+      // Service without kPerformBatch rejects the op code, one transaction per call.
+      ALOGW("kPerformBatch not supported, executing %zu calls one by one", last - first);
+      for (size_t i = first; i < last; i++) {
+        Call &call = calls_[pending[i]];
+        int32_t result = transport->Perform(call.op_code, call.input, &response);
+        complete(call, result, response.data(), response.size());
+      }
+      continue;
+    }
+
+    if (!error && (ParseBatchStream(response.data(), response.size(), &entries) ||
+                   entries.size() != last - first)) {
+      error = -EBADMSG;
+    }
+
+    if (error) {
+      // Retrying one by one would only repeat the failure, e.g. on a dead service.
+      ALOGE("Batch of %zu calls failed (%d)", last - first, error);
+      for (size_t i = first; i < last; i++) {
+        *calls_[pending[i]].error = error;
+      }
+      ret = error;
+      continue;
+    }
+
+    for (size_t i = first; i < last; i++) {
+      const BatchEntry &entry = entries[i - first];
+      complete(calls_[pending[i]], entry.error, entry.data, entry.size);
+    }
+  }
+
+  Clear();
+  return ret;
+}
+
+void ClientBatch::Clear() {
+  calls_.clear();
+}
+
+}  // namespace DisplayConfig
@@ -0,0 +1,372 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <display_config_batch.h>
+#include <errno.h>
+#include <string.h>
+#include <stdio.h>
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <map>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "batch_codec.h"
+#include "batch_transport.h"
+#include "config_cache.h"
+#include "opcode_types.h"
+using namespace testing;
+
+namespace DisplayConfig {
+namespace {
+
+typedef std::vector<uint8_t> Bytes;
+
+Bytes ToBytes(const void *data, size_t size) {
+  const uint8_t *bytes = reinterpret_cast<const uint8_t *>(data);
+  return Bytes(bytes, bytes + size);
+}
+
+template <class T>
+T FromBytes(const uint8_t *data, size_t size) {
+  T value = {};
+  memcpy(&value, data, std::min(size, sizeof(value)));
+  return value;
+}
+
+// Stands in for the binder transport of a client. Batches run through ExecuteBatch, the code
+// behind DeviceImpl::ParseBatch, and then through the same per op handlers as single calls.
+class FakeService : public BatchTransport {
+ public:
+  FakeService() {
+    // Registered like ClientInterface::Create does, the key is never dereferenced.
+    intf_ = reinterpret_cast<ClientInterface *>(this);
+    BatchTransport::Register(intf_, this);
+  }
+  ~FakeService() { BatchTransport::Unregister(intf_); }
+
+  virtual int Perform(uint32_t op_code, const std::vector<uint8_t> &input,
+                      std::vector<uint8_t> *output) {
+    transactions_++;
+    output->clear();
+    // Spin rather than sleep, so that the modeled round trip does not depend on the scheduler.
+    auto start = std::chrono::steady_clock::now();
+    while (std::chrono::steady_clock::now() - start < round_trip_) {
+    }
+    if (transport_error_) {
+      return transport_error_;
+    }
+    if (op_code == kPerformBatch && batch_supported_) {
+      auto call = [this] (uint32_t op, const uint8_t *data, size_t size, Bytes *call_output) {
+        return Handle(op, Bytes(data, data + size), call_output);
+      };
+      return ExecuteBatch(input.data(), input.size(), call, output);
+    }
+    return Handle(op_code, input, output);
+  }
+
+  virtual ConfigCache *GetConfigCache() { return &cache_; }
+
+  ClientInterface *intf_ = nullptr;
+  ConfigCache cache_;
+  bool batch_supported_ = true;
+  int transport_error_ = 0;
+  // Modeled cost of one binder transaction.
+  std::chrono::nanoseconds round_trip_ {0};
+  uint32_t transactions_ = 0;
+  std::map<uint32_t, uint32_t> handled_;
+
+ private:
+  int32_t Handle(uint32_t op_code, const Bytes &input, Bytes *output) {
+    handled_[op_code]++;
+    uint32_t arg = input.empty() ? 0 : input[0];
+    switch (op_code) {
+      case kIsDisplayConnected: {
+        bool connected = (arg == uint32_t(DisplayType::kPrimary));
+        *output = ToBytes(&connected, sizeof(connected));
+        return 0;
+      }
+      case kGetConfigCount: {
+        uint32_t count = arg + 3;
+        *output = ToBytes(&count, sizeof(count));
+        return 0;
+      }
+      case kGetDisplayAttributes: {
+        Attributes attributes;
+        memset(&attributes, 0, sizeof(attributes));
+        attributes.vsync_period = 16666666 + arg;
+        attributes.x_res = 1080;
+        attributes.y_res = 2400;
+        *output = ToBytes(&attributes, sizeof(attributes));
+        return 0;
+      }
+      case kGetDisplayHwId: {
+        uint32_t hw_id = arg * 10;
+        *output = ToBytes(&hw_id, sizeof(hw_id));
+        return 0;
+      }
+      case kIsHdrSupported:
+        // Fails, so that per call errors are covered.
+        return -ENOTSUP;
+      default:
+        return -EINVAL;
+    }
+  }
+};
+
+struct Results {
+  bool connected = false;
+  uint32_t count = 0;
+  Attributes attributes = {};
+  uint32_t hw_id = 0;
+  bool hdr = false;
+  int errors[5] = {1, 1, 1, 1, 1};
+};
+
+void QueueQueries(ClientBatch *batch, Results *results) {
+  batch->IsDisplayConnected(DisplayType::kPrimary, &results->connected, &results->errors[0]);
+  batch->GetConfigCount(DisplayType::kExternal, &results->count, &results->errors[1]);
+  batch->GetDisplayAttributes(2, DisplayType::kPrimary, &results->attributes,
+                              &results->errors[2]);
+  batch->GetDisplayHwId(4, &results->hw_id, &results->errors[3]);
+  batch->IsHDRSupported(0, &results->hdr, &results->errors[4]);
+}
+
+void ExpectResults(const Results &results) {
+  EXPECT_THAT(results.errors, ElementsAre(0, 0, 0, 0, -ENOTSUP));
+  EXPECT_TRUE(results.connected);
+  EXPECT_THAT(results.count, Eq(uint32_t(DisplayType::kExternal) + 3));
+  EXPECT_THAT(results.attributes.vsync_period, Eq(16666666u + 2));
+  EXPECT_THAT(results.attributes.y_res, Eq(2400u));
+  EXPECT_THAT(results.hw_id, Eq(40u));
+  EXPECT_FALSE(results.hdr);
+}
+
+}  // namespace
+
+TEST(BatchCodecTest, RoundTrip) {
+  Bytes stream;
+  BatchWriter writer(&stream);
+  uint32_t value = 0x12345678;
+  uint8_t odd[3] = {1, 2, 3};
+  writer.Append(4, 0, &value, sizeof(value));
+  writer.Append(9, -EINVAL, nullptr, 0);
+  writer.Append(11, 0, odd, sizeof(odd));
+  EXPECT_THAT(writer.GetCount(), Eq(3u));
+  EXPECT_THAT(stream.size() % kBatchAlignment, Eq(0u));
+
+  std::vector<BatchEntry> entries;
+  ASSERT_THAT(ParseBatchStream(stream.data(), stream.size(), &entries), Eq(0));
+  ASSERT_THAT(entries, SizeIs(3));
+  EXPECT_THAT(entries[0].op_code, Eq(4u));
+  EXPECT_THAT(ToBytes(entries[0].data, entries[0].size), ElementsAre(0x78, 0x56, 0x34, 0x12));
+  EXPECT_THAT(entries[1].error, Eq(-EINVAL));
+  EXPECT_THAT(entries[1].size, Eq(0u));
+  EXPECT_THAT(entries[2].op_code, Eq(11u));
+  EXPECT_THAT(ToBytes(entries[2].data, entries[2].size), ElementsAre(1, 2, 3));
+
+  // Payloads start aligned.
+  EXPECT_THAT(size_t(entries[2].data - stream.data()) % kBatchAlignment, Eq(0u));
+}
+
+TEST(BatchCodecTest, RejectsMalformedStreams) {
+  std::vector<BatchEntry> entries;
+  EXPECT_THAT(ParseBatchStream(nullptr, 0, &entries), Eq(-EINVAL));
+
+  Bytes stream;
+  BatchWriter writer(&stream);
+  uint64_t value = 7;
+  writer.Append(1, 0, &value, sizeof(value));
+  writer.Append(2, 0, &value, sizeof(value));
+
+  for (size_t size = 0; size < stream.size(); size++) {
+    EXPECT_THAT(ParseBatchStream(stream.data(), size, &entries), Eq(-EINVAL)) << size;
+  }
+
+  Bytes bad_version = stream;
+  bad_version[0]++;
+  EXPECT_THAT(ParseBatchStream(bad_version.data(), bad_version.size(), &entries), Eq(-EINVAL));
+
+  Bytes huge_size = stream;
+  BatchEntryHeader header = {};
+  memcpy(&header, huge_size.data() + sizeof(BatchHeader), sizeof(header));
+  header.size = 0xFFFFFFF0;
+  memcpy(huge_size.data() + sizeof(BatchHeader), &header, sizeof(header));
+  EXPECT_THAT(ParseBatchStream(huge_size.data(), huge_size.size(), &entries), Eq(-EINVAL));
+
+  Bytes too_many;
+  BatchWriter many_writer(&too_many);
+  for (uint32_t i = 0; i <= kMaxBatchEntries; i++) {
+    many_writer.Append(i, 0, nullptr, 0);
+  }
+  EXPECT_THAT(ParseBatchStream(too_many.data(), too_many.size(), &entries), Eq(-EINVAL));
+}
+
+TEST(ExecuteBatchTest, RejectsUnbatchableCallsAndMalformedRequests) {
+  Bytes request;
+  BatchWriter writer(&request);
+  uint32_t value = 1;
+  writer.Append(kDestroy, 0, nullptr, 0);
+  writer.Append(kSetCwbOutputBuffer, 0, nullptr, 0);
+  writer.Append(kPerformBatch, 0, nullptr, 0);
+  writer.Append(kGetConfigCount, 0, &value, sizeof(value));
+
+  std::vector<uint32_t> called;
+  auto call = [&called] (uint32_t op_code, const uint8_t *, size_t, Bytes *output) {
+    called.push_back(op_code);
+    *output = {7};
+    return 0;
+  };
+
+  Bytes response;
+  ASSERT_THAT(ExecuteBatch(request.data(), request.size(), call, &response), Eq(0));
+  EXPECT_THAT(called, ElementsAre(uint32_t(kGetConfigCount)));
+
+  std::vector<BatchEntry> entries;
+  ASSERT_THAT(ParseBatchStream(response.data(), response.size(), &entries), Eq(0));
+  ASSERT_THAT(entries, SizeIs(4));
+  for (int i = 0; i < 3; i++) {
+    EXPECT_THAT(entries[i].error, Eq(-EINVAL));
+  }
+  EXPECT_THAT(entries[3].error, Eq(0));
+  EXPECT_THAT(ToBytes(entries[3].data, entries[3].size), ElementsAre(7));
+
+  // Distinct from the -EINVAL of a service which does not know kPerformBatch.
+  EXPECT_THAT(ExecuteBatch(request.data(), request.size() - 1, call, &response), Eq(-EBADMSG));
+}
+
+TEST(ClientBatchTest, BatchMatchesSingleCalls) {
+  FakeService service;
+  ClientBatch batch;
+  Results results;
+  QueueQueries(&batch, &results);
+  EXPECT_THAT(batch.GetCount(), Eq(5u));
+
+  ASSERT_THAT(batch.Execute(service.intf_), Eq(0));
+  EXPECT_THAT(service.transactions_, Eq(1u));
+  EXPECT_THAT(batch.GetCount(), Eq(0u));
+  ExpectResults(results);
+}
+
+TEST(ClientBatchTest, FallsBackWhenServiceLacksBatch) {
+  FakeService service;
+  service.batch_supported_ = false;
+  ClientBatch batch;
+  Results results;
+  QueueQueries(&batch, &results);
+
+  ASSERT_THAT(batch.Execute(service.intf_), Eq(0));
+  EXPECT_THAT(service.transactions_, Eq(6u));
+  ExpectResults(results);
+}
+
+TEST(ClientBatchTest, TransportErrorIsNotRetried) {
+  FakeService service;
+  service.transport_error_ = -EPIPE;
+  ClientBatch batch;
+  Results results;
+  QueueQueries(&batch, &results);
+
+  EXPECT_THAT(batch.Execute(service.intf_), Eq(-EPIPE));
+  EXPECT_THAT(service.transactions_, Eq(1u));
+  EXPECT_THAT(results.errors, Each(Eq(-EPIPE)));
+  EXPECT_FALSE(results.connected);
+  EXPECT_THAT(results.count, Eq(0u));
+}
+
+TEST(ClientBatchTest, CachedCallsAreNotSent) {
+  FakeService service;
+  service.cache_.SetGeneration(1);
+  ClientBatch batch;
+  Results results;
+  QueueQueries(&batch, &results);
+  ASSERT_THAT(batch.Execute(service.intf_), Eq(0));
+
+  // Only the connection state is not cacheable, failed calls are not cached either.
+  Results cached;
+  QueueQueries(&batch, &cached);
+  ASSERT_THAT(batch.Execute(service.intf_), Eq(0));
+  ExpectResults(cached);
+  EXPECT_THAT(service.transactions_, Eq(2u));
+  EXPECT_THAT(service.handled_[kIsDisplayConnected], Eq(2u));
+  EXPECT_THAT(service.handled_[kGetConfigCount], Eq(1u));
+  EXPECT_THAT(service.handled_[kIsHdrSupported], Eq(2u));
+}
+
+TEST(ClientBatchTest, SplitsLargeBatches) {
+  FakeService service;
+  ClientBatch batch;
+  std::vector<uint32_t> hw_ids(kMaxBatchEntries + 6);
+  std::vector<int> errors(hw_ids.size(), 1);
+  for (uint32_t i = 0; i < hw_ids.size(); i++) {
+    batch.GetDisplayHwId(i % 8, &hw_ids[i], &errors[i]);
+  }
+
+  ASSERT_THAT(batch.Execute(service.intf_), Eq(0));
+  EXPECT_THAT(service.transactions_, Eq(2u));
+  EXPECT_THAT(errors, Each(Eq(0)));
+  for (uint32_t i = 0; i < hw_ids.size(); i++) {
+    EXPECT_THAT(hw_ids[i], Eq((i % 8) * 10));
+  }
+}
+
+TEST(ClientBatchTest, UnknownInterfaceIsRejected) {
+  FakeService service;
+  ClientBatch batch;
+  Results results;
+  QueueQueries(&batch, &results);
+
+  // Not created through ClientInterface::Create, so it has no transport.
+  ClientInterface *other = reinterpret_cast<ClientInterface *>(&batch);
+  EXPECT_THAT(batch.Execute(other), Eq(-EINVAL));
+  EXPECT_THAT(batch.GetCount(), Eq(0u));
+  EXPECT_THAT(batch.Execute(nullptr), Eq(-EINVAL));
+  EXPECT_THAT(service.transactions_, Eq(0u));
+}
+
+// Loopback through the fake transport with a modeled round trip per transaction. The same queries
+// are timed as single Perform calls and as one kPerformBatch.
+TEST(ClientBatchTest, BatchReducesLatency) {
+  const int kIterations = 100;
+  const uint32_t kQueries = 8;
+  FakeService service;
+  service.round_trip_ = std::chrono::microseconds(50);
+
+  Bytes output;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kIterations; i++) {
+    for (uint32_t query = 0; query < kQueries; query++) {
+      Bytes input = {uint8_t(query)};
+      ASSERT_THAT(service.Perform(kGetDisplayHwId, input, &output), Eq(0));
+    }
+  }
+  auto single = std::chrono::steady_clock::now() - start;
+
+  uint32_t hw_ids[kQueries] = {};
+  int errors[kQueries] = {};
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kIterations; i++) {
+    ClientBatch batch;
+    for (uint32_t query = 0; query < kQueries; query++) {
+      batch.GetDisplayHwId(query, &hw_ids[query], &errors[query]);
+    }
+    ASSERT_THAT(batch.Execute(service.intf_), Eq(0));
+  }
+  auto batched = std::chrono::steady_clock::now() - start;
+
+  EXPECT_THAT(service.transactions_, Eq(uint32_t(kIterations) * (kQueries + 1)));
+  EXPECT_THAT(errors, Each(Eq(0)));
+  EXPECT_THAT(hw_ids[kQueries - 1], Eq((kQueries - 1) * 10));
+
+  double single_us = std::chrono::duration<double, std::micro>(single).count() / kIterations;
+  double batched_us = std::chrono::duration<double, std::micro>(batched).count() / kIterations;
+  printf("%u queries: %.2f us as single transactions, %.2f us batched (%.1fx)\n", kQueries,
+         single_us, batched_us, single_us / batched_us);
+  // Round trips dominate, the batch has to at least halve the latency, also in sanitizer builds.
+  EXPECT_THAT(single_us / batched_us, Gt(2.0));
+}
+
+}  // namespace DisplayConfig
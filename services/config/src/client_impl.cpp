@@ -27,6 +27,43 @@
 * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+/*
+* Changes from Qualcomm Innovation Center are provided under the following license:
+*
+* Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted (subject to the limitations in the
+* disclaimer below) provided that the following conditions are met:
+*
+*    * Redistributions of source code must retain the above copyright
+*      notice, this list of conditions and the following disclaimer.
+*
+*    * Redistributions in binary form must reproduce the above
+*      copyright notice, this list of conditions and the following
+*      disclaimer in the documentation and/or other materials provided
+*      with the distribution.
+*
+*    * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+*      contributors may be used to endorse or promote products derived
+*      from this software without specific prior written permission.
+*
+* NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+* GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+* HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+* MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+* IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+* GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+* IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+* OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+* IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <string.h>
 #include <string>
 #include <vector>
 
@@ -47,7 +84,7 @@ int ClientImpl::Init(std::string client_name, ConfigCallback *callback) {
     handle = client_handle;
   };
   int pid = getpid();
-  android::sp<ClientCallback> client_cb(new ClientCallback(callback));
+  android::sp<ClientCallback> client_cb(new ClientCallback(callback, cache_));
   display_config_->registerClient(client_name + std::to_string(pid), client_cb,
                                   hidl_callback);
   client_handle_ = handle;
@@ -98,7 +135,7 @@ int ClientImpl::SetDisplayStatus(DisplayType dpy, ExternalStatus status) {
     error = err;
   };
 
-  display_config_->perform(client_handle_, kSetDisplayStatus, input_params, {}, hidl_cb);
+  PerformMutating(kSetDisplayStatus, input_params, hidl_cb);
 
   return error;
 }
@@ -114,7 +151,7 @@ int ClientImpl::ConfigureDynRefreshRate(DynRefreshRateOp op, uint32_t refresh_ra
     error = err;
   };
 
-  display_config_->perform(client_handle_, kConfigureDynRefreshRate, input_params, {}, hidl_cb);
+  PerformMutating(kConfigureDynRefreshRate, input_params, hidl_cb);
 
   return error;
 }
@@ -130,7 +167,7 @@ int ClientImpl::GetConfigCount(DisplayType dpy, uint32_t *count) {
     output_params = params;
   };
 
-  display_config_->perform(client_handle_, kGetConfigCount, input_params, {}, hidl_cb);
+  PerformCached(kGetConfigCount, input_params, hidl_cb);
 
   const uint8_t *data = output_params.data();
   output = reinterpret_cast<const uint32_t*>(data);
@@ -176,7 +213,7 @@ int ClientImpl::SetActiveConfig(DisplayType dpy, uint32_t config) {
     error = err;
   };
 
-  display_config_->perform(client_handle_, kSetActiveConfig, input_params, {}, hidl_cb);
+  PerformMutating(kSetActiveConfig, input_params, hidl_cb);
 
   return error;
 }
@@ -194,7 +231,7 @@ int ClientImpl::GetDisplayAttributes(uint32_t config_index, DisplayType dpy,
     output_params = params;
   };
 
-  display_config_->perform(client_handle_, kGetDisplayAttributes, input_params, {}, hidl_cb);
+  PerformCached(kGetDisplayAttributes, input_params, hidl_cb);
 
   const uint8_t *data = output_params.data();
   output = reinterpret_cast<const Attributes*>(data);
@@ -316,7 +353,7 @@ int ClientImpl::GetHDRCapabilities(DisplayType dpy, HDRCapsParams *caps) {
     output_params = params;
   };
 
-  display_config_->perform(client_handle_, kGetHdrCapabilities, input_params, {}, hidl_cb);
+  PerformCached(kGetHdrCapabilities, input_params, hidl_cb);
 
   const uint8_t *data = output_params.data();
 
@@ -410,7 +447,7 @@ int ClientImpl::GetWriteBackCapabilities(bool *is_wb_ubwc_supported) {
     output_params = params;
   };
 
-  display_config_->perform(client_handle_, kGetWritebackCapabilities, {}, {}, hidl_cb);
+  PerformCached(kGetWritebackCapabilities, {}, hidl_cb);
 
   const uint8_t *data = output_params.data();
   output = reinterpret_cast<const bool*>(data);
@@ -485,8 +522,7 @@ int ClientImpl::IsPowerModeOverrideSupported(uint32_t disp_id, bool *supported)
     output_params = params;
   };
 
-  display_config_->perform(client_handle_, kIsPowerModeOverrideSupported,
-                           input_params, {}, hidl_cb);
+  PerformCached(kIsPowerModeOverrideSupported, input_params, hidl_cb);
 
   const uint8_t *data = output_params.data();
   output = reinterpret_cast<const bool*>(data);
@@ -509,7 +545,7 @@ int ClientImpl::IsHDRSupported(uint32_t disp_id, bool *supported) {
     output_params = params;
   };
 
-  display_config_->perform(client_handle_, kIsHdrSupported, input_params, {}, hidl_cb);
+  PerformCached(kIsHdrSupported, input_params, hidl_cb);
 
   const uint8_t *data = output_params.data();
   output = reinterpret_cast<const bool*>(data);
@@ -532,7 +568,7 @@ int ClientImpl::IsWCGSupported(uint32_t disp_id, bool *supported) {
     output_params = params;
   };
 
-  display_config_->perform(client_handle_, kIsWcgSupported, input_params, {}, hidl_cb);
+  PerformCached(kIsWcgSupported, input_params, hidl_cb);
 
   const uint8_t *data = output_params.data();
   output = reinterpret_cast<const bool*>(data);
@@ -613,7 +649,7 @@ int ClientImpl::SetPanelLuminanceAttributes(uint32_t disp_id, float min_lum, flo
     error = err;
   };
 
-  display_config_->perform(client_handle_, kSetPanelLuminanceAttributes, input_params, {}, hidl_cb);
+  PerformMutating(kSetPanelLuminanceAttributes, input_params, hidl_cb);
 
   return error;
 }
@@ -629,7 +665,7 @@ int ClientImpl::IsBuiltInDisplay(uint32_t disp_id, bool *is_builtin) {
     output_params = params;
   };
 
-  display_config_->perform(client_handle_, kIsBuiltinDisplay, input_params, {}, hidl_cb);
+  PerformCached(kIsBuiltinDisplay, input_params, hidl_cb);
 
   const uint8_t *data = output_params.data();
   output = reinterpret_cast<const bool*>(data);
@@ -673,7 +709,7 @@ int ClientImpl::GetSupportedDSIBitClks(uint32_t disp_id, std::vector<uint64_t> *
     output_params = params;
   };
 
-  display_config_->perform(client_handle_, kGetSupportedDsiBitclks, input_params, {}, hidl_cb);
+  PerformCached(kGetSupportedDsiBitclks, input_params, hidl_cb);
 
   if (!error) {
     const uint8_t *data = output_params.data();
@@ -719,7 +755,7 @@ int ClientImpl::SetDSIClk(uint32_t disp_id, uint64_t bit_clk) {
     error = err;
   };
 
-  display_config_->perform(client_handle_, kSetDsiClk, input_params, {}, hidl_cb);
+  PerformMutating(kSetDsiClk, input_params, hidl_cb);
 
   return error;
 }
@@ -751,7 +787,7 @@ int ClientImpl::IsSmartPanelConfig(uint32_t disp_id, uint32_t config_id, bool *i
     output_params = params;
   };
 
-  display_config_->perform(client_handle_, kIsSmartPanelConfig, input_params, {}, hidl_cb);
+  PerformCached(kIsSmartPanelConfig, input_params, hidl_cb);
 
   const uint8_t *data = output_params.data();
   output = reinterpret_cast<const bool*>(data);
@@ -772,7 +808,7 @@ int ClientImpl::IsAsyncVDSCreationSupported(bool *supported) {
     output_params = params;
   };
 
-  display_config_->perform(client_handle_, kIsAsyncVdsSupported, {}, {}, hidl_cb);
+  PerformCached(kIsAsyncVdsSupported, {}, hidl_cb);
 
   const uint8_t *data = output_params.data();
   output = reinterpret_cast<const bool*>(data);
@@ -793,7 +829,7 @@ int ClientImpl::CreateVirtualDisplay(uint32_t width, uint32_t height, int32_t fo
     error = err;
   };
 
-  display_config_->perform(client_handle_, kCreateVirtualDisplay, input_params, {}, hidl_cb);
+  PerformMutating(kCreateVirtualDisplay, input_params, hidl_cb);
 
   return error;
 }
@@ -811,7 +847,7 @@ int ClientImpl::IsRotatorSupportedFormat(int hal_format, bool ubwc, bool *suppor
     output_params = params;
   };
 
-  display_config_->perform(client_handle_, kIsRotatorSupportedFormat, input_params, {}, hidl_cb);
+  PerformCached(kIsRotatorSupportedFormat, input_params, hidl_cb);
 
   const uint8_t *data = output_params.data();
   output = reinterpret_cast<const bool*>(data);
@@ -874,7 +910,7 @@ int ClientImpl::GetDisplayHwId(uint32_t disp_id, uint32_t *display_hw_id) {
     output_params = params;
   };
 
-  display_config_->perform(client_handle_, kGetDisplayHwId, input_params, {}, hidl_cb);
+  PerformCached(kGetDisplayHwId, input_params, hidl_cb);
 
   const uint8_t *data = output_params.data();
   const uint32_t *output = reinterpret_cast<const uint32_t*>(data);
@@ -897,8 +933,7 @@ int ClientImpl::GetSupportedDisplayRefreshRates(DisplayType dpy,
     output_params = params;
   };
 
-  display_config_->perform(client_handle_, kGetSupportedDisplayRefreshRates, input_params, {},
-                           hidl_cb);
+  PerformCached(kGetSupportedDisplayRefreshRates, input_params, hidl_cb);
 
   if (!error) {
     const uint8_t *data = output_params.data();
@@ -923,7 +958,7 @@ int ClientImpl::IsRCSupported(uint32_t disp_id, bool *supported) {
     output_params = params;
   };
 
-  display_config_->perform(client_handle_, kIsRCSupported, input_params, {}, hidl_cb);
+  PerformCached(kIsRCSupported, input_params, hidl_cb);
 
   if (!error) {
     const uint8_t *data = output_params.data();
@@ -984,7 +1019,7 @@ int ClientImpl::GetDisplayType(uint64_t physical_disp_id, DisplayType *disp_type
     output_params = params;
   };
   if (display_config_) {
-    display_config_->perform(client_handle_, kGetDisplayType, input_params, {}, hidl_cb);
+    PerformCached(kGetDisplayType, input_params, hidl_cb);
   }
 
   if (!error) {
@@ -1006,6 +1041,65 @@ int ClientImpl::AllowIdleFallback() {
   return error;
 }
 
+void ClientImpl::PerformCached(uint32_t op_code, const ByteStream &input_params,
+                               IDisplayConfig::perform_cb hidl_cb) {
+  std::vector<uint8_t> cached;
+  if (cache_->Lookup(op_code, input_params.data(), input_params.size(), &cached)) {
+    ByteStream output_params;
+    output_params.setToExternal(cached.data(), cached.size());
+    hidl_cb(0, output_params, {});
+    return;
+  }
+
+  if (!display_config_) {
+    return;
+  }
+
+  uint64_t generation = cache_->GetGeneration();
+  auto store_cb = [&] (int32_t err, const ByteStream &params, const HandleStream &handles) {
+    if (!err) {
+      cache_->Store(generation, op_code, input_params.data(), input_params.size(),
+                    params.data(), params.size());
+    }
+    hidl_cb(err, params, handles);
+  };
+  display_config_->perform(client_handle_, op_code, input_params, {}, store_cb);
+}
+
+void ClientImpl::PerformMutating(uint32_t op_code, const ByteStream &input_params,
+                                 IDisplayConfig::perform_cb hidl_cb) {
+  display_config_->perform(client_handle_, op_code, input_params, {}, hidl_cb);
+  // Invalidate even on error, the change may have been applied in part.
+  cache_->Invalidate();
+}
+
+int ClientImpl::Perform(uint32_t op_code, const std::vector<uint8_t> &input,
+                        std::vector<uint8_t> *output) {
+  ByteStream input_params;
+  input_params.setToExternal(const_cast<uint8_t*>(input.data()), input.size());
+  int error = -ENODEV;
+  auto hidl_cb = [&error, output] (int32_t err, ByteStream params, HandleStream handles) {
+    error = err;
+    output->assign(params.data(), params.data() + params.size());
+  };
+
+  output->clear();
+  if (!display_config_) {
+    return -ENODEV;
+  }
+
+  auto ret = display_config_->perform(client_handle_, op_code, input_params, {}, hidl_cb);
+  if (ConfigCache::IsMutating(op_code)) {
+    cache_->Invalidate();
+  }
+  if (!ret.isOk()) {
+    ALOGW("perform(%u) transaction failed: %s", op_code, ret.description().c_str());
+    return -EPIPE;
+  }
+
+  return error;
+}
+
 void ClientCallback::ParseNotifyCWBBufferDone(const ByteStream &input_params,
                                               const HandleStream &input_handles) {
   const int *error;
@@ -1044,6 +1138,16 @@ void ClientCallback::ParseNotifyIdleStatus(const ByteStream &input_params) {
   callback_->NotifyIdleStatus(*is_idle);
 }
 
+void ClientCallback::ParseNotifyConfigChanged(const ByteStream &input_params) {
+  uint64_t generation = 0;
+  if (input_params.size() < sizeof(generation)) {
+    return;
+  }
+
+  memcpy(&generation, input_params.data(), sizeof(generation));
+  cache_->SetGeneration(generation);
+}
+
 Return<void> ClientCallback::perform(uint32_t op_code, const ByteStream &input_params,
                                      const HandleStream &input_handles) {
   switch (op_code) {
@@ -1056,6 +1160,9 @@ Return<void> ClientCallback::perform(uint32_t op_code, const ByteStream &input_p
     case kControlIdleStatusCallback:
       ParseNotifyIdleStatus(input_params);
       break;
+    case kNotifyConfigChanged:
+      ParseNotifyConfigChanged(input_params);
+      break;
     default:
       break;
   }
@@ -27,6 +27,42 @@
 * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+/*
+* Changes from Qualcomm Innovation Center are provided under the following license:
+*
+* Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted (subject to the limitations in the
+* disclaimer below) provided that the following conditions are met:
+*
+*    * Redistributions of source code must retain the above copyright
+*      notice, this list of conditions and the following disclaimer.
+*
+*    * Redistributions in binary form must reproduce the above
+*      copyright notice, this list of conditions and the following
+*      disclaimer in the documentation and/or other materials provided
+*      with the distribution.
+*
+*    * Neither the name of Qualcomm Innovation Center, Inc. nor the names of its
+*      contributors may be used to endorse or promote products derived
+*      from this software without specific prior written permission.
+*
+* NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+* GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+* HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+* MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+* IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+* GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+* IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+* OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+* IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
 #ifndef __CLIENT_IMPL_H__
 #define __CLIENT_IMPL_H__
 
@@ -36,9 +72,12 @@
 #include <hidl/HidlSupport.h>
 #include <log/log.h>
 #include <config/client_interface.h>
+#include <memory>
 #include <string>
 #include <vector>
 
+#include "batch_transport.h"
+#include "config_cache.h"
 #include "opcode_types.h"
 
 namespace DisplayConfig {
@@ -55,8 +94,9 @@ typedef hidl_vec<hidl_handle> HandleStream;
 
 class ClientCallback: public IDisplayConfigCallback {
  public:
-  ClientCallback(ConfigCallback *cb) {
+  ClientCallback(ConfigCallback *cb, std::shared_ptr<ConfigCache> cache) {
     callback_ = cb;
+    cache_ = cache;
   }
 
  private:
@@ -65,10 +105,12 @@ class ClientCallback: public IDisplayConfigCallback {
   void ParseNotifyCWBBufferDone(const ByteStream &input_params, const HandleStream &input_handles);
   void ParseNotifyQsyncChange(const ByteStream &input_params);
   void ParseNotifyIdleStatus(const ByteStream &input_params);
+  void ParseNotifyConfigChanged(const ByteStream &input_params);
   ConfigCallback *callback_ = nullptr;
+  std::shared_ptr<ConfigCache> cache_ = nullptr;
 };
 
-class ClientImpl : public ClientInterface {
+class ClientImpl : public ClientInterface, public BatchTransport {
  public:
   int Init(std::string client_name, ConfigCallback *callback);
   void DeInit();
@@ -129,9 +171,22 @@ class ClientImpl : public ClientInterface {
   virtual int AllowIdleFallback();
   virtual int DummyDisplayConfigAPI();
 
+  // BatchTransport, input and output are raw perform() params.
+  virtual int Perform(uint32_t op_code, const std::vector<uint8_t> &input,
+                      std::vector<uint8_t> *output);
+  virtual ConfigCache *GetConfigCache() { return cache_.get(); }
+
  private:
+  // Serves ConfigCache::IsCacheable() op codes from cache_ while its generation is current.
+  void PerformCached(uint32_t op_code, const ByteStream &input_params,
+                     IDisplayConfig::perform_cb hidl_cb);
+  // Sends a ConfigCache::IsMutating() op code and invalidates cache_ for read-your-writes.
+  void PerformMutating(uint32_t op_code, const ByteStream &input_params,
+                       IDisplayConfig::perform_cb hidl_cb);
+
   android::sp<IDisplayConfig> display_config_ = nullptr;
   uint64_t client_handle_ = 0;
+  std::shared_ptr<ConfigCache> cache_ = std::make_shared<ConfigCache>();
 };
 
 }  // namespace DisplayConfig
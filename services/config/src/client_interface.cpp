@@ -50,6 +50,7 @@ int ClientInterface::Create(std::string client_name, ConfigCallback *callback,
     return -1;
   }
 
+  BatchTransport::Register(impl, impl);
   *intf = impl;
   return 0;
 }
@@ -57,6 +58,7 @@ int ClientInterface::Create(std::string client_name, ConfigCallback *callback,
 void ClientInterface::Destroy(ClientInterface *intf) {
   if (intf) {
     ClientImpl *impl = static_cast<ClientImpl *>(intf);
+    BatchTransport::Unregister(intf);
     impl->DeInit();
     delete impl;
   }
@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include "config_cache.h"
+#include "opcode_types.h"
+
+namespace DisplayConfig {
+
+bool ConfigCache::IsCacheable(uint32_t op_code) {
+  switch (op_code) {
+    case kGetConfigCount:
+    case kGetDisplayAttributes:
+    case kGetHdrCapabilities:
+    case kGetWritebackCapabilities:
+    case kIsPowerModeOverrideSupported:
+    case kIsHdrSupported:
+    case kIsWcgSupported:
+    case kIsBuiltinDisplay:
+    case kGetSupportedDsiBitclks:
+    case kIsSmartPanelConfig:
+    case kIsAsyncVdsSupported:
+    case kIsRotatorSupportedFormat:
+    case kGetDisplayHwId:
+    case kGetSupportedDisplayRefreshRates:
+    case kIsRCSupported:
+    case kGetDisplayType:
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool ConfigCache::IsMutating(uint32_t op_code) {
+  switch (op_code) {
+    case kSetDisplayStatus:
+    case kConfigureDynRefreshRate:
+    case kSetActiveConfig:
+    case kSetPanelLuminanceAttributes:
+    case kSetDsiClk:
+    case kCreateVirtualDisplay:
+      return true;
+    default:
+      return false;
+  }
+}
+
+uint64_t ConfigCache::GetGeneration() {
+  std::lock_guard<std::mutex> lock(lock_);
+  return (generation_ == kNoGeneration) ? kNoGeneration : epoch_;
+}
+
+bool ConfigCache::Lookup(uint32_t op_code, const uint8_t *input, size_t input_size,
+                         std::vector<uint8_t> *output) {
+  std::lock_guard<std::mutex> lock(lock_);
+  if (generation_ == kNoGeneration) {
+    return false;
+  }
+
+  auto it = entries_.find(Key(op_code, std::vector<uint8_t>(input, input + input_size)));
+  if (it == entries_.end() || it->second.generation != epoch_) {
+    stats_.misses++;
+    return false;
+  }
+
+  stats_.hits++;
+  *output = it->second.output;
+  return true;
+}
+
+void ConfigCache::Store(uint64_t generation, uint32_t op_code, const uint8_t *input,
+                        size_t input_size, const uint8_t *output, size_t output_size) {
+  std::lock_guard<std::mutex> lock(lock_);
+  if (generation_ == kNoGeneration || generation != epoch_) {
+    return;
+  }
+
+  if (entries_.size() >= kMaxEntries) {
+    entries_.clear();
+  }
+  Entry &entry = entries_[Key(op_code, std::vector<uint8_t>(input, input + input_size))];
+  entry.generation = generation;
+  entry.output.assign(output, output + output_size);
+}
+
+void ConfigCache::SetGeneration(uint64_t generation) {
+  std::lock_guard<std::mutex> lock(lock_);
+  if (generation == generation_) {
+    return;
+  }
+
+  if (generation_ != kNoGeneration) {
+    stats_.invalidations++;
+  }
+  generation_ = generation;
+  ClearLocked();
+}
+
+void ConfigCache::Invalidate() {
+  std::lock_guard<std::mutex> lock(lock_);
+  if (generation_ == kNoGeneration) {
+    return;
+  }
+
+  stats_.invalidations++;
+  ClearLocked();
+}
+
+void ConfigCache::ClearLocked() {
+  epoch_++;
+  entries_.clear();
+}
+
+ConfigCache::Stats ConfigCache::GetStats() {
+  std::lock_guard<std::mutex> lock(lock_);
+  return stats_;
+}
+
+}  // namespace DisplayConfig
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __CONFIG_CACHE_H__
+#define __CONFIG_CACHE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <map>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace DisplayConfig {
+
+// Client side cache of perform() replies which only change on hotplug or display mode list
+// changes. The service announces its config generation through kNotifyConfigChanged callbacks;
+// every entry records the generation it was fetched in and only hits while that is current.
+// Calls made by this client which change the config invalidate the cache right away, so the
+// next query reads the write back without waiting for the announcement. The cache stays
+// disabled until the first announcement, so services which never send one are always queried.
+class ConfigCache {
+ public:
+  static const uint64_t kNoGeneration = 0;
+
+  struct Stats {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t invalidations;
+  };
+
+  static bool IsCacheable(uint32_t op_code);
+  // True for calls whose effect may change the reply of a cacheable one.
+  static bool IsMutating(uint32_t op_code);
+
+  // Returns the opaque generation to pass to Store() for a query issued now, kNoGeneration if
+  // caching is disabled. Must be taken before the query is sent, so that a change or Invalidate() racing
+  // with the reply discards it.
+  uint64_t GetGeneration();
+  bool Lookup(uint32_t op_code, const uint8_t *input, size_t input_size,
+              std::vector<uint8_t> *output);
+  void Store(uint64_t generation, uint32_t op_code, const uint8_t *input, size_t input_size,
+             const uint8_t *output, size_t output_size);
+  void SetGeneration(uint64_t generation);
+  // Drops all entries and replies in flight, called after this client changed the config.
+  void Invalidate();
+  Stats GetStats();
+
+ private:
+  typedef std::pair<uint32_t, std::vector<uint8_t>> Key;
+
+  struct Entry {
+    uint64_t generation;
+    std::vector<uint8_t> output;
+  };
+
+  static const size_t kMaxEntries = 256;
+
+  void ClearLocked();
+
+  std::mutex lock_;
+  uint64_t generation_ = kNoGeneration;  // announced by the service
+  uint64_t epoch_ = 1;  // local, changes with the generation and on Invalidate()
+  std::map<Key, Entry> entries_;
+  Stats stats_ = {};
+};
+
+}  // namespace DisplayConfig
+
+#endif  // __CONFIG_CACHE_H__
@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <stdint.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "config_cache.h"
+#include "opcode_types.h"
+using namespace testing;
+
+namespace DisplayConfig {
+namespace {
+
+typedef std::vector<uint8_t> Bytes;
+
+void Store(ConfigCache *cache, uint64_t generation, uint32_t op_code, const Bytes &input,
+           const Bytes &output) {
+  cache->Store(generation, op_code, input.data(), input.size(), output.data(), output.size());
+}
+
+bool Lookup(ConfigCache *cache, uint32_t op_code, const Bytes &input, Bytes *output) {
+  return cache->Lookup(op_code, input.data(), input.size(), output);
+}
+
+}  // namespace
+
+TEST(ConfigCacheTest, DisabledUntilGenerationIsAnnounced) {
+  ConfigCache cache;
+  Bytes output;
+
+  EXPECT_THAT(cache.GetGeneration(), Eq(ConfigCache::kNoGeneration));
+  Store(&cache, cache.GetGeneration(), kGetConfigCount, {1}, {4, 0, 0, 0});
+  EXPECT_FALSE(Lookup(&cache, kGetConfigCount, {1}, &output));
+
+  cache.SetGeneration(7);
+  EXPECT_FALSE(Lookup(&cache, kGetConfigCount, {1}, &output));
+  Store(&cache, cache.GetGeneration(), kGetConfigCount, {1}, {4, 0, 0, 0});
+  ASSERT_TRUE(Lookup(&cache, kGetConfigCount, {1}, &output));
+  EXPECT_THAT(output, ElementsAre(4, 0, 0, 0));
+}
+
+TEST(ConfigCacheTest, KeyedByOpCodeAndInput) {
+  ConfigCache cache;
+  cache.SetGeneration(1);
+  uint64_t generation = cache.GetGeneration();
+  Store(&cache, generation, kIsHdrSupported, {0, 0, 0, 0}, {1});
+  Store(&cache, generation, kIsHdrSupported, {1, 0, 0, 0}, {0});
+  Store(&cache, generation, kIsWcgSupported, {0, 0, 0, 0}, {0});
+
+  Bytes output;
+  ASSERT_TRUE(Lookup(&cache, kIsHdrSupported, {0, 0, 0, 0}, &output));
+  EXPECT_THAT(output, ElementsAre(1));
+  ASSERT_TRUE(Lookup(&cache, kIsHdrSupported, {1, 0, 0, 0}, &output));
+  EXPECT_THAT(output, ElementsAre(0));
+  ASSERT_TRUE(Lookup(&cache, kIsWcgSupported, {0, 0, 0, 0}, &output));
+  EXPECT_THAT(output, ElementsAre(0));
+  EXPECT_FALSE(Lookup(&cache, kIsWcgSupported, {2, 0, 0, 0}, &output));
+
+  EXPECT_THAT(cache.GetStats().hits, Eq(3u));
+  EXPECT_THAT(cache.GetStats().misses, Eq(1u));
+}
+
+TEST(ConfigCacheTest, NewGenerationInvalidates) {
+  ConfigCache cache;
+  cache.SetGeneration(1);
+  Store(&cache, cache.GetGeneration(), kGetDisplayAttributes, {0}, {1, 2, 3});
+
+  Bytes output;
+  EXPECT_TRUE(Lookup(&cache, kGetDisplayAttributes, {0}, &output));
+  cache.SetGeneration(2);
+  EXPECT_FALSE(Lookup(&cache, kGetDisplayAttributes, {0}, &output));
+  EXPECT_THAT(cache.GetStats().invalidations, Eq(1u));
+
+  // Repeating the current generation keeps entries.
+  Store(&cache, cache.GetGeneration(), kGetDisplayAttributes, {0}, {4, 5, 6});
+  cache.SetGeneration(2);
+  ASSERT_TRUE(Lookup(&cache, kGetDisplayAttributes, {0}, &output));
+  EXPECT_THAT(output, ElementsAre(4, 5, 6));
+}
+
+TEST(ConfigCacheTest, ReplyRacingWithChangeIsDropped) {
+  ConfigCache cache;
+  cache.SetGeneration(1);
+
+  // Query sent in generation 1, the change notification arrives before its reply.
+  uint64_t generation = cache.GetGeneration();
+  cache.SetGeneration(2);
+  Store(&cache, generation, kGetConfigCount, {0}, {9});
+
+  Bytes output;
+  EXPECT_FALSE(Lookup(&cache, kGetConfigCount, {0}, &output));
+}
+
+TEST(ConfigCacheTest, InvalidateDropsEntriesAndRacingReplies) {
+  ConfigCache cache;
+  Bytes output;
+
+  // Nothing to drop while disabled.
+  cache.Invalidate();
+  EXPECT_THAT(cache.GetGeneration(), Eq(ConfigCache::kNoGeneration));
+
+  cache.SetGeneration(1);
+  Store(&cache, cache.GetGeneration(), kGetDisplayAttributes, {0}, {1, 2, 3});
+
+  // Query sent before this client changed the active config, its reply arrives after.
+  uint64_t generation = cache.GetGeneration();
+  cache.Invalidate();
+  EXPECT_FALSE(Lookup(&cache, kGetDisplayAttributes, {0}, &output));
+  Store(&cache, generation, kGetDisplayAttributes, {0}, {1, 2, 3});
+  EXPECT_FALSE(Lookup(&cache, kGetDisplayAttributes, {0}, &output));
+  EXPECT_THAT(cache.GetStats().invalidations, Eq(1u));
+
+  // Still enabled, queries issued after the change are cached again.
+  Store(&cache, cache.GetGeneration(), kGetDisplayAttributes, {0}, {4, 5, 6});
+  ASSERT_TRUE(Lookup(&cache, kGetDisplayAttributes, {0}, &output));
+  EXPECT_THAT(output, ElementsAre(4, 5, 6));
+
+  // The service announcing the change afterwards invalidates again.
+  cache.SetGeneration(2);
+  EXPECT_FALSE(Lookup(&cache, kGetDisplayAttributes, {0}, &output));
+}
+
+TEST(ConfigCacheTest, MutatingCallsAreNotCacheable) {
+  const uint32_t mutating[] = {kSetDisplayStatus, kConfigureDynRefreshRate, kSetActiveConfig,
+                               kSetPanelLuminanceAttributes, kSetDsiClk, kCreateVirtualDisplay};
+  for (uint32_t op_code : mutating) {
+    EXPECT_TRUE(ConfigCache::IsMutating(op_code));
+    EXPECT_FALSE(ConfigCache::IsCacheable(op_code));
+  }
+  EXPECT_FALSE(ConfigCache::IsMutating(kGetDisplayAttributes));
+  EXPECT_FALSE(ConfigCache::IsMutating(kGetActiveConfig));
+  EXPECT_FALSE(ConfigCache::IsMutating(kPerformBatch));
+}
+
+TEST(ConfigCacheTest, OnlyDisplayPropertiesAreCacheable) {
+  EXPECT_TRUE(ConfigCache::IsCacheable(kGetDisplayAttributes));
+  EXPECT_TRUE(ConfigCache::IsCacheable(kGetHdrCapabilities));
+  EXPECT_TRUE(ConfigCache::IsCacheable(kIsSmartPanelConfig));
+  EXPECT_FALSE(ConfigCache::IsCacheable(kGetActiveConfig));
+  EXPECT_FALSE(ConfigCache::IsCacheable(kGetPanelBrightness));
+  EXPECT_FALSE(ConfigCache::IsCacheable(kIsDisplayConnected));
+  EXPECT_FALSE(ConfigCache::IsCacheable(kSetActiveConfig));
+  EXPECT_FALSE(ConfigCache::IsCacheable(kPerformBatch));
+}
+
+TEST(ConfigCacheTest, ConcurrentInvalidation) {
+  ConfigCache cache;
+  cache.SetGeneration(1);
+  std::atomic<bool> done(false);
+
+  // Values encode the generation they were fetched in, a hit must never return an older one.
+  std::thread notifier([&cache, &done] {
+    for (uint64_t generation = 2; generation < 2000; generation++) {
+      cache.SetGeneration(generation);
+    }
+    done = true;
+  });
+
+  Bytes output;
+  while (!done) {
+    uint64_t generation = cache.GetGeneration();
+    Store(&cache, generation, kGetDisplayHwId, {0},
+          {uint8_t(generation), uint8_t(generation >> 8)});
+    if (Lookup(&cache, kGetDisplayHwId, {0}, &output)) {
+      uint64_t fetched = output[0] | (uint64_t(output[1]) << 8);
+      ASSERT_THAT(fetched, Ge(generation));
+    }
+  }
+  notifier.join();
+}
+
+}  // namespace DisplayConfig
@@ -30,7 +30,7 @@
 /*
 * Changes from Qualcomm Innovation Center are provided under the following license:
 *
-* Copyright (c) 2022 Qualcomm Innovation Center, Inc. All rights reserved.
+* Copyright (c) 2022-2023 Qualcomm Innovation Center, Inc. All rights reserved.
 *
 * Redistribution and use in source and binary forms, with or without
 * modification, are permitted (subject to the limitations in the
@@ -63,9 +63,12 @@
 * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+#include <chrono>
 #include <string>
 #include <vector>
 
+#include "batch_codec.h"
+#include "config_cache.h"
 #include "device_impl.h"
 
 namespace DisplayConfig {
@@ -80,6 +83,8 @@ int DeviceImpl::CreateInstance(ClientContext *intf) {
     if (!device_obj_) {
       return -1;
     }
+    device_obj_->config_generation_ = static_cast<uint64_t>(
+        std::chrono::steady_clock::now().time_since_epoch().count()) | 1;
 
     android::status_t status = device_obj_->IDisplayConfig::registerAsService();
     // Unable to start Display Config 2.0 service. Fail Init.
@@ -141,9 +146,40 @@ Return<void> DeviceImpl::registerClient(const hidl_string &client_name,
       device_client.get());
   display_config_map_.emplace(std::make_pair(client_handle, device_client));
   _hidl_cb(error, client_handle);
+  // Enables the client cache.
+  device_client->NotifyConfigChanged(config_generation_);
   return Void();
 }
 
+void DeviceImpl::NotifyDisplayConfigChanged() {
+  DeviceImpl *device = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(device_lock_);
+    device = device_obj_;
+  }
+
+  if (device) {
+    device->NotifyConfigChanged();
+  }
+}
+
+void DeviceImpl::NotifyConfigChanged() {
+  uint64_t generation = ++config_generation_;
+  std::vector<std::shared_ptr<DeviceClientContext>> clients;
+  {
+    std::lock_guard<std::recursive_mutex> lock(death_service_mutex_);
+    for (auto &client : display_config_map_) {
+      clients.push_back(client.second);
+    }
+  }
+
+  for (auto &client : clients) {
+    if (client) {
+      client->NotifyConfigChanged(generation);
+    }
+  }
+}
+
 void DeviceImpl::serviceDied(uint64_t client_handle,
                              const android::wp<::android::hidl::base::V1_0::IBase>& callback) {
   std::lock_guard<std::recursive_mutex> lock(death_service_mutex_);
@@ -207,6 +243,21 @@ void DeviceImpl::DeviceClientContext::NotifyIdleStatus(bool is_idle) {
   }
 }
 
+void DeviceImpl::DeviceClientContext::NotifyConfigChanged(uint64_t generation) {
+  ByteStream output_params;
+
+  if (!callback_) {
+    return;
+  }
+
+  output_params.setToExternal(reinterpret_cast<uint8_t*>(&generation), sizeof(generation));
+
+  auto status = callback_->perform(kNotifyConfigChanged, output_params, {});
+  if (status.isDeadObject()) {
+    return;
+  }
+}
+
 void DeviceImpl::DeviceClientContext::ParseIsDisplayConnected(const ByteStream &input_params,
                                                               perform_cb _hidl_cb) {
   const DisplayType *dpy;
@@ -923,6 +974,39 @@ Return<void> DeviceImpl::perform(uint64_t client_handle, uint32_t op_code,
     _hidl_cb(error, {}, {});
      return Void();
   }
+
+  if (op_code == kPerformBatch) {
+    ParseBatch(client_handle, client, input_params, _hidl_cb);
+  } else {
+    Dispatch(client_handle, client, op_code, input_params, input_handles, _hidl_cb);
+  }
+  return Void();
+}
+
+void DeviceImpl::Dispatch(uint64_t client_handle, std::shared_ptr<DeviceClientContext> client,
+                          uint32_t op_code, const ByteStream &input_params,
+                          const HandleStream &input_handles, perform_cb _hidl_cb) {
+  // Only calls which can change what clients cache are announced.
+  if (!ConfigCache::IsMutating(op_code)) {
+    DispatchOp(client_handle, client, op_code, input_params, input_handles, _hidl_cb);
+    return;
+  }
+
+  int32_t result = -EINVAL;
+  auto result_cb = [&result, &_hidl_cb] (int32_t err, const ByteStream &output_params,
+                                         const HandleStream &output_handles) {
+    result = err;
+    _hidl_cb(err, output_params, output_handles);
+  };
+  DispatchOp(client_handle, client, op_code, input_params, input_handles, result_cb);
+  if (!result) {
+    NotifyConfigChanged();
+  }
+}
+
+void DeviceImpl::DispatchOp(uint64_t client_handle, std::shared_ptr<DeviceClientContext> client,
+                            uint32_t op_code, const ByteStream &input_params,
+                            const HandleStream &input_handles, perform_cb _hidl_cb) {
   switch (op_code) {
     case kIsDisplayConnected:
       client->ParseIsDisplayConnected(input_params, _hidl_cb);
@@ -1084,7 +1168,34 @@ Return<void> DeviceImpl::perform(uint64_t client_handle, uint32_t op_code,
       _hidl_cb(-EINVAL, {}, {});
       break;
   }
-  return Void();
+}
+
+void DeviceImpl::ParseBatch(uint64_t client_handle, std::shared_ptr<DeviceClientContext> client,
+                            const ByteStream &input_params, perform_cb _hidl_cb) {
+  auto call = [&] (uint32_t op_code, const uint8_t *input, size_t input_size,
+                   std::vector<uint8_t> *output) {
+    ByteStream params;
+    params.setToExternal(const_cast<uint8_t *>(input), input_size);
+    int32_t error = -ENODATA;  // Handler which never replied.
+    auto entry_cb = [&error, output] (int32_t err, const ByteStream &output_params,
+                                      const HandleStream &output_handles) {
+      error = err;
+      output->assign(output_params.data(), output_params.data() + output_params.size());
+    };
+    Dispatch(client_handle, client, op_code, params, {}, entry_cb);
+    return error;
+  };
+
+  std::vector<uint8_t> response;
+  int32_t error = ExecuteBatch(input_params.data(), input_params.size(), call, &response);
+  if (error) {
+    _hidl_cb(error, {}, {});
+    return;
+  }
+
+  ByteStream output_params;
+  output_params.setToExternal(response.data(), response.size());
+  _hidl_cb(0, output_params, {});
 }
 
 }  // namespace DisplayConfig
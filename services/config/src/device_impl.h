@@ -30,7 +30,7 @@
 /*
 * Changes from Qualcomm Innovation Center are provided under the following license:
 *
-* Copyright (c) 2022 Qualcomm Innovation Center, Inc. All rights reserved.
+* Copyright (c) 2022-2023 Qualcomm Innovation Center, Inc. All rights reserved.
 *
 * Redistribution and use in source and binary forms, with or without
 * modification, are permitted (subject to the limitations in the
@@ -70,6 +70,7 @@
 #include <hidl/HidlSupport.h>
 #include <log/log.h>
 #include <config/device_interface.h>
+#include <atomic>
 #include <map>
 #include <utility>
 #include <string>
@@ -95,6 +96,7 @@ typedef hidl_vec<hidl_handle> HandleStream;
 class DeviceImpl : public IDisplayConfig, public android::hardware::hidl_death_recipient {
  public:
   static int CreateInstance(ClientContext *intf);
+  static void NotifyDisplayConfigChanged();
 
  private:
   class DeviceClientContext : public ConfigCallback {
@@ -109,6 +111,7 @@ class DeviceImpl : public IDisplayConfig, public android::hardware::hidl_death_r
     virtual void NotifyQsyncChange(bool qsync_enabled, int32_t refresh_rate,
                                    int32_t qsync_refresh_rate);
     virtual void NotifyIdleStatus(bool is_idle);
+    void NotifyConfigChanged(uint64_t generation);
 
     void ParseIsDisplayConnected(const ByteStream &input_params, perform_cb _hidl_cb);
     void ParseSetDisplayStatus(const ByteStream &input_params, perform_cb _hidl_cb);
@@ -176,11 +179,23 @@ class DeviceImpl : public IDisplayConfig, public android::hardware::hidl_death_r
   void serviceDied(uint64_t client_handle,
                    const android::wp<::android::hidl::base::V1_0::IBase>& callback);
   void ParseDestroy(uint64_t client_handle, perform_cb _hidl_cb);
+  void Dispatch(uint64_t client_handle, std::shared_ptr<DeviceClientContext> client,
+                uint32_t op_code, const ByteStream &input_params,
+                const HandleStream &input_handles, perform_cb _hidl_cb);
+  void DispatchOp(uint64_t client_handle, std::shared_ptr<DeviceClientContext> client,
+                  uint32_t op_code, const ByteStream &input_params,
+                  const HandleStream &input_handles, perform_cb _hidl_cb);
+  void NotifyConfigChanged();
+  void ParseBatch(uint64_t client_handle, std::shared_ptr<DeviceClientContext> client,
+                  const ByteStream &input_params, perform_cb _hidl_cb);
 
   ClientContext *intf_ = nullptr;
   std::map<uint64_t, std::shared_ptr<DeviceClientContext>> display_config_map_;
   std::vector<uint64_t> pending_display_config_;
   uint64_t client_id_ = 0;
+  // Announced to clients, which cache replies of this generation. Seeded from the clock so that
+  // a restarted service never repeats a generation.
+  std::atomic<uint64_t> config_generation_;
   std::recursive_mutex death_service_mutex_;
   static DeviceImpl *device_obj_;
   static std::mutex device_lock_;